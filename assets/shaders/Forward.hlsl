@@ -7,7 +7,7 @@ Texture2D gMetalnessMap : register(t2);
 Texture2D gNormalMap    : register(t3);
 STD_PIPELINE_SR_IBL(4); // cover 3 register
 
-STD_PIPELINE_CB_PER_OBJECT(0);
+STD_PIPELINE_SRV_INSTANCES(7, 8);
 
 cbuffer cbPerMaterial : register(b1)
 {
@@ -22,9 +22,9 @@ STD_PIPELINE_CB_LIGHT_ARRAY(3);
 struct VertexIn
 {
 	float3 PosL     : POSITION;
-    float3 NormalL  : NORMAL;
+    STD_PIPELINE_VERTEX_NORMAL NormalL : NORMAL;
 	float2 TexC     : TEXCOORD;
-	float3 TangentL : TENGENT;
+	STD_PIPELINE_VERTEX_TANGENT TangentL : TENGENT;
 };
 
 struct VertexOut
@@ -37,17 +37,18 @@ struct VertexOut
     float3   N       : NORMAL;
 };
 
-VertexOut VS(VertexIn vin)
+VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
 	VertexOut vout = (VertexOut)0.0f;
+	StdPipeline_Object obj = STD_PIPELINE_INSTANCE_OBJECT(instanceID);
 	
     // Transform to world space.
-    float4 posW = mul(gWorld, float4(vin.PosL, 1.0f));
+    float4 posW = mul(obj.world, float4(vin.PosL, 1.0f));
     vout.PosW = posW.xyz;
 
-	float3x3 normalMatrix = transpose((float3x3)gInvWorld);
-    vout.N = normalize(mul(normalMatrix, vin.NormalL));
-	float4 TangentH = mul(gWorld, float4(vin.TangentL, 1));
+	float3x3 normalMatrix = transpose((float3x3)obj.invWorld);
+    vout.N = normalize(mul(normalMatrix, STD_PIPELINE_DECODE_NORMAL(vin.NormalL)));
+	float4 TangentH = mul(obj.world, float4(STD_PIPELINE_DECODE_TANGENT(vin.TangentL), 1));
 	float3 TangentW = TangentH.xyz / TangentH.w;
     vout.T = normalize(TangentW - dot(TangentW, vout.N) * vout.N);
 	vout.B = cross(vout.N, vout.T);
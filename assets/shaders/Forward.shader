@@ -6,7 +6,8 @@ Shader "StdPipeline/Forward" {
 		SRV[1] : 2
 		SRV[1] : 3
 		SRV[3] : 4
-		CBV : 0
+		SRV : 7
+		SRV : 8
 		CBV : 1
 		CBV : 2
 		CBV : 3
@@ -22,9 +22,9 @@ STD_PIPELINE_CB_LIGHT_ARRAY(3);
 struct VertexIn
 {
 	float3 PosL     : POSITION;
-    float3 NormalL  : NORMAL;
+    STD_PIPELINE_VERTEX_NORMAL NormalL : NORMAL;
 	float2 TexC     : TEXCOORD;
-	float3 TangentL : TENGENT;
+	STD_PIPELINE_VERTEX_TANGENT TangentL : TENGENT;
 };
 
 struct VertexOut
@@ -46,8 +46,8 @@ VertexOut VS(VertexIn vin)
     vout.PosW = posW.xyz;
 
 	float3x3 normalMatrix = transpose((float3x3)gInvWorld);
-    vout.N = normalize(mul(normalMatrix, vin.NormalL));
-	float4 TangentH = mul(gWorld, float4(vin.TangentL, 1));
+    vout.N = normalize(mul(normalMatrix, STD_PIPELINE_DECODE_NORMAL(vin.NormalL)));
+	float4 TangentH = mul(gWorld, float4(STD_PIPELINE_DECODE_TANGENT(vin.TangentL), 1));
 	float3 TangentW = TangentH.xyz / TangentH.w;
     vout.T = normalize(TangentW - dot(TangentW, vout.N) * vout.N);
 	vout.B = cross(vout.N, vout.T);
@@ -5,7 +5,8 @@ Shader "StdPipeline/Geometry" {
 		SRV[1] : 1
 		SRV[1] : 2
 		SRV[1] : 3
-		CBV : 0
+		SRV : 4
+		SRV : 5
 		CBV : 1
 		CBV : 2
 	}
@@ -12,6 +12,19 @@ cbuffer StdPipeline_cbPerObject : register(b##x) \
     float4x4 gInvWorld;                          \
 }
 
+// objects (same stride as the object constant buffers) and the object indices of an instance batch,
+// bound as root SRV, the object of an instance is StdPipeline_srvObjects[StdPipeline_srvInstances[SV_InstanceID]]
+struct StdPipeline_Object
+{
+    float4x4 world;
+    float4x4 invWorld;
+    float4x4 _pad[2];
+};
+#define STD_PIPELINE_SRV_INSTANCES(x, y)                                  \
+StructuredBuffer<StdPipeline_Object> StdPipeline_srvObjects : register(t##x); \
+StructuredBuffer<uint> StdPipeline_srvInstances : register(t##y)
+#define STD_PIPELINE_INSTANCE_OBJECT(instanceID) StdPipeline_srvObjects[StdPipeline_srvInstances[instanceID]]
+
 #define STD_PIPELINE_CB_PER_CAMERA(x)            \
 cbuffer StdPipeline_cbPerCamera : register(b##x) \
 {                                                \
@@ -32,6 +45,10 @@ cbuffer StdPipeline_cbPerCamera : register(b##x) \
     float gFarZ;                                 \
     float gTotalTime;                            \
     float gDeltaTime;                            \
+                                                 \
+    uint3 gClusterDim;                           \
+    float gClusterLogScale;                      \
+    float gClusterLogBias;                       \
 }
 
 // 1. directional light
@@ -92,6 +109,29 @@ cbuffer StdPipeline_cbLightArray : register(b##x) \
 	Light gLights[16];                            \
 }
 
+// clustered point / spot / rect / disk lights (need STD_PIPELINE_CB_LIGHT_ARRAY for Light)
+// - light f2: type (1 point, 2 spot, 3 rect, 4 disk)
+// - cluster (x, y, z), index x + gClusterDim.x * (y + gClusterDim.y * z)
+//   x = floor((ndc.x * 0.5 + 0.5) * gClusterDim.x), y = floor((ndc.y * 0.5 + 0.5) * gClusterDim.y),
+//   z = floor(log(view depth) * gClusterLogScale + gClusterLogBias)
+// - StdPipeline_srvLightClusters[cluster]: (offset, count) in StdPipeline_srvClusterLightIndices
+#define STD_PIPELINE_SRV_LIGHT_CLUSTERS(x, y, z)                                   \
+StructuredBuffer<Light> StdPipeline_srvClusterLights        : register(t##x);     \
+StructuredBuffer<uint2> StdPipeline_srvLightClusters        : register(t##y);     \
+StructuredBuffer<uint>  StdPipeline_srvClusterLightIndices  : register(t##z)
+
+// index of the cluster of ndc (x, y) at view depth d (> 0), args from STD_PIPELINE_CB_PER_CAMERA
+uint StdPipeline_ClusterIndex(float2 ndc, float d, uint3 dim, float logScale, float logBias)
+{
+    int3 c = int3(
+        floor((ndc.x * 0.5f + 0.5f) * dim.x),
+        floor((ndc.y * 0.5f + 0.5f) * dim.y),
+        floor(log(max(d, 1e-4f)) * logScale + logBias)
+    );
+    uint3 cluster = (uint3)clamp(c, int3(0, 0, 0), int3(dim) - 1);
+    return cluster.x + dim.x * (cluster.y + dim.y * cluster.z);
+}
+
 // cover 3 register
 #define STD_PIPELINE_SR_IBL(x)                            \
 TextureCube StdPipeline_IrradianceMap : register(t[x  ]); \
@@ -109,4 +149,32 @@ StdPipeline_BRDFLUT.Sample(gSamplerLinearWrap, float2(NdotV, roughness)).rg
 #define STD_PIPELINE_SAMPLE_IRRADIANCE(N) \
 StdPipeline_IrradianceMap.Sample(gSamplerLinearWrap, N).rgb
 
+// normal and tangent of VertexCompression::Compact meshes (octahedral, declared as float2 NORMAL / TENGENT)
+float3 StdPipeline_DecodeOctahedral(float2 e)
+{
+    float3 v = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-v.z);
+    v.x += v.x >= 0.0f ? -t : t;
+    v.y += v.y >= 0.0f ? -t : t;
+    return normalize(v);
+}
+
+// vertex inputs of normal and tangent
+// VertexCompression::Compact meshes are drawn with the vertex shader compiled with VERTEX_COMPRESSION_COMPACT,
+// normal and tangent are octahedral float2 in it, a vertex shader declaring float3 ones can't draw them
+// e.g.
+// STD_PIPELINE_VERTEX_NORMAL NormalL : NORMAL;
+// float3 N = STD_PIPELINE_DECODE_NORMAL(vin.NormalL);
+#ifdef VERTEX_COMPRESSION_COMPACT
+#define STD_PIPELINE_VERTEX_NORMAL float2
+#define STD_PIPELINE_VERTEX_TANGENT float2
+#define STD_PIPELINE_DECODE_NORMAL(n) StdPipeline_DecodeOctahedral(n)
+#define STD_PIPELINE_DECODE_TANGENT(t) StdPipeline_DecodeOctahedral(t)
+#else
+#define STD_PIPELINE_VERTEX_NORMAL float3
+#define STD_PIPELINE_VERTEX_TANGENT float3
+#define STD_PIPELINE_DECODE_NORMAL(n) (n)
+#define STD_PIPELINE_DECODE_TANGENT(t) (t)
+#endif
+
 #endif // STD_PIEPELINE_HLSLI
@@ -11,6 +11,8 @@ STD_PIPELINE_CB_LIGHT_ARRAY(0);
 
 STD_PIPELINE_CB_PER_CAMERA(1);
 
+STD_PIPELINE_SRV_LIGHT_CLUSTERS(7, 8, 9);
+
 struct VertexOut
 {
 	float4 PosH    : SV_POSITION;
@@ -88,31 +90,18 @@ float4 PS(VertexOut pin) : SV_Target
 		float3 brdf = diffuse + specular;
 		Lo += brdf * gLights[i].color * cos_theta;
 	}
-	offset += gDirectionalLightNum;
-	for(i = offset; i < offset + gPointLightNum; i++) {
-		float3 pixelToLight = gLights[i].position - posW;
-		float dist2 = dot(pixelToLight, pixelToLight);
-		float dist = sqrt(dist2);
-		float3 L = pixelToLight / dist;
-		float3 H = normalize(L + V);
-		
-		float cos_theta = max(0, dot(N, L));
-		
-		float3 fr = Fresnel(F0, cos_theta);
-		float D = GGX_D(alpha, N, H);
-		float G = GGX_G(alpha, L, V, N);
-				
-		float3 diffuse = (1 - fr) * (1 - metalness) * albedo / PI;
-				
-		float3 specular = fr * D * G / (4 * max(dot(L, N)*dot(V, N), EPSILON));
-		
-		float3 brdf = diffuse + specular;
-		float3 color = gLights[i].color * Fwin(dist, gLights[i].range) / (max(0.0001, dist2) * 4 * PI);
-		Lo += brdf * color * cos_theta;
-	}
-	offset += gPointLightNum;
-	for(i = offset; i < offset + gSpotLightNum; i++) {
-		float3 pixelToLight = gLights[i].position - posW;
+	
+	// point and spot lights come from the cluster of the pixel, not from the light array
+	float viewDepth = -mul(gView, float4(posW, 1.0f)).z;
+	uint2 cluster = StdPipeline_srvLightClusters[
+		StdPipeline_ClusterIndex(posHC.xy, viewDepth, gClusterDim, gClusterLogScale, gClusterLogBias)];
+	for(i = 0; i < cluster.y; i++) {
+		Light light = StdPipeline_srvClusterLights[StdPipeline_srvClusterLightIndices[cluster.x + i]];
+		uint type = (uint)light.f2;
+		if (type != 1u && type != 2u) // rect and disk lights are not shaded here yet
+			continue;
+
+		float3 pixelToLight = light.position - posW;
 		float dist2 = dot(pixelToLight, pixelToLight);
 		float dist = sqrt(dist2);
 		float3 L = pixelToLight / dist;
@@ -129,10 +118,14 @@ float4 PS(VertexOut pin) : SV_Target
 		float3 specular = fr * D * G / (4 * max(dot(L, N)*dot(V, N), EPSILON));
 		
 		float3 brdf = diffuse + specular;
-		float3 color = gLights[i].color
-		    * Fwin(dist, gLights[i].range)
-			* DirFwin(-L, gLights[i].dir, gLights[i].f0, gLights[i].f1)
-			/ (max(0.0001, dist2));
+		float3 color;
+		if (type == 1u) // point
+			color = light.color * Fwin(dist, light.range) / (max(0.0001, dist2) * 4 * PI);
+		else // spot
+			color = light.color
+				* Fwin(dist, light.range)
+				* DirFwin(-L, light.dir, light.f0, light.f1)
+				/ (max(0.0001, dist2));
 		Lo += brdf * color * cos_theta;
 	}
 	
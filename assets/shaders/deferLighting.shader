@@ -6,6 +6,9 @@ Shader "StdPipeline/Defer Lighting" {
 		SRV[3] : 4
 		CBV : 0
 		CBV : 1
+		SRV : 7
+		SRV : 8
+		SRV : 9
 	}
 	Pass (VS, PS) {}
 }
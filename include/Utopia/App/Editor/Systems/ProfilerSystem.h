@@ -0,0 +1,9 @@
+#pragma once
+
+#include <UECS/World.h>
+
+namespace Ubpa::Utopia {
+	struct ProfilerSystem {
+		static void OnUpdate(UECS::Schedule&);
+	};
+}
@@ -20,8 +20,9 @@ namespace Ubpa::Utopia {
 	// support
 	// - basic: .lua, .hlsl, .shader, image(.jpg, .png, .bmp, .tga, .hdr), .tex2d, .texcube, .mat, .txt, .json, .scene
 	// - model
-	// * - support: .obj
+	// * - support: .obj, .gltf, .glb
 	// * - optional (assimp): .ply
+	// - animation: .anim (JSON curves, compressed to AnimationClip at load)
 	// other as DefaultAsset except .meta (generated by AssetMngr, unimportable)
 	class AssetMngr {
 	public:
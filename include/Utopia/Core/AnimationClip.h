@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Object.h"
+
+#include <UGM/vec.h>
+#include <UGM/quat.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	// bit i of a channel mask
+	enum class AnimationChannel : uint8_t {
+		Translation,
+		Rotation,
+		Scale
+	};
+
+	constexpr uint8_t GetAnimationChannelBit(AnimationChannel channel) noexcept {
+		return static_cast<uint8_t>(1u << static_cast<uint32_t>(channel));
+	}
+
+	// local TRS of the tracks of a clip, structure of arrays
+	struct AnimationPose {
+		std::vector<vecf3> translations;
+		std::vector<quatf> rotations;
+		std::vector<float> scales;
+		// per track, the sampled channels
+		std::vector<uint8_t> channelMasks;
+
+		void Resize(size_t trackNum);
+	};
+
+	// dst = dst * (1 - weight) + src * weight per track, rotations by nlerp along the shortest arc
+	// a channel sampled in one pose only is taken from it
+	void BlendAnimationPoses(AnimationPose& dst, const AnimationPose& src, float weight);
+
+	// error bounds of the key reduction
+	struct AnimationCompressionSettings {
+		float translationError{ 1e-4f }; // distance
+		float rotationError{ 5e-4f }; // angle, in radians
+		float scaleError{ 1e-4f };
+		size_t segmentFrames{ 16 }; // in [1, 254], a segment has up to segmentFrames + 1 keys per channel
+	};
+
+	// TRS curves of the tracks (usually bones), compressed
+	// - a channel within the error of its first frame is stored once (full precision)
+	// - the other channels are cut in segments of segmentFrames frames, a segment stores the keys of every channel
+	//   contiguously (sampling a time reads one segment), in structure of arrays
+	// - keys are 16-bit: translations and scales quantized in the range of the segment,
+	//   rotations as the smallest three components (the largest one is rebuilt)
+	// - per segment and channel, the frames that the linear interpolation of the kept keys reproduces within the error
+	//   are dropped
+	class AnimationClip : public Object {
+	public:
+		// uniformly sampled curves, a channel has frameNum samples, 1 (constant) or 0 (not animated)
+		struct Track {
+			std::vector<vecf3> translations;
+			std::vector<quatf> rotations;
+			std::vector<float> scales;
+		};
+
+		AnimationClip(const std::vector<Track>& tracks, float sampleRate, size_t frameNum, const AnimationCompressionSettings& settings = {});
+
+		size_t GetTrackNum() const noexcept { return channelMasks.size(); }
+		uint8_t GetChannelMask(size_t track) const noexcept { return channelMasks[track]; }
+		float GetSampleRate() const noexcept { return sampleRate; }
+		size_t GetFrameNum() const noexcept { return frameNum; }
+		// in seconds
+		float GetDuration() const noexcept { return frameNum > 1 ? (frameNum - 1) / sampleRate : 0.f; }
+
+		// keys kept in the segments, a key per frame and animated channel without the reduction
+		size_t GetKeyNum() const noexcept { return keyNum; }
+		// in bytes, of the constants and the segments
+		size_t GetCompressedSize() const noexcept;
+
+		// time in seconds, wrapped into the clip if loop, else clamped
+		// pose.channelMasks are the ones of the tracks
+		void Sample(AnimationPose& pose, float time, bool loop = true) const;
+
+	private:
+		float sampleRate;
+		size_t frameNum;
+		size_t segmentFrames;
+		size_t keyNum{ 0 };
+
+		std::vector<uint8_t> channelMasks;
+
+		// (track << 2) | channel
+		std::vector<uint32_t> constantChannels;
+		std::vector<float> constants; // 3, 4 or 1 floats per constant channel
+		std::vector<uint32_t> animatedChannels;
+
+		// segment i : segmentData[segmentOffsets[i], segmentOffsets[i + 1])
+		// - uint8_t keyNums[animated channel num]
+		// - uint8_t keyFrames[sum of keyNums] : frames in the segment, the first and the last one of it included
+		// - float ranges[] : per translation (min xyz, scale xyz) and scale (min, scale) channel
+		// - uint16_t values[] : per channel, component by component (3 for translations and rotations, 1 for scales)
+		// - uint8_t largest[] : per rotation key, the index of the dropped component
+		std::vector<uint32_t> segmentOffsets;
+		std::vector<uint8_t> segmentData;
+	};
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <UECS/Entity.h>
+
+namespace Ubpa::Utopia {
+	// its Translation / Rotation / Scale follow the track of the Animator on the entity animator
+	// written by the AnimatorSystem before the TRS systems
+	struct AnimationTarget {
+		UECS::Entity animator{ UECS::Entity::Invalid() };
+		size_t track{ 0 };
+	};
+}
+
+#include "details/AnimationTarget_AutoRefl.inl"
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../AnimationClip.h"
+
+#include <memory>
+
+namespace Ubpa::Utopia {
+	// plays a clip on the Translation / Rotation / Scale of the entities with an AnimationTarget of it
+	// written by the AnimatorSystem
+	struct Animator {
+		std::shared_ptr<AnimationClip> clip;
+		// in seconds, advanced by speed * deltaTime
+		float time{ 0.f };
+		float speed{ 1.f };
+		bool loop{ true };
+
+		// blended over the clip by blendWeight, with its own time
+		std::shared_ptr<AnimationClip> blendClip;
+		float blendTime{ 0.f };
+		[[interval(std::pair{0.f, 1.f})]]
+		float blendWeight{ 0.f };
+	};
+}
+
+#include "details/Animator_AutoRefl.inl"
@@ -1,11 +1,15 @@
 #pragma once
 
+#include "AnimationTarget.h"
+#include "Animator.h"
 #include "Children.h"
+#include "FixedTime.h"
 #include "Input.h"
 #include "LocalToParent.h"
 #include "LocalToWorld.h"
 #include "Name.h"
 #include "Parent.h"
+#include "PrevLocalToWorld.h"
 #include "Roamer.h"
 #include "Rotation.h"
 #include "RotationEuler.h"
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace Ubpa::Utopia {
+	// singleton, written by FixedTimestep
+	struct FixedTime {
+		double elapsedTime; // simulated time, in seconds
+		float deltaTime; // step time, in seconds
+		float alpha; // interpolation alpha between the last two steps, in [0, 1)
+	};
+}
+
+#include "details/FixedTime_AutoRefl.inl"
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <UGM/transform.h>
+
+namespace Ubpa::Utopia {
+	// LocalToWorld before the last fixed step, written by FixedTimestep
+	// render extraction blends it with LocalToWorld by FixedTime::alpha
+	struct PrevLocalToWorld {
+		transformf value{ transformf::eye() };
+		// set by the first step that sees the entity, render extraction uses LocalToWorld until then
+		bool seeded{ false };
+	};
+}
+
+#include "details/PrevLocalToWorld_AutoRefl.inl"
@@ -0,0 +1,17 @@
+// This file is generated by Ubpa::USRefl::AutoRefl
+
+#pragma once
+
+#include <USRefl/USRefl.h>
+
+template<>
+struct Ubpa::USRefl::TypeInfo<Ubpa::Utopia::AnimationTarget>
+    : Ubpa::USRefl::TypeInfoBase<Ubpa::Utopia::AnimationTarget>
+{
+    static constexpr AttrList attrs = {};
+
+    static constexpr FieldList fields = {
+        Field{"animator", &Ubpa::Utopia::AnimationTarget::animator},
+        Field{"track", &Ubpa::Utopia::AnimationTarget::track},
+    };
+};
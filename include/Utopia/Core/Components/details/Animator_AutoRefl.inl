@@ -0,0 +1,26 @@
+// This file is generated by Ubpa::USRefl::AutoRefl
+
+#pragma once
+
+#include <USRefl/USRefl.h>
+
+template<>
+struct Ubpa::USRefl::TypeInfo<Ubpa::Utopia::Animator>
+    : Ubpa::USRefl::TypeInfoBase<Ubpa::Utopia::Animator>
+{
+    static constexpr AttrList attrs = {};
+
+    static constexpr FieldList fields = {
+        Field{"clip", &Ubpa::Utopia::Animator::clip},
+        Field{"time", &Ubpa::Utopia::Animator::time},
+        Field{"speed", &Ubpa::Utopia::Animator::speed},
+        Field{"loop", &Ubpa::Utopia::Animator::loop},
+        Field{"blendClip", &Ubpa::Utopia::Animator::blendClip},
+        Field{"blendTime", &Ubpa::Utopia::Animator::blendTime},
+        Field{"blendWeight", &Ubpa::Utopia::Animator::blendWeight,
+            AttrList{
+                Attr{"interval", std::pair{0.f,1.f}},
+            }
+        },
+    };
+};
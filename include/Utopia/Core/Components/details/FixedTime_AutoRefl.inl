@@ -0,0 +1,19 @@
+// This file is generated by Ubpa::USRefl::AutoRefl
+
+#pragma once
+
+#include <USRefl/USRefl.h>
+
+template<>
+struct Ubpa::USRefl::TypeInfo<Ubpa::Utopia::FixedTime>
+    : Ubpa::USRefl::TypeInfoBase<Ubpa::Utopia::FixedTime>
+{
+    static constexpr AttrList attrs = {};
+
+    static constexpr FieldList fields = {
+        Field{"elapsedTime", &Ubpa::Utopia::FixedTime::elapsedTime},
+        Field{"deltaTime", &Ubpa::Utopia::FixedTime::deltaTime},
+        Field{"alpha", &Ubpa::Utopia::FixedTime::alpha},
+    };
+};
+
@@ -0,0 +1,18 @@
+// This file is generated by Ubpa::USRefl::AutoRefl
+
+#pragma once
+
+#include <USRefl/USRefl.h>
+
+template<>
+struct Ubpa::USRefl::TypeInfo<Ubpa::Utopia::PrevLocalToWorld>
+    : Ubpa::USRefl::TypeInfoBase<Ubpa::Utopia::PrevLocalToWorld>
+{
+    static constexpr AttrList attrs = {};
+
+    static constexpr FieldList fields = {
+        Field{"value", &Ubpa::Utopia::PrevLocalToWorld::value},
+        Field{"seeded", &Ubpa::Utopia::PrevLocalToWorld::seeded},
+    };
+};
+
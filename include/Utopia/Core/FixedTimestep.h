@@ -0,0 +1,60 @@
+#pragma once
+
+#include <UECS/World.h>
+
+#include <UGM/transform.h>
+
+#include <cstdint>
+
+namespace Ubpa::Utopia {
+	// fixed-timestep driver
+	// - accumulates the frame time and steps world.Update() at a fixed tick rate
+	// - the accumulator is clamped to maxStepsPerFrame steps (spiral-of-death protection),
+	//   the clamped time is dropped (the simulation slows down instead of falling behind)
+	// - before every step, LocalToWorld is copied to PrevLocalToWorld,
+	//   after it, the PrevLocalToWorld of the new entities is seeded with their LocalToWorld
+	//   and the FixedTime singleton is updated (WorldTimeSystem uses it if it exists)
+	// - render extraction blends PrevLocalToWorld and LocalToWorld by FixedTime::alpha
+	class FixedTimestep {
+	public:
+		FixedTimestep(double tickRate = 60., size_t maxStepsPerFrame = 8) noexcept;
+
+		void SetTickRate(double tickRate) noexcept; // in Hz
+		double GetTickRate() const noexcept { return tickRate; }
+		double GetStepTime() const noexcept { return stepTime; } // in seconds
+
+		void SetMaxStepsPerFrame(size_t num) noexcept;
+		size_t GetMaxStepsPerFrame() const noexcept { return maxStepsPerFrame; }
+
+		// accumulate frameTime (in seconds), return the number of steps to run
+		size_t Advance(double frameTime) noexcept;
+
+		// Advance, then run the steps on the world
+		// return the number of steps
+		size_t Update(UECS::World& world, double frameTime);
+
+		// accumulator / stepTime, in [0, 1)
+		float GetAlpha() const noexcept;
+
+		// simulated time, in seconds
+		double GetElapsedTime() const noexcept { return elapsedTime; }
+		uint64_t GetStepCount() const noexcept { return stepCount; }
+		// time dropped by the clamp, in seconds
+		double GetDroppedTime() const noexcept { return droppedTime; }
+
+		void Reset() noexcept;
+
+		// element-wise blend, fine for the small motion in a step
+		static transformf Interpolate(const transformf& prev, const transformf& curr, float alpha) noexcept;
+
+	private:
+		double tickRate;
+		double stepTime;
+		size_t maxStepsPerFrame;
+
+		double accumulator{ 0. };
+		double elapsedTime{ 0. };
+		double droppedTime{ 0. };
+		uint64_t stepCount{ 0 };
+	};
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
+
 namespace Ubpa::Utopia {
+	// steady clock (std::chrono), portable
 	class GameTimer {
 	public:
 		static GameTimer& Instance() noexcept {
@@ -22,11 +25,11 @@ namespace Ubpa::Utopia {
 		double mSecondsPerCount;
 		double mDeltaTime;
 
-		__int64 mBaseTime;
-		__int64 mPausedTime;
-		__int64 mStopTime;
-		__int64 mPrevTime;
-		__int64 mCurrTime;
+		int64_t mBaseTime;
+		int64_t mPausedTime;
+		int64_t mStopTime;
+		int64_t mPrevTime;
+		int64_t mCurrTime;
 
 		bool mStopped;
 	};
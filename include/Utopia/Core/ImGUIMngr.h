@@ -1,7 +1,5 @@
 #pragma once
 
-#include <UDX12/UDX12.h>
-
 #include <vector>
 
 struct ID3D12Device;
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Ubpa::Utopia {
+	// func(begin, end) on contiguous chunks of [0, num), one per thread of a persistent pool
+	// (the calling thread included), the pool has half of the hardware threads,
+	// the rest is left to the UECS job system
+	// at least minChunkSize items per chunk, so small loops run in the calling thread alone
+	// a call inside a running ParallelFor (or concurrent with it) runs in the calling thread alone
+	// func must be safe to call concurrently on disjoint chunks
+	template<typename Func>
+	void ParallelFor(size_t num, size_t minChunkSize, const Func& func);
+}
+
+#include "details/ParallelFor.inl"
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	namespace details {
+		struct ProfilerThreadBuffer;
+	}
+
+	// scoped-timer instrumentation
+	// - every thread records zones into its own fixed-capacity ring buffer (no lock on the hot path)
+	// - zone names must outlive the profiler (string literal or Intern)
+	// - UBPA_UTOPIA_PROFILE_* macros are compiled in by the CMake option Utopia_USE_PROFILER
+	class Profiler {
+	public:
+		static Profiler& Instance() noexcept {
+			static Profiler instance;
+			return instance;
+		}
+
+		struct Zone {
+			const char* name{ nullptr };
+			const char* counterName{ nullptr };
+			int64_t counter{ 0 };
+			uint64_t begin{ 0 }; // ns
+			uint64_t end{ 0 }; // ns
+			uint32_t threadID{ 0 };
+			uint32_t depth{ 0 };
+		};
+
+		struct ZoneStats {
+			std::string_view name;
+			size_t count{ 0 };
+			double totalMs{ 0. };
+			double meanMs{ 0. };
+			double minMs{ 0. };
+			double maxMs{ 0. };
+			double lastMs{ 0. };
+		};
+
+		// steady clock, in ns
+		static uint64_t Now() noexcept;
+
+		// cheap timestamp of the ring buffers (TSC on x86-64, else Now())
+		// Collect converts it to ns against the steady clock
+		static uint64_t Ticks() noexcept;
+
+		void SetEnabled(bool enabled) noexcept;
+		bool IsEnabled() const noexcept;
+
+		// capacity (power of 2) of ring buffers created after this call
+		void SetThreadBufferCapacity(size_t capacity);
+
+		// thread safe, return a c string with static storage duration
+		const char* Intern(std::string_view name);
+
+		// thread safe, zone.begin and zone.end are in Ticks()
+		void Record(const Zone& zone) noexcept;
+
+		// thread safe
+		// zones still in the ring buffers (begin and end in ns), sorted by begin
+		std::vector<Zone> Collect() const;
+
+		// thread safe
+		// statistics of zones ended in the last <window> ns, sorted by total time
+		std::vector<ZoneStats> GetStats(uint64_t window = 1000000000) const;
+
+		// Chrome trace / Perfetto JSON
+		std::string DumpChromeTrace() const;
+		bool ExportChromeTrace(const std::filesystem::path& path) const;
+
+		// drop the recorded zones
+		void Clear();
+
+	private:
+		friend class ProfileScope;
+
+		Profiler();
+		~Profiler();
+
+		struct Impl;
+		Impl* pImpl;
+	};
+
+	class ProfileScope {
+	public:
+		explicit ProfileScope(const char* name) noexcept;
+		~ProfileScope();
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+		void SetCounter(const char* name, int64_t value) noexcept;
+
+		// set the counter of the innermost scope of current thread
+		static void SetCurrentCounter(const char* name, int64_t value) noexcept;
+
+	private:
+		Profiler::Zone zone;
+		ProfileScope* outer{ nullptr };
+		details::ProfilerThreadBuffer* buffer{ nullptr }; // nullptr if disabled
+	};
+}
+
+#ifdef UBPA_UTOPIA_USE_PROFILER
+#define UBPA_UTOPIA_PROFILE_CONCAT_IMPL(a, b) a##b
+#define UBPA_UTOPIA_PROFILE_CONCAT(a, b) UBPA_UTOPIA_PROFILE_CONCAT_IMPL(a, b)
+#define UBPA_UTOPIA_PROFILE_SCOPE(name) \
+	::Ubpa::Utopia::ProfileScope UBPA_UTOPIA_PROFILE_CONCAT(utopia_profile_scope_, __LINE__){ name }
+#define UBPA_UTOPIA_PROFILE_COUNTER(name, value) \
+	::Ubpa::Utopia::ProfileScope::SetCurrentCounter(name, static_cast<int64_t>(value))
+#define UBPA_UTOPIA_PROFILE_INTERN(name) ::Ubpa::Utopia::Profiler::Instance().Intern(name)
+#else
+// name is still evaluated, so an interned name captured for a scope is not an unused variable
+#define UBPA_UTOPIA_PROFILE_SCOPE(name) ((void)(name))
+#define UBPA_UTOPIA_PROFILE_COUNTER(name, value) ((void)0)
+#define UBPA_UTOPIA_PROFILE_INTERN(name) static_cast<const char*>(nullptr)
+#endif // UBPA_UTOPIA_USE_PROFILER
@@ -1,25 +1,108 @@
+#pragma once
+
 #include <spdlog/sinks/base_sink.h>
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/details/null_mutex.h>
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <string>
-#include <deque>
+#include <string_view>
+#include <vector>
 
 namespace Ubpa::Utopia {
-	class StringsSink : public spdlog::sinks::base_sink<std::mutex> {
+	// bounded sink
+	// - producers (any thread) push raw records into a fixed-capacity MPSC ring without lock,
+	//   a record is dropped if the ring is full
+	// - readers drain the ring into a bounded history (the oldest records are evicted)
+	//   and format the records lazily on first read
+	class StringsSink : public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
 	public:
-		// not thread safe
-		const std::deque<std::string>& GetLogs() const noexcept { return logs; }
+		// capacity: size of the ring (rounded up to power of 2)
+		// historyCapacity: max number of records kept for readers
+		explicit StringsSink(size_t capacity = 4096, size_t historyCapacity = 16384);
+		virtual ~StringsSink();
+
+		struct Log {
+			uint64_t id; // monotonic, unique in the sink
+			spdlog::level::level_enum level;
+			spdlog::log_clock::time_point time;
+			size_t threadID;
+			std::string_view text; // formatted, valid during the call
+		};
+
+		// thread safe
+		// call func(const Log&) on every log in the history, from old to new
+		template<typename Func>
+		void ForEach(Func&& func);
+
+		// thread safe
+		// call func(const Log&) on the logs whose id >= beginID
+		template<typename Func>
+		void ForEachSince(uint64_t beginID, Func&& func);
+
+		// thread safe
+		// call func(const Log&) on the logs of the sorted ids (skip the evicted ones)
+		template<typename Func>
+		void ForEachOf(const uint64_t* ids, size_t num, Func&& func);
 
 		// thread safe
-		std::vector<std::string> CopyLogs() const noexcept;
-		
+		std::vector<std::string> CopyLogs();
+
 		// thread safe
 		void Clear();
 
+		// records dropped because the ring was full
+		uint64_t GetDroppedNum() const noexcept { return droppedNum.load(std::memory_order_relaxed); }
+		// records evicted from the history
+		uint64_t GetEvictedNum() const noexcept { return evictedNum.load(std::memory_order_relaxed); }
+		// id of the next record in the history, increase monotonically (not reset by Clear)
+		uint64_t GetNextID() const noexcept { return nextID.load(std::memory_order_relaxed); }
+		// thread safe
+		// id of the oldest record in the history, logs with smaller id are evicted or cleared
+		uint64_t GetFirstID();
+
 	protected:
 		virtual void sink_it_(const spdlog::details::log_msg& msg) override;
 		virtual void flush_() override {}
+		virtual void set_pattern_(const std::string& pattern) override;
+		virtual void set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter) override;
+
 	private:
-		std::deque<std::string> logs;
+		struct Slot {
+			std::atomic<size_t> sequence;
+			spdlog::details::log_msg_buffer msg;
+		};
+
+		struct Entry {
+			uint64_t id;
+			spdlog::details::log_msg_buffer msg;
+			std::string text;
+			bool formatted{ false };
+		};
+
+		// called under readMutex
+		void Drain();
+		Log Read(Entry& entry);
+
+		// ring
+		std::unique_ptr<Slot[]> slots;
+		const size_t mask;
+		alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+		alignas(64) size_t dequeuePos{ 0 };
+
+		// history
+		std::mutex readMutex; // history, formatter
+		std::deque<Entry> history;
+		const size_t historyCapacity;
+
+		std::atomic<uint64_t> droppedNum{ 0 };
+		std::atomic<uint64_t> evictedNum{ 0 };
+		std::atomic<uint64_t> nextID{ 0 };
 	};
 }
+
+#include "details/StringsSink.inl"
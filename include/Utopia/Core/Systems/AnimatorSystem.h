@@ -0,0 +1,14 @@
+#pragma once
+
+#include <UECS/World.h>
+
+namespace Ubpa::Utopia {
+	// samples the clips of the Animators in parallel, then writes the poses to the Translation / Rotation / Scale
+	// of their AnimationTargets, before the TRS systems of the same frame
+	struct AnimatorSystem {
+		static constexpr char SystemFuncName[] = "AnimatorSystem";
+		static constexpr char TargetFuncName[] = "AnimatorSystem Targets";
+
+		static void OnUpdate(UECS::Schedule& schedule);
+	};
+}
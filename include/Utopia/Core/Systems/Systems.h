@@ -1,5 +1,6 @@
 #pragma once
 
+#include "AnimatorSystem.h"
 #include "InputSystem.h"
 #include "LocalToParentSystem.h"
 #include "RoamerSystem.h"
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+
+namespace Ubpa::Utopia::details {
+	// threads of the persistent pool (ParallelFor.cpp), the calling thread included
+	size_t ParallelForThreadNum() noexcept;
+	// task(ctx, begin, end) on the chunks of [0, num) in the pool and the calling thread
+	// return false (nothing is run) if the pool is running another loop (nested or concurrent call)
+	bool ParallelForChunks(size_t num, size_t chunkSize, void(*task)(const void*, size_t, size_t), const void* ctx);
+}
+
+namespace Ubpa::Utopia {
+	template<typename Func>
+	void ParallelFor(size_t num, size_t minChunkSize, const Func& func) {
+		minChunkSize = std::max<size_t>(minChunkSize, 1);
+		const size_t threadNum = std::min<size_t>(
+			details::ParallelForThreadNum(),
+			(num + minChunkSize - 1) / minChunkSize
+		);
+		if (threadNum <= 1) {
+			func(size_t{ 0 }, num);
+			return;
+		}
+
+		const size_t chunkSize = (num + threadNum - 1) / threadNum;
+		auto task = [](const void* ctx, size_t begin, size_t end) {
+			(*static_cast<const Func*>(ctx))(begin, end);
+		};
+		if (!details::ParallelForChunks(num, chunkSize, task, &func))
+			func(size_t{ 0 }, num);
+	}
+}
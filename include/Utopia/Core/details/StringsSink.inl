@@ -0,0 +1,41 @@
+#pragma once
+
+namespace Ubpa::Utopia {
+	template<typename Func>
+	void StringsSink::ForEach(Func&& func) {
+		ForEachSince(0, std::forward<Func>(func));
+	}
+
+	template<typename Func>
+	void StringsSink::ForEachSince(uint64_t beginID, Func&& func) {
+		std::lock_guard<std::mutex> lock(readMutex);
+		Drain();
+		if (history.empty())
+			return;
+
+		const uint64_t frontID = history.front().id;
+		const size_t offset = beginID > frontID ? static_cast<size_t>(beginID - frontID) : 0;
+		for (size_t i = offset; i < history.size(); i++) {
+			const Log log = Read(history[i]);
+			func(log);
+		}
+	}
+
+	template<typename Func>
+	void StringsSink::ForEachOf(const uint64_t* ids, size_t num, Func&& func) {
+		std::lock_guard<std::mutex> lock(readMutex);
+		if (history.empty())
+			return;
+
+		const uint64_t frontID = history.front().id;
+		for (size_t i = 0; i < num; i++) {
+			if (ids[i] < frontID)
+				continue;
+			const size_t idx = static_cast<size_t>(ids[i] - frontID);
+			if (idx >= history.size())
+				break;
+			const Log log = Read(history[idx]);
+			func(log);
+		}
+	}
+}
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "Camera.h"
+#include "LODGroup.h"
 #include "Light.h"
 #include "MeshFilter.h"
 #include "MeshRenderer.h"
+#include "Skeleton.h"
+#include "SkinnedMesh.h"
 #include "Skybox.h"
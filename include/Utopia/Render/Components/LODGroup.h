@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+namespace Ubpa::Utopia {
+	// selects a level of the MeshFilter's mesh (Mesh::GetLODSubMeshes) by the size of the object on the screen
+	struct LODGroup {
+		// screen size (projected height of the submesh bounds / viewport height) below which level i switches to level i + 1
+		// descending, levels beyond the mesh's LODs use its coarsest level
+		std::vector<float> screenSizes{ 0.5f, 0.25f, 0.125f };
+		// a switch needs the screen size to cross a threshold by this fraction of it, avoids popping at the thresholds
+		[[interval(std::pair{0.f, 1.f})]]
+		float hysteresis{ 0.1f };
+
+		// the selected level is kept per camera by the render pipeline (PipelineCore)
+	};
+}
+
+#include "details/LODGroup_AutoRefl.inl"
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <UECS/Entity.h>
+
+#include <UGM/transform.h>
+
+#include <vector>
+
+namespace Ubpa::Utopia {
+	// the bones of the SkinnedMesh of the entity, posed by the LocalToWorld of their entities
+	// (a Parent / Children hierarchy, usually under the skinned entity)
+	struct Skeleton {
+		// bone i is the index i of Mesh::GetBoneIndices()
+		std::vector<UECS::Entity> bones;
+		// per bone, from the bind pose of the mesh to the space of the bone
+		std::vector<transformf> inverseBindMatrices;
+	};
+}
+
+#include "details/Skeleton_AutoRefl.inl"
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "../Mesh.h"
+
+namespace Ubpa::Utopia {
+	// deformed by the SkinningSystem with the Skeleton of the entity
+	// the result is written to an instance of the mesh, drawn instead of the mesh of the MeshFilter
+	struct SkinnedMesh {
+		// bind pose, with the bone weights
+		std::shared_ptr<Mesh> mesh;
+		// per entity, written by the SkinningSystem
+		std::shared_ptr<Mesh> instance;
+	};
+}
+
+#include "details/SkinnedMesh_AutoRefl.inl"
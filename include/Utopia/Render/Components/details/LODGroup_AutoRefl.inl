@@ -0,0 +1,22 @@
+// This file is generated by Ubpa::USRefl::AutoRefl
+
+#pragma once
+
+#include <USRefl/USRefl.h>
+
+template<>
+struct Ubpa::USRefl::TypeInfo<Ubpa::Utopia::LODGroup>
+    : Ubpa::USRefl::TypeInfoBase<Ubpa::Utopia::LODGroup>
+{
+    static constexpr AttrList attrs = {};
+
+    static constexpr FieldList fields = {
+        Field{"screenSizes", &Ubpa::Utopia::LODGroup::screenSizes},
+        Field{"hysteresis", &Ubpa::Utopia::LODGroup::hysteresis,
+            AttrList{
+                Attr{"interval", std::pair{0.f,1.f}},
+            }
+        },
+    };
+};
+
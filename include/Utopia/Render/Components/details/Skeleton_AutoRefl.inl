@@ -0,0 +1,18 @@
+// This file is generated by Ubpa::USRefl::AutoRefl
+
+#pragma once
+
+#include <USRefl/USRefl.h>
+
+template<>
+struct Ubpa::USRefl::TypeInfo<Ubpa::Utopia::Skeleton>
+    : Ubpa::USRefl::TypeInfoBase<Ubpa::Utopia::Skeleton>
+{
+    static constexpr AttrList attrs = {};
+
+    static constexpr FieldList fields = {
+        Field{"bones", &Ubpa::Utopia::Skeleton::bones},
+        Field{"inverseBindMatrices", &Ubpa::Utopia::Skeleton::inverseBindMatrices},
+    };
+};
+
@@ -0,0 +1,18 @@
+// This file is generated by Ubpa::USRefl::AutoRefl
+
+#pragma once
+
+#include <USRefl/USRefl.h>
+
+template<>
+struct Ubpa::USRefl::TypeInfo<Ubpa::Utopia::SkinnedMesh>
+    : Ubpa::USRefl::TypeInfoBase<Ubpa::Utopia::SkinnedMesh>
+{
+    static constexpr AttrList attrs = {};
+
+    static constexpr FieldList fields = {
+        Field{"mesh", &Ubpa::Utopia::SkinnedMesh::mesh},
+        Field{"instance", &Ubpa::Utopia::SkinnedMesh::instance},
+    };
+};
+
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../VertexLayout.h"
+
 #include <d3d12.h>
 
 #include <vector>
@@ -18,6 +20,8 @@ namespace Ubpa::Utopia {
 	uv2
 	uv3
 	uv4
+
+	stream i of the VertexLayout is bound to input slot i
 	*/
 	class MeshLayoutMngr {
 	public:
@@ -32,11 +36,15 @@ namespace Ubpa::Utopia {
 			bool uv,
 			bool normal,
 			bool tangent,
-			bool color
+			bool color,
+			VertexLayout layout = VertexLayout::Interleaved,
+			VertexCompression compression = VertexCompression::None
 		) noexcept;
 
 		// uv, normal, tangent, color
 		static constexpr std::array<bool, 4> DecodeMeshLayoutID(size_t ID) noexcept;
+		static constexpr VertexLayout DecodeMeshLayoutIDVertexLayout(size_t ID) noexcept;
+		static constexpr VertexCompression DecodeMeshLayoutIDVertexCompression(size_t ID) noexcept;
 
 		static size_t GetMeshLayoutID(const Mesh& mesh) noexcept;
 
@@ -48,7 +56,9 @@ namespace Ubpa::Utopia {
 			bool uv,
 			bool normal,
 			bool tangent,
-			bool color
+			bool color,
+			VertexLayout layout,
+			VertexCompression compression
 		);
 
 		std::unordered_map<size_t, std::vector<D3D12_INPUT_ELEMENT_DESC>> layoutMap;
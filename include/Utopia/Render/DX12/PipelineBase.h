@@ -1,5 +1,8 @@
 #pragma once
 
+#include "../DrawStream.h"
+#include "../PipelineCore.h"
+
 #include <UDX12/UDX12.h>
 
 #include <UECS/Entity.h>
@@ -7,6 +10,7 @@
 #include <unordered_map>
 #include <map>
 #include <set>
+#include <string>
 #include <unordered_set>
 #include <vector>
 
@@ -28,12 +32,7 @@ namespace Ubpa::Utopia {
 			ID3D12CommandQueue* cmdQueue;
 			DXGI_FORMAT rtFormat;
 		};
-		struct CameraData {
-			CameraData(UECS::Entity entity, const UECS::World& world)
-				: entity{ entity }, world{ world } {}
-			UECS::Entity entity;
-			const UECS::World& world;
-		};
+		using CameraData = RenderCamera;
 
 		PipelineBase(InitDesc initDesc) : initDesc{ initDesc } {}
 
@@ -74,14 +73,33 @@ namespace Ubpa::Utopia {
 			const std::unordered_set<const Material*>& materials,
 			const std::set<std::string_view>& commonCBs
 		);
-		static void SetGraphicsRoot_CBV_SRV(
-			ID3D12GraphicsCommandList* cmdList,
+		// root parameter of a shader resource, resolved from the reflection of all passes
+		struct RootBindingSlot {
+			enum class Source {
+				CB, // material CB (by register) or common CB (by name)
+				Texture, // material property or common SRV (by name)
+				BufferSRV // common structured buffer (by name)
+			};
+			Source source;
+			UINT rootParamIndex;
+			std::string name;
+			UINT bindPoint;
+			D3D_SRV_DIMENSION dimension;
+		};
+		// depends only on the shader, cache it per shader
+		static std::vector<RootBindingSlot> GetRootBindingSlots(const Shader& shader);
+		// append the values of the slots for the material
+		static void ResolveRootBindings(
+			std::vector<RootBinding>& bindings,
+			const std::vector<RootBindingSlot>& slots,
 			ShaderCBMngrDX12& shaderCBMngr,
 			const ShaderCBDesc& shaderCBDescconst,
 			const Material& material,
 			const std::map<std::string_view, D3D12_GPU_VIRTUAL_ADDRESS>& commonCBs,
-			const std::map<std::string_view, D3D12_GPU_DESCRIPTOR_HANDLE>& commonSRVs
+			const std::map<std::string_view, D3D12_GPU_DESCRIPTOR_HANDLE>& commonSRVs,
+			const std::map<std::string_view, D3D12_GPU_VIRTUAL_ADDRESS>& commonBufferSRVs = {}
 		);
+		static void SetGraphicsRoot(ID3D12GraphicsCommandList* cmdList, const RootBinding* bindings, size_t num);
 
 		static void SetPSODescForRenderState(D3D12_GRAPHICS_PIPELINE_STATE_DESC&, const RenderState&);
 
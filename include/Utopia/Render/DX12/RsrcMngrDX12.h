@@ -1,5 +1,8 @@
 #pragma once
 
+#include "../ShaderCBLayout.h"
+#include "../VertexLayout.h"
+
 #include <UDX12/UDX12.h>
 
 #include <array>
@@ -21,7 +24,8 @@ namespace Ubpa::Utopia {
 		DirectX::ResourceUploadBatch& GetUpload() const;
 		UDX12::ResourceDeleteBatch& GetDeleteBatch() const;
 
-		RsrcMngrDX12& Init(ID3D12Device* device);
+		// numFrame: number of frame resources (frames in flight)
+		RsrcMngrDX12& Init(ID3D12Device* device, size_t numFrame);
 		void Clear();
 
 		RsrcMngrDX12& RegisterTexture2D(
@@ -37,6 +41,8 @@ namespace Ubpa::Utopia {
 		// - (maybe) construct resized upload buffer
 		// - (maybe) construct resized default buffer
 		// - (maybe) cpu buffer -> upload buffer
+		// - (maybe) updated byte ranges -> the next of the numFrame dynamic vertex buffers,
+		//   for an editable mesh updated in place (Mesh::IsUpdatedInPlace()), at most once per frame
 		// [async]
 		// - (maybe) upload buffer -> default buffer
 		// - (maybe) delete upload buffer
@@ -51,9 +57,14 @@ namespace Ubpa::Utopia {
 
 		const ID3DBlob* GetShaderByteCode_vs(const Shader& shader, size_t passIdx) const;
 		const ID3DBlob* GetShaderByteCode_ps(const Shader& shader, size_t passIdx) const;
+		// vertex shader for VertexCompression::Compact meshes, compiled on first use with VERTEX_COMPRESSION_COMPACT defined
+		// nullptr if it reads more than 2 components of NORMAL or TENGENT (can't decode the octahedral float2)
+		const ID3DBlob* GetShaderByteCode_vs_Compact(const Shader& shader, size_t passIdx);
 		ID3D12ShaderReflection* GetShaderRefl_vs(const Shader& shader, size_t passIdx) const;
 		ID3D12ShaderReflection* GetShaderRefl_ps(const Shader& shader, size_t passIdx) const;
 		ID3D12RootSignature* GetShaderRootSignature(const Shader& shader) const;
+		// constant buffers of all passes (vs, ps), converted from the reflection once in RegisterShader
+		const ShaderCBReflection& GetShaderCBRefl(const Shader& shader) const;
 
 		size_t RegisterPSO(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc);
 
@@ -66,6 +77,18 @@ namespace Ubpa::Utopia {
 
 		UDX12::MeshGPUBuffer& GetMeshGPUBuffer(const Mesh& mesh) const;
 
+		// views of the vertex streams (input slot i <- vertexBuffers[i]) and of the index buffer
+		// the streams share the vertex buffer of the MeshGPUBuffer
+		// for VertexLayout::PositionSplit and VertexLayout::Split, vertexBuffers[0] only contains the positions,
+		// position-only passes (depth, shadow) can bind it alone
+		// updated in RegisterMesh, the address is stable until the mesh is unregistered
+		struct MeshBufferViews {
+			std::array<D3D12_VERTEX_BUFFER_VIEW, VertexStreams::MaxStreamNum> vertexBuffers;
+			UINT vertexBufferNum{ 0 };
+			D3D12_INDEX_BUFFER_VIEW indexBuffer;
+		};
+		const MeshBufferViews& GetMeshBufferViews(const Mesh& mesh) const;
+
 		ID3D12PipelineState* GetPSO(size_t id) const;
 
 		// 1. point wrap
@@ -1,7 +1,12 @@
 #pragma once
 
+#include "../ShaderCBLayout.h"
+
 #include <UDX12/UploadBuffer.h>
 
+#include <deque>
+#include <set>
+#include <string>
 #include <unordered_map>
 
 namespace Ubpa::Utopia {
@@ -16,8 +21,18 @@ namespace Ubpa::Utopia {
 		~ShaderCBMngrDX12();
 		UDX12::DynamicUploadBuffer* GetBuffer(const Shader& shader);
 		UDX12::DynamicUploadBuffer* GetCommonBuffer();
+		// persistent, the content is kept across frames (grow with Reserve)
+		UDX12::DynamicUploadBuffer* GetObjectBuffer();
+		// built on first use for every (shader, commonCBs) pair, the shader must be registered in RsrcMngrDX12
+		const ShaderCBLayout& GetLayout(const Shader& shader, const std::set<std::string_view>& commonCBs);
 	private:
 		std::unordered_map<size_t, UDX12::DynamicUploadBuffer*> bufferMap;
+		struct LayoutEntry {
+			std::set<std::string, std::less<>> commonCBs;
+			ShaderCBLayout layout;
+		};
+		// shader ID -> layouts (one per set of common constant buffers, usually only one)
+		std::unordered_map<size_t, std::deque<LayoutEntry>> layoutMap; // deque keeps the returned references valid
 		ID3D12Device* device;
 	};
 }
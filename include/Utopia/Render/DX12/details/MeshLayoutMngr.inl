@@ -5,13 +5,17 @@ namespace Ubpa::Utopia {
 		bool uv,
 		bool normal,
 		bool tangent,
-		bool color
+		bool color,
+		VertexLayout layout,
+		VertexCompression compression
 	) noexcept {
 		size_t rst = 0;
 		rst |= (static_cast<size_t>(uv     ) << 0);
 		rst |= (static_cast<size_t>(normal ) << 1);
 		rst |= (static_cast<size_t>(tangent) << 2);
 		rst |= (static_cast<size_t>(color  ) << 3);
+		rst |= (static_cast<size_t>(layout     ) << 4);
+		rst |= (static_cast<size_t>(compression) << 6);
 		return rst;
 	}
 
@@ -22,4 +26,12 @@ namespace Ubpa::Utopia {
 		bool color   = static_cast<bool>(ID & (1 << 3));
 		return { uv,normal,tangent,color };
 	}
+
+	constexpr VertexLayout MeshLayoutMngr::DecodeMeshLayoutIDVertexLayout(size_t ID) noexcept {
+		return static_cast<VertexLayout>((ID >> 4) & 0b11);
+	}
+
+	constexpr VertexCompression MeshLayoutMngr::DecodeMeshLayoutIDVertexCompression(size_t ID) noexcept {
+		return static_cast<VertexCompression>((ID >> 6) & 0b11);
+	}
 }
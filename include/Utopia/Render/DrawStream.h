@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	// value of a root parameter
+	struct RootBinding {
+		enum class Type : uint32_t {
+			CBV, // GPU virtual address
+			SRV, // GPU virtual address
+			DescriptorTable // GPU descriptor handle
+		};
+		Type type;
+		uint32_t slot; // root parameter index
+		uint64_t value;
+	};
+
+	// full state of a draw, the handles are opaque to the stream
+	struct DrawState {
+		uint64_t rootSignature{ 0 };
+		uint64_t pso{ 0 };
+		uint64_t mesh{ 0 }; // vertex and index buffers
+		bool stencilEnable{ false };
+		uint32_t stencilRef{ 0 };
+
+		const RootBinding* bindings{ nullptr };
+		size_t bindingNum{ 0 };
+
+		uint32_t indexCount{ 0 };
+		uint32_t instanceCount{ 1 };
+		uint32_t startIndex{ 0 };
+		int32_t baseVertex{ 0 };
+	};
+
+	// one step of the replay, only the changed state is set
+	struct DrawRecord {
+		enum Flag : uint32_t {
+			SetRootSignature = 1 << 0, // reset the root bindings
+			SetPSO = 1 << 1,
+			SetMesh = 1 << 2,
+			SetStencilRef = 1 << 3,
+		};
+		uint32_t flags;
+		uint64_t rootSignature;
+		uint64_t pso;
+		uint64_t mesh;
+		uint32_t stencilRef;
+
+		// changed bindings, in DrawStream::GetBindings()
+		uint32_t bindingOffset;
+		uint32_t bindingNum;
+
+		uint32_t indexCount;
+		uint32_t instanceCount;
+		uint32_t startIndex;
+		int32_t baseVertex;
+	};
+	static_assert(std::is_trivially_copyable_v<DrawRecord>);
+
+	// flat draw records built from the full states of the sorted draws with redundant-state elimination,
+	// the replay is a linear loop over the records
+	class DrawStream {
+	public:
+		void Clear();
+		void Add(const DrawState& state);
+
+		const std::vector<DrawRecord>& GetRecords() const noexcept { return records; }
+		const std::vector<RootBinding>& GetBindings() const noexcept { return bindings; }
+
+		struct Stats {
+			size_t draws{ 0 };
+			size_t rootSignatureChanges{ 0 };
+			size_t psoChanges{ 0 };
+			size_t meshChanges{ 0 };
+			size_t stencilRefChanges{ 0 };
+			size_t bindings{ 0 }; // recorded
+			size_t skippedBindings{ 0 }; // redundant
+		};
+		const Stats& GetStats() const noexcept { return stats; }
+
+	private:
+		std::vector<DrawRecord> records;
+		std::vector<RootBinding> bindings;
+		Stats stats;
+
+		// current state of the replay
+		bool hasState{ false };
+		uint64_t rootSignature{ 0 };
+		uint64_t pso{ 0 };
+		uint64_t mesh{ 0 };
+		bool hasStencilRef{ false };
+		uint32_t stencilRef{ 0 };
+		std::vector<uint8_t> slotBound; // slot -> bound since the last root signature change
+		std::vector<uint64_t> slotValues;
+	};
+}
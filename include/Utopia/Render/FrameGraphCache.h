@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	// order-dependent hash of the registered frame graph nodes and edges,
+	// and of the parameters of the plan (e.g. the size of the targets)
+	class FrameGraphTopology {
+	public:
+		void Clear() noexcept;
+
+		void AddResourceNode(std::string_view name) noexcept;
+		void AddPassNode(std::string_view name, const std::vector<size_t>& inputs, const std::vector<size_t>& outputs) noexcept;
+		void AddMoveNode(size_t dst, size_t src) noexcept;
+		void AddParam(uint64_t value) noexcept;
+
+		uint64_t GetHash() const noexcept { return hash; }
+
+	private:
+		void Combine(const void* data, size_t size) noexcept;
+		void Combine(uint64_t value) noexcept { Combine(&value, sizeof(uint64_t)); }
+
+		uint64_t hash{ 14695981039346656037ull }; // FNV-1a
+	};
+
+	// keep the last compiled result, recompile only when the topology hash changes
+	template<typename Result>
+	class FrameGraphCache {
+	public:
+		// compile: () -> std::tuple<bool, Result>, the result is cached if it succeeds
+		// return nullptr if the compilation fails
+		template<typename CompileFunc>
+		const Result* GetOrCompile(uint64_t hash, CompileFunc&& compile);
+
+		void Invalidate() noexcept { result.reset(); }
+
+		size_t GetHitNum() const noexcept { return hitNum; }
+		size_t GetMissNum() const noexcept { return missNum; }
+
+	private:
+		std::optional<Result> result;
+		uint64_t hash{ 0 };
+		size_t hitNum{ 0 };
+		size_t missNum{ 0 };
+	};
+}
+
+#include "details/FrameGraphCache.inl"
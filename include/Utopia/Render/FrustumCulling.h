@@ -0,0 +1,42 @@
+#pragma once
+
+#include <UGM/transform.h>
+#include <UGM/bbox.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	// 6 planes (a, b, c, d) in world space, point p is inside if a * p.x + b * p.y + c * p.z + d >= 0
+	// order: left, right, bottom, top, near, far
+	struct Frustum {
+		std::array<std::array<float, 4>, 6> planes;
+
+		// Gribb-Hartmann, viewProj = proj * view (column vector)
+		// nearClipValue: NDC z of the near plane, 0 (D3D, default) or -1 (OpenGL)
+		static Frustum FromMatrix(const transformf& viewProj, float nearClipValue = 0.f) noexcept;
+	};
+
+	// world-space AABBs in SoA (center / extent) for batched tests
+	struct CullingBounds {
+		std::vector<float> centerX, centerY, centerZ;
+		std::vector<float> extentX, extentY, extentZ;
+
+		size_t Size() const noexcept { return centerX.size(); }
+		void Reserve(size_t n);
+		void Clear() noexcept;
+
+		// transform the local AABB by l2w (Arvo), return the index
+		size_t Add(const bboxf3& localBounds, const transformf& l2w);
+		// add a world-space AABB, return the index
+		size_t Add(const bboxf3& worldBounds);
+	};
+
+	// visible[i] = 1 if bounds i may intersect the frustum (conservative), else 0
+	// SSE path processes 4 bounds per iteration
+	void FrustumCull(const Frustum& frustum, const CullingBounds& bounds, uint8_t* visible) noexcept;
+
+	// reference implementation
+	void FrustumCull_Scalar(const Frustum& frustum, const CullingBounds& bounds, uint8_t* visible) noexcept;
+}
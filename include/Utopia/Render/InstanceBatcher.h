@@ -0,0 +1,49 @@
+#pragma once
+
+#include "RenderQueue.h"
+
+#include <vector>
+
+namespace Ubpa::Utopia {
+	// range of consecutive objects sharing mesh, submesh, material and pass
+	struct InstanceBatch {
+		size_t first; // index of the first object in the sorted list
+		size_t count; // number of instances
+	};
+
+	// CPU-only, groups the sorted objects into instance batches
+	// instance k of a batch is objects[batch.first + k], so the instance array packed by PackInstances
+	// (in the order of the objects) is contiguous per batch
+	class InstanceBatcher {
+	public:
+		explicit InstanceBatcher(size_t maxBatchSize = 256) noexcept;
+
+		void SetMaxBatchSize(size_t maxBatchSize) noexcept;
+		size_t GetMaxBatchSize() const noexcept { return maxBatchSize; }
+
+		static bool IsCompatible(const RenderObject& lhs, const RenderObject& rhs) noexcept;
+
+		// objects must be sorted
+		void Build(const RenderObjectList& objects);
+		const std::vector<InstanceBatch>& GetBatches() const noexcept { return batches; }
+		void Clear() noexcept;
+
+		struct Stats {
+			size_t drawsBefore{ 0 }; // one per object
+			size_t drawsAfter{ 0 }; // one per batch
+			size_t maxInstances{ 0 };
+		};
+		const Stats& GetStats() const noexcept { return stats; }
+
+		// dst[i] = objectData[objects[i].objectIdx]
+		template<typename T>
+		static void PackInstances(const RenderObjectList& objects, const T* objectData, T* dst);
+
+	private:
+		size_t maxBatchSize;
+		std::vector<InstanceBatch> batches;
+		Stats stats;
+	};
+}
+
+#include "details/InstanceBatcher.inl"
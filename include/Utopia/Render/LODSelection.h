@@ -0,0 +1,22 @@
+#pragma once
+
+#include <UGM/point.h>
+
+#include <cstddef>
+
+namespace Ubpa::Utopia {
+	// projected height of a sphere / viewport height, proj11: element (1, 1) of the perspective projection (cot(fovY / 2))
+	// a sphere containing the eye covers the screen (infinity)
+	float ComputeLODScreenSize(const pointf3& center, float radius, const pointf3& eye, float proj11) noexcept;
+
+	// level for a screen size, thresholds[i] is the screen size below which level i switches to level i + 1 (descending)
+	// the level moves away from currentLOD only if the screen size passes a threshold by hysteresis * threshold
+	// return a level in [0, thresholdNum]
+	size_t SelectLOD(
+		float screenSize,
+		size_t currentLOD,
+		const float* thresholds,
+		size_t thresholdNum,
+		float hysteresis
+	) noexcept;
+}
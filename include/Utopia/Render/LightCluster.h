@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Components/Light.h"
+
+#include <UGM/transform.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	// point, spot, rect and disk light (directional lights are not clustered)
+	struct ClusterLight {
+		LightType type{ LightType::Point };
+		pointf3 position; // world space
+		vecf3 dir; // world space, normalized, spot / rect / disk emit along dir
+		float range{ 0.f };
+		float cosHalfOuterSpotAngle{ 0.f }; // spot
+	};
+
+	struct LightClusterDesc {
+		size_t dimX{ 16 };
+		size_t dimY{ 9 };
+		size_t dimZ{ 24 };
+		float fovY{ 1.f }; // radian
+		float aspect{ 1.f };
+		float nearZ{ 0.3f };
+		float farZ{ 1000.f };
+
+		bool operator==(const LightClusterDesc& rhs) const noexcept;
+	};
+
+	// view-space froxel grid (the camera looks along -z), depth slices are exponential
+	// - every cluster has an AABB in view space, separable: x (slice, tile x), y (slice, tile y), z (slice)
+	// - a light is assigned to the clusters whose AABB passes the sphere test,
+	//   the cone test (spot) and the half-space test (rect / disk)
+	// - output: per cluster range into a compact light index list, ready for upload
+	class LightClusterGrid {
+	public:
+		struct Range {
+			uint32_t offset;
+			uint32_t count;
+		};
+
+		// recompute the cluster bounds if desc changes
+		void SetDesc(const LightClusterDesc& desc);
+		const LightClusterDesc& GetDesc() const noexcept { return desc; }
+
+		size_t GetClusterNum() const noexcept { return desc.dimX * desc.dimY * desc.dimZ; }
+		size_t GetClusterIndex(size_t x, size_t y, size_t z) const noexcept { return x + desc.dimX * (y + desc.dimY * z); }
+		// slice of view depth d (> 0): floor(log(d) * logScale + logBias)
+		float GetLogScale() const noexcept { return logScale; }
+		float GetLogBias() const noexcept { return logBias; }
+
+		// lights[i] is referred by index i, SIMD path
+		void Assign(const transformf& view, const ClusterLight* lights, size_t num);
+		// reference, test every light against every cluster
+		void Assign_BruteForce(const transformf& view, const ClusterLight* lights, size_t num);
+
+		const std::vector<Range>& GetRanges() const noexcept { return ranges; }
+		const std::vector<uint32_t>& GetLightIndices() const noexcept { return lightIndices; }
+
+	private:
+		struct ViewLight {
+			LightType type;
+			float x, y, z; // view space position
+			float dx, dy, dz; // view space direction
+			float range;
+			float cosAngle, sinAngle; // spot
+		};
+
+		void TransformLights(const transformf& view, const ClusterLight* lights, size_t num);
+		// counting sort the pairs by cluster
+		void BuildRanges();
+
+		LightClusterDesc desc;
+		bool valid{ false };
+		float logScale{ 0.f };
+		float logBias{ 0.f };
+
+		// AABB center / extent
+		std::vector<float> xCenter, xExtent; // [z * dimX + x]
+		std::vector<float> yCenter, yExtent; // [z * dimY + y]
+		std::vector<float> zCenter, zExtent; // [z]
+
+		std::vector<ViewLight> viewLights;
+		std::vector<uint32_t> pairClusters;
+		std::vector<uint32_t> pairLights;
+
+		std::vector<Range> ranges;
+		std::vector<uint32_t> lightIndices;
+	};
+}
@@ -3,8 +3,10 @@
 #include "ShaderProperty.h"
 #include "../Core/Object.h"
 
+#include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace Ubpa::Utopia {
 	struct Shader;
@@ -12,6 +14,15 @@ namespace Ubpa::Utopia {
 	struct Material : Object {
 		std::shared_ptr<const Shader> shader;
 		std::map<std::string, ShaderProperty, std::less<>> properties;
+
+		// cache of ShaderCBLayout::GetPacked, validated by the layout and a hash of the packed values,
+		// so writers of properties need no bookkeeping
+		struct PackedCB {
+			size_t layoutID{ static_cast<size_t>(-1) };
+			uint64_t hash{ 0 };
+			std::vector<uint8_t> data;
+		};
+		mutable PackedCB packedCB;
 	};
 }
 
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "SubMeshDescriptor.h"
+#include "VertexLayout.h"
+#include "Meshlet.h"
+#include "TangentSpace.h"
 #include "../Core/Object.h"
 
 #include <UGM/UGM.h>
@@ -8,6 +11,29 @@
 #include <vector>
 
 namespace Ubpa::Utopia {
+	// vertices [first, first + count)
+	struct VertexRange {
+		size_t first;
+		size_t count;
+	};
+
+	// bytes [offset, offset + size) of a buffer
+	struct BufferRange {
+		size_t offset;
+		size_t size;
+	};
+
+	// in-place view of a range of a vertex attribute
+	template<typename T>
+	struct VertexSpan {
+		T* data{ nullptr };
+		size_t size{ 0 };
+
+		T* begin() const noexcept { return data; }
+		T* end() const noexcept { return data + size; }
+		T& operator[](size_t i) const noexcept { return data[i]; }
+	};
+
 	class Mesh : public Object {
 	public:
 		Mesh(bool isEditable = true) : isEditable{ isEditable } {}
@@ -30,13 +56,61 @@ namespace Ubpa::Utopia {
 		void SetSubMeshCount(size_t num);
 		void SetSubMesh(size_t index, SubMeshDescriptor desc);
 
+		// linear blend skinning, 4 bones per vertex (the indices in the Skeleton), the weights sum to 1
+		// deformed on the CPU by the SkinningSystem, they aren't in the vertex buffer
+		const std::vector<valu4>& GetBoneIndices() const noexcept { return boneIndices; }
+		const std::vector<valf4>& GetBoneWeights() const noexcept { return boneWeights; }
+		bool IsSkinned() const noexcept { return !boneWeights.empty(); }
+		// must editable
+		void SetBoneWeights(std::vector<valu4> indices, std::vector<valf4> weights);
+
+		// must editable
+		// edit the vertices [first, first + count) of a present attribute in place, only they are marked dirty
+		// so UpdateVertexBuffer() re-encodes them alone (deforming meshes, terrain brushes, ...)
+		// the span is valid until the attribute is set again, the bounds of the submeshes aren't updated
+		VertexSpan<pointf3> EditPositions(size_t first, size_t count);
+		VertexSpan<pointf2> EditUV(size_t first, size_t count);
+		VertexSpan<normalf> EditNormals(size_t first, size_t count);
+		VertexSpan<vecf3> EditTangents(size_t first, size_t count);
+		VertexSpan<rgbf> EditColors(size_t first, size_t count);
+
+		// level 0 is GetSubMeshes(), the coarser levels index the same vertices
+		// level i has one descriptor per submesh
+		size_t GetLODNum() const noexcept { return 1 + lods.size(); }
+		const std::vector<SubMeshDescriptor>& GetLODSubMeshes(size_t lod) const noexcept { return lod == 0 ? submeshes : lods[lod - 1]; }
+		// must editable
+		// levels 1, 2, ..., their ranges are in GetIndices(), the bounds are the ones of the submeshes
+		void SetLODs(std::vector<std::vector<SubMeshDescriptor>> lods);
+
+		// clusters of the submeshes (level 0), see BuildMeshlets(Mesh&)
+		// SetIndices() and SetSubMeshCount() clear them
+		const MeshletData& GetMeshlets() const noexcept { return meshlets; }
+		// must editable
+		void SetMeshlets(MeshletData meshlets);
+
 		// must editable
+		// normals and tangents of the triangle submeshes, computed in parallel
+		// the triangles around the vertices are cached until the indices or the submeshes change,
+		// so regenerating them for new positions (dynamic meshes) is cheap
 		void GenNormals();
 		void GenUV();
-		void GenTangents();
+		void GenTangents(TangentMode mode = TangentMode::Accumulated);
 
 		void SetToNonEditable() noexcept { isEditable = false; }
 
+		// must editable
+		// the default is VertexLayout::Interleaved
+		void SetVertexLayout(VertexLayout layout);
+		VertexLayout GetVertexLayout() const noexcept { return vertexLayout; }
+
+		// must editable
+		// the default is VertexCompression::None, the attributes of the mesh are kept in float
+		void SetVertexCompression(VertexCompression compression);
+		VertexCompression GetVertexCompression() const noexcept { return vertexCompression; }
+
+		// present attributes, bit i : VertexAttribute i
+		uint32_t GetVertexAttributeMask() const noexcept;
+
 		bool IsDirty() const noexcept { return dirty; }
 
 		bool IsEditable() const noexcept { return isEditable; }
@@ -45,8 +119,28 @@ namespace Ubpa::Utopia {
 		size_t GetVertexBufferVertexCount() const noexcept { return positions.size(); }
 		size_t GetVertexBufferVertexStride() const noexcept { return vertexBuffer.size() / positions.size(); }
 
+		// streams of the vertex buffer, valid after UpdateVertexBuffer()
+		const VertexStreams& GetVertexStreams() const noexcept { return vertexStreams; }
+		// in bytes, from the start of the vertex buffer
+		size_t GetVertexStreamOffset(size_t stream) const noexcept { return vertexStreamOffsets[stream]; }
+		// streams rewritten by the last UpdateVertexBuffer(), bit i : stream i
+		uint32_t GetUpdatedVertexStreams() const noexcept { return updatedVertexStreams; }
+		// bytes of the vertex buffer rewritten by the last UpdateVertexBuffer(), sorted and coalesced
+		const std::vector<BufferRange>& GetUpdatedVertexBufferRanges() const noexcept { return updatedVertexBufferRanges; }
+		// the last UpdateVertexBuffer() kept the arrangement, the size and the indices,
+		// a copy of the buffers is up to date once GetUpdatedVertexBufferRanges() are copied
+		bool IsUpdatedInPlace() const noexcept { return updatedInPlace; }
+
+		// 16-bit indices if the mesh has less than 65536 vertices, else GetIndices()
+		// valid after UpdateVertexBuffer()
+		const void* GetIndexBufferData() const noexcept;
+		size_t GetIndexBufferIndexCount() const noexcept { return indices.size(); }
+		// 2 or 4
+		size_t GetIndexBufferIndexSize() const noexcept { return indices16.empty() ? sizeof(uint32_t) : sizeof(uint16_t); }
+
 		// asset(IsDirty())
 		// call by the engine, need to update GPU buffer
+		// only the streams of the changed attributes are rebuilt
 		void UpdateVertexBuffer();
 
 		// non empty and every attributes have same num
@@ -57,13 +151,37 @@ namespace Ubpa::Utopia {
 		std::vector<normalf> normals;
 		std::vector<vecf3> tangents;
 		std::vector<rgbf> colors;
+		std::vector<valu4> boneIndices;
+		std::vector<valf4> boneWeights;
 		std::vector<uint32_t> indices;
 		std::vector<SubMeshDescriptor> submeshes;
+		std::vector<std::vector<SubMeshDescriptor>> lods;
+		MeshletData meshlets;
+		TriangleAdjacency triangleAdjacency; // cache of GetTriangleAdjacency()
 
 		// pos, uv, normal, tangent, color
+		// arranged in streams by vertexLayout
 		std::vector<uint8_t> vertexBuffer;
+		VertexLayout vertexLayout{ VertexLayout::Interleaved };
+		VertexStreams vertexStreams;
+		std::array<size_t, VertexStreams::MaxStreamNum> vertexStreamOffsets{};
+		uint32_t updatedVertexStreams{ 0 };
+		std::vector<BufferRange> updatedVertexBufferRanges;
+		bool updatedInPlace{ false };
+		VertexCompression vertexCompression{ VertexCompression::None };
+		std::vector<uint16_t> indices16;
 
 		bool isEditable;
 		bool dirty{ false };
+		uint32_t dirtyAttributes{ 0 }; // attributes changed since the last UpdateVertexBuffer()
+		// changed vertices of the dirty attributes, empty : all of them
+		std::array<std::vector<VertexRange>, VertexAttributeNum> dirtyVertexRanges;
+		bool dirtyIndices{ false };
+
+		void MarkDirty(VertexAttribute attr) noexcept;
+		void MarkDirty(VertexAttribute attr, size_t first, size_t count);
+
+		// of the triangle submeshes
+		const TriangleAdjacency& GetTriangleAdjacency();
 	};
 }
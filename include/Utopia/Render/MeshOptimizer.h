@@ -0,0 +1,59 @@
+#pragma once
+
+#include <UGM/point.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	class Mesh;
+
+	// post-transform vertex cache efficiency, simulated with a FIFO cache
+	// - ACMR: average cache miss ratio, transformed vertices per triangle (0.5 is ideal for a large grid, 3 is the worst)
+	// - ATVR: average transformed vertex ratio, transformed vertices per referenced vertex (1 is ideal)
+	struct VertexCacheStats {
+		float acmr{ 0.f };
+		float atvr{ 0.f };
+	};
+
+	VertexCacheStats AnalyzeVertexCache(
+		const uint32_t* indices,
+		size_t indexCount,
+		size_t vertexCount,
+		size_t cacheSize = 16
+	);
+
+	// the triangle submeshes (level 0) of the mesh, in their current order
+	VertexCacheStats AnalyzeVertexCache(const Mesh& mesh, size_t cacheSize = 16);
+
+	// triangle lists, dst and indices can't overlap, the winding of the triangles is kept
+
+	// Forsyth, linear-speed vertex cache optimisation
+	void OptimizeVertexCache(uint32_t* dst, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	// view-independent overdraw reduction (Sander et al. 2007), run after OptimizeVertexCache
+	// the cache-optimized list is split into clusters, the clusters facing outwards are drawn first
+	// threshold: the ACMR of a cluster may grow up to threshold * the ACMR of the input
+	void OptimizeOverdraw(
+		uint32_t* dst,
+		const uint32_t* indices,
+		size_t indexCount,
+		const pointf3* positions,
+		size_t vertexCount,
+		float threshold = 1.05f
+	);
+
+	// vertices in the order of their first use
+	// remap[old vertex] = new vertex, unused vertices get static_cast<uint32_t>(-1)
+	// return the number of used vertices
+	size_t OptimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	// the triangle submeshes (and their LODs) are reordered one by one, then the vertices of the whole mesh are remapped,
+	// unused vertices are removed and the base vertices become 0
+	// the mesh must be editable, run before UpdateVertexBuffer()
+	struct MeshOptimizationReport {
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+	MeshOptimizationReport OptimizeMesh(Mesh& mesh);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <UGM/point.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	class Mesh;
+
+	// quadric error metric simplification (Garland and Heckbert 1997) of a triangle list
+	// only the indices change, the result indexes the input vertices
+	// - vertices sharing a position (UV / normal seams) collapse in pairs along the seam, both sides keep their attributes
+	// - border vertices only collapse along the border
+	// - seam corners and non-manifold vertices are kept
+	// - collapses flipping a triangle are rejected
+	// - with regions (per vertex), a vertex only collapses onto a vertex of the same region
+	// stops at targetIndexCount or when the next collapse would exceed targetError
+	// the errors are distances relative to the extent of the mesh
+	// return the error of the result
+	float SimplifyIndices(
+		std::vector<uint32_t>& dst,
+		const uint32_t* indices,
+		size_t indexCount,
+		const pointf3* positions,
+		size_t vertexCount,
+		size_t targetIndexCount,
+		float targetError = 1e-2f,
+		const uint32_t* regions = nullptr
+	);
+
+	struct LODGenerationDesc {
+		size_t levelNum{ 4 }; // including level 0
+		float ratio{ 0.5f }; // triangles of level i / triangles of level i - 1
+		float maxError{ 5e-2f }; // of every level, relative to the extent of the mesh
+	};
+
+	// generates the LODs of the triangle submeshes (Mesh::SetLODs), level i is simplified from level i - 1
+	// the other submeshes keep their indices at every level
+	// the levels index the vertices of the mesh, so the bone weights stay valid,
+	// a skinned vertex only collapses onto a vertex with the same main bone (the largest weight)
+	// stops before a level that no submesh can simplify further
+	// the mesh must be editable, run before UpdateVertexBuffer()
+	// return the number of levels of the mesh
+	size_t GenerateLODs(Mesh& mesh, const LODGenerationDesc& desc = {});
+}
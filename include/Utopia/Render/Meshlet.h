@@ -0,0 +1,90 @@
+#pragma once
+
+#include <UGM/UGM.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	class Mesh;
+	struct Frustum;
+
+	// limits of a meshlet, fit the mesh shader output of the common GPUs
+	constexpr size_t MeshletMaxVertices = 64;
+	constexpr size_t MeshletMaxTriangles = 124;
+
+	struct Meshlet {
+		uint32_t vertexOffset{ 0 }; // in MeshletData::vertices
+		uint32_t vertexCount{ 0 };
+		uint32_t triangleOffset{ 0 }; // in MeshletData::triangles, 3 local indices per triangle
+		uint32_t triangleCount{ 0 };
+		// the triangles in the index buffer of the mesh, [indexStart, indexStart + 3 * triangleCount)
+		size_t indexStart{ 0 };
+	};
+
+	// in the local space of the mesh
+	struct MeshletBounds {
+		pointf3 center;
+		float radius{ 0.f };
+		// normal cone, the triangles face away from every eye with
+		// dot(center - eye, coneAxis) >= coneCutoff * |center - eye| + (1 + coneCutoff) * radius
+		vecf3 coneAxis;
+		float coneCutoff{ 1.f }; // sine of the spread of the normals, 1 if they can't be culled together
+	};
+
+	struct MeshletData {
+		std::vector<Meshlet> meshlets;
+		std::vector<MeshletBounds> bounds; // per meshlet
+		std::vector<uint32_t> vertices; // local vertex -> vertex of the mesh (with the base vertex)
+		std::vector<uint8_t> triangles; // local vertices
+		// meshlets of submesh i : [submeshOffsets[i], submeshOffsets[i + 1])
+		std::vector<size_t> submeshOffsets{ 0 };
+
+		bool Empty() const noexcept { return meshlets.empty(); }
+		size_t GetSubMeshMeshletNum(size_t submeshIdx) const noexcept { return submeshOffsets[submeshIdx + 1] - submeshOffsets[submeshIdx]; }
+	};
+
+	// partition a triangle list into meshlets, append them to data
+	// a meshlet grows over the triangles sharing its vertices, the ones adding the fewest vertices and then the nearest first,
+	// the next meshlet starts next to the last one
+	// dst: the triangles in meshlet order (the winding is kept), dst and indices can't overlap
+	// indexStart of the meshlets counts from indexOffset
+	void BuildMeshlets(
+		MeshletData& data,
+		uint32_t* dst,
+		const uint32_t* indices,
+		size_t indexCount,
+		const pointf3* positions,
+		size_t vertexCount,
+		size_t indexOffset = 0,
+		size_t maxVertices = MeshletMaxVertices,
+		size_t maxTriangles = MeshletMaxTriangles
+	);
+
+	// the triangles of every triangle submesh are grouped by meshlet in the index buffer,
+	// the other submeshes get no meshlet
+	// the mesh must be editable, run after OptimizeMesh and before UpdateVertexBuffer()
+	void BuildMeshlets(Mesh& mesh);
+
+	struct MeshletIndexRange {
+		size_t indexStart;
+		size_t indexCount;
+	};
+
+	struct MeshletCullStats {
+		size_t visible{ 0 };
+		size_t frustumCulled{ 0 };
+		size_t backfaceCulled{ 0 };
+	};
+
+	// append the index ranges of the visible meshlets of a submesh, contiguous ranges are merged
+	// frustum and eye in the local space of the mesh, e.g. Frustum::FromMatrix(viewProj * l2w) and w2l * eye
+	// the backface test assumes the local-to-world transform doesn't mirror
+	MeshletCullStats CullMeshlets(
+		std::vector<MeshletIndexRange>& ranges,
+		const MeshletData& data,
+		size_t submeshIdx,
+		const Frustum& frustum,
+		const pointf3& eye
+	);
+}
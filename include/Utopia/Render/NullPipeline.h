@@ -0,0 +1,93 @@
+#pragma once
+
+#include "PipelineCore.h"
+#include "DrawStream.h"
+#include "FrameGraphCache.h"
+
+#include <UFG/UFG.h>
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	// pipeline without GPU, for CPU-side benchmarks and regression tests
+	// it runs the same flow as StdPipeline (extraction, sorting, batching, lights, uploads,
+	// frame graph, draw streams) on a null device that counts the commands and the uploaded bytes
+	// - handles are fake: root signature <- shader, PSO <- (shader, pass, render targets), mesh <- mesh
+	// - material CBs are not uploaded (their layouts come from the shader reflection of the backend)
+	class NullPipeline {
+	public:
+		struct InitDesc {
+			size_t numFrame{ 3 };
+			// StdPipeline uses instancing if the shader declares StdPipeline_srvInstances
+			bool instancing{ true };
+		};
+
+		explicit NullPipeline(InitDesc initDesc);
+
+		void Resize(size_t width, size_t height);
+
+		// run in update
+		void BeginFrame(const std::vector<const UECS::World*>& worlds, const RenderCamera& camera);
+		// run in draw
+		void Render();
+		// run at the end of draw
+		void EndFrame();
+
+		struct Stats {
+			size_t objects{ 0 }; // in the render queue
+			size_t culled{ 0 };
+			size_t draws{ 0 };
+			size_t instances{ 0 };
+			size_t triangles{ 0 }; // of the triangle-list draws, times the instances
+			size_t commands{ 0 }; // recorded on the null device
+			size_t rootSignatureChanges{ 0 };
+			size_t psoChanges{ 0 };
+			size_t meshChanges{ 0 };
+			size_t stencilRefChanges{ 0 };
+			size_t bindings{ 0 };
+			size_t skippedBindings{ 0 };
+			size_t uploadedBytes{ 0 };
+			size_t uploadedObjects{ 0 };
+			size_t frameGraphCompiles{ 0 };
+			size_t frameGraphCacheHits{ 0 };
+
+			Stats& operator+=(const Stats& rhs) noexcept;
+		};
+		// the last frame
+		const Stats& GetFrameStats() const noexcept { return frameStats; }
+		// accumulated since the construction
+		const Stats& GetTotalStats() const noexcept { return totalStats; }
+		size_t GetFrameCount() const noexcept { return frameCount; }
+
+		const PipelineCore& GetCore() const noexcept { return core; }
+
+	private:
+		void CompileDrawStream(DrawStream& stream, std::string_view lightMode, size_t rtNum);
+		void Record(const DrawStream& stream);
+
+		const InitDesc initDesc;
+		size_t width{ 0 };
+		size_t height{ 0 };
+
+		PipelineCore core;
+
+		// null device
+		std::vector<uint8_t> commonBuffer;
+		std::vector<std::vector<uint8_t>> objectBuffers; // per frame resource
+		size_t frameIndex{ 0 };
+
+		UFG::FrameGraph fg;
+		UFG::Compiler fgCompiler;
+		FrameGraphTopology fgTopology;
+		FrameGraphCache<UFG::Compiler::Result> fgCache;
+
+		DrawStream deferredStream;
+		DrawStream forwardStream;
+
+		Stats frameStats;
+		Stats totalStats;
+		size_t frameCount{ 0 };
+	};
+}
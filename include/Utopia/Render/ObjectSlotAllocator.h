@@ -0,0 +1,61 @@
+#pragma once
+
+#include <UECS/Entity.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	// stable slot (index in a persistent object buffer) per renderable entity
+	// - slots of the entities not acquired in a frame are released and reused (free list)
+	// - a dirty slot is uploaded into each of the numFrame frame resources (countdown),
+	//   so a static object costs no upload after numFrame frames
+	class ObjectSlotAllocator {
+	public:
+		explicit ObjectSlotAllocator(size_t numFrame) noexcept;
+
+		// world: index of the world, entities of different worlds get different slots
+		// return the slot of the entity, isNew is true if the slot is (re)allocated (and dirty)
+		size_t Acquire(size_t world, UECS::Entity entity, bool& isNew);
+		// upload the slot into the next numFrame frame resources
+		void MarkDirty(size_t slot);
+		// release the slots not acquired since the last call
+		void ReleaseUnused();
+
+		// sorted and merged dirty ranges [begin, end) to upload into the current frame resource,
+		// call once per frame, countdowns are decreased
+		const std::vector<std::pair<size_t, size_t>>& CollectDirtyRanges();
+
+		// slots are in [0, capacity)
+		size_t GetCapacity() const noexcept { return slots.size(); }
+		size_t GetLiveNum() const noexcept { return slots.size() - freeSlots.size(); }
+		// number of slots in the last collected ranges
+		size_t GetUploadNum() const noexcept { return uploadNum; }
+
+		void Clear();
+
+	private:
+		struct EntitySlot {
+			size_t version{ static_cast<size_t>(-1) };
+			size_t slot{ static_cast<size_t>(-1) };
+		};
+		struct Slot {
+			size_t world{ static_cast<size_t>(-1) }; // -1: free
+			size_t entityIdx{ 0 };
+			uint64_t frame{ 0 }; // last acquired frame
+			uint32_t countdown{ 0 }; // dirty frames left
+		};
+
+		const uint32_t numFrame;
+		uint64_t frame{ 1 };
+
+		std::vector<std::vector<EntitySlot>> entity2slot; // world -> entity index -> slot
+		std::vector<Slot> slots;
+		std::vector<size_t> freeSlots;
+
+		std::vector<size_t> dirtySlots; // countdown > 0
+		std::vector<std::pair<size_t, size_t>> dirtyRanges;
+		size_t uploadNum{ 0 };
+	};
+}
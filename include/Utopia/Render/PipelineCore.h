@@ -0,0 +1,237 @@
+#pragma once
+
+#include "RenderQueue.h"
+#include "FrustumCulling.h"
+#include "InstanceBatcher.h"
+#include "ObjectSlotAllocator.h"
+#include "LightCluster.h"
+
+#include <UECS/Entity.h>
+
+#include <UGM/transform.h>
+#include <UGM/rgb.h>
+#include <UGM/val.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace Ubpa::UECS {
+	class World;
+}
+
+namespace Ubpa::Utopia {
+	struct RenderCamera {
+		RenderCamera(UECS::Entity entity, const UECS::World& world)
+			: entity{ entity }, world{ world } {}
+		UECS::Entity entity;
+		const UECS::World& world;
+	};
+
+	// backend-agnostic CPU side of the standard pipeline
+	// - extraction: culling, persistent object slots, render queue and instance batches
+	// - lights: light array and light clusters
+	// - content of the common buffer (camera, lights, instances, clusters) and of the object buffer
+	// the backends read the extracted data and upload it with their own buffers
+	class PipelineCore {
+	public:
+		static constexpr size_t MaxInstanceBatchSize = 256;
+
+		// layouts match StdPipeline.hlsli
+		struct ObjectConstants {
+			transformf World;
+			transformf InvWorld;
+		};
+		struct CameraConstants {
+			transformf View;
+
+			transformf InvView;
+
+			transformf Proj;
+
+			transformf InvProj;
+
+			transformf ViewProj;
+
+			transformf InvViewProj;
+
+			pointf3 EyePosW;
+			float _pad0;
+
+			valf2 RenderTargetSize;
+			valf2 InvRenderTargetSize;
+
+			float NearZ;
+			float FarZ;
+			float TotalTime;
+			float DeltaTime;
+
+			// light clusters
+			uint32_t ClusterDimX;
+			uint32_t ClusterDimY;
+			uint32_t ClusterDimZ;
+			float ClusterLogScale;
+			float ClusterLogBias;
+		};
+		struct ShaderLight {
+			rgbf color;
+			float range;
+			vecf3 dir;
+			float f0;
+			pointf3 position;
+			float f1;
+			vecf3 horizontal;
+			float f2;
+
+			struct Spot {
+				static constexpr auto pCosHalfInnerSpotAngle  = &ShaderLight::f0;
+				static constexpr auto pCosHalfOuterSpotAngle = &ShaderLight::f1;
+			};
+			struct Rect {
+				static constexpr auto pWidth  = &ShaderLight::f0;
+				static constexpr auto pHeight = &ShaderLight::f1;
+			};
+			struct Disk {
+				static constexpr auto pRadius = &ShaderLight::f0;
+			};
+		};
+		struct LightArray {
+			static constexpr size_t size = 16;
+
+			uint32_t diectionalLightNum{ 0 };
+			uint32_t pointLightNum{ 0 };
+			uint32_t spotLightNum{ 0 };
+			uint32_t rectLightNum{ 0 };
+			uint32_t diskLightNum{ 0 };
+			const uint32_t _g_cbLightArray_pad0{ static_cast<uint32_t>(-1) };
+			const uint32_t _g_cbLightArray_pad1{ static_cast<uint32_t>(-1) };
+			const uint32_t _g_cbLightArray_pad2{ static_cast<uint32_t>(-1) };
+			ShaderLight lights[size];
+		};
+
+		// size of a constant buffer, multiple of 256
+		static constexpr size_t CalcConstantBufferByteSize(size_t size) noexcept { return (size + 255) & ~static_cast<size_t>(255); }
+
+		explicit PipelineCore(size_t numFrame);
+
+		// run in update
+		void Extract(const std::vector<const UECS::World*>& worlds, const RenderCamera& camera, size_t width, size_t height);
+
+		// place the instances and the light clusters in the common buffer, return the size of the buffer
+		size_t LayoutCommonBuffer();
+		// set(offset, data, size) on the whole common buffer, call after LayoutCommonBuffer
+		template<typename SetFunc>
+		void UploadCommonBuffer(SetFunc&& set) const;
+		// set(offset, data, size) on the dirty slots of the object buffer, call once per frame
+		// the buffer must keep the content of the other slots, its size is GetObjectCapacity() * stride
+		template<typename SetFunc>
+		void UploadObjects(size_t stride, SetFunc&& set);
+
+		size_t GetObjectCapacity() const noexcept { return objectSlots.GetCapacity(); }
+		size_t GetUploadedObjectNum() const noexcept { return objectSlots.GetUploadNum(); }
+		size_t GetCulledNum() const noexcept { return culledNum; }
+
+		// extracted data
+
+		RenderQueue renderQueue;
+
+		CameraConstants cameraConstants;
+
+		LightArray lights;
+
+		// common
+		size_t cameraOffset = 0;
+		size_t lightOffset = CalcConstantBufferByteSize(sizeof(CameraConstants));
+		// instance batches of the sorted queue
+		// instances: slots of the opaques then the transparents, in the sorted order, after the lights
+		size_t instanceOffset = CalcConstantBufferByteSize(sizeof(CameraConstants))
+			+ CalcConstantBufferByteSize(sizeof(LightArray));
+		InstanceBatcher opaqueBatcher{ MaxInstanceBatchSize };
+		InstanceBatcher transparentBatcher{ MaxInstanceBatchSize };
+		std::vector<uint32_t> instances; // filled by LayoutCommonBuffer, reused every frame
+
+		// persistent, RenderObject::objectIdx (slot) -> data, a slot is uploaded when it is dirty
+		struct ObjectData {
+			valf<16> l2w;
+			valf<16> w2l;
+		};
+		std::vector<ObjectData> objects;
+
+		// clustered point / spot / rect / disk lights, uploaded after the instances
+		std::vector<ClusterLight> clusterLights;
+		std::vector<ShaderLight> clusterShaderLights;
+		LightClusterGrid lightClusters;
+		size_t clusterLightOffset = 0;
+		size_t clusterRangeOffset = 0;
+		size_t clusterIndexOffset = 0;
+
+	private:
+		void ExtractCamera(const RenderCamera& camera, size_t width, size_t height);
+		void ExtractObjects(const std::vector<const UECS::World*>& worlds);
+		void ExtractLights(const std::vector<const UECS::World*>& worlds, const RenderCamera& camera);
+
+		// per-thread output and scratch of the extraction, reused every frame
+		struct ExtractionBuffer {
+			RenderQueue renderQueue;
+
+			// every renderable entity (culled or not), RenderObject::objectIdx is the local index before the merge
+			struct ObjectRecord {
+				size_t world;
+				UECS::Entity entity;
+				transformf l2w;
+				transformf w2l; // valid if hasW2L
+				bool hasW2L;
+				size_t lod; // selected level of the LODGroup, -1 if the entity has no LODGroup
+			};
+			std::vector<ObjectRecord> objects;
+			std::vector<size_t> slots; // local index -> slot
+
+			// frustum culling, per chunk
+			CullingBounds bounds;
+			std::vector<std::pair<size_t, size_t>> candidates; // (entity index in chunk, submesh index)
+			std::vector<uint8_t> visible;
+			std::vector<transformf> l2ws;
+			std::vector<size_t> objectIndices; // entity index in chunk -> local index
+
+			// LOD selection, per entity in chunk
+			std::vector<float> screenSizes;
+			std::vector<size_t> lods;
+		};
+		std::mutex extractionMutex;
+		std::vector<std::unique_ptr<ExtractionBuffer>> extractionBuffers;
+		std::unordered_map<std::thread::id, ExtractionBuffer*> thread2extractionBuffer;
+		uint64_t extractionID{ 0 }; // of the running ExtractObjects, keys the thread_local cache
+		ExtractionBuffer& GetExtractionBuffer();
+
+		// hysteresis state of the LOD selection, per camera (a level depends on the previous one of the same view)
+		// written in the merge, read-only in the parallel extraction
+		struct LODState {
+			struct Entry {
+				size_t version{ static_cast<size_t>(-1) };
+				size_t lod{ 0 };
+			};
+			std::vector<std::vector<Entry>> entity2lod; // world -> entity index -> selected level
+			uint64_t lastExtraction{ 0 };
+
+			// 0 if the entity has no previous level
+			size_t Get(size_t world, UECS::Entity entity) const noexcept;
+			void Set(size_t world, UECS::Entity entity, size_t lod);
+		};
+		// (world, entity index, entity version) of the camera -> state
+		// a state is dropped if its camera is not rendered in LODStateLifetime extractions
+		static constexpr uint64_t LODStateLifetime = 256;
+		std::map<std::tuple<const UECS::World*, size_t, size_t>, LODState> camera2lodState;
+		LODState* lodState{ nullptr }; // of the camera of the running Extract
+		uint64_t extractNum{ 0 };
+
+		ObjectSlotAllocator objectSlots;
+		size_t culledNum{ 0 };
+	};
+}
+
+#include "details/PipelineCore.inl"
@@ -3,33 +3,110 @@
 #include <UECS/Entity.h>
 #include <UGM/point.h>
 
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
 namespace Ubpa::Utopia {
 	class Mesh;
 	struct Material;
 
+	// trivially copyable packet
+	// the material and the mesh are kept alive by the components during the frame
 	struct RenderObject {
 		UECS::Entity entity;
 
-		std::shared_ptr<const Material> material;
+		const Material* material{ nullptr };
 		size_t passIdx{ static_cast<size_t>(-1) };
 
-		std::shared_ptr<const Mesh> mesh;
+		const Mesh* mesh{ nullptr };
 		size_t submeshIdx{ static_cast<size_t>(-1) };
+		size_t lod{ 0 }; // level of the submesh, Mesh::GetLODSubMeshes
+
+		size_t objectIdx{ static_cast<size_t>(-1) }; // index of the object constants
 
 		vecf3 translation{ 0.f };
+		float depth{ 0.f }; // squared distance from the bounds center to the camera
 	};
+	static_assert(std::is_trivially_copyable_v<RenderObject>);
+
+	// view of the objects of a queue in sorted order, objects[order[i]]
+	// valid until the queue is changed
+	class RenderObjectList {
+	public:
+		class Iterator {
+		public:
+			Iterator(const RenderObject* objects, const uint32_t* cur) noexcept : objects{ objects }, cur{ cur } {}
+			const RenderObject& operator*() const noexcept { return objects[*cur]; }
+			const RenderObject* operator->() const noexcept { return objects + *cur; }
+			Iterator& operator++() noexcept { ++cur; return *this; }
+			bool operator==(const Iterator& rhs) const noexcept { return cur == rhs.cur; }
+			bool operator!=(const Iterator& rhs) const noexcept { return cur != rhs.cur; }
+		private:
+			const RenderObject* objects;
+			const uint32_t* cur;
+		};
+
+		RenderObjectList(const RenderObject* objects, const uint32_t* order, size_t num) noexcept
+			: objects{ objects }, order{ order }, num{ num } {}
 
+		size_t size() const noexcept { return num; }
+		bool empty() const noexcept { return num == 0; }
+		const RenderObject& operator[](size_t i) const noexcept { return objects[order[i]]; }
+		const RenderObject& front() const noexcept { return (*this)[0]; }
+		const RenderObject& back() const noexcept { return (*this)[num - 1]; }
+		Iterator begin() const noexcept { return { objects, order }; }
+		Iterator end() const noexcept { return { objects, order + num }; }
+
+	private:
+		const RenderObject* objects;
+		const uint32_t* order;
+		size_t num;
+	};
+
+	// every object gets a packed 64-bit key when it is added, Sort is a LSD radix sort on the keys
+	// - only the keys and a 32-bit permutation are sorted, the objects stay in place
+	// - opaque     : queue (12) | shader (12) | material (12) | mesh (10) | pass (2) | submesh (3) | lod (3) | depth (10),
+	//                front-to-back, the objects of an instance batch are adjacent
+	// - transparent: queue (13) | inverted depth (24) | shader (12) | material (15), back-to-front
+	// IDs and indices are truncated, a collision only costs a state change or a split batch
 	class RenderQueue {
 	public:
-		void Add(RenderObject object);
-		void Sort(pointf3 cameraPos);
-		const std::vector<RenderObject>& GetOpaques() const noexcept { return opaques; }
-		const std::vector<RenderObject>& GetTransparents() const noexcept { return transparents; }
+		void Add(const RenderObject& object);
+		// append the objects of other, objectIdx += objectIdxOffset
+		void Append(const RenderQueue& other, size_t objectIdxOffset);
+		// append the objects of other, objectIdx = objectIdxMap[objectIdx]
+		void Append(const RenderQueue& other, const size_t* objectIdxMap);
+		void Sort();
+		// in the order of the last Sort, new objects are appended
+		RenderObjectList GetOpaques() const noexcept { return { opaques.data(), opaqueOrder.data(), opaques.size() }; }
+		RenderObjectList GetTransparents() const noexcept { return { transparents.data(), transparentOrder.data(), transparents.size() }; }
 		void Clear();
+
+		static uint64_t OpaqueKey(const RenderObject& object) noexcept;
+		static uint64_t TransparentKey(const RenderObject& object) noexcept;
+
+		// number of changes between adjacent objects, in current order
+		struct StateChanges {
+			size_t shader{ 0 };
+			size_t material{ 0 };
+			size_t mesh{ 0 };
+		};
+		StateChanges CountStateChanges() const noexcept;
+
 	private:
 		std::vector<RenderObject> opaques;
 		std::vector<RenderObject> transparents;
+		// keys[i] is the key of objects[order[i]]
+		std::vector<uint64_t> opaqueKeys;
+		std::vector<uint64_t> transparentKeys;
+		std::vector<uint32_t> opaqueOrder;
+		std::vector<uint32_t> transparentOrder;
+
+		// scratch of Sort
+		std::vector<uint64_t> keysBuffer;
+		std::vector<uint32_t> orderBuffer;
+
+		void Sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& order);
 	};
 }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ShaderProperty.h"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	struct Material;
+
+	// backend-independent view of the constant buffers in the shader reflection
+	struct ShaderCBReflection {
+		struct Variable {
+			std::string name;
+			size_t offset; // in the constant buffer
+			size_t size;
+		};
+		struct ConstantBuffer {
+			std::string name;
+			size_t bindPoint;
+			size_t size;
+			std::vector<Variable> variables;
+		};
+		// constant buffers of all passes and stages, may contain duplicated bind points
+		std::vector<ConstantBuffer> constantBuffers;
+	};
+
+	// layout of the material constant buffers of a shader, resolved once
+	// - every non-common constant buffer (unique bind point) gets a 256-byte aligned region
+	// - a flat table (property name -> offset, size), sorted by name,
+	//   packing is a merge of the table and the sorted properties
+	class ShaderCBLayout {
+	public:
+		ShaderCBLayout() = default;
+		// constant buffers named in commonCBs are skipped
+		ShaderCBLayout(const ShaderCBReflection& refl, const std::set<std::string_view>& commonCBs);
+
+		struct Entry {
+			std::string name;
+			size_t offset; // in the material region
+			size_t size;
+		};
+
+		// size of the material region
+		size_t GetSize() const noexcept { return size; }
+		// bind point -> offset in the material region
+		const std::map<size_t, size_t>& GetOffsetMap() const noexcept { return offsetMap; }
+		const std::vector<Entry>& GetEntries() const noexcept { return entries; }
+		// unique per layout, validates the packed caches of the materials
+		size_t GetID() const noexcept { return id; }
+
+		// write the properties into dst (GetSize() bytes), missing properties are 0
+		// bool is written as uint, textures are skipped, properties of mismatched size are skipped
+		void Pack(const std::map<std::string, ShaderProperty, std::less<>>& properties, uint8_t* dst) const;
+
+		// FNV-1a of the values Pack would write (and their offsets)
+		uint64_t Hash(const std::map<std::string, ShaderProperty, std::less<>>& properties) const noexcept;
+
+		// packed constant buffers of the material, repacked only if the packed values or the layout change
+		const std::vector<uint8_t>& GetPacked(const Material& material) const;
+
+	private:
+		size_t size{ 0 };
+		std::map<size_t, size_t> offsetMap;
+		std::vector<Entry> entries;
+		size_t id{ static_cast<size_t>(-1) };
+	};
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <UGM/UGM.h>
+
+#include <cstdint>
+
+namespace Ubpa::Utopia {
+	class Mesh;
+
+	// affine 3x4 matrix in rows, p' = m * (p, 1)
+	struct SkinMatrix {
+		float m[3][4];
+	};
+
+	// skin[i] = worldToLocal * boneLocalToWorld[i] * inverseBindMatrices[i]
+	// from the bind pose of the mesh to the local space of the skinned entity
+	void ComputeSkinMatrices(
+		SkinMatrix* skin,
+		const transformf* boneLocalToWorld,
+		const transformf* inverseBindMatrices,
+		size_t boneNum,
+		const transformf& worldToLocal
+	);
+
+	// linear blend skinning of the vertices [first, first + count), 4 bones per vertex
+	// normals and tangents are transformed by the blended matrix and renormalized (exact without non-uniform scale),
+	// zero vectors stay zero
+	// normals and tangents (src and dst) can be nullptr, dst can be src
+	// 8 vertices at a time with AVX2 if the CPU supports it (Utopia_USE_AVX2),
+	// the scalar path evaluates the same expressions in the same order
+	void SkinVertices(
+		pointf3* dstPositions,
+		normalf* dstNormals,
+		vecf3* dstTangents,
+		const pointf3* positions,
+		const normalf* normals,
+		const vecf3* tangents,
+		const valu4* boneIndices,
+		const valf4* boneWeights,
+		const SkinMatrix* skin,
+		size_t first,
+		size_t count
+	);
+
+	struct SkinningTask {
+		const Mesh* mesh; // bind pose, with the bone weights
+		const SkinMatrix* skin;
+		size_t boneNum;
+		// a vertex per vertex of the mesh
+		pointf3* positions;
+		normalf* normals; // nullptr : not deformed
+		vecf3* tangents; // nullptr : not deformed
+	};
+
+	// skin every task, in parallel across the meshes and blocks of their vertices
+	void SkinMeshes(const SkinningTask* tasks, size_t num);
+
+	// SkinVertices runs the AVX2 kernel on this CPU (else the scalar one)
+	bool IsSkinningAVX2() noexcept;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "FrameGraphCache.h"
+
+#include <UFG/UFG.h>
+
+namespace Ubpa::Utopia {
+	// nodes of the frame graph of StdPipeline, shared with NullPipeline
+	struct StdFrameGraph {
+		// resources
+		size_t gbuffer0;
+		size_t gbuffer1;
+		size_t gbuffer2;
+		size_t deferLightedRT;
+		size_t deferLightedSkyRT;
+		size_t sceneRT;
+		size_t presentedRT;
+		size_t deferDS;
+		size_t forwardDS;
+		size_t irradianceMap;
+		size_t prefilterMap;
+
+		// passes
+		size_t gbPass;
+		size_t iblPass;
+		size_t deferLightingPass;
+		size_t skyboxPass;
+		size_t forwardPass;
+		size_t postprocessPass;
+
+		// clear fg and topology, then register the nodes into both
+		// the size of the targets is a parameter of the topology
+		static StdFrameGraph Register(UFG::FrameGraph& fg, FrameGraphTopology& topology, size_t width, size_t height);
+	};
+}
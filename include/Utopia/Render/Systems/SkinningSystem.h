@@ -0,0 +1,13 @@
+#pragma once
+
+#include <UECS/World.h>
+
+namespace Ubpa::Utopia {
+	// deforms the SkinnedMesh of the entities with a Skeleton, MeshFilter and LocalToWorld on the CPU
+	// runs as a command, after the transform systems
+	struct SkinningSystem {
+		static constexpr char SystemFuncName[] = "SkinningSystem";
+
+		static void OnUpdate(UECS::Schedule& schedule);
+	};
+}
@@ -1,3 +1,4 @@
 #pragma once
 
 #include "CameraSystem.h"
+#include "SkinningSystem.h"
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <UGM/UGM.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Ubpa::Utopia {
+	// the triangles around every vertex, built once per topology
+	// the normal and tangent generation gathers over it, so the vertices are computed in parallel without races
+	struct TriangleAdjacency {
+		std::vector<uint32_t> indices; // triangle list, with the base vertices
+		// triangles of vertex v : triangles[offsets[v], offsets[v + 1]), in increasing order
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+
+		size_t GetVertexNum() const noexcept { return offsets.empty() ? 0 : offsets.size() - 1; }
+		size_t GetTriangleNum() const noexcept { return indices.size() / 3; }
+	};
+
+	// indices : triangle list of the vertices [0, vertexCount)
+	TriangleAdjacency BuildTriangleAdjacency(std::vector<uint32_t> indices, size_t vertexCount);
+
+	enum class TangentMode {
+		// sum of the UV-scaled face tangents (Lengyel)
+		Accumulated,
+		// weighting of MikkTSpace : unit face tangents projected to the vertex normal, weighted by the corner angle,
+		// degenerate UV triangles skipped
+		// the vertices aren't split, so it matches MikkTSpace where the tangent spaces of a vertex agree
+		MikkTSpace,
+	};
+
+	// area-weighted vertex normals, the vertices without triangles get a zero normal
+	// write adjacency.GetVertexNum() normals
+	void ComputeNormals(normalf* normals, const TriangleAdjacency& adjacency, const pointf3* positions);
+
+	// unit tangents orthogonal to the normals, the sign encodes the handedness : cross(normal, tangent) is the bitangent
+	// write adjacency.GetVertexNum() tangents
+	void ComputeTangents(
+		vecf3* tangents,
+		const TriangleAdjacency& adjacency,
+		const pointf3* positions,
+		const normalf* normals,
+		const pointf2* uv,
+		TangentMode mode = TangentMode::Accumulated
+	);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <UGM/UGM.h>
+
+#include <array>
+#include <cstdint>
+
+namespace Ubpa::Utopia {
+	// encodings of the compressed vertex attributes (VertexCompression)
+	// the decoders match the input assembler (DXGI) conversions
+
+	// IEEE 754 binary16, round to nearest even
+	uint16_t EncodeHalf(float value) noexcept;
+	float DecodeHalf(uint16_t value) noexcept;
+
+	// [-1, 1] <-> [-32767, 32767], round to nearest
+	int16_t EncodeSnorm16(float value) noexcept;
+	float DecodeSnorm16(int16_t value) noexcept;
+
+	// [0, 1] <-> [0, 255], round to nearest, clamped
+	uint8_t EncodeUnorm8(float value) noexcept;
+	float DecodeUnorm8(uint8_t value) noexcept;
+
+	// unit vector <-> octahedral map, 2 x snorm16
+	// the sign of a tangent (the handedness) is kept, it is part of the direction
+	std::array<int16_t, 2> EncodeOctahedral(const vecf3& v) noexcept;
+	vecf3 DecodeOctahedral(const std::array<int16_t, 2>& e) noexcept;
+}
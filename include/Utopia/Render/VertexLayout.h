@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Ubpa::Utopia {
+	// arrangement of the vertex attributes in the vertex buffer of a mesh
+	// the streams are stored one after another in the buffer, stream i is bound to input slot i
+	enum class VertexLayout : uint8_t {
+		Interleaved,   // 1 stream: position, uv, normal, tangent, color
+		PositionSplit, // 2 streams: position | uv, normal, tangent, color
+		Split          // 1 stream per attribute
+	};
+
+	// bit i of an attribute mask
+	enum class VertexAttribute : uint8_t {
+		Position,
+		UV,
+		Normal,
+		Tangent,
+		Color
+	};
+
+	// storage of the attributes in the vertex buffer, the position is always float3
+	enum class VertexCompression : uint8_t {
+		None,     // float2 uv, float3 normal, tangent and color
+		// decoded by the input assembler
+		// - uv: half2
+		// - normal, tangent: snorm16x4 (w: 0 for the normal, 1 for the tangent)
+		// - color: unorm8x4 (clamped to [0, 1], alpha 1)
+		Standard,
+		// Standard, but normal and tangent are octahedral snorm16x2 (float2 in the shader)
+		// drawn with the vertex shader compiled with VERTEX_COMPRESSION_COMPACT,
+		// it decodes them with STD_PIPELINE_DECODE_NORMAL / TANGENT (StdPipeline.hlsli)
+		Compact
+	};
+
+	constexpr size_t VertexAttributeNum = 5;
+	// in bytes, VertexCompression::None
+	constexpr std::array<size_t, VertexAttributeNum> VertexAttributeSizes{ 12, 8, 12, 12, 12 };
+
+	// in bytes
+	constexpr size_t GetVertexAttributeSize(size_t attr, VertexCompression compression) noexcept {
+		constexpr std::array<size_t, VertexAttributeNum> standardSizes{ 12, 4, 8, 8, 4 };
+		constexpr std::array<size_t, VertexAttributeNum> compactSizes{ 12, 4, 4, 4, 4 };
+		switch (compression)
+		{
+		case VertexCompression::Standard:
+			return standardSizes[attr];
+		case VertexCompression::Compact:
+			return compactSizes[attr];
+		default:
+			return VertexAttributeSizes[attr];
+		}
+	}
+
+	constexpr uint32_t GetVertexAttributeBit(VertexAttribute attr) noexcept {
+		return 1u << static_cast<uint32_t>(attr);
+	}
+
+	// streams of a layout for the present attributes (the position is always present)
+	struct VertexStreams {
+		static constexpr size_t MaxStreamNum = VertexAttributeNum;
+
+		VertexLayout layout{ VertexLayout::Interleaved };
+		VertexCompression compression{ VertexCompression::None };
+		uint32_t attributeMask{ 0 };
+		size_t streamNum{ 0 };
+		std::array<size_t, MaxStreamNum> strides{};
+		// attribute -> (stream, offset in the stream), valid if the attribute is present
+		std::array<size_t, VertexAttributeNum> streams{};
+		std::array<size_t, VertexAttributeNum> offsets{};
+
+		// sum of the strides
+		constexpr size_t GetVertexSize() const noexcept;
+
+		// streams containing the attributes of the mask
+		constexpr uint32_t GetStreamMask(uint32_t attributeMask) const noexcept;
+
+		static constexpr VertexStreams Create(
+			VertexLayout layout,
+			uint32_t attributeMask,
+			VertexCompression compression = VertexCompression::None
+		) noexcept;
+	};
+}
+
+#include "details/VertexLayout.inl"
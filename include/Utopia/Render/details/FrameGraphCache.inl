@@ -0,0 +1,25 @@
+#pragma once
+
+#include <tuple>
+#include <utility>
+
+namespace Ubpa::Utopia {
+	template<typename Result>
+	template<typename CompileFunc>
+	const Result* FrameGraphCache<Result>::GetOrCompile(uint64_t hash, CompileFunc&& compile) {
+		if (result.has_value() && this->hash == hash) {
+			hitNum++;
+			return &*result;
+		}
+
+		missNum++;
+		result.reset();
+		auto [success, rst] = std::forward<CompileFunc>(compile)();
+		if (!success)
+			return nullptr;
+
+		result.emplace(std::move(rst));
+		this->hash = hash;
+		return &*result;
+	}
+}
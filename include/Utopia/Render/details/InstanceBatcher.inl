@@ -0,0 +1,9 @@
+#pragma once
+
+namespace Ubpa::Utopia {
+	template<typename T>
+	void InstanceBatcher::PackInstances(const RenderObjectList& objects, const T* objectData, T* dst) {
+		for (size_t i = 0; i < objects.size(); i++)
+			dst[i] = objectData[objects[i].objectIdx];
+	}
+}
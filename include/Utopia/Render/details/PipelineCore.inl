@@ -0,0 +1,34 @@
+#pragma once
+
+namespace Ubpa::Utopia {
+	template<typename SetFunc>
+	void PipelineCore::UploadCommonBuffer(SetFunc&& set) const {
+		set(cameraOffset, &cameraConstants, sizeof(CameraConstants));
+
+		// light array
+		set(lightOffset, &lights, sizeof(LightArray));
+
+		// instances, slots contiguous per batch
+		if (!instances.empty())
+			set(instanceOffset, instances.data(), instances.size() * sizeof(uint32_t));
+
+		// light clusters
+		const auto& clusterRanges = lightClusters.GetRanges();
+		const auto& clusterIndices = lightClusters.GetLightIndices();
+		if (!clusterShaderLights.empty())
+			set(clusterLightOffset, clusterShaderLights.data(), clusterShaderLights.size() * sizeof(ShaderLight));
+		if (!clusterRanges.empty())
+			set(clusterRangeOffset, clusterRanges.data(), clusterRanges.size() * sizeof(LightClusterGrid::Range));
+		if (!clusterIndices.empty())
+			set(clusterIndexOffset, clusterIndices.data(), clusterIndices.size() * sizeof(uint32_t));
+	}
+
+	template<typename SetFunc>
+	void PipelineCore::UploadObjects(size_t stride, SetFunc&& set) {
+		static_assert(sizeof(ObjectData) == sizeof(ObjectConstants));
+		for (const auto& [begin, end] : objectSlots.CollectDirtyRanges()) {
+			for (size_t slot = begin; slot < end; slot++)
+				set(slot * stride, &objects[slot], sizeof(ObjectConstants));
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+namespace Ubpa::Utopia {
+	constexpr size_t VertexStreams::GetVertexSize() const noexcept {
+		size_t size = 0;
+		for (size_t i = 0; i < streamNum; i++)
+			size += strides[i];
+		return size;
+	}
+
+	constexpr uint32_t VertexStreams::GetStreamMask(uint32_t mask) const noexcept {
+		uint32_t rst = 0;
+		for (size_t i = 0; i < VertexAttributeNum; i++) {
+			if (mask & attributeMask & (1u << i))
+				rst |= 1u << streams[i];
+		}
+		return rst;
+	}
+
+	constexpr VertexStreams VertexStreams::Create(
+		VertexLayout layout,
+		uint32_t attributeMask,
+		VertexCompression compression
+	) noexcept {
+		VertexStreams rst;
+		rst.layout = layout;
+		rst.compression = compression;
+		rst.attributeMask = attributeMask | GetVertexAttributeBit(VertexAttribute::Position);
+
+		for (size_t i = 0; i < VertexAttributeNum; i++) {
+			if (!(rst.attributeMask & (1u << i)))
+				continue;
+
+			size_t stream = 0;
+			switch (layout)
+			{
+			case VertexLayout::Interleaved:
+				stream = 0;
+				break;
+			case VertexLayout::PositionSplit:
+				stream = i == 0 ? 0 : 1;
+				break;
+			case VertexLayout::Split:
+				stream = rst.streamNum;
+				break;
+			}
+
+			rst.streams[i] = stream;
+			rst.offsets[i] = rst.strides[stream];
+			rst.strides[stream] += GetVertexAttributeSize(i, compression);
+			if (stream + 1 > rst.streamNum)
+				rst.streamNum = stream + 1;
+		}
+
+		return rst;
+	}
+}
@@ -297,7 +297,7 @@ bool DX12App::InitDirect3D() {
 		IID_PPV_ARGS(&mFence)));
 
 
-	Ubpa::Utopia::RsrcMngrDX12::Instance().Init(uDevice.raw.Get());
+	Ubpa::Utopia::RsrcMngrDX12::Instance().Init(uDevice.raw.Get(), NumFrameResources);
 	Ubpa::UDX12::DescriptorHeapMngr::Instance().Init(uDevice.Get(), 16384, 16384, 16384, 16384, 16384);
 
 	frameRsrcMngr = std::make_unique<Ubpa::UDX12::FrameResourceMngr>(NumFrameResources, uDevice.Get());
@@ -8,6 +8,7 @@
 #include <Utopia/App/Editor/Systems/InspectorSystem.h>
 #include <Utopia/App/Editor/Systems/ProjectViewerSystem.h>
 #include <Utopia/App/Editor/Systems/LoggerSystem.h>
+#include <Utopia/App/Editor/Systems/ProfilerSystem.h>
 
 #include <Utopia/App/Editor/InspectorRegistry.h>
 
@@ -33,6 +34,7 @@
 #include <Utopia/Core/Components/Components.h>
 #include <Utopia/Core/Systems/Systems.h>
 #include <Utopia/Core/ImGUIMngr.h>
+#include <Utopia/Core/Profiler.h>
 
 #include <_deps/imgui/imgui.h>
 #include <_deps/imgui/imgui_impl_win32.h>
@@ -494,7 +496,10 @@ void Editor::Impl::Update() {
 		}
 		ImGui::End(); // Game Control window
 
-		editorWorld.Update();
+		{
+			UBPA_UTOPIA_PROFILE_SCOPE("Editor::UpdateEditorWorld");
+			editorWorld.Update();
+		}
 	}
 
 	{ // game update
@@ -504,8 +509,11 @@ void Editor::Impl::Update() {
 		switch (gameState)
 		{
 		case Impl::GameState::NotStart:
+		{
+			UBPA_UTOPIA_PROFILE_SCOPE("Editor::UpdateGameWorld");
 			gameWorld.Update();
 			break;
+		}
 		case Impl::GameState::Starting:
 		{
 			runningGameWorld = std::make_unique<Ubpa::UECS::World>(gameWorld);
@@ -521,7 +529,10 @@ void Editor::Impl::Update() {
 			// break;
 		}
 		case Impl::GameState::Running:
+		{
+			UBPA_UTOPIA_PROFILE_SCOPE("Editor::UpdateRunningGameWorld");
 			runningGameWorld->Update();
+		}
 			ImGui::Begin("in game");
 			ImGui::Text("This is some useful text.");               // Display some text (you can use a format strings too)
 			ImGui::End();
@@ -549,7 +560,10 @@ void Editor::Impl::Update() {
 		ImGui::NewFrame(); // scene ctx
 
 		//UpdateCamera();
-		sceneWorld.Update();
+		{
+			UBPA_UTOPIA_PROFILE_SCOPE("Editor::UpdateSceneWorld");
+			sceneWorld.Update();
+		}
 		ImGui::Begin("in scene");
 		ImGui::Text("This is some useful text.");               // Display some text (you can use a format strings too)
 		ImGui::End();
@@ -598,6 +612,19 @@ void Editor::Impl::Update() {
 			}
 			}, false);
 
+		// the deformed instances are drawn instead of the meshes of the MeshFilters
+		w->RunEntityJob([&](const SkinnedMesh* skinnedMesh) {
+			if (!skinnedMesh->instance)
+				return;
+
+			RsrcMngrDX12::Instance().RegisterMesh(
+				upload,
+				deleteBatch,
+				pEditor->uGCmdList.Get(),
+				*skinnedMesh->instance
+			);
+		}, false);
+
 		if (auto skybox = w->entityMngr.GetSingleton<Skybox>(); skybox && skybox->material) {
 			for (const auto& [name, property] : skybox->material->properties) {
 				if (std::holds_alternative<std::shared_ptr<const Texture2D>>(property)) {
@@ -716,18 +743,25 @@ void Editor::Impl::InitInspectorRegistry() {
 		Camera,
 		MeshFilter,
 		MeshRenderer,
+		LODGroup,
+		Skeleton,
+		SkinnedMesh,
 		WorldTime,
+		FixedTime,
 		Name,
 		Skybox,
 		Light,
 		Input,
 		Roamer,
+		Animator,
+		AnimationTarget,
 
 		// transform
 		Children,
 		LocalToParent,
 		LocalToWorld,
 		Parent,
+		PrevLocalToWorld,
 		Rotation,
 		RotationEuler,
 		Scale,
@@ -754,8 +788,10 @@ void Editor::Impl::InitWorld(Ubpa::UECS::World& w) {
 		// core
 		WorldTimeSystem,
 		CameraSystem,
+		SkinningSystem,
 		InputSystem,
 		RoamerSystem,
+		AnimatorSystem,
 
 		// editor
 		HierarchySystem,
@@ -772,6 +808,7 @@ void Editor::Impl::InitWorld(Ubpa::UECS::World& w) {
 		LocalToParent,
 		LocalToWorld,
 		Parent,
+		PrevLocalToWorld,
 		Rotation,
 		RotationEuler,
 		Scale,
@@ -782,12 +819,18 @@ void Editor::Impl::InitWorld(Ubpa::UECS::World& w) {
 		Camera,
 		MeshFilter,
 		MeshRenderer,
+		LODGroup,
+		Skeleton,
+		SkinnedMesh,
 		WorldTime,
+		FixedTime,
 		Name,
 		Skybox,
 		Light,
 		Input,
 		Roamer,
+		Animator,
+		AnimationTarget,
 
 		// script
 		LuaScriptQueue,
@@ -805,18 +848,25 @@ void Editor::Impl::BuildWorld() {
 		Camera,
 		MeshFilter,
 		MeshRenderer,
+		LODGroup,
+		Skeleton,
+		SkinnedMesh,
 		WorldTime,
+		FixedTime,
 		Name,
 		Skybox,
 		Light,
 		Input,
 		Roamer,
+		Animator,
+		AnimationTarget,
 
 		// transform
 		Children,
 		LocalToParent,
 		LocalToWorld,
 		Parent,
+		PrevLocalToWorld,
 		Rotation,
 		RotationEuler,
 		Scale,
@@ -882,8 +932,9 @@ void Editor::Impl::BuildWorld() {
 		}
 		editorWorld.entityMngr.Create<Inspector>();
 		editorWorld.entityMngr.Create<ProjectViewer>();
-		auto [logSys] = editorWorld.systemMngr.Register<LoggerSystem>();
+		auto [logSys, profilerSys] = editorWorld.systemMngr.Register<LoggerSystem, ProfilerSystem>();
 		editorWorld.systemMngr.Activate(logSys);
+		editorWorld.systemMngr.Activate(profilerSys);
 	}
 }
 
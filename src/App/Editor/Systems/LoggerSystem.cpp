@@ -5,9 +5,55 @@
 #include <imgui/imgui.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
 using namespace Ubpa::Utopia;
 using namespace Ubpa::UECS;
 
+namespace Ubpa::Utopia::details {
+	// ids of the logs passing the filters, only the new logs are tested every frame
+	struct LoggerIndex {
+		ImGuiTextFilter textFilter;
+		int minLevel{ spdlog::level::trace };
+		size_t threadID{ 0 }; // 0: all threads
+		std::set<size_t> threadIDs;
+
+		std::vector<uint64_t> ids; // sorted
+		uint64_t scannedID{ 0 }; // logs with id < scannedID are tested
+
+		bool Pass(const StringsSink::Log& log) const {
+			if (log.level < minLevel)
+				return false;
+			if (threadID != 0 && log.threadID != threadID)
+				return false;
+			return !textFilter.IsActive()
+				|| textFilter.PassFilter(log.text.data(), log.text.data() + log.text.size());
+		}
+
+		void Rebuild() {
+			ids.clear();
+			scannedID = 0;
+		}
+
+		void Update(StringsSink& sink) {
+			sink.ForEachSince(scannedID, [&](const StringsSink::Log& log) {
+				threadIDs.insert(log.threadID);
+				if (Pass(log))
+					ids.push_back(log.id);
+				scannedID = log.id + 1;
+			});
+		}
+
+		// drop the evicted logs
+		void Clamp(uint64_t firstID) {
+			ids.erase(ids.begin(), std::lower_bound(ids.begin(), ids.end(), firstID));
+		}
+	};
+}
+
 void LoggerSystem::OnUpdate(UECS::Schedule& schedule) {
 	schedule.RegisterCommand([](UECS::World*) {
 		if (ImGui::Begin("Log")) {
@@ -36,29 +82,72 @@ void LoggerSystem::OnUpdate(UECS::Schedule& schedule) {
 			ImGui::SameLine();
 #endif // !NDEBUG
 
-			if (ImGui::Button("Clear"))
+			static details::LoggerIndex index;
+
+			if (ImGui::Button("Clear")) {
 				sink->Clear();
+				index.ids.clear();
+			}
+			ImGui::SameLine();
+
+			static const char* levelNames[] = { "trace", "debug", "info", "warn", "error", "critical", "off" };
+			ImGui::SetNextItemWidth(100.f);
+			if (ImGui::Combo("level", &index.minLevel, levelNames, IM_ARRAYSIZE(levelNames)))
+				index.Rebuild();
+			ImGui::SameLine();
+
+			ImGui::SetNextItemWidth(100.f);
+			std::string threadName = index.threadID == 0 ? "all" : std::to_string(index.threadID);
+			if (ImGui::BeginCombo("thread", threadName.c_str())) {
+				if (ImGui::Selectable("all", index.threadID == 0)) {
+					index.threadID = 0;
+					index.Rebuild();
+				}
+				for (auto threadID : index.threadIDs) {
+					if (ImGui::Selectable(std::to_string(threadID).c_str(), index.threadID == threadID)) {
+						index.threadID = threadID;
+						index.Rebuild();
+					}
+				}
+				ImGui::EndCombo();
+			}
 			ImGui::SameLine();
 
-			const auto& logs = sink->GetLogs();
+			if (index.textFilter.Draw("filter", 200.f))
+				index.Rebuild();
 
-			static ImGuiTextFilter filter;
-			filter.Draw();
+			index.Update(*sink);
+			// the row count of the clipper must not include evicted logs
+			index.Clamp(sink->GetFirstID());
+
+			ImGui::Text("%zu / %llu lines, dropped: %llu, evicted: %llu",
+				index.ids.size(),
+				static_cast<unsigned long long>(sink->GetNextID() - sink->GetFirstID()),
+				static_cast<unsigned long long>(sink->GetDroppedNum()),
+				static_cast<unsigned long long>(sink->GetEvictedNum()));
 
 			ImGui::Separator();
 			ImGui::BeginChild("scrolling", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
 
 			ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, 0));
-			if (filter.IsActive()) {
-				for (const auto& log : logs) {
-					if (filter.PassFilter(log.c_str()))
-						ImGui::TextUnformatted(log.c_str());
-				}
-			}
-			else {
-				for (const auto& log : logs)
-					ImGui::TextUnformatted(log.c_str());
+			ImGuiListClipper clipper;
+			clipper.Begin(static_cast<int>(index.ids.size()));
+			while (clipper.Step()) {
+				const size_t num = static_cast<size_t>(clipper.DisplayEnd - clipper.DisplayStart);
+				size_t drawn = 0;
+				sink->ForEachOf(
+					index.ids.data() + clipper.DisplayStart,
+					num,
+					[&](const StringsSink::Log& log) {
+						ImGui::TextUnformatted(log.text.data(), log.text.data() + log.text.size());
+						drawn++;
+					}
+				);
+				// logs evicted by another reader after the clamp, keep the row height
+				for (; drawn < num; drawn++)
+					ImGui::TextUnformatted("");
 			}
+			clipper.End();
 			ImGui::PopStyleVar();
 
 			if (ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
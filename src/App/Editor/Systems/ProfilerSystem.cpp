@@ -0,0 +1,53 @@
+#include <Utopia/App/Editor/Systems/ProfilerSystem.h>
+
+#include <Utopia/Core/Profiler.h>
+
+#include <imgui/imgui.h>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa::UECS;
+
+void ProfilerSystem::OnUpdate(UECS::Schedule& schedule) {
+	schedule.RegisterCommand([](UECS::World*) {
+		if (ImGui::Begin("Profiler")) {
+#ifndef UBPA_UTOPIA_USE_PROFILER
+			ImGui::Text("compiled without profiler (Utopia_USE_PROFILER)");
+#else
+			auto& profiler = Profiler::Instance();
+
+			bool enabled = profiler.IsEnabled();
+			if (ImGui::Checkbox("Enabled", &enabled))
+				profiler.SetEnabled(enabled);
+			ImGui::SameLine();
+			if (ImGui::Button("Clear"))
+				profiler.Clear();
+			ImGui::SameLine();
+			if (ImGui::Button("Export"))
+				profiler.ExportChromeTrace("utopia_trace.json");
+
+			ImGui::Separator();
+
+			// last second
+			auto stats = profiler.GetStats();
+			ImGui::Columns(6, "zones");
+			ImGui::Text("zone"); ImGui::NextColumn();
+			ImGui::Text("count"); ImGui::NextColumn();
+			ImGui::Text("mean (ms)"); ImGui::NextColumn();
+			ImGui::Text("min (ms)"); ImGui::NextColumn();
+			ImGui::Text("max (ms)"); ImGui::NextColumn();
+			ImGui::Text("last (ms)"); ImGui::NextColumn();
+			ImGui::Separator();
+			for (const auto& zone : stats) {
+				ImGui::TextUnformatted(zone.name.data(), zone.name.data() + zone.name.size()); ImGui::NextColumn();
+				ImGui::Text("%zu", zone.count); ImGui::NextColumn();
+				ImGui::Text("%.3f", zone.meanMs); ImGui::NextColumn();
+				ImGui::Text("%.3f", zone.minMs); ImGui::NextColumn();
+				ImGui::Text("%.3f", zone.maxMs); ImGui::NextColumn();
+				ImGui::Text("%.3f", zone.lastMs); ImGui::NextColumn();
+			}
+			ImGui::Columns(1);
+#endif // UBPA_UTOPIA_USE_PROFILER
+		}
+		ImGui::End();
+	});
+}
@@ -316,6 +316,19 @@ void GameStarter::Update() {
 		}
 	}, false);
 
+	// the deformed instances are drawn instead of the meshes of the MeshFilters
+	world.RunEntityJob([&](const Ubpa::Utopia::SkinnedMesh* skinnedMesh) {
+		if (!skinnedMesh->instance)
+			return;
+
+		Ubpa::Utopia::RsrcMngrDX12::Instance().RegisterMesh(
+			upload,
+			deleteBatch,
+			uGCmdList.Get(),
+			*skinnedMesh->instance
+		);
+	}, false);
+
 	if (auto skybox = world.entityMngr.GetSingleton<Ubpa::Utopia::Skybox>(); skybox && skybox->material) {
 		for (const auto& [name, property] : skybox->material->properties) {
 			if (std::holds_alternative<std::shared_ptr<const Ubpa::Utopia::Texture2D>>(property)) {
@@ -435,8 +448,10 @@ void GameStarter::UpdateCamera()
 
 void GameStarter::BuildWorld() {
 	auto indices = world.systemMngr.Register<
+		Ubpa::Utopia::AnimatorSystem,
 		Ubpa::Utopia::CameraSystem,
 		Ubpa::Utopia::LocalToParentSystem,
+		Ubpa::Utopia::SkinningSystem,
 		Ubpa::Utopia::RotationEulerSystem,
 		Ubpa::Utopia::TRSToLocalToParentSystem,
 		Ubpa::Utopia::TRSToLocalToWorldSystem,
@@ -448,6 +463,8 @@ void GameStarter::BuildWorld() {
 	
 	world.entityMngr.cmptTraits.Register<
 		// core
+		Ubpa::Utopia::AnimationTarget,
+		Ubpa::Utopia::Animator,
 		Ubpa::Utopia::Camera,
 		Ubpa::Utopia::MeshFilter,
 		Ubpa::Utopia::MeshRenderer,
@@ -6,6 +6,9 @@
 
 #include <Utopia/ScriptSystem/LuaScript.h>
 #include <Utopia/Render/Mesh.h>
+#include <Utopia/Render/MeshOptimizer.h>
+#include <Utopia/Render/Meshlet.h>
+#include <Utopia/Render/MeshSimplifier.h>
 #include <Utopia/Render/HLSLFile.h>
 #include <Utopia/Render/Shader.h>
 #include <Utopia/Core/Image.h>
@@ -13,8 +16,10 @@
 #include <Utopia/Render/TextureCube.h>
 #include <Utopia/Render/Material.h>
 #include <Utopia/Core/TextAsset.h>
+#include <Utopia/Core/AnimationClip.h>
 #include <Utopia/Core/Scene.h>
 #include <Utopia/Core/DefaultAsset.h>
+#include <Utopia/Core/Profiler.h>
 
 #include <_deps/tinyobjloader/tiny_obj_loader.h>
 #ifdef UBPA_DUSTENGINE_USE_ASSIMP
@@ -28,6 +33,10 @@
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <any>
 #include <memory>
@@ -68,14 +77,35 @@ struct AssetMngr::Impl {
 		std::vector<uint32_t> indices;
 		std::vector<pointf2> uv;
 		std::vector<SubMeshDescriptor> submeshes;
+		VertexCompression compression{ VertexCompression::None };
+		size_t lodLevelNum{ 1 };
+		bool buildMeshlets{ false };
+		TangentMode tangentMode{ TangentMode::Accumulated };
 	};
+	// import settings in the meta file
+	// - "vertexCompression": "None" (default), "Standard" or "Compact"
+	// - "lodLevels": number of levels including the mesh itself (default 1, no LOD)
+	// - "meshlets": build the meshlets of the mesh (default false)
+	// - "tangents": "Accumulated" (default) or "MikkTSpace", mode of the generated tangents
+	static void LoadMeshImportSettings(const std::filesystem::path& path, MeshContext& ctx);
 	static std::shared_ptr<Mesh> BuildMesh(MeshContext ctx);
 	static std::shared_ptr<Mesh> LoadObj(const std::filesystem::path& path);
+	// .gltf (embedded or external buffers) and .glb, the triangle primitives of the meshes become submeshes
+	static std::shared_ptr<Mesh> LoadGLTF(const std::filesystem::path& path);
 #ifdef UBPA_DUSTENGINE_USE_ASSIMP
 	static std::shared_ptr<Mesh> AssimpLoadMesh(const std::filesystem::path& path);
 	static void AssimpLoadNode(AssetMngr::Impl::MeshContext& ctx, const aiNode* node, const aiScene* scene);
 	static void AssimpLoadMesh(AssetMngr::Impl::MeshContext& ctx, const aiMesh* mesh, const aiScene* scene);
 #endif // UBPA_DUSTENGINE_USE_ASSIMP
+	// .anim, JSON
+	// {
+	//   "sampleRate": 30,
+	//   "frameNum": 60,
+	//   "tracks": [ { "translations": [x, y, z, ...], "rotations": [x, y, z, w, ...], "scales": [s, ...] }, ... ]
+	// }
+	// a channel has frameNum samples, 1 (constant) or none
+	// import settings in the meta file : "translationError", "rotationError", "scaleError", "segmentFrames"
+	static std::shared_ptr<AnimationClip> LoadAnimationClip(const std::filesystem::path& path);
 
 	std::map<xg::Guid, std::set<xg::Guid>> assetTree;
 
@@ -109,6 +139,8 @@ bool AssetMngr::IsSupported(std::string_view ext) const noexcept {
 
 		// [models]
 		|| ext == "obj"
+		|| ext == "gltf"
+		|| ext == "glb"
 #ifdef UBPA_DUSTENGINE_USE_ASSIMP
 		|| ext == "ply"
 #endif // UBPA_DUSTENGINE_USE_ASSIMP
@@ -131,6 +163,9 @@ bool AssetMngr::IsSupported(std::string_view ext) const noexcept {
 		|| ext == "texcube"
 		|| ext == "mat"
 		|| ext == "scene"
+
+		// [animations]
+		|| ext == "anim"
 		;
 }
 
@@ -276,6 +311,7 @@ void AssetMngr::ImportAssetRecursively(const std::filesystem::path& directory) {
 }
 
 std::shared_ptr<Object> AssetMngr::LoadAsset(const std::filesystem::path& path) {
+	UBPA_UTOPIA_PROFILE_SCOPE("AssetMngr::LoadAsset");
 	ImportAsset(path);
 	auto target = pImpl->path2assert.find(path);
 	if (target != pImpl->path2assert.end())
@@ -294,6 +330,14 @@ std::shared_ptr<Object> AssetMngr::LoadAsset(const std::filesystem::path& path)
 		pImpl->assetID2path.emplace(mesh->GetInstanceID(), path);
 		return mesh;
 	}
+	else if (ext == ".gltf" || ext == ".glb") {
+		auto mesh = Impl::LoadGLTF(path);
+		if (!mesh)
+			return nullptr;
+		pImpl->path2assert.emplace_hint(target, path, Impl::Asset{ mesh });
+		pImpl->assetID2path.emplace(mesh->GetInstanceID(), path);
+		return mesh;
+	}
 #ifdef UBPA_DUSTENGINE_USE_ASSIMP
 	else if (ext == ".ply") {
 		auto mesh = Impl::AssimpLoadMesh(path);
@@ -404,6 +448,14 @@ std::shared_ptr<Object> AssetMngr::LoadAsset(const std::filesystem::path& path)
 		pImpl->assetID2path.emplace(material->GetInstanceID(), path);
 		return material;
 	}
+	else if (ext == ".anim") {
+		auto clip = Impl::LoadAnimationClip(path);
+		if (!clip)
+			return nullptr;
+		pImpl->path2assert.emplace_hint(target, path, Impl::Asset{ clip });
+		pImpl->assetID2path.emplace(clip->GetInstanceID(), path);
+		return clip;
+	}
 	else {
 		auto defaultAsset = std::make_shared<DefaultAsset>();
 		pImpl->path2assert.emplace_hint(target, path, Impl::Asset{ defaultAsset });
@@ -423,6 +475,8 @@ std::shared_ptr<Object> AssetMngr::LoadAsset(const std::filesystem::path& path,
 	}
 	else if (
 		ext == ".obj"
+		|| ext == ".gltf"
+		|| ext == ".glb"
 		|| ext == ".ply" && IsSupported("ply")
 	) {
 		if (typeinfo != typeid(Mesh))
@@ -479,6 +533,11 @@ std::shared_ptr<Object> AssetMngr::LoadAsset(const std::filesystem::path& path,
 			return nullptr;
 		return LoadAsset(path);
 	}
+	else if (ext == ".anim") {
+		if (typeinfo != typeid(AnimationClip))
+			return nullptr;
+		return LoadAsset(path);
+	}
 	else {
 		if (typeinfo != typeid(DefaultAsset))
 			return nullptr;
@@ -678,25 +737,85 @@ rapidjson::Document AssetMngr::Impl::LoadJSON(const std::filesystem::path& metap
 }
 
 
+void AssetMngr::Impl::LoadMeshImportSettings(const std::filesystem::path& path, MeshContext& ctx) {
+	auto metapath = std::filesystem::path{ path }.concat(".meta");
+	if (!std::filesystem::exists(metapath))
+		return;
+
+	rapidjson::Document doc = LoadJSON(metapath);
+	if (!doc.IsObject())
+		return;
+
+	if (doc.HasMember("vertexCompression") && doc["vertexCompression"].IsString()) {
+		std::string_view compression = doc["vertexCompression"].GetString();
+		if (compression == "Standard")
+			ctx.compression = VertexCompression::Standard;
+		else if (compression == "Compact")
+			ctx.compression = VertexCompression::Compact;
+		else
+			ctx.compression = VertexCompression::None;
+	}
+
+	if (doc.HasMember("lodLevels") && doc["lodLevels"].IsUint())
+		ctx.lodLevelNum = std::max<size_t>(doc["lodLevels"].GetUint(), 1);
+
+	if (doc.HasMember("meshlets") && doc["meshlets"].IsBool())
+		ctx.buildMeshlets = doc["meshlets"].GetBool();
+
+	if (doc.HasMember("tangents") && doc["tangents"].IsString()) {
+		std::string_view mode = doc["tangents"].GetString();
+		ctx.tangentMode = mode == "MikkTSpace" ? TangentMode::MikkTSpace : TangentMode::Accumulated;
+	}
+}
+
 std::shared_ptr<Mesh> AssetMngr::Impl::BuildMesh(MeshContext ctx) {
 	auto mesh = std::make_shared<Mesh>();
 	mesh->SetPositions(std::move(ctx.positions));
 	mesh->SetColors(std::move(ctx.colors));
 	mesh->SetNormals(std::move(ctx.normals));
+	mesh->SetTangents(std::move(ctx.tangents));
 	mesh->SetUV(std::move(ctx.uv));
 	mesh->SetIndices(std::move(ctx.indices));
 	mesh->SetSubMeshCount(ctx.submeshes.size());
 	for (size_t i = 0; i < ctx.submeshes.size(); i++)
 		mesh->SetSubMesh(i, ctx.submeshes[i]);
 
+	if (ctx.lodLevelNum > 1) {
+		UBPA_UTOPIA_PROFILE_SCOPE("AssetMngr::GenerateLODs");
+		LODGenerationDesc desc;
+		desc.levelNum = ctx.lodLevelNum;
+		size_t levelNum = GenerateLODs(*mesh, desc);
+		spdlog::debug("mesh LODs: {} levels", levelNum);
+	}
+
+	// reorder the triangles and the vertices (of every level), lossless
+	MeshOptimizationReport report;
+	{
+		UBPA_UTOPIA_PROFILE_SCOPE("AssetMngr::OptimizeMesh");
+		report = OptimizeMesh(*mesh);
+	}
+
+	// clusters of the submeshes, reorders the triangles again
+	if (ctx.buildMeshlets) {
+		UBPA_UTOPIA_PROFILE_SCOPE("AssetMngr::BuildMeshlets");
+		BuildMeshlets(*mesh);
+		report.after = AnalyzeVertexCache(*mesh);
+		spdlog::debug("mesh meshlets: {}", mesh->GetMeshlets().meshlets.size());
+	}
+
+	// of the final triangle order
+	spdlog::debug("mesh optimization: ACMR {} -> {}, ATVR {} -> {}",
+		report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+
 	// generate normals, uv, tangents
 	if (mesh->GetNormals().empty())
 		mesh->GenNormals();
 	if (mesh->GetUV().empty())
 		mesh->GenUV();
 	if (mesh->GetTangents().empty())
-		mesh->GenTangents();
+		mesh->GenTangents(ctx.tangentMode);
 
+	mesh->SetVertexCompression(ctx.compression);
 	mesh->UpdateVertexBuffer();
 	mesh->SetToNonEditable();
 
@@ -722,6 +841,7 @@ std::shared_ptr<Mesh> AssetMngr::Impl::LoadObj(const std::filesystem::path& path
 	const auto& materials = reader.GetMaterials();
 
 	MeshContext ctx;
+	LoadMeshImportSettings(path, ctx);
 	std::map<valu3, size_t> vertexIndexMap;
 
 	// Loop over shapes
@@ -785,6 +905,463 @@ std::shared_ptr<Mesh> AssetMngr::Impl::LoadObj(const std::filesystem::path& path
 	return BuildMesh(std::move(ctx));
 }
 
+namespace {
+	// glTF 2.0 : https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html
+	constexpr uint32_t GLBMagic = 0x46546C67; // "glTF"
+	constexpr uint32_t GLBChunkJSON = 0x4E4F534A; // "JSON"
+	constexpr uint32_t GLBChunkBIN = 0x004E4942; // "BIN\0"
+	constexpr int GLTFTriangles = 4;
+
+	enum class GLTFComponentType : int {
+		Byte = 5120,
+		UnsignedByte = 5121,
+		Short = 5122,
+		UnsignedShort = 5123,
+		UnsignedInt = 5125,
+		Float = 5126
+	};
+
+	struct GLTFBuffer {
+		const uint8_t* data{ nullptr };
+		size_t size{ 0 };
+	};
+
+	// elements of an accessor, in place in its buffer
+	struct GLTFAccessor {
+		const uint8_t* data{ nullptr }; // nullptr : zeros
+		size_t count{ 0 };
+		size_t stride{ 0 };
+		GLTFComponentType componentType{ GLTFComponentType::Float };
+		size_t componentNum{ 0 };
+		bool normalized{ false };
+	};
+
+	std::vector<uint8_t> LoadBinary(const std::filesystem::path& path) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file)
+			return {};
+		std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+		file.seekg(0, std::ios::beg);
+		file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+		return bytes;
+	}
+
+	bool DecodeBase64(std::vector<uint8_t>& dst, std::string_view src) {
+		auto Decode = [](char c) -> int {
+			if (c >= 'A' && c <= 'Z') return c - 'A';
+			if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+			if (c >= '0' && c <= '9') return c - '0' + 52;
+			if (c == '+') return 62;
+			if (c == '/') return 63;
+			return -1;
+		};
+		while (!src.empty() && src.back() == '=')
+			src.remove_suffix(1);
+		dst.clear();
+		dst.reserve(src.size() * 3 / 4);
+		uint32_t bits = 0;
+		int bitNum = 0;
+		for (char c : src) {
+			const int value = Decode(c);
+			if (value < 0)
+				return false;
+			bits = (bits << 6) | static_cast<uint32_t>(value);
+			bitNum += 6;
+			if (bitNum >= 8) {
+				bitNum -= 8;
+				dst.push_back(static_cast<uint8_t>(bits >> bitNum));
+			}
+		}
+		return true;
+	}
+
+	size_t GetGLTFComponentSize(GLTFComponentType type) noexcept {
+		switch (type)
+		{
+		case GLTFComponentType::Byte:
+		case GLTFComponentType::UnsignedByte:
+			return 1;
+		case GLTFComponentType::Short:
+		case GLTFComponentType::UnsignedShort:
+			return 2;
+		case GLTFComponentType::UnsignedInt:
+		case GLTFComponentType::Float:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	size_t GetGLTFComponentNum(std::string_view type) noexcept {
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	bool GetGLTFAccessor(
+		GLTFAccessor& accessor,
+		const rapidjson::Document& doc,
+		const std::vector<GLTFBuffer>& buffers,
+		const rapidjson::Value& index
+	) {
+		if (!index.IsUint() || !doc.HasMember("accessors") || !doc["accessors"].IsArray() || index.GetUint() >= doc["accessors"].Size())
+			return false;
+		const auto& json = doc["accessors"][index.GetUint()];
+		if (!json.IsObject() || json.HasMember("sparse")
+			|| !json.HasMember("count") || !json["count"].IsUint()
+			|| !json.HasMember("componentType") || !json["componentType"].IsInt()
+			|| !json.HasMember("type") || !json["type"].IsString()
+		)
+			return false;
+
+		accessor.count = json["count"].GetUint();
+		accessor.componentType = static_cast<GLTFComponentType>(json["componentType"].GetInt());
+		accessor.componentNum = GetGLTFComponentNum(json["type"].GetString());
+		accessor.normalized = json.HasMember("normalized") && json["normalized"].IsBool() && json["normalized"].GetBool();
+		const size_t elementSize = GetGLTFComponentSize(accessor.componentType) * accessor.componentNum;
+		if (elementSize == 0)
+			return false;
+		accessor.stride = elementSize;
+		accessor.data = nullptr;
+		if (!json.HasMember("bufferView"))
+			return true;
+
+		const auto& viewIndex = json["bufferView"];
+		if (!viewIndex.IsUint() || !doc.HasMember("bufferViews") || !doc["bufferViews"].IsArray() || viewIndex.GetUint() >= doc["bufferViews"].Size())
+			return false;
+		const auto& view = doc["bufferViews"][viewIndex.GetUint()];
+		if (!view.IsObject() || !view.HasMember("buffer") || !view["buffer"].IsUint() || view["buffer"].GetUint() >= buffers.size()
+			|| !view.HasMember("byteLength") || !view["byteLength"].IsUint64()
+		)
+			return false;
+		const GLTFBuffer& buffer = buffers[view["buffer"].GetUint()];
+		const size_t viewOffset = view.HasMember("byteOffset") && view["byteOffset"].IsUint64() ? view["byteOffset"].GetUint64() : 0;
+		const size_t viewLength = view["byteLength"].GetUint64();
+		if (view.HasMember("byteStride") && view["byteStride"].IsUint())
+			accessor.stride = view["byteStride"].GetUint();
+		const size_t offset = json.HasMember("byteOffset") && json["byteOffset"].IsUint64() ? json["byteOffset"].GetUint64() : 0;
+
+		// every element in the view, the view in the buffer
+		if (viewOffset > buffer.size || viewLength > buffer.size - viewOffset || accessor.stride < elementSize)
+			return false;
+		if (accessor.count > 0 && (offset > viewLength || (accessor.count - 1) * accessor.stride + elementSize > viewLength - offset))
+			return false;
+		accessor.data = buffer.data + viewOffset + offset;
+		return true;
+	}
+
+	float ReadGLTFComponent(const uint8_t* p, GLTFComponentType type, bool normalized) noexcept {
+		switch (type)
+		{
+		case GLTFComponentType::Byte: {
+			int8_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return normalized ? std::max(v / 127.f, -1.f) : static_cast<float>(v);
+		}
+		case GLTFComponentType::UnsignedByte:
+			return normalized ? *p / 255.f : static_cast<float>(*p);
+		case GLTFComponentType::Short: {
+			int16_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return normalized ? std::max(v / 32767.f, -1.f) : static_cast<float>(v);
+		}
+		case GLTFComponentType::UnsignedShort: {
+			uint16_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return normalized ? v / 65535.f : static_cast<float>(v);
+		}
+		case GLTFComponentType::UnsignedInt: {
+			uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return static_cast<float>(v);
+		}
+		default: {
+			float v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+		}
+	}
+
+	// N floats per element, a straight copy if the accessor is N packed floats
+	// the missing components are 0, the extra ones are dropped
+	template<size_t N>
+	void ReadGLTFFloats(float* dst, const GLTFAccessor& accessor) {
+		if (!accessor.data) {
+			std::fill(dst, dst + N * accessor.count, 0.f);
+			return;
+		}
+		if (accessor.componentType == GLTFComponentType::Float && accessor.componentNum == N && accessor.stride == N * sizeof(float)) {
+			std::memcpy(dst, accessor.data, N * sizeof(float) * accessor.count);
+			return;
+		}
+		const size_t componentSize = GetGLTFComponentSize(accessor.componentType);
+		const size_t num = std::min(N, accessor.componentNum);
+		for (size_t i = 0; i < accessor.count; i++) {
+			const uint8_t* element = accessor.data + i * accessor.stride;
+			for (size_t c = 0; c < num; c++)
+				dst[N * i + c] = ReadGLTFComponent(element + c * componentSize, accessor.componentType, accessor.normalized);
+			for (size_t c = num; c < N; c++)
+				dst[N * i + c] = 0.f;
+		}
+	}
+
+	bool ReadGLTFIndices(uint32_t* dst, const GLTFAccessor& accessor) {
+		if (!accessor.data || accessor.componentNum != 1)
+			return false;
+		switch (accessor.componentType)
+		{
+		case GLTFComponentType::UnsignedByte:
+			for (size_t i = 0; i < accessor.count; i++)
+				dst[i] = accessor.data[i * accessor.stride];
+			return true;
+		case GLTFComponentType::UnsignedShort:
+			for (size_t i = 0; i < accessor.count; i++) {
+				uint16_t index;
+				std::memcpy(&index, accessor.data + i * accessor.stride, sizeof(index));
+				dst[i] = index;
+			}
+			return true;
+		case GLTFComponentType::UnsignedInt:
+			if (accessor.stride == sizeof(uint32_t))
+				std::memcpy(dst, accessor.data, sizeof(uint32_t) * accessor.count);
+			else {
+				for (size_t i = 0; i < accessor.count; i++)
+					std::memcpy(dst + i, accessor.data + i * accessor.stride, sizeof(uint32_t));
+			}
+			return true;
+		default:
+			return false;
+		}
+	}
+}
+
+std::shared_ptr<Mesh> AssetMngr::Impl::LoadGLTF(const std::filesystem::path& path) {
+	static_assert(sizeof(pointf3) == 3 * sizeof(float) && sizeof(normalf) == 3 * sizeof(float) && sizeof(vecf3) == 3 * sizeof(float));
+	static_assert(sizeof(pointf2) == 2 * sizeof(float) && sizeof(rgbf) == 3 * sizeof(float));
+
+	auto Fail = [&](std::string_view error) -> std::shared_ptr<Mesh> {
+		spdlog::error("glTF {}: {}", path.string(), error);
+		return nullptr;
+	};
+
+	const std::vector<uint8_t> file = LoadBinary(path);
+	if (file.empty())
+		return Fail("can't read the file");
+
+	// the JSON chunk and the binary chunk of a .glb, or the JSON of a .gltf
+	std::string_view json;
+	GLTFBuffer glbBuffer;
+	if (path.extension() == ".glb") {
+		auto ReadU32 = [&](size_t offset) {
+			uint32_t v;
+			std::memcpy(&v, file.data() + offset, sizeof(v));
+			return v;
+		};
+		if (file.size() < 20 || ReadU32(0) != GLBMagic || ReadU32(4) != 2)
+			return Fail("not a glTF 2.0 binary");
+		const size_t length = std::min<size_t>(ReadU32(8), file.size());
+		for (size_t offset = 12; offset + 8 <= length;) {
+			const size_t chunkLength = ReadU32(offset);
+			const uint32_t chunkType = ReadU32(offset + 4);
+			if (chunkLength > length - offset - 8)
+				return Fail("truncated chunk");
+			const uint8_t* chunk = file.data() + offset + 8;
+			if (chunkType == GLBChunkJSON && json.empty())
+				json = { reinterpret_cast<const char*>(chunk), chunkLength };
+			else if (chunkType == GLBChunkBIN && !glbBuffer.data)
+				glbBuffer = { chunk, chunkLength };
+			offset += 8 + (chunkLength + 3) / 4 * 4;
+		}
+	}
+	else
+		json = { reinterpret_cast<const char*>(file.data()), file.size() };
+
+	rapidjson::Document doc;
+	doc.Parse(json.data(), json.size());
+	if (doc.HasParseError() || !doc.IsObject())
+		return Fail("invalid JSON");
+
+	if (doc.HasMember("extensionsRequired") && doc["extensionsRequired"].IsArray()) {
+		for (const auto& extension : doc["extensionsRequired"].GetArray()) {
+			// integer attributes, read by ReadGLTFFloats
+			if (!extension.IsString() || std::string_view{ extension.GetString() } != "KHR_mesh_quantization")
+				return Fail("unsupported required extension");
+		}
+	}
+
+	// buffers : the binary chunk, embedded (base64) or external files
+	std::vector<std::vector<uint8_t>> ownedBuffers;
+	std::vector<GLTFBuffer> buffers;
+	if (doc.HasMember("buffers") && doc["buffers"].IsArray()) {
+		for (const auto& buffer : doc["buffers"].GetArray()) {
+			if (!buffer.IsObject() || !buffer.HasMember("byteLength") || !buffer["byteLength"].IsUint64())
+				return Fail("invalid buffer");
+			const size_t byteLength = buffer["byteLength"].GetUint64();
+			GLTFBuffer view;
+			if (buffer.HasMember("uri") && buffer["uri"].IsString()) {
+				std::string_view uri = buffer["uri"].GetString();
+				std::vector<uint8_t> bytes;
+				if (uri.substr(0, 5) == "data:") {
+					const size_t comma = uri.find(',');
+					if (comma == std::string_view::npos || uri.substr(0, comma).find(";base64") == std::string_view::npos
+						|| !DecodeBase64(bytes, uri.substr(comma + 1)))
+						return Fail("invalid data uri");
+				}
+				else
+					bytes = LoadBinary(path.parent_path() / std::filesystem::u8path(uri));
+				view = { bytes.data(), bytes.size() };
+				ownedBuffers.push_back(std::move(bytes));
+			}
+			else
+				view = glbBuffer;
+			if (view.size < byteLength)
+				return Fail("buffer smaller than its byteLength");
+			buffers.push_back(view);
+		}
+	}
+
+	struct Primitive {
+		GLTFAccessor positions;
+		GLTFAccessor normals;
+		GLTFAccessor tangents;
+		GLTFAccessor uv;
+		GLTFAccessor colors;
+		GLTFAccessor indices;
+		bool hasNormals{ false };
+		bool hasTangents{ false };
+		bool hasUV{ false };
+		bool hasColors{ false };
+		bool hasIndices{ false };
+	};
+
+	// the triangle primitives of the meshes, in the space of the meshes (the node transforms aren't applied)
+	std::vector<Primitive> primitives;
+	size_t vertexNum = 0;
+	size_t indexNum = 0;
+	if (doc.HasMember("meshes") && doc["meshes"].IsArray()) {
+		for (const auto& mesh : doc["meshes"].GetArray()) {
+			if (!mesh.IsObject() || !mesh.HasMember("primitives") || !mesh["primitives"].IsArray())
+				return Fail("invalid mesh");
+			for (const auto& primitiveJSON : mesh["primitives"].GetArray()) {
+				if (!primitiveJSON.IsObject() || !primitiveJSON.HasMember("attributes") || !primitiveJSON["attributes"].IsObject())
+					return Fail("invalid primitive");
+				if (primitiveJSON.HasMember("mode") && (!primitiveJSON["mode"].IsInt() || primitiveJSON["mode"].GetInt() != GLTFTriangles)) {
+					// only support triangle mesh
+					spdlog::warn("glTF {}: skip a primitive that isn't a triangle list", path.string());
+					continue;
+				}
+
+				const auto& attributes = primitiveJSON["attributes"];
+				Primitive primitive;
+				if (!attributes.HasMember("POSITION") || !GetGLTFAccessor(primitive.positions, doc, buffers, attributes["POSITION"]))
+					return Fail("invalid positions");
+				auto GetAttribute = [&](const char* name, GLTFAccessor& accessor, bool& has) {
+					if (!attributes.HasMember(name))
+						return true;
+					has = GetGLTFAccessor(accessor, doc, buffers, attributes[name]) && accessor.count == primitive.positions.count;
+					return has;
+				};
+				if (!GetAttribute("NORMAL", primitive.normals, primitive.hasNormals)
+					|| !GetAttribute("TANGENT", primitive.tangents, primitive.hasTangents)
+					|| !GetAttribute("TEXCOORD_0", primitive.uv, primitive.hasUV)
+					|| !GetAttribute("COLOR_0", primitive.colors, primitive.hasColors)
+				)
+					return Fail("invalid attribute");
+				if (primitive.hasTangents && primitive.tangents.componentNum != 4)
+					return Fail("invalid tangents");
+				if (primitive.positions.count == 0)
+					continue;
+				if (primitiveJSON.HasMember("indices")) {
+					primitive.hasIndices = GetGLTFAccessor(primitive.indices, doc, buffers, primitiveJSON["indices"]);
+					if (!primitive.hasIndices)
+						return Fail("invalid indices");
+				}
+
+				const size_t primitiveIndexNum = primitive.hasIndices ? primitive.indices.count : primitive.positions.count;
+				if (primitiveIndexNum % 3 != 0)
+					return Fail("invalid triangles");
+				vertexNum += primitive.positions.count;
+				indexNum += primitiveIndexNum;
+				primitives.push_back(primitive);
+			}
+		}
+	}
+	if (primitives.empty())
+		return Fail("no triangle mesh");
+
+	// an attribute missing in a primitive is dropped (generated by BuildMesh), colors default to white
+	auto All = [&](bool Primitive::* has) {
+		return std::all_of(primitives.begin(), primitives.end(), [&](const Primitive& p) { return p.*has; });
+	};
+	auto Any = [&](bool Primitive::* has) {
+		return std::any_of(primitives.begin(), primitives.end(), [&](const Primitive& p) { return p.*has; });
+	};
+	const bool hasNormals = All(&Primitive::hasNormals);
+	// the tangents are orthogonal to the given normals only
+	const bool hasTangents = hasNormals && All(&Primitive::hasTangents);
+	const bool hasUV = All(&Primitive::hasUV);
+	const bool hasColors = Any(&Primitive::hasColors);
+
+	MeshContext ctx;
+	LoadMeshImportSettings(path, ctx);
+	ctx.positions.resize(vertexNum);
+	if (hasNormals)
+		ctx.normals.resize(vertexNum);
+	if (hasTangents)
+		ctx.tangents.resize(vertexNum);
+	if (hasUV)
+		ctx.uv.resize(vertexNum);
+	if (hasColors)
+		ctx.colors.resize(vertexNum, rgbf{ 1.f, 1.f, 1.f });
+	ctx.indices.resize(indexNum);
+
+	size_t baseVertex = 0;
+	size_t indexStart = 0;
+	std::vector<float> tangents;
+	for (const auto& primitive : primitives) {
+		const size_t count = primitive.positions.count;
+		ReadGLTFFloats<3>(&ctx.positions[baseVertex][0], primitive.positions);
+		if (hasNormals)
+			ReadGLTFFloats<3>(&ctx.normals[baseVertex][0], primitive.normals);
+		if (hasTangents) {
+			// xyz and the handedness w, cross(normal, tangent) * w is the bitangent
+			tangents.resize(4 * count);
+			ReadGLTFFloats<4>(tangents.data(), primitive.tangents);
+			for (size_t i = 0; i < count; i++) {
+				const float w = tangents[4 * i + 3] < 0.f ? -1.f : 1.f;
+				ctx.tangents[baseVertex + i] = { w * tangents[4 * i], w * tangents[4 * i + 1], w * tangents[4 * i + 2] };
+			}
+		}
+		if (hasUV)
+			ReadGLTFFloats<2>(&ctx.uv[baseVertex][0], primitive.uv);
+		if (primitive.hasColors)
+			ReadGLTFFloats<3>(&ctx.colors[baseVertex][0], primitive.colors);
+
+		SubMeshDescriptor desc{ indexStart, primitive.hasIndices ? primitive.indices.count : count };
+		desc.baseVertex = baseVertex;
+		if (primitive.hasIndices) {
+			if (!ReadGLTFIndices(&ctx.indices[indexStart], primitive.indices))
+				return Fail("invalid indices");
+			if (std::any_of(ctx.indices.begin() + indexStart, ctx.indices.begin() + indexStart + desc.indexCount,
+				[&](uint32_t index) { return index >= count; }))
+				return Fail("index out of range");
+		}
+		else {
+			for (size_t i = 0; i < count; i++)
+				ctx.indices[indexStart + i] = static_cast<uint32_t>(i);
+		}
+		ctx.submeshes.push_back(desc);
+
+		baseVertex += count;
+		indexStart += desc.indexCount;
+	}
+
+	return BuildMesh(std::move(ctx));
+}
+
 #ifdef UBPA_DUSTENGINE_USE_ASSIMP
 void AssetMngr::Impl::AssimpLoadNode(MeshContext& ctx, const aiNode* node, const aiScene* scene) {
 	for (unsigned int i = 0; i < node->mNumMeshes; i++) {
@@ -863,8 +1440,90 @@ std::shared_ptr<Mesh> AssetMngr::Impl::AssimpLoadMesh(const std::filesystem::pat
 		return nullptr;
 
 	MeshContext ctx;
+	LoadMeshImportSettings(path, ctx);
 	AssimpLoadNode(ctx, scene->mRootNode, scene);
 
 	return BuildMesh(std::move(ctx));
 }
 #endif // UBPA_DUSTENGINE_USE_ASSIMP
+
+std::shared_ptr<AnimationClip> AssetMngr::Impl::LoadAnimationClip(const std::filesystem::path& path) {
+	rapidjson::Document doc = LoadJSON(path);
+	if (!doc.IsObject()
+		|| !doc.HasMember("sampleRate") || !doc["sampleRate"].IsNumber()
+		|| !doc.HasMember("frameNum") || !doc["frameNum"].IsUint()
+		|| !doc.HasMember("tracks") || !doc["tracks"].IsArray()
+	)
+		return nullptr;
+
+	const float sampleRate = doc["sampleRate"].GetFloat();
+	const size_t frameNum = doc["frameNum"].GetUint();
+	if (!(sampleRate > 0.f) || frameNum == 0)
+		return nullptr;
+
+	// flat float array of sampleNum * dim, sampleNum in { 0, 1, frameNum }
+	auto LoadFloats = [&](const rapidjson::Value& track, const char* name, size_t dim, std::vector<float>& floats) {
+		floats.clear();
+		if (!track.HasMember(name))
+			return true;
+		const auto& array = track[name];
+		if (!array.IsArray())
+			return false;
+		const size_t size = array.Size();
+		if (size != 0 && size != dim && size != frameNum * dim)
+			return false;
+		floats.resize(size);
+		for (rapidjson::SizeType i = 0; i < size; i++) {
+			if (!array[i].IsNumber())
+				return false;
+			floats[i] = array[i].GetFloat();
+		}
+		return true;
+	};
+
+	std::vector<AnimationClip::Track> tracks;
+	std::vector<float> floats;
+	for (const auto& trackJSON : doc["tracks"].GetArray()) {
+		if (!trackJSON.IsObject())
+			return nullptr;
+		AnimationClip::Track track;
+
+		if (!LoadFloats(trackJSON, "translations", 3, floats))
+			return nullptr;
+		for (size_t i = 0; i < floats.size(); i += 3)
+			track.translations.push_back({ floats[i], floats[i + 1], floats[i + 2] });
+
+		if (!LoadFloats(trackJSON, "rotations", 4, floats))
+			return nullptr;
+		for (size_t i = 0; i < floats.size(); i += 4) {
+			quatf q;
+			for (size_t j = 0; j < 4; j++)
+				q[j] = floats[i + j];
+			track.rotations.push_back(q);
+		}
+
+		if (!LoadFloats(trackJSON, "scales", 1, floats))
+			return nullptr;
+		track.scales = floats;
+
+		tracks.push_back(std::move(track));
+	}
+
+	AnimationCompressionSettings settings;
+	auto metapath = std::filesystem::path{ path }.concat(".meta");
+	if (std::filesystem::exists(metapath)) {
+		rapidjson::Document meta = LoadJSON(metapath);
+		if (meta.IsObject()) {
+			if (meta.HasMember("translationError") && meta["translationError"].IsNumber())
+				settings.translationError = meta["translationError"].GetFloat();
+			if (meta.HasMember("rotationError") && meta["rotationError"].IsNumber())
+				settings.rotationError = meta["rotationError"].GetFloat();
+			if (meta.HasMember("scaleError") && meta["scaleError"].IsNumber())
+				settings.scaleError = meta["scaleError"].GetFloat();
+			if (meta.HasMember("segmentFrames") && meta["segmentFrames"].IsUint())
+				settings.segmentFrames = meta["segmentFrames"].GetUint();
+		}
+	}
+
+	return std::make_shared<AnimationClip>(tracks, sampleRate, frameNum, settings);
+}
@@ -0,0 +1,441 @@
+#include <Utopia/Core/AnimationClip.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+namespace {
+	constexpr float SqrtHalf = 0.70710678f;
+
+	constexpr size_t GetChannelDimension(AnimationChannel channel) noexcept {
+		switch (channel)
+		{
+		case AnimationChannel::Translation:
+			return 3;
+		case AnimationChannel::Rotation:
+			return 4;
+		default:
+			return 1;
+		}
+	}
+
+	// floats of the ranges of a segment
+	constexpr size_t GetChannelRangeSize(AnimationChannel channel) noexcept {
+		switch (channel)
+		{
+		case AnimationChannel::Translation:
+			return 6;
+		case AnimationChannel::Rotation:
+			return 0;
+		default:
+			return 2;
+		}
+	}
+
+	// uint16_t per key
+	constexpr size_t GetChannelValueSize(AnimationChannel channel) noexcept {
+		return channel == AnimationChannel::Scale ? 1 : 3;
+	}
+
+	template<typename T>
+	T Read(const uint8_t* data, size_t i) noexcept {
+		T value;
+		std::memcpy(&value, data + i * sizeof(T), sizeof(T));
+		return value;
+	}
+
+	template<typename T>
+	void Append(std::vector<uint8_t>& data, const std::vector<T>& values) {
+		const size_t offset = data.size();
+		data.resize(offset + values.size() * sizeof(T));
+		if (!values.empty())
+			std::memcpy(data.data() + offset, values.data(), values.size() * sizeof(T));
+	}
+
+	uint16_t QuantizeUnorm16(float v) noexcept {
+		return static_cast<uint16_t>(std::lround(std::clamp(v, 0.f, 1.f) * 65535.f));
+	}
+
+	// q[] : x, y, z, w
+	void Normalize4(float* q) noexcept {
+		const float norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+		if (norm > 0.f) {
+			for (size_t i = 0; i < 4; i++)
+				q[i] /= norm;
+		}
+		else {
+			q[0] = q[1] = q[2] = 0.f;
+			q[3] = 1.f;
+		}
+	}
+
+	// smallest three, the largest component is positive and dropped
+	void EncodeRotation(uint16_t* c, uint8_t& largest, const float* q) noexcept {
+		largest = 0;
+		for (uint8_t i = 1; i < 4; i++) {
+			if (std::abs(q[i]) > std::abs(q[largest]))
+				largest = i;
+		}
+		const float sign = q[largest] < 0.f ? -1.f : 1.f;
+		for (size_t i = 0, j = 0; i < 4; i++) {
+			if (i != largest)
+				c[j++] = QuantizeUnorm16((sign * q[i] + SqrtHalf) / (2.f * SqrtHalf));
+		}
+	}
+
+	void DecodeRotation(float* q, const uint16_t* c, uint8_t largest) noexcept {
+		float sum = 0.f;
+		for (size_t i = 0, j = 0; i < 4; i++) {
+			if (i == largest)
+				continue;
+			q[i] = c[j++] * (2.f * SqrtHalf / 65535.f) - SqrtHalf;
+			sum += q[i] * q[i];
+		}
+		q[largest] = std::sqrt(std::max(1.f - sum, 0.f));
+	}
+
+	// the shortest arc, normalized
+	void Nlerp(float* dst, const float* a, const float* b, float t) noexcept {
+		const float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+		const float tb = dot < 0.f ? -t : t;
+		for (size_t i = 0; i < 4; i++)
+			dst[i] = a[i] * (1.f - t) + b[i] * tb;
+		Normalize4(dst);
+	}
+
+	// angle of the rotation from a to b, unit quaternions
+	float RotationAngle(const float* a, const float* b) noexcept {
+		const float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+		const float s = dot < 0.f ? -1.f : 1.f;
+		float diff = 0.f;
+		float sum = 0.f;
+		for (size_t i = 0; i < 4; i++) {
+			diff += (a[i] - s * b[i]) * (a[i] - s * b[i]);
+			sum += (a[i] + s * b[i]) * (a[i] + s * b[i]);
+		}
+		return 4.f * std::atan2(std::sqrt(diff), std::sqrt(sum));
+	}
+
+	float ChannelError(AnimationChannel channel, const float* a, const float* b) noexcept {
+		switch (channel)
+		{
+		case AnimationChannel::Translation:
+			return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+		case AnimationChannel::Rotation:
+			return RotationAngle(a, b);
+		default:
+			return std::abs(a[0] - b[0]);
+		}
+	}
+
+	void Interpolate(AnimationChannel channel, float* dst, const float* a, const float* b, float t) noexcept {
+		if (channel == AnimationChannel::Rotation) {
+			Nlerp(dst, a, b, t);
+			return;
+		}
+		for (size_t i = 0; i < GetChannelDimension(channel); i++)
+			dst[i] = a[i] + (b[i] - a[i]) * t;
+	}
+
+	// sections of a segment under construction
+	struct SegmentBuilder {
+		std::vector<uint8_t> keyNums;
+		std::vector<uint8_t> keyFrames;
+		std::vector<float> ranges;
+		std::vector<uint16_t> values;
+		std::vector<uint8_t> largest;
+	};
+}
+
+void AnimationPose::Resize(size_t trackNum) {
+	translations.resize(trackNum, vecf3{ 0.f });
+	rotations.resize(trackNum, quatf::identity());
+	scales.resize(trackNum, 1.f);
+	channelMasks.resize(trackNum, 0);
+}
+
+void Ubpa::Utopia::BlendAnimationPoses(AnimationPose& dst, const AnimationPose& src, float weight) {
+	const size_t trackNum = std::min(dst.channelMasks.size(), src.channelMasks.size());
+	for (size_t i = 0; i < trackNum; i++) {
+		const uint8_t both = dst.channelMasks[i] & src.channelMasks[i];
+		const uint8_t srcOnly = src.channelMasks[i] & ~dst.channelMasks[i];
+
+		auto Blend = [&](AnimationChannel channel, float* d, const float* s) {
+			const uint8_t bit = GetAnimationChannelBit(channel);
+			if (both & bit)
+				Interpolate(channel, d, d, s, weight);
+			else if (srcOnly & bit)
+				std::copy(s, s + GetChannelDimension(channel), d);
+		};
+		Blend(AnimationChannel::Translation, &dst.translations[i][0], &src.translations[i][0]);
+		Blend(AnimationChannel::Rotation, &dst.rotations[i][0], &src.rotations[i][0]);
+		Blend(AnimationChannel::Scale, &dst.scales[i], &src.scales[i]);
+		dst.channelMasks[i] |= src.channelMasks[i];
+	}
+}
+
+AnimationClip::AnimationClip(const std::vector<Track>& tracks, float sampleRate, size_t frameNum, const AnimationCompressionSettings& settings)
+	: sampleRate{ sampleRate },
+	frameNum{ std::max<size_t>(frameNum, 1) },
+	segmentFrames{ std::clamp<size_t>(settings.segmentFrames, 1, 254) }
+{
+	assert(sampleRate > 0.f);
+
+	// raw curves of a channel, normalized rotations
+	auto GetRaw = [&](size_t track, AnimationChannel channel) {
+		const auto& t = tracks[track];
+		std::vector<float> raw;
+		switch (channel)
+		{
+		case AnimationChannel::Translation:
+			for (const auto& v : t.translations)
+				raw.insert(raw.end(), { v[0], v[1], v[2] });
+			break;
+		case AnimationChannel::Rotation:
+			for (const auto& q : t.rotations) {
+				float r[4] = { q[0], q[1], q[2], q[3] };
+				Normalize4(r);
+				raw.insert(raw.end(), r, r + 4);
+			}
+			break;
+		default:
+			raw.assign(t.scales.begin(), t.scales.end());
+			break;
+		}
+		return raw;
+	};
+	auto GetError = [&](AnimationChannel channel) {
+		switch (channel)
+		{
+		case AnimationChannel::Translation:
+			return settings.translationError;
+		case AnimationChannel::Rotation:
+			return settings.rotationError;
+		default:
+			return settings.scaleError;
+		}
+	};
+
+	constexpr AnimationChannel channels[3] = { AnimationChannel::Translation, AnimationChannel::Rotation, AnimationChannel::Scale };
+
+	// constant and animated channels
+	std::vector<std::vector<float>> animatedRaw;
+	channelMasks.resize(tracks.size(), 0);
+	for (size_t i = 0; i < tracks.size(); i++) {
+		for (auto channel : channels) {
+			auto raw = GetRaw(i, channel);
+			if (raw.empty())
+				continue;
+
+			const size_t dim = GetChannelDimension(channel);
+			const size_t sampleNum = raw.size() / dim;
+			assert(sampleNum == 1 || sampleNum == this->frameNum);
+			channelMasks[i] |= GetAnimationChannelBit(channel);
+
+			bool constant = true;
+			for (size_t f = 1; f < sampleNum && constant; f++)
+				constant = ChannelError(channel, &raw[f * dim], &raw[0]) <= GetError(channel);
+			const uint32_t id = static_cast<uint32_t>(i << 2) | static_cast<uint32_t>(channel);
+			if (constant) {
+				constantChannels.push_back(id);
+				constants.insert(constants.end(), raw.begin(), raw.begin() + dim);
+			}
+			else {
+				animatedChannels.push_back(id);
+				animatedRaw.push_back(std::move(raw));
+			}
+		}
+	}
+
+	if (animatedChannels.empty())
+		return;
+
+	const size_t segmentNum = (this->frameNum - 1 + segmentFrames - 1) / segmentFrames;
+	segmentOffsets.push_back(0);
+	for (size_t s = 0; s < segmentNum; s++) {
+		const size_t firstFrame = s * segmentFrames;
+		const size_t length = std::min(firstFrame + segmentFrames, this->frameNum - 1) - firstFrame;
+
+		SegmentBuilder builder;
+		for (size_t c = 0; c < animatedChannels.size(); c++) {
+			const auto channel = static_cast<AnimationChannel>(animatedChannels[c] & 3);
+			const size_t dim = GetChannelDimension(channel);
+			const size_t valueDim = GetChannelValueSize(channel);
+			const float* raw = &animatedRaw[c][firstFrame * dim];
+
+			// quantize every frame, the decoded values drive the key reduction
+			std::vector<uint16_t> quantized((length + 1) * valueDim);
+			std::vector<uint8_t> largest(length + 1, 0);
+			std::vector<float> decoded((length + 1) * dim);
+			if (channel == AnimationChannel::Rotation) {
+				for (size_t f = 0; f <= length; f++) {
+					EncodeRotation(&quantized[f * 3], largest[f], raw + f * dim);
+					DecodeRotation(&decoded[f * dim], &quantized[f * 3], largest[f]);
+				}
+			}
+			else {
+				// min and scale per component
+				float range[6];
+				for (size_t k = 0; k < dim; k++) {
+					float minValue = raw[k];
+					float maxValue = raw[k];
+					for (size_t f = 1; f <= length; f++) {
+						minValue = std::min(minValue, raw[f * dim + k]);
+						maxValue = std::max(maxValue, raw[f * dim + k]);
+					}
+					const float scale = (maxValue - minValue) / 65535.f;
+					for (size_t f = 0; f <= length; f++) {
+						quantized[f * dim + k] = scale > 0.f ? QuantizeUnorm16((raw[f * dim + k] - minValue) / (maxValue - minValue)) : 0;
+						decoded[f * dim + k] = minValue + quantized[f * dim + k] * scale;
+					}
+					range[k] = minValue;
+					range[dim + k] = scale;
+				}
+				builder.ranges.insert(builder.ranges.end(), range, range + 2 * dim);
+			}
+
+			// greedy : the farthest key that interpolates the frames in between within the error
+			std::vector<uint8_t> keys{ 0 };
+			const float error = GetError(channel);
+			float interpolated[4];
+			for (size_t a = 0; a < length;) {
+				size_t b = a + 1;
+				for (size_t next = a + 2; next <= length; next++) {
+					bool within = true;
+					for (size_t f = a + 1; f < next && within; f++) {
+						Interpolate(channel, interpolated, &decoded[a * dim], &decoded[next * dim], float(f - a) / float(next - a));
+						within = ChannelError(channel, interpolated, raw + f * dim) <= error;
+					}
+					if (!within)
+						break;
+					b = next;
+				}
+				keys.push_back(static_cast<uint8_t>(b));
+				a = b;
+			}
+
+			builder.keyNums.push_back(static_cast<uint8_t>(keys.size()));
+			builder.keyFrames.insert(builder.keyFrames.end(), keys.begin(), keys.end());
+			for (size_t k = 0; k < valueDim; k++) {
+				for (auto f : keys)
+					builder.values.push_back(quantized[f * valueDim + k]);
+			}
+			if (channel == AnimationChannel::Rotation) {
+				for (auto f : keys)
+					builder.largest.push_back(largest[f]);
+			}
+			keyNum += keys.size();
+		}
+
+		Append(segmentData, builder.keyNums);
+		Append(segmentData, builder.keyFrames);
+		Append(segmentData, builder.ranges);
+		Append(segmentData, builder.values);
+		Append(segmentData, builder.largest);
+		segmentOffsets.push_back(static_cast<uint32_t>(segmentData.size()));
+	}
+}
+
+size_t AnimationClip::GetCompressedSize() const noexcept {
+	return constants.size() * sizeof(float) + segmentData.size();
+}
+
+void AnimationClip::Sample(AnimationPose& pose, float time, bool loop) const {
+	const size_t trackNum = GetTrackNum();
+	pose.Resize(trackNum);
+	std::copy(channelMasks.begin(), channelMasks.end(), pose.channelMasks.begin());
+
+	auto GetDst = [&](uint32_t id) -> float* {
+		const size_t track = id >> 2;
+		switch (static_cast<AnimationChannel>(id & 3))
+		{
+		case AnimationChannel::Translation:
+			return &pose.translations[track][0];
+		case AnimationChannel::Rotation:
+			return &pose.rotations[track][0];
+		default:
+			return &pose.scales[track];
+		}
+	};
+
+	const float* constant = constants.data();
+	for (auto id : constantChannels) {
+		const size_t dim = GetChannelDimension(static_cast<AnimationChannel>(id & 3));
+		std::copy(constant, constant + dim, GetDst(id));
+		constant += dim;
+	}
+
+	if (animatedChannels.empty())
+		return;
+
+	// frame in the clip
+	const float duration = GetDuration();
+	if (loop && duration > 0.f) {
+		time = std::fmod(time, duration);
+		if (time < 0.f)
+			time += duration;
+	}
+	const float frame = std::clamp(time * sampleRate, 0.f, static_cast<float>(frameNum - 1));
+	const size_t segment = std::min(static_cast<size_t>(frame) / segmentFrames, segmentOffsets.size() - 2);
+	const float localFrame = frame - static_cast<float>(segment * segmentFrames);
+
+	// walk the sections of the segment
+	const uint8_t* keyNums = segmentData.data() + segmentOffsets[segment];
+	const uint8_t* keyFrames = keyNums + animatedChannels.size();
+	size_t totalKeyNum = 0;
+	size_t rangeNum = 0;
+	size_t valueNum = 0;
+	for (size_t c = 0; c < animatedChannels.size(); c++) {
+		const auto channel = static_cast<AnimationChannel>(animatedChannels[c] & 3);
+		totalKeyNum += keyNums[c];
+		rangeNum += GetChannelRangeSize(channel);
+		valueNum += keyNums[c] * GetChannelValueSize(channel);
+	}
+	const uint8_t* ranges = keyFrames + totalKeyNum;
+	const uint8_t* values = ranges + rangeNum * sizeof(float);
+	const uint8_t* largest = values + valueNum * sizeof(uint16_t);
+
+	for (size_t c = 0; c < animatedChannels.size(); c++) {
+		const auto channel = static_cast<AnimationChannel>(animatedChannels[c] & 3);
+		const size_t dim = GetChannelDimension(channel);
+		const size_t valueDim = GetChannelValueSize(channel);
+		const size_t channelKeyNum = keyNums[c];
+
+		// keys k, k + 1 around the frame
+		size_t k = 0;
+		while (k + 2 < channelKeyNum && keyFrames[k + 1] <= localFrame)
+			k++;
+		const float t = std::min((localFrame - keyFrames[k]) / float(keyFrames[k + 1] - keyFrames[k]), 1.f);
+
+		float a[4];
+		float b[4];
+		if (channel == AnimationChannel::Rotation) {
+			uint16_t qa[3];
+			uint16_t qb[3];
+			for (size_t i = 0; i < 3; i++) {
+				qa[i] = Read<uint16_t>(values, i * channelKeyNum + k);
+				qb[i] = Read<uint16_t>(values, i * channelKeyNum + k + 1);
+			}
+			DecodeRotation(a, qa, largest[k]);
+			DecodeRotation(b, qb, largest[k + 1]);
+			largest += channelKeyNum;
+		}
+		else {
+			for (size_t i = 0; i < dim; i++) {
+				const float minValue = Read<float>(ranges, i);
+				const float scale = Read<float>(ranges, dim + i);
+				a[i] = minValue + Read<uint16_t>(values, i * channelKeyNum + k) * scale;
+				b[i] = minValue + Read<uint16_t>(values, i * channelKeyNum + k + 1) * scale;
+			}
+			ranges += GetChannelRangeSize(channel) * sizeof(float);
+		}
+		Interpolate(channel, GetDst(animatedChannels[c]), a, b, t);
+
+		keyFrames += channelKeyNum;
+		values += channelKeyNum * valueDim * sizeof(uint16_t);
+	}
+}
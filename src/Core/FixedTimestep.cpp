@@ -0,0 +1,130 @@
+#include <Utopia/Core/FixedTimestep.h>
+
+#include <Utopia/Core/Components/FixedTime.h>
+#include <Utopia/Core/Components/LocalToWorld.h>
+#include <Utopia/Core/Components/PrevLocalToWorld.h>
+
+#include <Utopia/Core/Profiler.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa::UECS;
+using namespace Ubpa;
+
+namespace {
+	// seeded : before a step, keep the LocalToWorld of the last step
+	// !seeded : after a step, seed the new entities with their first LocalToWorld
+	void StorePrevLocalToWorld(World& world, bool seeded) {
+		ArchetypeFilter filter;
+		filter.all = {
+			CmptAccessType::Of<Latest<LocalToWorld>>,
+			CmptAccessType::Of<Write<PrevLocalToWorld>>,
+		};
+		world.RunChunkJob(
+			[seeded](ChunkView chunk) {
+				auto L2Ws = chunk.GetCmptArray<LocalToWorld>();
+				auto prevL2Ws = chunk.GetCmptArray<PrevLocalToWorld>();
+				for (size_t j = 0; j < chunk.EntityNum(); j++) {
+					if (prevL2Ws[j].seeded != seeded)
+						continue;
+					prevL2Ws[j].value = L2Ws[j].value;
+					prevL2Ws[j].seeded = true;
+				}
+			},
+			filter,
+			true
+		);
+	}
+}
+
+FixedTimestep::FixedTimestep(double tickRate, size_t maxStepsPerFrame) noexcept
+	: tickRate{ 1. }, stepTime{ 1. }, maxStepsPerFrame{ 1 }
+{
+	SetTickRate(tickRate);
+	SetMaxStepsPerFrame(maxStepsPerFrame);
+}
+
+void FixedTimestep::SetTickRate(double tickRate) noexcept {
+	assert(tickRate > 0.);
+	this->tickRate = tickRate;
+	stepTime = 1. / tickRate;
+}
+
+void FixedTimestep::SetMaxStepsPerFrame(size_t num) noexcept {
+	maxStepsPerFrame = std::max<size_t>(num, 1);
+}
+
+size_t FixedTimestep::Advance(double frameTime) noexcept {
+	accumulator += std::max(frameTime, 0.);
+
+	const double maxTime = maxStepsPerFrame * stepTime;
+	if (accumulator > maxTime) {
+		// keep the fraction of a step so that alpha stays continuous
+		double dropped = std::floor((accumulator - maxTime) / stepTime) * stepTime;
+		droppedTime += dropped;
+		accumulator -= dropped;
+	}
+
+	size_t num = static_cast<size_t>(accumulator / stepTime);
+	num = std::min(num, maxStepsPerFrame);
+	accumulator -= num * stepTime;
+
+	return num;
+}
+
+size_t FixedTimestep::Update(World& world, double frameTime) {
+	UBPA_UTOPIA_PROFILE_SCOPE("FixedTimestep::Update");
+
+	size_t num = Advance(frameTime);
+
+	if (!world.entityMngr.GetSingleton<FixedTime>())
+		world.entityMngr.Create<FixedTime>();
+
+	for (size_t i = 0; i < num; i++) {
+		StorePrevLocalToWorld(world, true);
+
+		elapsedTime += stepTime;
+		stepCount++;
+
+		// world.Update() may change the structure, so get it every step
+		if (auto fixedTime = world.entityMngr.GetSingleton<FixedTime>()) {
+			fixedTime->elapsedTime = elapsedTime;
+			fixedTime->deltaTime = static_cast<float>(stepTime);
+			fixedTime->alpha = 0.f;
+		}
+
+		world.Update();
+		StorePrevLocalToWorld(world, false);
+	}
+
+	if (auto fixedTime = world.entityMngr.GetSingleton<FixedTime>()) {
+		fixedTime->elapsedTime = elapsedTime;
+		fixedTime->deltaTime = static_cast<float>(stepTime);
+		fixedTime->alpha = GetAlpha();
+	}
+
+	return num;
+}
+
+float FixedTimestep::GetAlpha() const noexcept {
+	return std::clamp(static_cast<float>(accumulator / stepTime), 0.f, 1.f);
+}
+
+void FixedTimestep::Reset() noexcept {
+	accumulator = 0.;
+	elapsedTime = 0.;
+	droppedTime = 0.;
+	stepCount = 0;
+}
+
+transformf FixedTimestep::Interpolate(const transformf& prev, const transformf& curr, float alpha) noexcept {
+	transformf rst;
+	for (size_t c = 0; c < 4; c++) {
+		for (size_t r = 0; r < 4; r++)
+			rst[c][r] = prev[c][r] + alpha * (curr[c][r] - prev[c][r]);
+	}
+	return rst;
+}
@@ -1,16 +1,20 @@
 #include <Utopia/Core/GameTimer.h>
 
-#include <windows.h>
+#include <chrono>
 
 using namespace Ubpa::Utopia;
 
+namespace {
+	int64_t GameTimerCount() noexcept {
+		return static_cast<int64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+}
+
 GameTimer::GameTimer()
 : mSecondsPerCount(0.0), mDeltaTime(-1.0), mBaseTime(0), 
   mPausedTime(0), mPrevTime(0), mCurrTime(0), mStopped(false)
 {
-	__int64 countsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-	mSecondsPerCount = 1.0 / (double)countsPerSec;
+	mSecondsPerCount = (double)std::chrono::steady_clock::period::num / (double)std::chrono::steady_clock::period::den;
 }
 
 // Returns the total time elapsed since Reset() was called, NOT counting any
@@ -54,8 +58,7 @@ float GameTimer::DeltaTime()const
 
 void GameTimer::Reset()
 {
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	int64_t currTime = GameTimerCount();
 
 	mBaseTime = currTime;
 	mPrevTime = currTime;
@@ -65,8 +68,7 @@ void GameTimer::Reset()
 
 void GameTimer::Start()
 {
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+	int64_t startTime = GameTimerCount();
 
 
 	// Accumulate the time elapsed between stop and start pairs.
@@ -89,8 +91,7 @@ void GameTimer::Stop()
 {
 	if( !mStopped )
 	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+		int64_t currTime = GameTimerCount();
 
 		mStopTime = currTime;
 		mStopped  = true;
@@ -105,8 +106,7 @@ void GameTimer::Tick()
 		return;
 	}
 
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	int64_t currTime = GameTimerCount();
 	mCurrTime = currTime;
 
 	// Time difference between this frame and the previous.
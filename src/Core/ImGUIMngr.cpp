@@ -1,5 +1,7 @@
 #include <Utopia/Core/ImGUIMngr.h>
 
+#include <UDX12/UDX12.h>
+
 #include <_deps/imgui/imgui.h>
 #include <_deps/imgui/imgui_impl_dx12.h>
 #include <_deps/imgui/imgui_impl_win32.h>
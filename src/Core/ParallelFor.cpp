@@ -0,0 +1,138 @@
+#include <Utopia/Core/ParallelFor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+
+namespace {
+	class ParallelForPool {
+	public:
+		static ParallelForPool& Instance() {
+			static ParallelForPool instance;
+			return instance;
+		}
+
+		size_t ThreadNum() const noexcept { return workers.size() + 1; }
+
+		bool Run(size_t num, size_t chunkSize, void(*task)(const void*, size_t, size_t), const void* ctx) {
+			// nested in a chunk, the calling thread may own runMutex
+			if (inChunk)
+				return false;
+			std::unique_lock<std::mutex> runLock(runMutex, std::try_to_lock);
+			if (!runLock.owns_lock())
+				return false;
+
+			// a worker waking late keeps the finished job, it has no chunk left
+			auto job = std::make_shared<Job>();
+			job->num = num;
+			job->chunkSize = chunkSize;
+			job->chunkNum = (num + chunkSize - 1) / chunkSize;
+			job->task = task;
+			job->ctx = ctx;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				this->job = job;
+				generation++;
+			}
+			jobCV.notify_all();
+
+			Work(*job);
+
+			std::unique_lock<std::mutex> lock(mutex);
+			doneCV.wait(lock, [&]() { return job->doneNum.load() == job->chunkNum; });
+			return true;
+		}
+
+	private:
+		struct Job {
+			size_t num;
+			size_t chunkSize;
+			size_t chunkNum;
+			void(*task)(const void*, size_t, size_t);
+			const void* ctx;
+			std::atomic<size_t> nextChunk{ 0 };
+			std::atomic<size_t> doneNum{ 0 };
+		};
+
+		ParallelForPool() {
+			// the UECS executor runs the jobs on its own workers, don't oversubscribe the cores
+			const size_t threadNum = std::max<size_t>(std::thread::hardware_concurrency() / 2, 1);
+			for (size_t i = 1; i < threadNum; i++)
+				workers.emplace_back([this]() { WorkerLoop(); });
+		}
+
+		~ParallelForPool() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stop = true;
+			}
+			jobCV.notify_all();
+			for (auto& worker : workers)
+				worker.join();
+		}
+
+		void Work(Job& job) {
+			for (size_t chunk = job.nextChunk++; chunk < job.chunkNum; chunk = job.nextChunk++) {
+				const size_t begin = chunk * job.chunkSize;
+				inChunk = true;
+				job.task(job.ctx, begin, std::min(job.num, begin + job.chunkSize));
+				inChunk = false;
+				if (++job.doneNum == job.chunkNum) {
+					std::lock_guard<std::mutex> lock(mutex);
+					doneCV.notify_all();
+				}
+			}
+		}
+
+		void WorkerLoop() {
+			uint64_t seenGeneration = 0;
+			for (;;) {
+				std::shared_ptr<Job> curJob;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					jobCV.wait(lock, [&]() { return stop || generation != seenGeneration; });
+					if (stop)
+						return;
+					seenGeneration = generation;
+					curJob = job;
+				}
+				Work(*curJob);
+			}
+		}
+
+		static thread_local bool inChunk;
+
+		std::vector<std::thread> workers;
+
+		std::mutex runMutex; // one loop at a time
+
+		std::mutex mutex;
+		std::condition_variable jobCV;
+		std::condition_variable doneCV;
+		std::shared_ptr<Job> job;
+		uint64_t generation{ 0 };
+		bool stop{ false };
+	};
+}
+
+thread_local bool ParallelForPool::inChunk = false;
+
+size_t Ubpa::Utopia::details::ParallelForThreadNum() noexcept {
+	return ParallelForPool::Instance().ThreadNum();
+}
+
+bool Ubpa::Utopia::details::ParallelForChunks(
+	size_t num,
+	size_t chunkSize,
+	void(*task)(const void*, size_t, size_t),
+	const void* ctx
+) {
+	return ParallelForPool::Instance().Run(num, chunkSize, task, ctx);
+}
@@ -0,0 +1,330 @@
+#include <Utopia/Core/Profiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define UBPA_UTOPIA_PROFILER_TSC
+#endif
+
+using namespace Ubpa::Utopia;
+
+namespace Ubpa::Utopia::details {
+	// single producer (owner thread), multiple consumers (Collect)
+	struct ProfilerThreadBuffer {
+		ProfilerThreadBuffer(size_t capacity, uint32_t threadID)
+			: zones{ new Profiler::Zone[capacity] }, mask{ capacity - 1 }, threadID{ threadID } {}
+
+		std::unique_ptr<Profiler::Zone[]> zones;
+		const size_t mask;
+		const uint32_t threadID;
+		std::atomic<uint64_t> head{ 0 };
+		ProfileScope* currentScope{ nullptr }; // innermost scope, owner thread only
+
+		void Push(const Profiler::Zone& zone) noexcept {
+			uint64_t h = head.load(std::memory_order_relaxed);
+			auto& dst = zones[h & mask];
+			dst = zone;
+			dst.threadID = threadID;
+			head.store(h + 1, std::memory_order_release);
+		}
+	};
+}
+
+namespace {
+	thread_local Ubpa::Utopia::details::ProfilerThreadBuffer* tlsBuffer{ nullptr };
+
+	// (ticks, ns) read back to back, the tightest of a few tries (the first clock call may be slow)
+	struct ClockPair {
+		uint64_t ticks;
+		uint64_t ns;
+
+		static ClockPair Read() noexcept {
+			ClockPair rst{ 0, 0 };
+			uint64_t minGap = static_cast<uint64_t>(-1);
+			for (size_t i = 0; i < 4; i++) {
+				const uint64_t t0 = Profiler::Ticks();
+				const uint64_t ns = Profiler::Now();
+				const uint64_t t1 = Profiler::Ticks();
+				if (t1 - t0 < minGap) {
+					minGap = t1 - t0;
+					rst = { t0 + (t1 - t0) / 2, ns };
+				}
+			}
+			return rst;
+		}
+	};
+
+	void DumpJSONString(std::ostream& os, std::string_view str) {
+		os << '"';
+		for (char c : str) {
+			switch (c)
+			{
+			case '"': os << "\\\""; break;
+			case '\\': os << "\\\\"; break;
+			case '\n': os << "\\n"; break;
+			case '\t': os << "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+					os << ' ';
+				else
+					os << c;
+				break;
+			}
+		}
+		os << '"';
+	}
+}
+
+struct Profiler::Impl {
+	std::atomic<bool> enabled{ true };
+	std::atomic<uint64_t> clearTime{ 0 }; // ticks
+	const ClockPair base{ ClockPair::Read() };
+
+	std::mutex mutex; // buffers, names, capacity
+	size_t capacity{ 1 << 14 };
+	std::vector<std::unique_ptr<details::ProfilerThreadBuffer>> buffers;
+	std::set<std::string, std::less<>> names;
+
+	details::ProfilerThreadBuffer* GetThreadBuffer() {
+		if (tlsBuffer)
+			return tlsBuffer;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		buffers.push_back(std::make_unique<details::ProfilerThreadBuffer>(
+			capacity, static_cast<uint32_t>(buffers.size())
+		));
+		tlsBuffer = buffers.back().get();
+		return tlsBuffer;
+	}
+
+	// ticks -> ns, the rate is measured from the construction to now
+	std::vector<Profiler::Zone> ToNs(std::vector<Profiler::Zone> zones) const {
+		const ClockPair now = ClockPair::Read();
+		const double nsPerTick = now.ticks > base.ticks
+			? double(now.ns - base.ns) / double(now.ticks - base.ticks)
+			: 1.;
+		auto convert = [&](uint64_t ticks) {
+			return base.ns + static_cast<uint64_t>(double(ticks - base.ticks) * nsPerTick);
+		};
+		for (auto& zone : zones) {
+			zone.begin = convert(zone.begin);
+			zone.end = convert(zone.end);
+		}
+		return zones;
+	}
+};
+
+Profiler::Profiler() : pImpl{ new Impl } {}
+
+Profiler::~Profiler() { delete pImpl; }
+
+uint64_t Profiler::Now() noexcept {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count());
+}
+
+uint64_t Profiler::Ticks() noexcept {
+#ifdef UBPA_UTOPIA_PROFILER_TSC
+	return __rdtsc();
+#else
+	return Now();
+#endif
+}
+
+void Profiler::SetEnabled(bool enabled) noexcept {
+	pImpl->enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::IsEnabled() const noexcept {
+	return pImpl->enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadBufferCapacity(size_t capacity) {
+	size_t pow2 = 1;
+	while (pow2 < capacity)
+		pow2 <<= 1;
+	std::lock_guard<std::mutex> lock(pImpl->mutex);
+	pImpl->capacity = pow2;
+}
+
+const char* Profiler::Intern(std::string_view name) {
+	std::lock_guard<std::mutex> lock(pImpl->mutex);
+	auto target = pImpl->names.find(name);
+	if (target == pImpl->names.end())
+		target = pImpl->names.emplace_hint(target, name);
+	return target->c_str();
+}
+
+void Profiler::Record(const Zone& zone) noexcept {
+	pImpl->GetThreadBuffer()->Push(zone);
+}
+
+std::vector<Profiler::Zone> Profiler::Collect() const {
+	std::vector<Zone> rst;
+	const uint64_t clearTime = pImpl->clearTime.load(std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> lock(pImpl->mutex);
+	for (const auto& buffer : pImpl->buffers) {
+		const uint64_t capacity = buffer->mask + 1;
+		const uint64_t head0 = buffer->head.load(std::memory_order_acquire);
+		const uint64_t begin = head0 > capacity ? head0 - capacity : 0;
+		const size_t offset = rst.size();
+		for (uint64_t i = begin; i < head0; i++)
+			rst.push_back(buffer->zones[i & buffer->mask]);
+
+		// drop the zones which may be overwritten during the copy
+		const uint64_t head1 = buffer->head.load(std::memory_order_acquire);
+		const uint64_t safeBegin = head1 >= capacity ? head1 - capacity + 1 : 0;
+		if (safeBegin > begin) {
+			size_t num = static_cast<size_t>(std::min(safeBegin, head0) - begin);
+			rst.erase(rst.begin() + offset, rst.begin() + offset + num);
+		}
+	}
+
+	rst.erase(
+		std::remove_if(rst.begin(), rst.end(), [=](const Zone& zone) { return zone.begin < clearTime; }),
+		rst.end()
+	);
+	std::sort(rst.begin(), rst.end(), [](const Zone& lhs, const Zone& rhs) {
+		return lhs.begin < rhs.begin;
+	});
+
+	return pImpl->ToNs(std::move(rst));
+}
+
+std::vector<Profiler::ZoneStats> Profiler::GetStats(uint64_t window) const {
+	auto zones = Collect();
+	const uint64_t now = Now();
+	const uint64_t windowBegin = now > window ? now - window : 0;
+
+	std::map<std::string_view, ZoneStats> statsMap;
+	std::map<std::string_view, uint64_t> lastEndMap;
+	for (const auto& zone : zones) {
+		if (zone.end < windowBegin)
+			continue;
+
+		double ms = (zone.end - zone.begin) / 1000000.;
+		auto& stats = statsMap[zone.name];
+		if (stats.count == 0) {
+			stats.name = zone.name;
+			stats.minMs = ms;
+			stats.maxMs = ms;
+		}
+		else {
+			stats.minMs = std::min(stats.minMs, ms);
+			stats.maxMs = std::max(stats.maxMs, ms);
+		}
+		stats.count++;
+		stats.totalMs += ms;
+
+		auto& lastEnd = lastEndMap[zone.name];
+		if (zone.end >= lastEnd) {
+			lastEnd = zone.end;
+			stats.lastMs = ms;
+		}
+	}
+
+	std::vector<ZoneStats> rst;
+	rst.reserve(statsMap.size());
+	for (auto& [name, stats] : statsMap) {
+		stats.meanMs = stats.totalMs / stats.count;
+		rst.push_back(stats);
+	}
+	std::sort(rst.begin(), rst.end(), [](const ZoneStats& lhs, const ZoneStats& rhs) {
+		return lhs.totalMs > rhs.totalMs;
+	});
+
+	return rst;
+}
+
+std::string Profiler::DumpChromeTrace() const {
+	auto zones = Collect();
+
+	std::ostringstream os;
+	os.precision(3);
+	os << std::fixed;
+	os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (size_t i = 0; i < zones.size(); i++) {
+		const auto& zone = zones[i];
+		if (i != 0)
+			os << ',';
+		os << "\n{\"name\":";
+		DumpJSONString(os, zone.name);
+		os << ",\"cat\":\"Utopia\",\"ph\":\"X\",\"pid\":0,\"tid\":" << zone.threadID
+			<< ",\"ts\":" << (zone.begin - pImpl->base.ns) / 1000.
+			<< ",\"dur\":" << (zone.end - zone.begin) / 1000.;
+		if (zone.counterName) {
+			os << ",\"args\":{";
+			DumpJSONString(os, zone.counterName);
+			os << ':' << zone.counter << '}';
+		}
+		os << '}';
+	}
+	os << "\n]}\n";
+
+	return os.str();
+}
+
+bool Profiler::ExportChromeTrace(const std::filesystem::path& path) const {
+	std::ofstream ofs{ path };
+	if (!ofs.is_open())
+		return false;
+
+	ofs << DumpChromeTrace();
+	return true;
+}
+
+void Profiler::Clear() {
+	pImpl->clearTime.store(Ticks(), std::memory_order_relaxed);
+}
+
+// ============================
+//         ProfileScope
+// ============================
+
+ProfileScope::ProfileScope(const char* name) noexcept {
+	auto& profiler = Profiler::Instance();
+	if (!profiler.IsEnabled())
+		return;
+
+	// one thread-local lookup, the destructor reuses the buffer
+	buffer = profiler.pImpl->GetThreadBuffer();
+	outer = buffer->currentScope;
+	buffer->currentScope = this;
+	zone.name = name;
+	zone.depth = outer ? outer->zone.depth + 1 : 0;
+	zone.begin = Profiler::Ticks();
+}
+
+ProfileScope::~ProfileScope() {
+	if (!buffer)
+		return;
+
+	zone.end = Profiler::Ticks();
+	buffer->currentScope = outer;
+	buffer->Push(zone);
+}
+
+void ProfileScope::SetCounter(const char* name, int64_t value) noexcept {
+	zone.counterName = name;
+	zone.counter = value;
+}
+
+void ProfileScope::SetCurrentCounter(const char* name, int64_t value) noexcept {
+	if (tlsBuffer && tlsBuffer->currentScope)
+		tlsBuffer->currentScope->SetCounter(name, value);
+}
@@ -1,23 +1,115 @@
 #include <Utopia/Core/StringsSink.h>
 
-#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/pattern_formatter.h>
 
 using namespace Ubpa::Utopia;
 
-std::vector<std::string> StringsSink::CopyLogs() const noexcept {
-	std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(base_sink<std::mutex>::mutex_));
-	std::vector<std::string> rst(logs.begin(), logs.end());
+namespace {
+	size_t StringsSinkRingSize(size_t capacity) noexcept {
+		size_t pow2 = 2;
+		while (pow2 < capacity)
+			pow2 <<= 1;
+		return pow2;
+	}
+}
+
+StringsSink::StringsSink(size_t capacity, size_t historyCapacity)
+	: slots{ new Slot[StringsSinkRingSize(capacity)] },
+	mask{ StringsSinkRingSize(capacity) - 1 },
+	historyCapacity{ historyCapacity > 0 ? historyCapacity : 1 }
+{
+	for (size_t i = 0; i <= mask; i++)
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+StringsSink::~StringsSink() = default;
+
+std::vector<std::string> StringsSink::CopyLogs() {
+	std::vector<std::string> rst;
+	ForEach([&](const Log& log) {
+		rst.emplace_back(log.text);
+	});
 	return rst;
 }
 
 void StringsSink::Clear() {
-	std::lock_guard<std::mutex> lock(base_sink<std::mutex>::mutex_);
-	logs.clear();
+	std::lock_guard<std::mutex> lock(readMutex);
+	Drain();
+	history.clear();
+}
+
+uint64_t StringsSink::GetFirstID() {
+	std::lock_guard<std::mutex> lock(readMutex);
+	Drain();
+	return history.empty() ? nextID.load(std::memory_order_relaxed) : history.front().id;
 }
 
 void StringsSink::sink_it_(const spdlog::details::log_msg& msg) {
-	spdlog::details::log_msg_buffer buffer{ msg };
-	spdlog::memory_buf_t formatted;
-	base_sink<std::mutex>::formatter_->format(buffer, formatted);
-	logs.push_back(fmt::to_string(formatted));
+	// bounded MPSC queue (Vyukov)
+	size_t pos = enqueuePos.load(std::memory_order_relaxed);
+	Slot* slot;
+	for (;;) {
+		slot = &slots[pos & mask];
+		size_t seq = slot->sequence.load(std::memory_order_acquire);
+		auto dif = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+		if (dif == 0) {
+			if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (dif < 0) { // full
+			droppedNum.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+			pos = enqueuePos.load(std::memory_order_relaxed);
+	}
+
+	slot->msg = spdlog::details::log_msg_buffer{ msg };
+	slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void StringsSink::set_pattern_(const std::string& pattern) {
+	set_formatter_(std::make_unique<spdlog::pattern_formatter>(pattern));
+}
+
+void StringsSink::set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter) {
+	std::lock_guard<std::mutex> lock(readMutex);
+	formatter_ = std::move(sink_formatter);
+	for (auto& entry : history)
+		entry.formatted = false;
+}
+
+void StringsSink::Drain() {
+	for (;;) {
+		auto& slot = slots[dequeuePos & mask];
+		size_t seq = slot.sequence.load(std::memory_order_acquire);
+		if (seq != dequeuePos + 1)
+			break;
+
+		if (history.size() == historyCapacity) {
+			history.pop_front();
+			evictedNum.fetch_add(1, std::memory_order_relaxed);
+		}
+		history.push_back(Entry{ nextID.fetch_add(1, std::memory_order_relaxed), std::move(slot.msg) });
+
+		slot.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+		dequeuePos++;
+	}
+}
+
+StringsSink::Log StringsSink::Read(Entry& entry) {
+	if (!entry.formatted) {
+		spdlog::memory_buf_t formatted;
+		formatter_->format(entry.msg, formatted);
+		entry.text.assign(formatted.data(), formatted.size());
+		entry.formatted = true;
+	}
+
+	Log log;
+	log.id = entry.id;
+	log.level = entry.msg.level;
+	log.time = entry.msg.time;
+	log.threadID = entry.msg.thread_id;
+	log.text = entry.text;
+	return log;
 }
@@ -0,0 +1,124 @@
+#include <Utopia/Core/Systems/AnimatorSystem.h>
+
+#include <Utopia/Core/Components/AnimationTarget.h>
+#include <Utopia/Core/Components/Animator.h>
+#include <Utopia/Core/Components/Rotation.h>
+#include <Utopia/Core/Components/Scale.h>
+#include <Utopia/Core/Components/Translation.h>
+#include <Utopia/Core/Components/WorldTime.h>
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa::UECS;
+
+namespace {
+	// poses sampled by the animator job, read by the target job of the same world update
+	// the worlds are updated one at a time
+	struct SampledPoses {
+		static SampledPoses& Instance() noexcept {
+			static SampledPoses instance;
+			return instance;
+		}
+
+		// return a pose of the animator, reused across the frames
+		AnimationPose& Acquire(Entity animator) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (num == poses.size())
+				poses.emplace_back(); // the references to the other poses stay valid
+			AnimationPose& pose = poses[num++];
+			if (animator.Idx() >= table.size())
+				table.resize(animator.Idx() + 1);
+			table[animator.Idx()] = { animator.Version(), &pose };
+			return pose;
+		}
+
+		// nullptr if the animator is not sampled in this update
+		const AnimationPose* Find(Entity animator) const noexcept {
+			if (animator.Idx() >= table.size())
+				return nullptr;
+			const auto& entry = table[animator.Idx()];
+			return entry.version == animator.Version() ? entry.pose : nullptr;
+		}
+
+		void Clear() noexcept {
+			for (auto& entry : table)
+				entry.pose = nullptr;
+			num = 0;
+		}
+
+		struct Entry {
+			size_t version{ 0 };
+			const AnimationPose* pose{ nullptr };
+		};
+
+		std::mutex mutex;
+		std::deque<AnimationPose> poses;
+		size_t num{ 0 };
+		// indexed by the entity index of the animator
+		std::vector<Entry> table;
+	};
+}
+
+void AnimatorSystem::OnUpdate(Schedule& schedule) {
+	schedule.RegisterEntityJob(
+		[](Entity e, Animator* animator, Latest<Singleton<WorldTime>> time) {
+			if (!animator->clip)
+				return;
+
+			const float dt = time->deltaTime;
+			animator->time += animator->speed * dt;
+			animator->blendTime += animator->speed * dt;
+
+			auto& pose = SampledPoses::Instance().Acquire(e);
+			animator->clip->Sample(pose, animator->time, animator->loop);
+			if (animator->blendClip && animator->blendWeight > 0.f) {
+				// reused by the jobs of the thread
+				thread_local AnimationPose blendPose;
+				animator->blendClip->Sample(blendPose, animator->blendTime, animator->loop);
+				BlendAnimationPoses(pose, blendPose, animator->blendWeight);
+			}
+		},
+		SystemFuncName,
+		true
+	);
+
+	// writes the TRS, the TRS systems read the latest ones
+	ArchetypeFilter filter;
+	filter.all = { CmptAccessType::Of<Latest<AnimationTarget>> };
+	filter.any = {
+		CmptAccessType::Of<Write<Translation>>,
+		CmptAccessType::Of<Write<Rotation>>,
+		CmptAccessType::Of<Write<Scale>>,
+	};
+	schedule.RegisterChunkJob([](ChunkView chunk) {
+		constexpr uint8_t T = GetAnimationChannelBit(AnimationChannel::Translation);
+		constexpr uint8_t R = GetAnimationChannelBit(AnimationChannel::Rotation);
+		constexpr uint8_t S = GetAnimationChannelBit(AnimationChannel::Scale);
+		const auto& sampled = SampledPoses::Instance();
+		auto chunkTarget = chunk.GetCmptArray<AnimationTarget>();
+		auto chunkT = chunk.GetCmptArray<Translation>();
+		auto chunkR = chunk.GetCmptArray<Rotation>();
+		auto chunkS = chunk.GetCmptArray<Scale>();
+		for (size_t i = 0; i < chunk.EntityNum(); i++) {
+			const auto* pose = sampled.Find(chunkTarget[i].animator);
+			const size_t track = chunkTarget[i].track;
+			if (!pose || track >= pose->channelMasks.size())
+				continue;
+			const uint8_t mask = pose->channelMasks[track];
+			if (chunkT && (mask & T))
+				chunkT[i].value = pose->translations[track];
+			if (chunkR && (mask & R))
+				chunkR[i].value = pose->rotations[track];
+			if (chunkS && (mask & S))
+				chunkS[i].value = pose->scales[track];
+		}
+	}, TargetFuncName, filter);
+	schedule.Order(SystemFuncName, TargetFuncName);
+
+	schedule.RegisterCommand([](World*) {
+		SampledPoses::Instance().Clear();
+	});
+}
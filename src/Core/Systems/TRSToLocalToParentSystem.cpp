@@ -5,6 +5,8 @@
 #include <Utopia/Core/Components/Scale.h>
 #include <Utopia/Core/Components/Translation.h>
 
+#include <Utopia/Core/Profiler.h>
+
 using namespace Ubpa::Utopia;
 
 void TRSToLocalToParentSystem::OnUpdate(UECS::Schedule& schedule) {
@@ -17,6 +19,8 @@ void TRSToLocalToParentSystem::OnUpdate(UECS::Schedule& schedule) {
 	};
 
 	schedule.RegisterChunkJob([](UECS::ChunkView chunk) {
+		UBPA_UTOPIA_PROFILE_SCOPE(SystemFuncName);
+		UBPA_UTOPIA_PROFILE_COUNTER("entities", chunk.EntityNum());
 		auto chunkL2P = chunk.GetCmptArray<LocalToParent>();
 		auto chunkT = chunk.GetCmptArray<Translation>();
 		auto chunkR = chunk.GetCmptArray<Rotation>();
@@ -1,6 +1,7 @@
 #include <Utopia/Core/Systems/WorldTimeSystem.h>
 
 #include <Utopia/Core/Components/WorldTime.h>
+#include <Utopia/Core/Components/FixedTime.h>
 
 #include <Utopia/Core/GameTimer.h>
 
@@ -8,7 +9,13 @@ using namespace Ubpa::Utopia;
 using namespace Ubpa::UECS;
 
 void WorldTimeSystem::OnUpdate(Schedule& schedule) {
-	schedule.RegisterJob([](Singleton<WorldTime> time) {
+	schedule.RegisterJob([](World* w, Singleton<WorldTime> time) {
+		// the world is driven by FixedTimestep
+		if (auto fixedTime = w->entityMngr.GetSingleton<FixedTime>()) {
+			time->elapsedTime = fixedTime->elapsedTime;
+			time->deltaTime = fixedTime->deltaTime;
+			return;
+		}
 		time->elapsedTime = GameTimer::Instance().TotalTime();
 		time->deltaTime = GameTimer::Instance().DeltaTime();
 	}, SystemFuncName);
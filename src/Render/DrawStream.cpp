@@ -0,0 +1,76 @@
+#include <Utopia/Render/DrawStream.h>
+
+using namespace Ubpa::Utopia;
+
+void DrawStream::Clear() {
+	records.clear();
+	bindings.clear();
+	stats = {};
+
+	hasState = false;
+	rootSignature = 0;
+	pso = 0;
+	mesh = 0;
+	hasStencilRef = false;
+	stencilRef = 0;
+	slotBound.clear();
+	slotValues.clear();
+}
+
+void DrawStream::Add(const DrawState& state) {
+	DrawRecord record;
+	record.flags = 0;
+	record.rootSignature = state.rootSignature;
+	record.pso = state.pso;
+	record.mesh = state.mesh;
+	record.stencilRef = state.stencilRef;
+
+	if (!hasState || state.rootSignature != rootSignature) {
+		record.flags |= DrawRecord::SetRootSignature;
+		rootSignature = state.rootSignature;
+		slotBound.assign(slotBound.size(), 0);
+		stats.rootSignatureChanges++;
+	}
+	if (!hasState || state.pso != pso) {
+		record.flags |= DrawRecord::SetPSO;
+		pso = state.pso;
+		stats.psoChanges++;
+	}
+	if (!hasState || state.mesh != mesh) {
+		record.flags |= DrawRecord::SetMesh;
+		mesh = state.mesh;
+		stats.meshChanges++;
+	}
+	if (state.stencilEnable && (!hasStencilRef || state.stencilRef != stencilRef)) {
+		record.flags |= DrawRecord::SetStencilRef;
+		hasStencilRef = true;
+		stencilRef = state.stencilRef;
+		stats.stencilRefChanges++;
+	}
+	hasState = true;
+
+	record.bindingOffset = static_cast<uint32_t>(bindings.size());
+	for (size_t i = 0; i < state.bindingNum; i++) {
+		const auto& binding = state.bindings[i];
+		if (binding.slot >= slotBound.size()) {
+			slotBound.resize(binding.slot + 1, 0);
+			slotValues.resize(binding.slot + 1, 0);
+		}
+		if (slotBound[binding.slot] && slotValues[binding.slot] == binding.value) {
+			stats.skippedBindings++;
+			continue;
+		}
+		slotBound[binding.slot] = 1;
+		slotValues[binding.slot] = binding.value;
+		bindings.push_back(binding);
+	}
+	record.bindingNum = static_cast<uint32_t>(bindings.size()) - record.bindingOffset;
+	stats.bindings += record.bindingNum;
+
+	record.indexCount = state.indexCount;
+	record.instanceCount = state.instanceCount;
+	record.startIndex = state.startIndex;
+	record.baseVertex = state.baseVertex;
+	records.push_back(record);
+	stats.draws++;
+}
@@ -0,0 +1,54 @@
+#include <Utopia/Render/FrameGraphCache.h>
+
+using namespace Ubpa::Utopia;
+
+namespace {
+	// separate the node kinds, "a" + "bc" != "ab" + "c"
+	enum class Tag : uint64_t {
+		Resource = 1,
+		Pass,
+		Move,
+		Param
+	};
+}
+
+void FrameGraphTopology::Clear() noexcept {
+	hash = FrameGraphTopology{}.hash;
+}
+
+void FrameGraphTopology::Combine(const void* data, size_t size) noexcept {
+	const auto* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+void FrameGraphTopology::AddResourceNode(std::string_view name) noexcept {
+	Combine(static_cast<uint64_t>(Tag::Resource));
+	Combine(name.size());
+	Combine(name.data(), name.size());
+}
+
+void FrameGraphTopology::AddPassNode(std::string_view name, const std::vector<size_t>& inputs, const std::vector<size_t>& outputs) noexcept {
+	Combine(static_cast<uint64_t>(Tag::Pass));
+	Combine(name.size());
+	Combine(name.data(), name.size());
+	Combine(inputs.size());
+	for (auto input : inputs)
+		Combine(input);
+	Combine(outputs.size());
+	for (auto output : outputs)
+		Combine(output);
+}
+
+void FrameGraphTopology::AddMoveNode(size_t dst, size_t src) noexcept {
+	Combine(static_cast<uint64_t>(Tag::Move));
+	Combine(dst);
+	Combine(src);
+}
+
+void FrameGraphTopology::AddParam(uint64_t value) noexcept {
+	Combine(static_cast<uint64_t>(Tag::Param));
+	Combine(value);
+}
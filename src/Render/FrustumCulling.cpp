@@ -0,0 +1,185 @@
+#include <Utopia/Render/FrustumCulling.h>
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define UBPA_UTOPIA_FRUSTUM_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+namespace {
+	// m is column-major: m[col][row]
+	float Elem(const transformf& m, size_t r, size_t c) noexcept {
+		return m[c][r];
+	}
+
+	std::array<float, 4> Normalize(float a, float b, float c, float d) noexcept {
+		float len = std::sqrt(a * a + b * b + c * c);
+		if (len > 0.f) {
+			float inv = 1.f / len;
+			return { a * inv, b * inv, c * inv, d * inv };
+		}
+		return { a, b, c, d };
+	}
+
+	bool IsVisible(const Frustum& frustum, const CullingBounds& bounds, size_t i) noexcept {
+		for (const auto& p : frustum.planes) {
+			// same order as the SSE path
+			float dist = (p[0] * bounds.centerX[i] + p[1] * bounds.centerY[i]) + (p[2] * bounds.centerZ[i] + p[3]);
+			float radius = (std::abs(p[0]) * bounds.extentX[i] + std::abs(p[1]) * bounds.extentY[i]) + std::abs(p[2]) * bounds.extentZ[i];
+			if (dist + radius < 0.f)
+				return false;
+		}
+		return true;
+	}
+}
+
+Frustum Frustum::FromMatrix(const transformf& m, float nearClipValue) noexcept {
+	auto row = [&](size_t r) {
+		return std::array<float, 4>{ Elem(m, r, 0), Elem(m, r, 1), Elem(m, r, 2), Elem(m, r, 3) };
+	};
+	const auto r0 = row(0);
+	const auto r1 = row(1);
+	const auto r2 = row(2);
+	const auto r3 = row(3);
+
+	Frustum frustum;
+	frustum.planes[0] = Normalize(r3[0] + r0[0], r3[1] + r0[1], r3[2] + r0[2], r3[3] + r0[3]); // left
+	frustum.planes[1] = Normalize(r3[0] - r0[0], r3[1] - r0[1], r3[2] - r0[2], r3[3] - r0[3]); // right
+	frustum.planes[2] = Normalize(r3[0] + r1[0], r3[1] + r1[1], r3[2] + r1[2], r3[3] + r1[3]); // bottom
+	frustum.planes[3] = Normalize(r3[0] - r1[0], r3[1] - r1[1], r3[2] - r1[2], r3[3] - r1[3]); // top
+	// z >= nearClipValue * w
+	frustum.planes[4] = Normalize(
+		r2[0] - nearClipValue * r3[0],
+		r2[1] - nearClipValue * r3[1],
+		r2[2] - nearClipValue * r3[2],
+		r2[3] - nearClipValue * r3[3]
+	); // near
+	frustum.planes[5] = Normalize(r3[0] - r2[0], r3[1] - r2[1], r3[2] - r2[2], r3[3] - r2[3]); // far
+	return frustum;
+}
+
+void CullingBounds::Reserve(size_t n) {
+	centerX.reserve(n);
+	centerY.reserve(n);
+	centerZ.reserve(n);
+	extentX.reserve(n);
+	extentY.reserve(n);
+	extentZ.reserve(n);
+}
+
+void CullingBounds::Clear() noexcept {
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	extentX.clear();
+	extentY.clear();
+	extentZ.clear();
+}
+
+size_t CullingBounds::Add(const bboxf3& localBounds, const transformf& l2w) {
+	const auto& minP = localBounds.minP();
+	const auto& maxP = localBounds.maxP();
+	const float c[3] = {
+		0.5f * (minP[0] + maxP[0]),
+		0.5f * (minP[1] + maxP[1]),
+		0.5f * (minP[2] + maxP[2]),
+	};
+	const float e[3] = {
+		0.5f * (maxP[0] - minP[0]),
+		0.5f * (maxP[1] - minP[1]),
+		0.5f * (maxP[2] - minP[2]),
+	};
+
+	float wc[3];
+	float we[3];
+	for (size_t r = 0; r < 3; r++) {
+		wc[r] = Elem(l2w, r, 3);
+		we[r] = 0.f;
+		for (size_t k = 0; k < 3; k++) {
+			wc[r] += Elem(l2w, r, k) * c[k];
+			we[r] += std::abs(Elem(l2w, r, k)) * e[k];
+		}
+	}
+
+	centerX.push_back(wc[0]);
+	centerY.push_back(wc[1]);
+	centerZ.push_back(wc[2]);
+	extentX.push_back(we[0]);
+	extentY.push_back(we[1]);
+	extentZ.push_back(we[2]);
+	return Size() - 1;
+}
+
+size_t CullingBounds::Add(const bboxf3& worldBounds) {
+	const auto& minP = worldBounds.minP();
+	const auto& maxP = worldBounds.maxP();
+	centerX.push_back(0.5f * (minP[0] + maxP[0]));
+	centerY.push_back(0.5f * (minP[1] + maxP[1]));
+	centerZ.push_back(0.5f * (minP[2] + maxP[2]));
+	extentX.push_back(0.5f * (maxP[0] - minP[0]));
+	extentY.push_back(0.5f * (maxP[1] - minP[1]));
+	extentZ.push_back(0.5f * (maxP[2] - minP[2]));
+	return Size() - 1;
+}
+
+void Ubpa::Utopia::FrustumCull_Scalar(const Frustum& frustum, const CullingBounds& bounds, uint8_t* visible) noexcept {
+	for (size_t i = 0; i < bounds.Size(); i++)
+		visible[i] = IsVisible(frustum, bounds, i) ? 1 : 0;
+}
+
+void Ubpa::Utopia::FrustumCull(const Frustum& frustum, const CullingBounds& bounds, uint8_t* visible) noexcept {
+	const size_t n = bounds.Size();
+	size_t i = 0;
+
+#ifdef UBPA_UTOPIA_FRUSTUM_CULLING_SSE
+	// plane coefficients and their absolute values, broadcast
+	__m128 pa[6], pb[6], pc[6], pd[6], absA[6], absB[6], absC[6];
+	for (size_t k = 0; k < 6; k++) {
+		const auto& p = frustum.planes[k];
+		pa[k] = _mm_set1_ps(p[0]);
+		pb[k] = _mm_set1_ps(p[1]);
+		pc[k] = _mm_set1_ps(p[2]);
+		pd[k] = _mm_set1_ps(p[3]);
+		absA[k] = _mm_set1_ps(std::abs(p[0]));
+		absB[k] = _mm_set1_ps(std::abs(p[1]));
+		absC[k] = _mm_set1_ps(std::abs(p[2]));
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	for (; i + 4 <= n; i += 4) {
+		const __m128 cx = _mm_loadu_ps(bounds.centerX.data() + i);
+		const __m128 cy = _mm_loadu_ps(bounds.centerY.data() + i);
+		const __m128 cz = _mm_loadu_ps(bounds.centerZ.data() + i);
+		const __m128 ex = _mm_loadu_ps(bounds.extentX.data() + i);
+		const __m128 ey = _mm_loadu_ps(bounds.extentY.data() + i);
+		const __m128 ez = _mm_loadu_ps(bounds.extentZ.data() + i);
+
+		__m128 outside = _mm_setzero_ps();
+		for (size_t k = 0; k < 6; k++) {
+			// dist + radius < 0
+			__m128 dist = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(pa[k], cx), _mm_mul_ps(pb[k], cy)),
+				_mm_add_ps(_mm_mul_ps(pc[k], cz), pd[k])
+			);
+			__m128 radius = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(absA[k], ex), _mm_mul_ps(absB[k], ey)),
+				_mm_mul_ps(absC[k], ez)
+			);
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+		}
+
+		const int mask = _mm_movemask_ps(outside);
+		visible[i + 0] = (mask & 0b0001) ? 0 : 1;
+		visible[i + 1] = (mask & 0b0010) ? 0 : 1;
+		visible[i + 2] = (mask & 0b0100) ? 0 : 1;
+		visible[i + 3] = (mask & 0b1000) ? 0 : 1;
+	}
+#endif // UBPA_UTOPIA_FRUSTUM_CULLING_SSE
+
+	for (; i < n; i++)
+		visible[i] = IsVisible(frustum, bounds, i) ? 1 : 0;
+}
@@ -0,0 +1,46 @@
+#include <Utopia/Render/InstanceBatcher.h>
+
+#include <algorithm>
+
+using namespace Ubpa::Utopia;
+
+InstanceBatcher::InstanceBatcher(size_t maxBatchSize) noexcept
+	: maxBatchSize{ std::max<size_t>(maxBatchSize, 1) } {}
+
+void InstanceBatcher::SetMaxBatchSize(size_t maxBatchSize) noexcept {
+	this->maxBatchSize = std::max<size_t>(maxBatchSize, 1);
+}
+
+bool InstanceBatcher::IsCompatible(const RenderObject& lhs, const RenderObject& rhs) noexcept {
+	return lhs.mesh == rhs.mesh
+		&& lhs.submeshIdx == rhs.submeshIdx
+		&& lhs.lod == rhs.lod
+		&& lhs.material == rhs.material
+		&& lhs.passIdx == rhs.passIdx;
+}
+
+void InstanceBatcher::Build(const RenderObjectList& objects) {
+	batches.clear();
+	stats = {};
+
+	for (size_t i = 0; i < objects.size(); i++) {
+		if (!batches.empty()) {
+			auto& batch = batches.back();
+			if (batch.count < maxBatchSize && IsCompatible(objects[batch.first], objects[i])) {
+				batch.count++;
+				continue;
+			}
+		}
+		batches.push_back({ i, 1 });
+	}
+
+	stats.drawsBefore = objects.size();
+	stats.drawsAfter = batches.size();
+	for (const auto& batch : batches)
+		stats.maxInstances = std::max(stats.maxInstances, batch.count);
+}
+
+void InstanceBatcher::Clear() noexcept {
+	batches.clear();
+	stats = {};
+}
@@ -0,0 +1,49 @@
+#include <Utopia/Render/LODSelection.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+namespace {
+	// the number of thresholds above screenSize, thresholds scaled by scale
+	size_t CountPassedThresholds(float screenSize, const float* thresholds, size_t thresholdNum, float scale) noexcept {
+		size_t level = 0;
+		while (level < thresholdNum && screenSize < thresholds[level] * scale)
+			level++;
+		return level;
+	}
+}
+
+float Ubpa::Utopia::ComputeLODScreenSize(const pointf3& center, float radius, const pointf3& eye, float proj11) noexcept {
+	const float dx = center[0] - eye[0];
+	const float dy = center[1] - eye[1];
+	const float dz = center[2] - eye[2];
+	const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+	if (distance <= radius)
+		return std::numeric_limits<float>::infinity();
+	// the diameter covers 2 * radius * proj11 / distance of the NDC height 2
+	return radius * proj11 / distance;
+}
+
+size_t Ubpa::Utopia::SelectLOD(
+	float screenSize,
+	size_t currentLOD,
+	const float* thresholds,
+	size_t thresholdNum,
+	float hysteresis
+) noexcept {
+	currentLOD = std::min(currentLOD, thresholdNum);
+	const size_t level = CountPassedThresholds(screenSize, thresholds, thresholdNum, 1.f);
+	if (level > currentLOD) {
+		// coarser, below the thresholds by the band
+		return std::max(currentLOD, CountPassedThresholds(screenSize, thresholds, thresholdNum, 1.f - hysteresis));
+	}
+	if (level < currentLOD) {
+		// finer, above the thresholds by the band
+		return std::min(currentLOD, CountPassedThresholds(screenSize, thresholds, thresholdNum, 1.f + hysteresis));
+	}
+	return level;
+}
@@ -0,0 +1,301 @@
+#include <Utopia/Render/LightCluster.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define UBPA_UTOPIA_LIGHT_CLUSTER_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+namespace {
+	// scalar tests, the SSE path evaluates the same expressions in the same order
+	bool Intersect(
+		LightType type,
+		float lx, float ly, float lz,
+		float ldx, float ldy, float ldz,
+		float range, float cosAngle, float sinAngle,
+		float cx, float ex, float cy, float ey, float cz, float ez
+	) noexcept {
+		// sphere vs AABB
+		float dx = std::max(std::abs(cx - lx) - ex, 0.f);
+		float dy = std::max(std::abs(cy - ly) - ey, 0.f);
+		float dz = std::max(std::abs(cz - lz) - ez, 0.f);
+		if ((dx * dx + dy * dy) + dz * dz > range * range)
+			return false;
+
+		float vx = cx - lx;
+		float vy = cy - ly;
+		float vz = cz - lz;
+		switch (type)
+		{
+		case LightType::Spot:
+		{
+			if (cosAngle <= 0.f)
+				return true;
+			// cone vs bounding sphere of the AABB
+			float radius = std::sqrt((ex * ex + ey * ey) + ez * ez);
+			float v1 = (vx * ldx + vy * ldy) + vz * ldz;
+			float lenSq = (vx * vx + vy * vy) + vz * vz;
+			float dist = cosAngle * std::sqrt(std::max(lenSq - v1 * v1, 0.f)) - v1 * sinAngle;
+			return !(dist > radius) && !(v1 > radius + range) && !(v1 < -radius);
+		}
+		case LightType::Rect:
+		case LightType::Disk:
+			// one-sided emitter, AABB behind the plane of the light
+			return !((vx * ldx + vy * ldy) + vz * ldz + ((std::abs(ldx) * ex + std::abs(ldy) * ey) + std::abs(ldz) * ez) < 0.f);
+		default:
+			return true;
+		}
+	}
+}
+
+bool LightClusterDesc::operator==(const LightClusterDesc& rhs) const noexcept {
+	return dimX == rhs.dimX && dimY == rhs.dimY && dimZ == rhs.dimZ
+		&& fovY == rhs.fovY && aspect == rhs.aspect
+		&& nearZ == rhs.nearZ && farZ == rhs.farZ;
+}
+
+void LightClusterGrid::SetDesc(const LightClusterDesc& newDesc) {
+	if (valid && newDesc == desc)
+		return;
+
+	desc = newDesc;
+	valid = true;
+
+	const float tanY = std::tan(desc.fovY / 2.f);
+	const float tanX = tanY * desc.aspect;
+	const float logRatio = std::log(desc.farZ / desc.nearZ);
+	logScale = desc.dimZ / logRatio;
+	logBias = -static_cast<float>(desc.dimZ) * std::log(desc.nearZ) / logRatio;
+
+	xCenter.resize(desc.dimZ * desc.dimX);
+	xExtent.resize(desc.dimZ * desc.dimX);
+	yCenter.resize(desc.dimZ * desc.dimY);
+	yExtent.resize(desc.dimZ * desc.dimY);
+	zCenter.resize(desc.dimZ);
+	zExtent.resize(desc.dimZ);
+
+	// the tile spans [a, b] in NDC, [a * d * tan, b * d * tan] in view space at depth d
+	auto TileBounds = [](size_t i, size_t dim, float tan, float d0, float d1, float& center, float& extent) {
+		float a = -1.f + 2.f * i / dim;
+		float b = -1.f + 2.f * (i + 1) / dim;
+		float minV = std::min(a * d0, a * d1) * tan;
+		float maxV = std::max(b * d0, b * d1) * tan;
+		center = 0.5f * (minV + maxV);
+		extent = 0.5f * (maxV - minV);
+	};
+
+	for (size_t z = 0; z < desc.dimZ; z++) {
+		float d0 = desc.nearZ * std::pow(desc.farZ / desc.nearZ, static_cast<float>(z) / desc.dimZ);
+		float d1 = desc.nearZ * std::pow(desc.farZ / desc.nearZ, static_cast<float>(z + 1) / desc.dimZ);
+		zCenter[z] = -0.5f * (d0 + d1);
+		zExtent[z] = 0.5f * (d1 - d0);
+		for (size_t x = 0; x < desc.dimX; x++)
+			TileBounds(x, desc.dimX, tanX, d0, d1, xCenter[z * desc.dimX + x], xExtent[z * desc.dimX + x]);
+		for (size_t y = 0; y < desc.dimY; y++)
+			TileBounds(y, desc.dimY, tanY, d0, d1, yCenter[z * desc.dimY + y], yExtent[z * desc.dimY + y]);
+	}
+}
+
+void LightClusterGrid::TransformLights(const transformf& view, const ClusterLight* lights, size_t num) {
+	viewLights.resize(num);
+	for (size_t i = 0; i < num; i++) {
+		const auto& light = lights[i];
+		auto& vl = viewLights[i];
+		const auto& p = light.position;
+		const auto& d = light.dir;
+		// view is column-major: view[col][row]
+		vl.type = light.type;
+		vl.x = view[0][0] * p[0] + view[1][0] * p[1] + view[2][0] * p[2] + view[3][0];
+		vl.y = view[0][1] * p[0] + view[1][1] * p[1] + view[2][1] * p[2] + view[3][1];
+		vl.z = view[0][2] * p[0] + view[1][2] * p[1] + view[2][2] * p[2] + view[3][2];
+		vl.dx = view[0][0] * d[0] + view[1][0] * d[1] + view[2][0] * d[2];
+		vl.dy = view[0][1] * d[0] + view[1][1] * d[1] + view[2][1] * d[2];
+		vl.dz = view[0][2] * d[0] + view[1][2] * d[1] + view[2][2] * d[2];
+		vl.range = light.range;
+		vl.cosAngle = light.cosHalfOuterSpotAngle;
+		vl.sinAngle = std::sqrt(std::max(1.f - light.cosHalfOuterSpotAngle * light.cosHalfOuterSpotAngle, 0.f));
+	}
+	pairClusters.clear();
+	pairLights.clear();
+}
+
+void LightClusterGrid::BuildRanges() {
+	const size_t clusterNum = GetClusterNum();
+	ranges.assign(clusterNum, Range{ 0, 0 });
+	for (uint32_t cluster : pairClusters)
+		ranges[cluster].count++;
+
+	uint32_t offset = 0;
+	for (auto& range : ranges) {
+		range.offset = offset;
+		offset += range.count;
+		range.count = 0;
+	}
+
+	// stable, the lights of a cluster are in ascending order
+	lightIndices.resize(pairClusters.size());
+	for (size_t i = 0; i < pairClusters.size(); i++) {
+		auto& range = ranges[pairClusters[i]];
+		lightIndices[range.offset + range.count++] = pairLights[i];
+	}
+}
+
+void LightClusterGrid::Assign_BruteForce(const transformf& view, const ClusterLight* lights, size_t num) {
+	TransformLights(view, lights, num);
+
+	for (size_t z = 0; z < desc.dimZ; z++) {
+		for (size_t y = 0; y < desc.dimY; y++) {
+			for (size_t x = 0; x < desc.dimX; x++) {
+				const uint32_t cluster = static_cast<uint32_t>(GetClusterIndex(x, y, z));
+				for (size_t i = 0; i < num; i++) {
+					const auto& l = viewLights[i];
+					bool hit = Intersect(
+						l.type, l.x, l.y, l.z, l.dx, l.dy, l.dz, l.range, l.cosAngle, l.sinAngle,
+						xCenter[z * desc.dimX + x], xExtent[z * desc.dimX + x],
+						yCenter[z * desc.dimY + y], yExtent[z * desc.dimY + y],
+						zCenter[z], zExtent[z]
+					);
+					if (hit) {
+						pairClusters.push_back(cluster);
+						pairLights.push_back(static_cast<uint32_t>(i));
+					}
+				}
+			}
+		}
+	}
+
+	BuildRanges();
+}
+
+void LightClusterGrid::Assign(const transformf& view, const ClusterLight* lights, size_t num) {
+	TransformLights(view, lights, num);
+
+	// the axis ranges only skip the clusters whose AABB is far from the sphere (conservative),
+	// every remaining cluster runs the full test
+	auto Near = [](float c, float e, float l, float r) {
+		return std::abs(c - l) <= (e + r) * 1.001f + 1e-4f;
+	};
+
+	for (size_t i = 0; i < num; i++) {
+		const auto& l = viewLights[i];
+		const uint32_t lightIdx = static_cast<uint32_t>(i);
+
+		for (size_t z = 0; z < desc.dimZ; z++) {
+			if (!Near(zCenter[z], zExtent[z], l.z, l.range))
+				continue;
+
+			const float* xc = xCenter.data() + z * desc.dimX;
+			const float* xe = xExtent.data() + z * desc.dimX;
+			size_t x0 = 0;
+			while (x0 < desc.dimX && !Near(xc[x0], xe[x0], l.x, l.range))
+				x0++;
+			size_t x1 = desc.dimX;
+			while (x1 > x0 && !Near(xc[x1 - 1], xe[x1 - 1], l.x, l.range))
+				x1--;
+			if (x0 == x1)
+				continue;
+
+			for (size_t y = 0; y < desc.dimY; y++) {
+				const float cy = yCenter[z * desc.dimY + y];
+				const float ey = yExtent[z * desc.dimY + y];
+				if (!Near(cy, ey, l.y, l.range))
+					continue;
+				const float cz = zCenter[z];
+				const float ez = zExtent[z];
+				const uint32_t rowCluster = static_cast<uint32_t>(GetClusterIndex(0, y, z));
+
+				size_t x = x0;
+#ifdef UBPA_UTOPIA_LIGHT_CLUSTER_SSE
+				const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+				const __m128 zero = _mm_setzero_ps();
+				const __m128 lx = _mm_set1_ps(l.x);
+				const __m128 range = _mm_set1_ps(l.range);
+				const __m128 rangeSq = _mm_set1_ps(l.range * l.range);
+
+				// row constants
+				const float dy = std::max(std::abs(cy - l.y) - ey, 0.f);
+				const float dz = std::max(std::abs(cz - l.z) - ez, 0.f);
+				const float vy = cy - l.y;
+				const float vz = cz - l.z;
+
+				for (; x + 4 <= x1; x += 4) {
+					const __m128 cx = _mm_loadu_ps(xc + x);
+					const __m128 ex = _mm_loadu_ps(xe + x);
+					const __m128 vx = _mm_sub_ps(cx, lx);
+
+					// sphere vs AABB
+					__m128 dx = _mm_max_ps(_mm_sub_ps(_mm_and_ps(vx, absMask), ex), zero);
+					__m128 distSq = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(dx, dx), _mm_set1_ps(dy * dy)),
+						_mm_set1_ps(dz * dz)
+					);
+					__m128 hit = _mm_cmple_ps(distSq, rangeSq);
+
+					if (l.type == LightType::Spot && l.cosAngle > 0.f) {
+						__m128 radius = _mm_sqrt_ps(_mm_add_ps(
+							_mm_add_ps(_mm_mul_ps(ex, ex), _mm_set1_ps(ey * ey)),
+							_mm_set1_ps(ez * ez)
+						));
+						__m128 v1 = _mm_add_ps(
+							_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(l.dx)), _mm_set1_ps(vy * l.dy)),
+							_mm_set1_ps(vz * l.dz)
+						);
+						__m128 lenSq = _mm_add_ps(
+							_mm_add_ps(_mm_mul_ps(vx, vx), _mm_set1_ps(vy * vy)),
+							_mm_set1_ps(vz * vz)
+						);
+						__m128 dist = _mm_sub_ps(
+							_mm_mul_ps(_mm_set1_ps(l.cosAngle), _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lenSq, _mm_mul_ps(v1, v1)), zero))),
+							_mm_mul_ps(v1, _mm_set1_ps(l.sinAngle))
+						);
+						hit = _mm_andnot_ps(_mm_cmpgt_ps(dist, radius), hit);
+						hit = _mm_andnot_ps(_mm_cmpgt_ps(v1, _mm_add_ps(radius, range)), hit);
+						hit = _mm_andnot_ps(_mm_cmplt_ps(v1, _mm_sub_ps(zero, radius)), hit);
+					}
+					else if (l.type == LightType::Rect || l.type == LightType::Disk) {
+						__m128 side = _mm_add_ps(
+							_mm_add_ps(
+								_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(l.dx)), _mm_set1_ps(vy * l.dy)),
+								_mm_set1_ps(vz * l.dz)
+							),
+							_mm_add_ps(
+								_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::abs(l.dx)), ex), _mm_set1_ps(std::abs(l.dy) * ey)),
+								_mm_set1_ps(std::abs(l.dz) * ez)
+							)
+						);
+						hit = _mm_andnot_ps(_mm_cmplt_ps(side, zero), hit);
+					}
+
+					int mask = _mm_movemask_ps(hit);
+					while (mask) {
+						int k = 0;
+						while (!(mask & (1 << k)))
+							k++;
+						mask &= ~(1 << k);
+						pairClusters.push_back(rowCluster + static_cast<uint32_t>(x + k));
+						pairLights.push_back(lightIdx);
+					}
+				}
+#endif // UBPA_UTOPIA_LIGHT_CLUSTER_SSE
+
+				for (; x < x1; x++) {
+					bool hit = Intersect(
+						l.type, l.x, l.y, l.z, l.dx, l.dy, l.dz, l.range, l.cosAngle, l.sinAngle,
+						xc[x], xe[x], cy, ey, cz, ez
+					);
+					if (hit) {
+						pairClusters.push_back(rowCluster + static_cast<uint32_t>(x));
+						pairLights.push_back(lightIdx);
+					}
+				}
+			}
+		}
+	}
+
+	BuildRanges();
+}
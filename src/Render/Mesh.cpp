@@ -1,45 +1,229 @@
 #include <Utopia/Render/Mesh.h>
 
+#include <Utopia/Render/VertexCodec.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+namespace {
+	static_assert(sizeof(pointf3) == VertexAttributeSizes[0]);
+	static_assert(sizeof(pointf2) == VertexAttributeSizes[1]);
+	static_assert(sizeof(normalf) == VertexAttributeSizes[2]);
+	static_assert(sizeof(vecf3) == VertexAttributeSizes[3]);
+	static_assert(sizeof(rgbf) == VertexAttributeSizes[4]);
+
+	// copy the elements [first, first + num) of an attribute array into a stream
+	// the size is a constant so every copy is a few moves
+	template<size_t Size>
+	void CopyToStream(uint8_t* dst, size_t stride, const void* src, size_t first, size_t num) noexcept {
+		dst += first * stride;
+		const uint8_t* srcBytes = static_cast<const uint8_t*>(src) + first * Size;
+		if (stride == Size) {
+			std::memcpy(dst, srcBytes, Size * num);
+			return;
+		}
+
+		for (size_t i = 0; i < num; i++)
+			std::memcpy(dst + i * stride, srcBytes + i * Size, Size);
+	}
+
+	// encode the elements [first, first + num) of an attribute array into a stream
+	// encode(dst, i) writes the compressed element i
+	template<typename Encode>
+	void EncodeToStream(uint8_t* dst, size_t stride, size_t first, size_t num, Encode&& encode) noexcept {
+		for (size_t i = first; i < first + num; i++)
+			encode(dst + i * stride, i);
+	}
+
+	// sort and merge the overlapping or adjacent ranges
+	void CoalesceRanges(std::vector<VertexRange>& ranges) {
+		std::sort(ranges.begin(), ranges.end(), [](const VertexRange& lhs, const VertexRange& rhs) {
+			return lhs.first < rhs.first;
+		});
+		size_t n = 0;
+		for (const auto& range : ranges) {
+			if (n > 0 && ranges[n - 1].first + ranges[n - 1].count >= range.first)
+				ranges[n - 1].count = std::max(ranges[n - 1].count, range.first + range.count - ranges[n - 1].first);
+			else
+				ranges[n++] = range;
+		}
+		ranges.resize(n);
+	}
+
+	void CoalesceRanges(std::vector<BufferRange>& ranges) {
+		std::sort(ranges.begin(), ranges.end(), [](const BufferRange& lhs, const BufferRange& rhs) {
+			return lhs.offset < rhs.offset;
+		});
+		size_t n = 0;
+		for (const auto& range : ranges) {
+			if (n > 0 && ranges[n - 1].offset + ranges[n - 1].size >= range.offset)
+				ranges[n - 1].size = std::max(ranges[n - 1].size, range.offset + range.size - ranges[n - 1].offset);
+			else
+				ranges[n++] = range;
+		}
+		ranges.resize(n);
+	}
+
+	template<typename T, size_t N>
+	void StoreElement(uint8_t* dst, const std::array<T, N>& value) noexcept {
+		std::memcpy(dst, value.data(), sizeof(T) * N);
+	}
+
+	void EncodeNormal(uint8_t* dst, const float* v, float w, VertexCompression compression) noexcept {
+		if (compression == VertexCompression::Compact)
+			StoreElement(dst, EncodeOctahedral({ v[0], v[1], v[2] }));
+		else {
+			StoreElement(dst, std::array<int16_t, 4>{
+				EncodeSnorm16(v[0]),
+				EncodeSnorm16(v[1]),
+				EncodeSnorm16(v[2]),
+				EncodeSnorm16(w)
+			});
+		}
+	}
+}
 
 void Mesh::SetPositions(std::vector<pointf3> positions) {
 	assert(isEditable);
-	dirty = true;
+	MarkDirty(VertexAttribute::Position);
 	this->positions = std::move(positions);
 }
 
 void Mesh::SetColors(std::vector<rgbf> colors) {
 	assert(isEditable);
-	dirty = true;
+	MarkDirty(VertexAttribute::Color);
 	this->colors = std::move(colors);
 }
 
 void Mesh::SetNormals(std::vector<normalf> normals) {
 	assert(isEditable);
-	dirty = true;
+	MarkDirty(VertexAttribute::Normal);
 	this->normals = std::move(normals);
 }
 
 void Mesh::SetTangents(std::vector<vecf3> tangents) {
 	assert(isEditable);
-	dirty = true;
+	MarkDirty(VertexAttribute::Tangent);
 	this->tangents = std::move(tangents);
 }
 
 void Mesh::SetUV(std::vector<pointf2> uv) {
 	assert(isEditable);
-	dirty = true;
+	MarkDirty(VertexAttribute::UV);
 	this->uv = std::move(uv);
 }
 
+void Mesh::SetBoneWeights(std::vector<valu4> indices, std::vector<valf4> weights) {
+	assert(isEditable);
+	assert(indices.size() == weights.size());
+	boneIndices = std::move(indices);
+	boneWeights = std::move(weights);
+}
+
 void Mesh::SetIndices(std::vector<uint32_t> indices) {
 	assert(isEditable);
 	dirty = true;
+	dirtyIndices = true;
 	this->indices = std::move(indices);
+	meshlets = {};
+	triangleAdjacency = {};
+}
+
+void Mesh::MarkDirty(VertexAttribute attr) noexcept {
+	dirty = true;
+	dirtyAttributes |= GetVertexAttributeBit(attr);
+	dirtyVertexRanges[static_cast<size_t>(attr)].clear();
+}
+
+void Mesh::MarkDirty(VertexAttribute attr, size_t first, size_t count) {
+	if (count == 0)
+		return;
+	dirty = true;
+	auto& ranges = dirtyVertexRanges[static_cast<size_t>(attr)];
+	if (!(dirtyAttributes & GetVertexAttributeBit(attr))) {
+		dirtyAttributes |= GetVertexAttributeBit(attr);
+		ranges.push_back({ first, count });
+	}
+	else if (!ranges.empty())
+		ranges.push_back({ first, count });
+	// else the whole attribute is dirty
+}
+
+VertexSpan<pointf3> Mesh::EditPositions(size_t first, size_t count) {
+	assert(isEditable);
+	assert(first + count <= positions.size());
+	MarkDirty(VertexAttribute::Position, first, count);
+	return { positions.data() + first, count };
+}
+
+VertexSpan<pointf2> Mesh::EditUV(size_t first, size_t count) {
+	assert(isEditable);
+	assert(first + count <= uv.size());
+	MarkDirty(VertexAttribute::UV, first, count);
+	return { uv.data() + first, count };
+}
+
+VertexSpan<normalf> Mesh::EditNormals(size_t first, size_t count) {
+	assert(isEditable);
+	assert(first + count <= normals.size());
+	MarkDirty(VertexAttribute::Normal, first, count);
+	return { normals.data() + first, count };
+}
+
+VertexSpan<vecf3> Mesh::EditTangents(size_t first, size_t count) {
+	assert(isEditable);
+	assert(first + count <= tangents.size());
+	MarkDirty(VertexAttribute::Tangent, first, count);
+	return { tangents.data() + first, count };
+}
+
+VertexSpan<rgbf> Mesh::EditColors(size_t first, size_t count) {
+	assert(isEditable);
+	assert(first + count <= colors.size());
+	MarkDirty(VertexAttribute::Color, first, count);
+	return { colors.data() + first, count };
+}
+
+void Mesh::SetVertexLayout(VertexLayout layout) {
+	assert(isEditable);
+	if (vertexLayout == layout)
+		return;
+	dirty = true;
+	vertexLayout = layout;
+}
+
+void Mesh::SetVertexCompression(VertexCompression compression) {
+	assert(isEditable);
+	if (vertexCompression == compression)
+		return;
+	dirty = true;
+	vertexCompression = compression;
+}
+
+const void* Mesh::GetIndexBufferData() const noexcept {
+	return indices16.empty() ?
+		static_cast<const void*>(indices.data())
+		: static_cast<const void*>(indices16.data());
+}
+
+uint32_t Mesh::GetVertexAttributeMask() const noexcept {
+	uint32_t mask = GetVertexAttributeBit(VertexAttribute::Position);
+	if (!uv.empty()) mask |= GetVertexAttributeBit(VertexAttribute::UV);
+	if (!normals.empty()) mask |= GetVertexAttributeBit(VertexAttribute::Normal);
+	if (!tangents.empty()) mask |= GetVertexAttributeBit(VertexAttribute::Tangent);
+	if (!colors.empty()) mask |= GetVertexAttributeBit(VertexAttribute::Color);
+	return mask;
 }
 
 void Mesh::SetSubMeshCount(size_t num) {
 	assert(isEditable);
+	lods.clear();
+	meshlets = {};
+	triangleAdjacency = {};
 	if (submeshes.size() < num) {
 		for (size_t i = submeshes.size(); i < num; i++) {
 			submeshes.emplace_back(
@@ -66,41 +250,55 @@ void Mesh::SetSubMesh(size_t index, SubMeshDescriptor desc) {
 		desc.bounds.combine_to_self(positions[index]);
 	}
 	submeshes[index] = desc;
+	triangleAdjacency = {};
 }
 
-void Mesh::GenNormals() {
-	normals.clear();
-	normals.resize(positions.size(), normalf(0, 0, 0));
+void Mesh::SetMeshlets(MeshletData meshlets) {
+	assert(isEditable);
+	assert(meshlets.submeshOffsets.size() == submeshes.size() + 1);
+	this->meshlets = std::move(meshlets);
+}
 
-	for (const auto& submesh : GetSubMeshes()) {
+void Mesh::SetLODs(std::vector<std::vector<SubMeshDescriptor>> lods) {
+	assert(isEditable);
+	dirty = true;
+	for (auto& level : lods) {
+		assert(level.size() == submeshes.size());
+		for (size_t i = 0; i < level.size(); i++) {
+			level[i].firstVertex = level[i].indexCount > 0 ? indices[level[i].indexStart] + level[i].baseVertex : submeshes[i].firstVertex;
+			level[i].bounds = submeshes[i].bounds;
+		}
+	}
+	this->lods = std::move(lods);
+}
+
+const TriangleAdjacency& Mesh::GetTriangleAdjacency() {
+	if (triangleAdjacency.GetVertexNum() == positions.size())
+		return triangleAdjacency;
+
+	std::vector<uint32_t> triangleIndices;
+	for (const auto& submesh : submeshes) {
 		if (submesh.topology != MeshTopology::Triangles)
 			continue;
 
 		assert(submesh.indexCount % 3 == 0);
-		for (size_t i = 0; i < submesh.indexCount; i += 3) {
-			auto v0 = indices[submesh.indexStart + i + 0];
-			auto v1 = indices[submesh.indexStart + i + 1];
-			auto v2 = indices[submesh.indexStart + i + 2];
-
-			auto d10 = positions.at(v0) - positions.at(v1);
-			auto d12 = positions.at(v2) - positions.at(v1);
-			auto wN = d12.cross(d10).cast_to<normalf>();
-
-			normals.at(v0) += wN;
-			normals.at(v1) += wN;
-			normals.at(v2) += wN;
-		}
+		for (size_t i = 0; i < submesh.indexCount; i++)
+			triangleIndices.push_back(indices[submesh.indexStart + i] + static_cast<uint32_t>(submesh.baseVertex));
 	}
+	triangleAdjacency = BuildTriangleAdjacency(std::move(triangleIndices), positions.size());
+	return triangleAdjacency;
+}
 
-	for (auto& normal : normals) {
-		if (normal.norm2() == 0)
-			return;
-
-		normal.normalize_self();
-	}
+void Mesh::GenNormals() {
+	assert(isEditable);
+	MarkDirty(VertexAttribute::Normal);
+	normals.resize(positions.size());
+	ComputeNormals(normals.data(), GetTriangleAdjacency(), positions.data());
 }
 
 void Mesh::GenUV() {
+	assert(isEditable);
+	MarkDirty(VertexAttribute::UV);
 	uv.resize(positions.size());
 	pointf3 center = pointf3::combine(positions, 1.f / positions.size());
 	for (size_t i = 0; i < positions.size(); i++) {
@@ -109,76 +307,16 @@ void Mesh::GenUV() {
 	}
 }
 
-void Mesh::GenTangents() {
+void Mesh::GenTangents(TangentMode mode) {
+	assert(isEditable);
 	if (normals.empty())
 		GenNormals();
 	if (uv.empty())
 		GenUV();
 
-	const size_t vertexNum = positions.size();
-	const size_t triangleCount = indices.size() / 3;
-
-	std::vector<vecf3> tanS(vertexNum, vecf3{ 0,0,0 });
-	std::vector<vecf3> tanT(vertexNum, vecf3{ 0,0,0 });
-
-	for (const auto& submesh : GetSubMeshes()) {
-		if (submesh.topology != MeshTopology::Triangles)
-			continue;
-
-		assert(submesh.indexCount % 3 == 0);
-		for (size_t i = 0; i < submesh.indexCount; i += 3) {
-			auto i1 = indices[submesh.indexStart + i + 0];
-			auto i2 = indices[submesh.indexStart + i + 1];
-			auto i3 = indices[submesh.indexStart + i + 2];
-
-			const pointf3& v1 = positions.at(i1);
-			const pointf3& v2 = positions.at(i2);
-			const pointf3& v3 = positions.at(i3);
-
-			const pointf2& w1 = uv.at(i1);
-			const pointf2& w2 = uv.at(i2);
-			const pointf2& w3 = uv.at(i3);
-
-			float x1 = v2[0] - v1[0];
-			float x2 = v3[0] - v1[0];
-			float y1 = v2[1] - v1[1];
-			float y2 = v3[1] - v1[1];
-			float z1 = v2[2] - v1[2];
-			float z2 = v3[2] - v1[2];
-
-			float s1 = w2[0] - w1[0];
-			float s2 = w3[0] - w1[0];
-			float t1 = w2[1] - w1[1];
-			float t2 = w3[1] - w1[1];
-
-			float denominator = s1 * t2 - s2 * t1;
-			float r = denominator == 0.f ? 1.f : 1.f / denominator;
-			vecf3 sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
-				(t2 * z1 - t1 * z2) * r);
-			vecf3 tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
-				(s1 * z2 - s2 * z1) * r);
-
-			tanS[i1] += sdir;
-			tanS[i2] += sdir;
-			tanS[i3] += sdir;
-			tanT[i1] += tdir;
-			tanT[i2] += tdir;
-			tanT[i3] += tdir;
-		}
-	}
-
-	tangents.resize(vertexNum);
-	for (size_t i = 0; i < vertexNum; i++) {
-		const vecf3& n = normals.at(i).cast_to<vecf3>();
-		const vecf3& t = tanS[i];
-
-		// Gram-Schmidt orthogonalize
-		auto projT = t - n * n.dot(t);
-		tangents.at(i) = projT.norm2() == 0.f ? vecf3{ 1,0,0 } : projT.normalize();
-
-		// Calculate handedness
-		tangents.at(i) *= (n.cross(t).dot(tanT[i]) < 0.0F) ? -1.f : 1.f;
-	}
+	MarkDirty(VertexAttribute::Tangent);
+	tangents.resize(positions.size());
+	ComputeTangents(tangents.data(), GetTriangleAdjacency(), positions.data(), normals.data(), uv.data(), mode);
 }
 
 bool Mesh::IsVertexValid() {
@@ -188,6 +326,8 @@ bool Mesh::IsVertexValid() {
 		&& (normals.size() == 0 || normals.size() == num)
 		&& (tangents.size() == 0 || tangents.size() == num)
 		&& (colors.size() == 0 || colors.size() == num)
+		&& (boneWeights.size() == 0 || boneWeights.size() == num)
+		&& boneIndices.size() == boneWeights.size()
 	)
 		return true;
 	else
@@ -199,43 +339,118 @@ void Mesh::UpdateVertexBuffer() {
 
 	assert(IsVertexValid());
 
-	size_t num = GetVertexBufferVertexCount();
-
-	size_t stride = 0;
-	stride += sizeof(decltype(positions)::value_type);
-	if (!uv.empty()) stride += sizeof(decltype(uv)::value_type);
-	if (!normals.empty()) stride += sizeof(decltype(normals)::value_type);
-	if (!tangents.empty()) stride += sizeof(decltype(tangents)::value_type);
-	if (!colors.empty()) stride += sizeof(decltype(colors)::value_type);
+	const size_t num = GetVertexBufferVertexCount();
+	const auto streams = VertexStreams::Create(vertexLayout, GetVertexAttributeMask(), vertexCompression);
+
+	updatedInPlace = true;
+	updatedVertexBufferRanges.clear();
+
+	// the arrangement changed, rebuild every stream
+	if (streams.layout != vertexStreams.layout
+		|| streams.compression != vertexStreams.compression
+		|| streams.attributeMask != vertexStreams.attributeMask
+		|| vertexBuffer.size() != streams.GetVertexSize() * num)
+	{
+		dirtyAttributes = streams.attributeMask;
+		for (auto& ranges : dirtyVertexRanges)
+			ranges.clear();
+		vertexStreams = streams;
+		vertexBuffer.resize(streams.GetVertexSize() * num);
+		updatedInPlace = false;
+
+		size_t offset = 0;
+		for (size_t i = 0; i < streams.streamNum; i++) {
+			vertexStreamOffsets[i] = offset;
+			offset += streams.strides[i] * num;
+		}
+	}
 
-	vertexBuffer.resize(stride * positions.size());
+	const void* attributes[VertexAttributeNum] = {
+		positions.data(),
+		uv.data(),
+		normals.data(),
+		tangents.data(),
+		colors.data()
+	};
 
-	size_t offset = 0;
 	uint8_t* data = vertexBuffer.data();
-	for (size_t i = 0; i < num; i++) {
-		memcpy(data + offset, positions[i].data(), sizeof(decltype(positions)::value_type));
-		offset += sizeof(decltype(positions)::value_type);
-
-		if (!uv.empty()) {
-			memcpy(data + offset, uv[i].data(), sizeof(decltype(uv)::value_type));
-			offset += sizeof(decltype(uv)::value_type);
-		}
-
-		if (!normals.empty()) {
-			memcpy(data + offset, normals[i].data(), sizeof(decltype(normals)::value_type));
-			offset += sizeof(decltype(normals)::value_type);
-		}
+	const uint32_t changed = dirtyAttributes & streams.attributeMask;
+	for (size_t i = 0; i < VertexAttributeNum; i++) {
+		if (!(changed & (1u << i)))
+			continue;
 
-		if (!tangents.empty()) {
-			memcpy(data + offset, tangents[i].data(), sizeof(decltype(tangents)::value_type));
-			offset += sizeof(decltype(tangents)::value_type);
+		auto& ranges = dirtyVertexRanges[i];
+		if (ranges.empty())
+			ranges.push_back({ 0, num });
+		else
+			CoalesceRanges(ranges);
+
+		const size_t stream = streams.streams[i];
+		uint8_t* dst = data + vertexStreamOffsets[stream] + streams.offsets[i];
+		const size_t stride = streams.strides[stream];
+		for (const auto& range : ranges) {
+			updatedVertexBufferRanges.push_back({ vertexStreamOffsets[stream] + range.first * stride, range.count * stride });
+
+			if (i == static_cast<size_t>(VertexAttribute::Position) || vertexCompression == VertexCompression::None) {
+				if (VertexAttributeSizes[i] == 8)
+					CopyToStream<8>(dst, stride, attributes[i], range.first, range.count);
+				else
+					CopyToStream<12>(dst, stride, attributes[i], range.first, range.count);
+				continue;
+			}
+
+			switch (static_cast<VertexAttribute>(i))
+			{
+			case VertexAttribute::UV:
+				EncodeToStream(dst, stride, range.first, range.count, [&](uint8_t* e, size_t k) {
+					StoreElement(e, std::array<uint16_t, 2>{ EncodeHalf(uv[k][0]), EncodeHalf(uv[k][1]) });
+				});
+				break;
+			case VertexAttribute::Normal:
+				EncodeToStream(dst, stride, range.first, range.count, [&](uint8_t* e, size_t k) {
+					EncodeNormal(e, normals[k].data(), 0.f, vertexCompression);
+				});
+				break;
+			case VertexAttribute::Tangent:
+				EncodeToStream(dst, stride, range.first, range.count, [&](uint8_t* e, size_t k) {
+					EncodeNormal(e, tangents[k].data(), 1.f, vertexCompression);
+				});
+				break;
+			case VertexAttribute::Color:
+				EncodeToStream(dst, stride, range.first, range.count, [&](uint8_t* e, size_t k) {
+					StoreElement(e, std::array<uint8_t, 4>{
+						EncodeUnorm8(colors[k][0]),
+						EncodeUnorm8(colors[k][1]),
+						EncodeUnorm8(colors[k][2]),
+						255
+					});
+				});
+				break;
+			default:
+				assert(false);
+				break;
+			}
 		}
-
-		if (!colors.empty()) {
-			memcpy(data + offset, colors[i].data(), sizeof(decltype(colors)::value_type));
-			offset += sizeof(decltype(colors)::value_type);
+	}
+	for (auto& ranges : dirtyVertexRanges)
+		ranges.clear();
+	CoalesceRanges(updatedVertexBufferRanges);
+
+	// 16-bit indices when every index fits
+	const bool use16 = num <= static_cast<size_t>(std::numeric_limits<uint16_t>::max()) + 1;
+	if (dirtyIndices || (use16 ? indices16.size() != indices.size() : !indices16.empty())) {
+		indices16.clear();
+		if (use16) {
+			indices16.resize(indices.size());
+			for (size_t i = 0; i < indices.size(); i++)
+				indices16[i] = static_cast<uint16_t>(indices[i]);
 		}
+		indices16.shrink_to_fit();
+		dirtyIndices = false;
+		updatedInPlace = false;
 	}
 
+	updatedVertexStreams = streams.GetStreamMask(changed);
+	dirtyAttributes = 0;
 	dirty = false;
 }
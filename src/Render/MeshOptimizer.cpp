@@ -0,0 +1,431 @@
+#include <Utopia/Render/MeshOptimizer.h>
+
+#include <Utopia/Render/Mesh.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+namespace {
+	constexpr uint32_t InvalidIndex = static_cast<uint32_t>(-1);
+
+	// FIFO cache, return the number of misses of the triangle
+	class FIFOCache {
+	public:
+		FIFOCache(size_t vertexCount, size_t cacheSize)
+			: timestamps(vertexCount, 0), cacheSize{ cacheSize } {}
+
+		size_t Add(const uint32_t* tri) noexcept {
+			size_t misses = 0;
+			for (size_t k = 0; k < 3; k++) {
+				uint32_t v = tri[k];
+				// more than cacheSize vertices were added after v : evicted
+				if (time - timestamps[v] > cacheSize) {
+					timestamps[v] = time;
+					time++;
+					misses++;
+				}
+			}
+			return misses;
+		}
+
+		// empty the cache
+		void Flush() noexcept { time += cacheSize + 1; }
+
+	private:
+		std::vector<size_t> timestamps;
+		size_t cacheSize;
+		size_t time{ cacheSize + 1 };
+	};
+
+	// Forsyth's score
+	constexpr size_t ForsythCacheSize = 32;
+	constexpr float ForsythCacheDecayPower = 1.5f;
+	constexpr float ForsythLastTriScore = 0.75f;
+	constexpr float ForsythValenceBoostScale = 2.f;
+	constexpr float ForsythValenceBoostPower = 0.5f;
+
+	float ForsythVertexScore(int cachePos, uint32_t remaining) noexcept {
+		if (remaining == 0)
+			return -1.f;
+
+		float score = 0.f;
+		if (cachePos >= 0) {
+			if (cachePos < 3)
+				score = ForsythLastTriScore;
+			else {
+				const float scaler = 1.f / static_cast<float>(ForsythCacheSize - 3);
+				score = std::pow(1.f - static_cast<float>(cachePos - 3) * scaler, ForsythCacheDecayPower);
+			}
+		}
+		score += ForsythValenceBoostScale * std::pow(static_cast<float>(remaining), -ForsythValenceBoostPower);
+		return score;
+	}
+}
+
+VertexCacheStats Ubpa::Utopia::AnalyzeVertexCache(
+	const uint32_t* indices,
+	size_t indexCount,
+	size_t vertexCount,
+	size_t cacheSize
+) {
+	assert(indexCount % 3 == 0);
+	VertexCacheStats stats;
+	if (indexCount == 0)
+		return stats;
+
+	FIFOCache cache{ vertexCount, cacheSize };
+	std::vector<uint8_t> used(vertexCount, 0);
+	size_t misses = 0;
+	size_t usedNum = 0;
+	for (size_t i = 0; i < indexCount; i += 3) {
+		misses += cache.Add(indices + i);
+		for (size_t k = 0; k < 3; k++) {
+			if (!used[indices[i + k]]) {
+				used[indices[i + k]] = 1;
+				usedNum++;
+			}
+		}
+	}
+
+	stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+	stats.atvr = static_cast<float>(misses) / static_cast<float>(usedNum);
+	return stats;
+}
+
+VertexCacheStats Ubpa::Utopia::AnalyzeVertexCache(const Mesh& mesh, size_t cacheSize) {
+	const auto& indices = mesh.GetIndices();
+	std::vector<uint32_t> triangles;
+	for (const auto& submesh : mesh.GetSubMeshes()) {
+		if (submesh.topology != MeshTopology::Triangles)
+			continue;
+		for (size_t i = 0; i < submesh.indexCount; i++)
+			triangles.push_back(indices[submesh.indexStart + i] + static_cast<uint32_t>(submesh.baseVertex));
+	}
+	return AnalyzeVertexCache(triangles.data(), triangles.size(), mesh.GetPositions().size(), cacheSize);
+}
+
+void Ubpa::Utopia::OptimizeVertexCache(uint32_t* dst, const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	assert(indexCount % 3 == 0);
+	assert(dst != indices);
+	const size_t triNum = indexCount / 3;
+	if (triNum == 0)
+		return;
+
+	// vertex -> triangles, CSR
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (size_t i = 0; i < indexCount; i++)
+		remaining[indices[i]]++;
+	std::vector<uint32_t> adjOffsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		adjOffsets[v + 1] = adjOffsets[v] + remaining[v];
+	std::vector<uint32_t> adjTris(indexCount);
+	{
+		std::vector<uint32_t> cursor(adjOffsets.begin(), adjOffsets.end() - 1);
+		for (size_t i = 0; i < indexCount; i++)
+			adjTris[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int> cachePos(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		vertexScores[v] = ForsythVertexScore(-1, remaining[v]);
+
+	std::vector<float> triScores(triNum);
+	std::vector<uint8_t> emitted(triNum, 0);
+	for (size_t t = 0; t < triNum; t++) {
+		const uint32_t* tri = indices + 3 * t;
+		triScores[t] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+	}
+
+	uint32_t cache[ForsythCacheSize + 3];
+	size_t cacheNum = 0;
+
+	uint32_t best = static_cast<uint32_t>(std::max_element(triScores.begin(), triScores.end()) - triScores.begin());
+	size_t cursor = 0; // dead end: next triangle in the input order
+
+	for (size_t out = 0; out < triNum; out++) {
+		if (best == InvalidIndex) {
+			while (emitted[cursor])
+				cursor++;
+			best = static_cast<uint32_t>(cursor);
+		}
+
+		const uint32_t* tri = indices + 3 * best;
+		dst[3 * out + 0] = tri[0];
+		dst[3 * out + 1] = tri[1];
+		dst[3 * out + 2] = tri[2];
+		emitted[best] = 1;
+
+		// remove the triangle from the adjacency
+		for (size_t k = 0; k < 3; k++) {
+			uint32_t v = tri[k];
+			uint32_t* begin = adjTris.data() + adjOffsets[v];
+			uint32_t* end = begin + remaining[v];
+			auto target = std::find(begin, end, best);
+			assert(target != end);
+			*target = *(end - 1);
+			remaining[v]--;
+		}
+
+		// the vertices of the triangle go to the front of the cache
+		uint32_t newCache[ForsythCacheSize + 3];
+		size_t newCacheNum = 0;
+		for (size_t k = 0; k < 3; k++) {
+			if (std::find(newCache, newCache + newCacheNum, tri[k]) == newCache + newCacheNum)
+				newCache[newCacheNum++] = tri[k];
+		}
+		for (size_t i = 0; i < cacheNum; i++) {
+			uint32_t v = cache[i];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache[newCacheNum++] = v;
+		}
+
+		// evicted vertices
+		for (size_t i = ForsythCacheSize; i < newCacheNum; i++) {
+			uint32_t v = newCache[i];
+			cachePos[v] = -1;
+			vertexScores[v] = ForsythVertexScore(-1, remaining[v]);
+		}
+		cacheNum = std::min(newCacheNum, ForsythCacheSize);
+		std::copy(newCache, newCache + cacheNum, cache);
+
+		for (size_t i = 0; i < cacheNum; i++) {
+			uint32_t v = cache[i];
+			cachePos[v] = static_cast<int>(i);
+			vertexScores[v] = ForsythVertexScore(static_cast<int>(i), remaining[v]);
+		}
+
+		// the next triangle is the best one touching the cache
+		best = InvalidIndex;
+		float bestScore = -1.f;
+		for (size_t i = 0; i < cacheNum; i++) {
+			uint32_t v = cache[i];
+			for (uint32_t j = 0; j < remaining[v]; j++) {
+				uint32_t t = adjTris[adjOffsets[v] + j];
+				const uint32_t* adj = indices + 3 * t;
+				float score = vertexScores[adj[0]] + vertexScores[adj[1]] + vertexScores[adj[2]];
+				triScores[t] = score;
+				if (score > bestScore) {
+					bestScore = score;
+					best = t;
+				}
+			}
+		}
+	}
+}
+
+void Ubpa::Utopia::OptimizeOverdraw(
+	uint32_t* dst,
+	const uint32_t* indices,
+	size_t indexCount,
+	const pointf3* positions,
+	size_t vertexCount,
+	float threshold
+) {
+	assert(indexCount % 3 == 0);
+	assert(dst != indices);
+	const size_t triNum = indexCount / 3;
+	if (triNum == 0)
+		return;
+
+	constexpr size_t cacheSize = 16;
+
+	// hard boundaries: the triangle misses all its vertices, the cache is cold there anyway
+	std::vector<size_t> hard;
+	{
+		FIFOCache cache{ vertexCount, cacheSize };
+		for (size_t t = 0; t < triNum; t++) {
+			if (cache.Add(indices + 3 * t) == 3)
+				hard.push_back(t);
+		}
+		hard.push_back(triNum);
+		if (hard.front() != 0)
+			hard.insert(hard.begin(), 0);
+	}
+
+	// soft boundaries: split a hard cluster where the ACMR of the part (cold cache) stays under the threshold
+	std::vector<size_t> clusters;
+	{
+		const float maxACMR = threshold * AnalyzeVertexCache(indices, indexCount, vertexCount, cacheSize).acmr;
+		FIFOCache cache{ vertexCount, cacheSize };
+		for (size_t c = 0; c + 1 < hard.size(); c++) {
+			size_t start = hard[c];
+			cache.Flush();
+			size_t misses = 0;
+			clusters.push_back(start);
+			for (size_t t = hard[c]; t < hard[c + 1]; t++) {
+				misses += cache.Add(indices + 3 * t);
+				const size_t num = t + 1 - start;
+				if (t + 1 < hard[c + 1] && static_cast<float>(misses) <= maxACMR * static_cast<float>(num)) {
+					start = t + 1;
+					misses = 0;
+					cache.Flush();
+					clusters.push_back(start);
+				}
+			}
+		}
+		clusters.push_back(triNum);
+	}
+
+	// sort key: how much the cluster faces outwards, area weighted
+	float meshCentroid[3] = { 0.f, 0.f, 0.f };
+	float meshArea = 0.f;
+	const size_t clusterNum = clusters.size() - 1;
+	std::vector<float> keys(clusterNum);
+	std::vector<std::array<float, 7>> clusterData(clusterNum); // centroid * area, normal, area
+	for (size_t c = 0; c < clusterNum; c++) {
+		auto& data = clusterData[c];
+		data.fill(0.f);
+		for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+			const auto& p0 = positions[indices[3 * t + 0]];
+			const auto& p1 = positions[indices[3 * t + 1]];
+			const auto& p2 = positions[indices[3 * t + 2]];
+			const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			// |cross| = 2 * area
+			const float n[3] = {
+				e1[1] * e2[2] - e1[2] * e2[1],
+				e1[2] * e2[0] - e1[0] * e2[2],
+				e1[0] * e2[1] - e1[1] * e2[0],
+			};
+			const float area = 0.5f * std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (size_t k = 0; k < 3; k++) {
+				data[k] += area * (p0[k] + p1[k] + p2[k]) / 3.f;
+				data[3 + k] += n[k];
+			}
+			data[6] += area;
+		}
+		for (size_t k = 0; k < 3; k++)
+			meshCentroid[k] += data[k];
+		meshArea += data[6];
+	}
+	if (meshArea > 0.f) {
+		for (size_t k = 0; k < 3; k++)
+			meshCentroid[k] /= meshArea;
+	}
+	for (size_t c = 0; c < clusterNum; c++) {
+		const auto& data = clusterData[c];
+		if (data[6] == 0.f) {
+			keys[c] = 0.f;
+			continue;
+		}
+		const float normalLength = std::sqrt(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+		float key = 0.f;
+		for (size_t k = 0; k < 3; k++) {
+			const float centroid = data[k] / data[6];
+			key += (centroid - meshCentroid[k]) * (normalLength > 0.f ? data[3 + k] / normalLength : 0.f);
+		}
+		keys[c] = key;
+	}
+
+	std::vector<size_t> order(clusterNum);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+		return keys[lhs] > keys[rhs];
+	});
+
+	size_t out = 0;
+	for (size_t c : order) {
+		const size_t begin = 3 * clusters[c];
+		const size_t end = 3 * clusters[c + 1];
+		std::copy(indices + begin, indices + end, dst + out);
+		out += end - begin;
+	}
+	assert(out == indexCount);
+}
+
+size_t Ubpa::Utopia::OptimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	std::fill(remap, remap + vertexCount, InvalidIndex);
+	uint32_t next = 0;
+	for (size_t i = 0; i < indexCount; i++) {
+		uint32_t v = indices[i];
+		if (remap[v] == InvalidIndex)
+			remap[v] = next++;
+	}
+	return next;
+}
+
+namespace {
+	template<typename T>
+	std::vector<T> RemapAttribute(const std::vector<T>& src, const std::vector<uint32_t>& remap, size_t newCount) {
+		if (src.empty())
+			return {};
+		std::vector<T> dst(newCount);
+		for (size_t v = 0; v < src.size(); v++) {
+			if (remap[v] != InvalidIndex)
+				dst[remap[v]] = src[v];
+		}
+		return dst;
+	}
+}
+
+MeshOptimizationReport Ubpa::Utopia::OptimizeMesh(Mesh& mesh) {
+	assert(mesh.IsEditable());
+	MeshOptimizationReport report;
+
+	const size_t vertexCount = mesh.GetPositions().size();
+	const auto& positions = mesh.GetPositions();
+
+	// level 0 and the LODs
+	std::vector<std::vector<SubMeshDescriptor>> levels;
+	for (size_t lod = 0; lod < mesh.GetLODNum(); lod++)
+		levels.push_back(mesh.GetLODSubMeshes(lod));
+
+	// with the base vertices
+	std::vector<uint32_t> indices = mesh.GetIndices();
+	for (const auto& level : levels) {
+		for (const auto& desc : level) {
+			for (size_t i = 0; i < desc.indexCount; i++)
+				indices[desc.indexStart + i] += static_cast<uint32_t>(desc.baseVertex);
+		}
+	}
+
+	report.before = AnalyzeVertexCache(mesh);
+
+	std::vector<uint32_t> scratch;
+	for (const auto& level : levels) {
+		for (const auto& desc : level) {
+			if (desc.topology != MeshTopology::Triangles || desc.indexCount < 3)
+				continue;
+
+			uint32_t* range = indices.data() + desc.indexStart;
+			scratch.resize(desc.indexCount);
+			OptimizeVertexCache(scratch.data(), range, desc.indexCount, vertexCount);
+			OptimizeOverdraw(range, scratch.data(), desc.indexCount, positions.data(), vertexCount);
+		}
+	}
+
+	std::vector<uint32_t> remap(vertexCount);
+	const size_t newCount = OptimizeVertexFetchRemap(remap.data(), indices.data(), indices.size(), vertexCount);
+	for (auto& index : indices)
+		index = remap[index];
+
+	mesh.SetPositions(RemapAttribute(mesh.GetPositions(), remap, newCount));
+	mesh.SetUV(RemapAttribute(mesh.GetUV(), remap, newCount));
+	mesh.SetNormals(RemapAttribute(mesh.GetNormals(), remap, newCount));
+	mesh.SetTangents(RemapAttribute(mesh.GetTangents(), remap, newCount));
+	mesh.SetColors(RemapAttribute(mesh.GetColors(), remap, newCount));
+	if (mesh.IsSkinned()) {
+		mesh.SetBoneWeights(
+			RemapAttribute(mesh.GetBoneIndices(), remap, newCount),
+			RemapAttribute(mesh.GetBoneWeights(), remap, newCount)
+		);
+	}
+	mesh.SetIndices(indices);
+	for (auto& level : levels) {
+		for (auto& desc : level)
+			desc.baseVertex = 0;
+	}
+	for (size_t i = 0; i < levels[0].size(); i++)
+		mesh.SetSubMesh(i, levels[0][i]);
+	mesh.SetLODs({ levels.begin() + 1, levels.end() });
+
+	report.after = AnalyzeVertexCache(mesh);
+	return report;
+}
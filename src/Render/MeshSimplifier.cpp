@@ -0,0 +1,530 @@
+#include <Utopia/Render/MeshSimplifier.h>
+
+#include <Utopia/Render/Mesh.h>
+#include <Utopia/Render/MeshOptimizer.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+namespace {
+	constexpr uint32_t InvalidIndex = static_cast<uint32_t>(-1);
+
+	// border edges are kept by planes perpendicular to their triangles, weighted by the squared edge length
+	constexpr double BorderWeight = 10.;
+	// a collapse may rotate the normal of a triangle by at most ~75 degrees
+	constexpr double MinNormalCos = 0.25;
+
+	using Vec3 = std::array<double, 3>;
+
+	Vec3 Sub(const Vec3& a, const Vec3& b) noexcept {
+		return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+	}
+
+	Vec3 Cross(const Vec3& a, const Vec3& b) noexcept {
+		return {
+			a[1] * b[2] - a[2] * b[1],
+			a[2] * b[0] - a[0] * b[2],
+			a[0] * b[1] - a[1] * b[0],
+		};
+	}
+
+	double Dot(const Vec3& a, const Vec3& b) noexcept {
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	// symmetric 4x4 matrix, sum of w * (n, d)(n, d)^T of the planes n.p + d = 0
+	struct Quadric {
+		double a2{ 0. }, ab{ 0. }, ac{ 0. }, ad{ 0. };
+		double b2{ 0. }, bc{ 0. }, bd{ 0. };
+		double c2{ 0. }, cd{ 0. };
+		double d2{ 0. };
+		double weight{ 0. }; // sum of w
+
+		void AddPlane(const Vec3& n, double d, double w) noexcept {
+			a2 += w * n[0] * n[0]; ab += w * n[0] * n[1]; ac += w * n[0] * n[2]; ad += w * n[0] * d;
+			b2 += w * n[1] * n[1]; bc += w * n[1] * n[2]; bd += w * n[1] * d;
+			c2 += w * n[2] * n[2]; cd += w * n[2] * d;
+			d2 += w * d * d;
+			weight += w;
+		}
+
+		void Add(const Quadric& q) noexcept {
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+			weight += q.weight;
+		}
+
+		// weighted sum of the squared distances to the planes
+		double Evaluate(const Vec3& p) const noexcept {
+			const double x = p[0], y = p[1], z = p[2];
+			return a2 * x * x + b2 * y * y + c2 * z * z
+				+ 2. * (ab * x * y + ac * x * z + bc * y * z)
+				+ 2. * (ad * x + bd * y + cd * z)
+				+ d2;
+		}
+	};
+
+	// mean squared distance of p to the planes of a and b
+	double CollapseCost(const Quadric& a, const Quadric& b, const Vec3& p) noexcept {
+		const double weight = a.weight + b.weight;
+		if (weight <= 0.)
+			return 0.;
+		return std::max(0., (a.Evaluate(p) + b.Evaluate(p)) / weight);
+	}
+
+	uint64_t EdgeKey(uint32_t a, uint32_t b) noexcept {
+		if (a > b)
+			std::swap(a, b);
+		return (static_cast<uint64_t>(a) << 32) | b;
+	}
+
+	// bits of a position
+	using PositionKey = std::array<uint32_t, 3>;
+	struct PositionKeyHash {
+		size_t operator()(const PositionKey& key) const noexcept {
+			return (key[0] * 73856093u) ^ (key[1] * 19349663u) ^ (key[2] * 83492791u);
+		}
+	};
+
+	// a seam edge has 1 triangle per vertex pair but 2 per position pair
+	enum class VertexKind : uint8_t {
+		Manifold,
+		Border, // on exactly 2 border edges
+		Seam,   // 1 of the 2 vertices at a position, both on exactly 2 seam edges, collapse together along the seam
+		Locked  // non-manifold, a corner of the border or of the seams
+	};
+
+	// the number of triangles of every edge, the vertices are mapped by id(v)
+	template<typename IDFunc>
+	void CountEdges(
+		std::unordered_map<uint64_t, uint32_t>& counts,
+		const std::vector<uint32_t>& indices,
+		IDFunc&& id
+	) {
+		counts.clear();
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			for (size_t k = 0; k < 3; k++) {
+				const uint32_t a = id(indices[i + k]);
+				const uint32_t b = id(indices[i + (k + 1) % 3]);
+				counts[EdgeKey(a, b)]++;
+			}
+		}
+	}
+
+	struct Collapse {
+		uint32_t v; // removed
+		uint32_t u; // kept
+		uint32_t seamU; // target of the partner of a seam vertex, else InvalidIndex
+		double cost;
+	};
+}
+
+float Ubpa::Utopia::SimplifyIndices(
+	std::vector<uint32_t>& dst,
+	const uint32_t* indices,
+	size_t indexCount,
+	const pointf3* positions,
+	size_t vertexCount,
+	size_t targetIndexCount,
+	float targetError,
+	const uint32_t* regions
+) {
+	assert(indexCount % 3 == 0);
+	dst.assign(indices, indices + indexCount);
+	if (indexCount <= targetIndexCount)
+		return 0.f;
+
+	// positions in the unit box of the mesh, the errors are relative to its extent
+	std::array<float, 3> minP{ positions[indices[0]][0], positions[indices[0]][1], positions[indices[0]][2] };
+	std::array<float, 3> maxP = minP;
+	for (size_t i = 0; i < indexCount; i++) {
+		const auto& p = positions[indices[i]];
+		for (size_t k = 0; k < 3; k++) {
+			minP[k] = std::min(minP[k], p[k]);
+			maxP[k] = std::max(maxP[k], p[k]);
+		}
+	}
+	const double extent = std::max({ maxP[0] - minP[0], maxP[1] - minP[1], maxP[2] - minP[2] });
+	if (extent <= 0.)
+		return 0.f;
+
+	std::vector<Vec3> points(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++) {
+		for (size_t k = 0; k < 3; k++)
+			points[i][k] = (positions[i][k] - minP[k]) / extent;
+	}
+
+	// welded[v] : the first vertex with the position of v
+	std::vector<uint32_t> welded(vertexCount, InvalidIndex);
+	{
+		std::unordered_map<PositionKey, uint32_t, PositionKeyHash> positionMap;
+		for (size_t i = 0; i < indexCount; i++) {
+			const uint32_t v = indices[i];
+			if (welded[v] != InvalidIndex)
+				continue;
+			PositionKey key;
+			for (size_t k = 0; k < 3; k++)
+				std::memcpy(&key[k], &positions[v][k], sizeof(uint32_t));
+			welded[v] = positionMap.try_emplace(key, v).first->second;
+		}
+	}
+
+	auto TriangleNormal = [&](const uint32_t* tri) {
+		return Cross(Sub(points[tri[1]], points[tri[0]]), Sub(points[tri[2]], points[tri[0]]));
+	};
+
+	auto WeldedID = [&](uint32_t v) { return welded[v]; };
+	auto VertexID = [](uint32_t v) { return v; };
+
+	std::unordered_map<uint64_t, uint32_t> edgeCounts; // of the welded vertices
+	std::unordered_map<uint64_t, uint32_t> vertexEdgeCounts;
+	CountEdges(edgeCounts, dst, WeldedID);
+
+	// quadrics of the welded vertices, planes weighted by the area of the triangles
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < indexCount; i += 3) {
+		const uint32_t* tri = indices + i;
+		Vec3 n = TriangleNormal(tri);
+		const double length = std::sqrt(Dot(n, n));
+		if (length == 0.)
+			continue;
+		n = { n[0] / length, n[1] / length, n[2] / length };
+		const double d = -Dot(n, points[tri[0]]);
+		for (size_t k = 0; k < 3; k++)
+			quadrics[welded[tri[k]]].AddPlane(n, d, 0.5 * length);
+
+		for (size_t k = 0; k < 3; k++) {
+			const uint32_t a = tri[k];
+			const uint32_t b = tri[(k + 1) % 3];
+			if (edgeCounts[EdgeKey(welded[a], welded[b])] != 1)
+				continue;
+			const Vec3 edge = Sub(points[b], points[a]);
+			Vec3 m = Cross(edge, n);
+			const double mLength = std::sqrt(Dot(m, m));
+			if (mLength == 0.)
+				continue;
+			m = { m[0] / mLength, m[1] / mLength, m[2] / mLength };
+			const double md = -Dot(m, points[a]);
+			const double w = Dot(edge, edge) * BorderWeight;
+			quadrics[welded[a]].AddPlane(m, md, w);
+			quadrics[welded[b]].AddPlane(m, md, w);
+		}
+	}
+
+	const size_t targetTriangleNum = targetIndexCount / 3;
+	const double maxCost = static_cast<double>(targetError) * targetError;
+	double error = 0.;
+
+	std::vector<VertexKind> kinds(vertexCount);
+	std::vector<uint8_t> referenced(vertexCount);
+	std::vector<uint32_t> groupSizes(vertexCount); // per welded vertex
+	std::vector<uint32_t> groupFirsts(vertexCount); // per welded vertex
+	std::vector<uint32_t> partners(vertexCount); // the other vertex at the position of a seam vertex
+	std::vector<uint8_t> nonManifold(vertexCount); // per welded vertex
+	std::vector<uint32_t> borderEdgeNums(vertexCount); // per welded vertex
+	std::vector<uint32_t> seamEdgeNums(vertexCount);
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<double> bestCosts(vertexCount);
+	std::vector<uint32_t> bestTargets(vertexCount);
+	std::vector<uint32_t> bestSeamTargets(vertexCount);
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint8_t> touched(vertexCount);
+
+	// passes of independent collapses, cheapest first
+	while (dst.size() > targetIndexCount) {
+		const size_t triangleNum = dst.size() / 3;
+
+		// classify the vertices on the current topology
+		CountEdges(edgeCounts, dst, WeldedID);
+		CountEdges(vertexEdgeCounts, dst, VertexID);
+		std::fill(referenced.begin(), referenced.end(), 0);
+		for (auto index : dst)
+			referenced[index] = 1;
+		std::fill(groupSizes.begin(), groupSizes.end(), 0);
+		for (size_t v = 0; v < vertexCount; v++) {
+			if (!referenced[v])
+				continue;
+			const uint32_t w = welded[v];
+			if (groupSizes[w] == 0)
+				groupFirsts[w] = static_cast<uint32_t>(v);
+			else if (groupSizes[w] == 1) {
+				partners[v] = groupFirsts[w];
+				partners[groupFirsts[w]] = static_cast<uint32_t>(v);
+			}
+			groupSizes[w]++;
+		}
+		std::fill(nonManifold.begin(), nonManifold.end(), 0);
+		std::fill(borderEdgeNums.begin(), borderEdgeNums.end(), 0);
+		std::fill(seamEdgeNums.begin(), seamEdgeNums.end(), 0);
+		for (const auto& [key, count] : edgeCounts) {
+			const auto a = static_cast<uint32_t>(key >> 32);
+			const auto b = static_cast<uint32_t>(key & 0xffffffff);
+			if (count > 2) {
+				nonManifold[a] = 1;
+				nonManifold[b] = 1;
+			}
+			else if (count == 1) {
+				borderEdgeNums[a]++;
+				borderEdgeNums[b]++;
+			}
+		}
+		for (const auto& [key, count] : vertexEdgeCounts) {
+			const auto a = static_cast<uint32_t>(key >> 32);
+			const auto b = static_cast<uint32_t>(key & 0xffffffff);
+			if (count == 1 && edgeCounts[EdgeKey(welded[a], welded[b])] == 2) {
+				seamEdgeNums[a]++;
+				seamEdgeNums[b]++;
+			}
+		}
+		for (size_t v = 0; v < vertexCount; v++) {
+			if (!referenced[v])
+				continue;
+			const uint32_t w = welded[v];
+			if (nonManifold[w] || groupSizes[w] > 2)
+				kinds[v] = VertexKind::Locked;
+			else if (groupSizes[w] == 2) {
+				const bool isSeam = borderEdgeNums[w] == 0 && seamEdgeNums[v] == 2 && seamEdgeNums[partners[v]] == 2;
+				kinds[v] = isSeam ? VertexKind::Seam : VertexKind::Locked;
+			}
+			else if (seamEdgeNums[v] > 0) // end of a seam
+				kinds[v] = VertexKind::Locked;
+			else if (borderEdgeNums[w] == 0)
+				kinds[v] = VertexKind::Manifold;
+			else
+				kinds[v] = borderEdgeNums[w] == 2 ? VertexKind::Border : VertexKind::Locked;
+		}
+
+		// vertex -> triangles
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (auto index : dst)
+			adjacencyOffsets[index + 1]++;
+		std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+		adjacency.resize(dst.size());
+		{
+			std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < dst.size(); i++)
+				adjacency[cursors[dst[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		// the vertex next to seam vertex v at the welded vertex w along the seam
+		auto SeamTarget = [&](uint32_t v, uint32_t w) {
+			for (uint32_t j = adjacencyOffsets[v]; j < adjacencyOffsets[v + 1]; j++) {
+				const uint32_t* tri = dst.data() + 3 * adjacency[j];
+				for (size_t k = 0; k < 3; k++) {
+					if (tri[k] != v && welded[tri[k]] == w && vertexEdgeCounts[EdgeKey(v, tri[k])] == 1)
+						return tri[k];
+				}
+			}
+			return InvalidIndex;
+		};
+
+		// the cheapest collapse of every vertex, a seam pair is handled by its first vertex
+		std::fill(bestCosts.begin(), bestCosts.end(), std::numeric_limits<double>::infinity());
+		for (size_t i = 0; i < dst.size(); i++) {
+			const uint32_t v = dst[i];
+			const VertexKind kind = kinds[v];
+			if (kind == VertexKind::Locked || kind == VertexKind::Seam && partners[v] < v)
+				continue;
+			const size_t triStart = i - i % 3;
+			for (size_t k = 1; k < 3; k++) {
+				const uint32_t u = dst[triStart + (i % 3 + k) % 3];
+				if (regions && regions[u] != regions[v])
+					continue;
+				const uint32_t weldedEdgeCount = edgeCounts[EdgeKey(welded[v], welded[u])];
+				uint32_t seamU = InvalidIndex;
+				if (kind == VertexKind::Border && weldedEdgeCount != 1)
+					continue;
+				if (kind == VertexKind::Seam) {
+					if (weldedEdgeCount != 2 || vertexEdgeCounts[EdgeKey(v, u)] != 1)
+						continue;
+					seamU = SeamTarget(partners[v], welded[u]);
+					if (seamU == InvalidIndex || seamU == u || (regions && regions[seamU] != regions[partners[v]]))
+						continue;
+				}
+				const double cost = CollapseCost(quadrics[welded[v]], quadrics[welded[u]], points[u]);
+				if (cost < bestCosts[v]) {
+					bestCosts[v] = cost;
+					bestTargets[v] = u;
+					bestSeamTargets[v] = seamU;
+				}
+			}
+		}
+		collapses.clear();
+		for (size_t v = 0; v < vertexCount; v++) {
+			if (bestCosts[v] <= maxCost)
+				collapses.push_back({ static_cast<uint32_t>(v), bestTargets[v], bestSeamTargets[v], bestCosts[v] });
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) {
+			return lhs.cost < rhs.cost;
+		});
+
+		// a triangle around v must keep its orientation when v moves to u
+		auto Flips = [&](uint32_t v, uint32_t u) {
+			for (uint32_t j = adjacencyOffsets[v]; j < adjacencyOffsets[v + 1]; j++) {
+				const uint32_t* tri = dst.data() + 3 * adjacency[j];
+				if (tri[0] == u || tri[1] == u || tri[2] == u)
+					continue;
+				const uint32_t moved[3] = {
+					tri[0] == v ? u : tri[0],
+					tri[1] == v ? u : tri[1],
+					tri[2] == v ? u : tri[2],
+				};
+				const Vec3 n0 = TriangleNormal(tri);
+				const Vec3 n1 = TriangleNormal(moved);
+				if (Dot(n0, n1) <= MinNormalCos * std::sqrt(Dot(n0, n0) * Dot(n1, n1)))
+					return true;
+			}
+			return false;
+		};
+
+		// the triangles around a collapse are not touched again in this pass
+		std::iota(remap.begin(), remap.end(), 0);
+		std::fill(touched.begin(), touched.end(), 0);
+		size_t removedNum = 0;
+		auto Apply = [&](uint32_t v, uint32_t u) {
+			remap[v] = u;
+			for (uint32_t j = adjacencyOffsets[v]; j < adjacencyOffsets[v + 1]; j++) {
+				const uint32_t* tri = dst.data() + 3 * adjacency[j];
+				if (tri[0] == u || tri[1] == u || tri[2] == u)
+					removedNum++;
+				for (size_t k = 0; k < 3; k++)
+					touched[tri[k]] = 1;
+			}
+		};
+		bool collapsed = false;
+		for (const auto& collapse : collapses) {
+			const uint32_t v = collapse.v;
+			const uint32_t u = collapse.u;
+			if (touched[v] || touched[u] || Flips(v, u))
+				continue;
+			if (collapse.seamU != InvalidIndex) {
+				const uint32_t seamV = partners[v];
+				if (touched[seamV] || touched[collapse.seamU] || Flips(seamV, collapse.seamU))
+					continue;
+				Apply(seamV, collapse.seamU);
+			}
+			Apply(v, u);
+			quadrics[welded[u]].Add(quadrics[welded[v]]);
+			error = std::max(error, collapse.cost);
+			collapsed = true;
+
+			if (triangleNum - removedNum <= targetTriangleNum)
+				break;
+		}
+		if (!collapsed)
+			break;
+
+		// drop the triangles without area
+		size_t count = 0;
+		for (size_t i = 0; i < dst.size(); i += 3) {
+			const uint32_t a = remap[dst[i + 0]];
+			const uint32_t b = remap[dst[i + 1]];
+			const uint32_t c = remap[dst[i + 2]];
+			if (welded[a] == welded[b] || welded[b] == welded[c] || welded[c] == welded[a])
+				continue;
+			dst[count++] = a;
+			dst[count++] = b;
+			dst[count++] = c;
+		}
+		dst.resize(count);
+	}
+
+	return static_cast<float>(std::sqrt(error));
+}
+
+size_t Ubpa::Utopia::GenerateLODs(Mesh& mesh, const LODGenerationDesc& desc) {
+	assert(mesh.IsEditable());
+	assert(desc.ratio > 0.f && desc.ratio < 1.f);
+
+	const auto& positions = mesh.GetPositions();
+	const auto& submeshes = mesh.GetSubMeshes();
+	std::vector<uint32_t> indices = mesh.GetIndices();
+
+	// the previous level of every submesh, with the base vertices
+	std::vector<std::vector<uint32_t>> levels(submeshes.size());
+	for (size_t i = 0; i < submeshes.size(); i++) {
+		const auto& submesh = submeshes[i];
+		levels[i].assign(
+			indices.begin() + submesh.indexStart,
+			indices.begin() + submesh.indexStart + submesh.indexCount
+		);
+		for (auto& index : levels[i])
+			index += static_cast<uint32_t>(submesh.baseVertex);
+	}
+
+	// a skinned vertex only collapses onto a vertex with the same main bone, the joints keep their edge loops
+	std::vector<uint32_t> mainBones;
+	if (mesh.IsSkinned()) {
+		const auto& boneIndices = mesh.GetBoneIndices();
+		const auto& boneWeights = mesh.GetBoneWeights();
+		mainBones.resize(boneWeights.size());
+		for (size_t v = 0; v < boneWeights.size(); v++) {
+			size_t k = 0;
+			for (size_t j = 1; j < 4; j++) {
+				if (boneWeights[v][j] > boneWeights[v][k])
+					k = j;
+			}
+			mainBones[v] = boneIndices[v][k];
+		}
+	}
+
+	std::vector<std::vector<SubMeshDescriptor>> lods;
+	std::vector<uint32_t> simplified;
+	for (size_t lod = 1; lod < desc.levelNum; lod++) {
+		const size_t indexNum = indices.size();
+		bool progress = false;
+		std::vector<SubMeshDescriptor> lodSubmeshes;
+		for (size_t i = 0; i < submeshes.size(); i++) {
+			const auto& submesh = submeshes[i];
+			auto& level = levels[i];
+			if (submesh.topology == MeshTopology::Triangles && level.size() > 3) {
+				const auto target = static_cast<size_t>(submesh.indexCount * std::pow(desc.ratio, static_cast<float>(lod)));
+				SimplifyIndices(
+					simplified,
+					level.data(),
+					level.size(),
+					positions.data(),
+					positions.size(),
+					std::max<size_t>(target / 3 * 3, 3),
+					desc.maxError,
+					mainBones.empty() ? nullptr : mainBones.data()
+				);
+				if (simplified.size() < level.size()) {
+					progress = true;
+					level.resize(simplified.size());
+					OptimizeVertexCache(level.data(), simplified.data(), simplified.size(), positions.size());
+				}
+			}
+
+			SubMeshDescriptor lodSubmesh = submesh;
+			lodSubmesh.indexStart = indices.size();
+			lodSubmesh.indexCount = level.size();
+			lodSubmesh.baseVertex = 0;
+			lodSubmeshes.push_back(lodSubmesh);
+			indices.insert(indices.end(), level.begin(), level.end());
+		}
+
+		if (!progress) {
+			indices.resize(indexNum);
+			break;
+		}
+		lods.push_back(std::move(lodSubmeshes));
+	}
+
+	mesh.SetIndices(std::move(indices));
+	mesh.SetLODs(std::move(lods));
+	return mesh.GetLODNum();
+}
@@ -0,0 +1,316 @@
+#include <Utopia/Render/Meshlet.h>
+
+#include <Utopia/Render/Mesh.h>
+#include <Utopia/Render/FrustumCulling.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+namespace {
+	constexpr uint32_t InvalidIndex = static_cast<uint32_t>(-1);
+
+	MeshletBounds ComputeBounds(const MeshletData& data, const Meshlet& meshlet, const pointf3* positions) {
+		MeshletBounds bounds;
+
+		// sphere around the center of the AABB
+		const uint32_t* vertices = data.vertices.data() + meshlet.vertexOffset;
+		float minP[3] = { positions[vertices[0]][0], positions[vertices[0]][1], positions[vertices[0]][2] };
+		float maxP[3] = { minP[0], minP[1], minP[2] };
+		for (uint32_t i = 1; i < meshlet.vertexCount; i++) {
+			const auto& p = positions[vertices[i]];
+			for (size_t k = 0; k < 3; k++) {
+				minP[k] = std::min(minP[k], p[k]);
+				maxP[k] = std::max(maxP[k], p[k]);
+			}
+		}
+		for (size_t k = 0; k < 3; k++)
+			bounds.center[k] = 0.5f * (minP[k] + maxP[k]);
+		float radius2 = 0.f;
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+			const auto& p = positions[vertices[i]];
+			const float d[3] = { p[0] - bounds.center[0], p[1] - bounds.center[1], p[2] - bounds.center[2] };
+			radius2 = std::max(radius2, d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+		}
+		bounds.radius = std::sqrt(radius2);
+
+		// cone around the mean of the unit normals
+		std::vector<std::array<float, 3>> normals;
+		normals.reserve(meshlet.triangleCount);
+		float axis[3] = { 0.f, 0.f, 0.f };
+		const uint8_t* triangles = data.triangles.data() + meshlet.triangleOffset;
+		for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+			const auto& p0 = positions[vertices[triangles[3 * t + 0]]];
+			const auto& p1 = positions[vertices[triangles[3 * t + 1]]];
+			const auto& p2 = positions[vertices[triangles[3 * t + 2]]];
+			const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			const float n[3] = {
+				e1[1] * e2[2] - e1[2] * e2[1],
+				e1[2] * e2[0] - e1[0] * e2[2],
+				e1[0] * e2[1] - e1[1] * e2[0],
+			};
+			const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (length == 0.f)
+				continue;
+			normals.push_back({ n[0] / length, n[1] / length, n[2] / length });
+			for (size_t k = 0; k < 3; k++)
+				axis[k] += normals.back()[k];
+		}
+
+		const float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		if (normals.empty() || axisLength < 1e-6f) {
+			bounds.coneAxis = { 0.f, 0.f, 1.f };
+			bounds.coneCutoff = 1.f;
+			return bounds;
+		}
+		for (size_t k = 0; k < 3; k++)
+			bounds.coneAxis[k] = axis[k] / axisLength;
+
+		// cosine of the spread
+		float minDot = 1.f;
+		for (const auto& n : normals)
+			minDot = std::min(minDot, n[0] * bounds.coneAxis[0] + n[1] * bounds.coneAxis[1] + n[2] * bounds.coneAxis[2]);
+		bounds.coneCutoff = minDot <= 0.f ? 1.f : std::sqrt(1.f - minDot * minDot);
+
+		return bounds;
+	}
+}
+
+void Ubpa::Utopia::BuildMeshlets(
+	MeshletData& data,
+	uint32_t* dst,
+	const uint32_t* indices,
+	size_t indexCount,
+	const pointf3* positions,
+	size_t vertexCount,
+	size_t indexOffset,
+	size_t maxVertices,
+	size_t maxTriangles
+) {
+	assert(indexCount % 3 == 0);
+	assert(dst != indices);
+	assert(maxVertices >= 3 && maxVertices <= 256);
+	assert(maxTriangles >= 1);
+
+	const size_t triangleNum = indexCount / 3;
+
+	// vertex -> triangles
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < indexCount; i++)
+		adjacencyOffsets[indices[i] + 1]++;
+	for (size_t v = 0; v < vertexCount; v++)
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+	std::vector<uint32_t> adjacency(indexCount);
+	{
+		std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indexCount; i++)
+			adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<float> centroids(3 * triangleNum);
+	for (size_t t = 0; t < triangleNum; t++) {
+		const auto& p0 = positions[indices[3 * t + 0]];
+		const auto& p1 = positions[indices[3 * t + 1]];
+		const auto& p2 = positions[indices[3 * t + 2]];
+		for (size_t k = 0; k < 3; k++)
+			centroids[3 * t + k] = (p0[k] + p1[k] + p2[k]) / 3.f;
+	}
+
+	std::vector<uint8_t> emitted(triangleNum, 0);
+	// mesh vertex -> local vertex of the current meshlet
+	std::vector<uint32_t> localVertices(vertexCount, InvalidIndex);
+
+	Meshlet meshlet;
+	meshlet.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+	meshlet.triangleOffset = static_cast<uint32_t>(data.triangles.size());
+	meshlet.indexStart = indexOffset;
+	float centroidSum[3] = { 0.f, 0.f, 0.f };
+	size_t emittedNum = 0;
+	// the first triangle in the input order that may not be emitted
+	size_t cursor = 0;
+
+	auto NewVertexNum = [&](size_t t) {
+		size_t num = 0;
+		for (size_t k = 0; k < 3; k++) {
+			if (localVertices[indices[3 * t + k]] == InvalidIndex)
+				num++;
+		}
+		return num;
+	};
+
+	auto Emit = [&](size_t t) {
+		for (size_t k = 0; k < 3; k++) {
+			const uint32_t v = indices[3 * t + k];
+			uint32_t& local = localVertices[v];
+			if (local == InvalidIndex) {
+				local = meshlet.vertexCount++;
+				data.vertices.push_back(v);
+			}
+			data.triangles.push_back(static_cast<uint8_t>(local));
+			dst[3 * emittedNum + k] = v;
+			centroidSum[k] += centroids[3 * t + k];
+		}
+		emitted[t] = 1;
+		emittedNum++;
+		meshlet.triangleCount++;
+	};
+
+	auto Flush = [&]() {
+		if (meshlet.triangleCount == 0)
+			return;
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+			localVertices[data.vertices[meshlet.vertexOffset + i]] = InvalidIndex;
+		data.meshlets.push_back(meshlet);
+		data.bounds.push_back(ComputeBounds(data, meshlet, positions));
+
+		meshlet.indexStart += 3 * meshlet.triangleCount;
+		meshlet.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+		meshlet.triangleOffset = static_cast<uint32_t>(data.triangles.size());
+		meshlet.vertexCount = 0;
+		meshlet.triangleCount = 0;
+		centroidSum[0] = centroidSum[1] = centroidSum[2] = 0.f;
+	};
+
+	while (emittedNum < triangleNum) {
+		// the not emitted triangles around the meshlet, fewest new vertices first, then nearest to the meshlet
+		size_t best = InvalidIndex;
+		size_t bestNewVertexNum = 4;
+		float bestDistance2 = 0.f;
+		const float count = static_cast<float>(meshlet.triangleCount);
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+			const uint32_t v = data.vertices[meshlet.vertexOffset + i];
+			for (uint32_t j = adjacencyOffsets[v]; j < adjacencyOffsets[v + 1]; j++) {
+				const uint32_t t = adjacency[j];
+				if (emitted[t])
+					continue;
+				const size_t newVertexNum = NewVertexNum(t);
+				if (newVertexNum > bestNewVertexNum)
+					continue;
+				float distance2 = 0.f;
+				for (size_t k = 0; k < 3; k++) {
+					const float d = centroids[3 * t + k] - centroidSum[k] / count;
+					distance2 += d * d;
+				}
+				if (newVertexNum < bestNewVertexNum || distance2 < bestDistance2) {
+					best = t;
+					bestNewVertexNum = newVertexNum;
+					bestDistance2 = distance2;
+				}
+			}
+		}
+
+		if (best != InvalidIndex
+			&& (meshlet.vertexCount + bestNewVertexNum > maxVertices || meshlet.triangleCount + 1 > maxTriangles))
+		{
+			// the next meshlet starts from here
+			Flush();
+		}
+		else if (best == InvalidIndex) {
+			// the region is used up, restart at the first triangle left
+			Flush();
+			while (emitted[cursor])
+				cursor++;
+			best = cursor;
+		}
+		Emit(best);
+	}
+	Flush();
+}
+
+void Ubpa::Utopia::BuildMeshlets(Mesh& mesh) {
+	assert(mesh.IsEditable());
+
+	const auto& positions = mesh.GetPositions();
+	const auto submeshes = mesh.GetSubMeshes();
+	std::vector<uint32_t> indices = mesh.GetIndices();
+
+	MeshletData data;
+	data.submeshOffsets.clear();
+	std::vector<uint32_t> range;
+	std::vector<uint32_t> ordered;
+	for (const auto& submesh : submeshes) {
+		data.submeshOffsets.push_back(data.meshlets.size());
+		if (submesh.topology != MeshTopology::Triangles || submesh.indexCount < 3)
+			continue;
+
+		// with the base vertex
+		range.assign(
+			indices.begin() + submesh.indexStart,
+			indices.begin() + submesh.indexStart + submesh.indexCount
+		);
+		for (auto& index : range)
+			index += static_cast<uint32_t>(submesh.baseVertex);
+
+		ordered.resize(range.size());
+		BuildMeshlets(data, ordered.data(), range.data(), range.size(), positions.data(), positions.size(), submesh.indexStart);
+
+		for (size_t i = 0; i < ordered.size(); i++)
+			indices[submesh.indexStart + i] = ordered[i] - static_cast<uint32_t>(submesh.baseVertex);
+	}
+	data.submeshOffsets.push_back(data.meshlets.size());
+
+	mesh.SetIndices(std::move(indices));
+	// update the first vertices
+	for (size_t i = 0; i < submeshes.size(); i++)
+		mesh.SetSubMesh(i, submeshes[i]);
+	mesh.SetMeshlets(std::move(data));
+}
+
+MeshletCullStats Ubpa::Utopia::CullMeshlets(
+	std::vector<MeshletIndexRange>& ranges,
+	const MeshletData& data,
+	size_t submeshIdx,
+	const Frustum& frustum,
+	const pointf3& eye
+) {
+	MeshletCullStats stats;
+
+	const size_t begin = data.submeshOffsets[submeshIdx];
+	const size_t end = data.submeshOffsets[submeshIdx + 1];
+	// the last range is extended while the meshlets stay contiguous
+	bool extendable = false;
+	for (size_t i = begin; i < end; i++) {
+		const auto& meshlet = data.meshlets[i];
+		const auto& bounds = data.bounds[i];
+
+		bool outside = false;
+		for (const auto& plane : frustum.planes) {
+			const float distance = plane[0] * bounds.center[0] + plane[1] * bounds.center[1] + plane[2] * bounds.center[2] + plane[3];
+			if (distance < -bounds.radius) {
+				outside = true;
+				break;
+			}
+		}
+		if (outside) {
+			stats.frustumCulled++;
+			extendable = false;
+			continue;
+		}
+
+		if (bounds.coneCutoff < 1.f) {
+			const float d[3] = { bounds.center[0] - eye[0], bounds.center[1] - eye[1], bounds.center[2] - eye[2] };
+			const float distance = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+			const float projection = d[0] * bounds.coneAxis[0] + d[1] * bounds.coneAxis[1] + d[2] * bounds.coneAxis[2];
+			if (projection >= bounds.coneCutoff * distance + (1.f + bounds.coneCutoff) * bounds.radius) {
+				stats.backfaceCulled++;
+				extendable = false;
+				continue;
+			}
+		}
+
+		stats.visible++;
+		const size_t indexCount = 3 * static_cast<size_t>(meshlet.triangleCount);
+		if (extendable && ranges.back().indexStart + ranges.back().indexCount == meshlet.indexStart)
+			ranges.back().indexCount += indexCount;
+		else
+			ranges.push_back({ meshlet.indexStart, indexCount });
+		extendable = true;
+	}
+
+	return stats;
+}
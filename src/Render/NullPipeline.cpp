@@ -0,0 +1,223 @@
+#include <Utopia/Render/NullPipeline.h>
+
+#include <Utopia/Render/Shader.h>
+#include <Utopia/Render/Mesh.h>
+#include <Utopia/Render/Material.h>
+#include <Utopia/Render/StdFrameGraph.h>
+#include <Utopia/Core/Profiler.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+using namespace Ubpa::Utopia;
+
+namespace Ubpa::Utopia::details {
+	// fake root parameters of the null device
+	enum NullRootSlot : uint32_t {
+		MaterialCB,
+		CameraCB,
+		LightArrayCB,
+		ObjectCB,
+		Objects,
+		Instances,
+		LightClusters,
+	};
+}
+
+NullPipeline::Stats& NullPipeline::Stats::operator+=(const Stats& rhs) noexcept {
+	objects += rhs.objects;
+	culled += rhs.culled;
+	draws += rhs.draws;
+	instances += rhs.instances;
+	triangles += rhs.triangles;
+	commands += rhs.commands;
+	rootSignatureChanges += rhs.rootSignatureChanges;
+	psoChanges += rhs.psoChanges;
+	meshChanges += rhs.meshChanges;
+	stencilRefChanges += rhs.stencilRefChanges;
+	bindings += rhs.bindings;
+	skippedBindings += rhs.skippedBindings;
+	uploadedBytes += rhs.uploadedBytes;
+	uploadedObjects += rhs.uploadedObjects;
+	frameGraphCompiles += rhs.frameGraphCompiles;
+	frameGraphCacheHits += rhs.frameGraphCacheHits;
+	return *this;
+}
+
+NullPipeline::NullPipeline(InitDesc initDesc)
+	:
+	initDesc{ initDesc },
+	core{ initDesc.numFrame },
+	objectBuffers(initDesc.numFrame)
+{}
+
+void NullPipeline::Resize(size_t width, size_t height) {
+	this->width = width;
+	this->height = height;
+	fgCache.Invalidate();
+}
+
+void NullPipeline::BeginFrame(const std::vector<const UECS::World*>& worlds, const RenderCamera& camera) {
+	UBPA_UTOPIA_PROFILE_SCOPE("NullPipeline::BeginFrame");
+
+	frameStats = {};
+
+	core.Extract(worlds, camera, width, height);
+	frameStats.objects = core.renderQueue.GetOpaques().size() + core.renderQueue.GetTransparents().size();
+	frameStats.culled = core.GetCulledNum();
+
+	// uploads
+	commonBuffer.resize(core.LayoutCommonBuffer());
+	core.UploadCommonBuffer([&](size_t offset, const void* data, size_t size) {
+		std::memcpy(commonBuffer.data() + offset, data, size);
+		frameStats.uploadedBytes += size;
+	});
+
+	const size_t stride = PipelineCore::CalcConstantBufferByteSize(sizeof(PipelineCore::ObjectConstants));
+	auto& objectBuffer = objectBuffers[frameIndex];
+	// keep the content
+	objectBuffer.resize(std::max<size_t>(core.GetObjectCapacity(), 1) * stride);
+	core.UploadObjects(stride, [&](size_t offset, const void* data, size_t size) {
+		std::memcpy(objectBuffer.data() + offset, data, size);
+		frameStats.uploadedBytes += size;
+	});
+	frameStats.uploadedObjects = core.GetUploadedObjectNum();
+}
+
+void NullPipeline::Render() {
+	UBPA_UTOPIA_PROFILE_SCOPE("NullPipeline::Render");
+
+	const auto nodes = StdFrameGraph::Register(fg, fgTopology, width, height);
+
+	const size_t missNum = fgCache.GetMissNum();
+	const auto* crst = fgCache.GetOrCompile(fgTopology.GetHash(), [&]() {
+		return fgCompiler.Compile(fg);
+	});
+	if (fgCache.GetMissNum() != missNum)
+		frameStats.frameGraphCompiles++;
+	else
+		frameStats.frameGraphCacheHits++;
+	if (!crst)
+		return;
+
+	for (auto pass : crst->sorted_passes) {
+		// begin pass
+		frameStats.commands++;
+
+		if (pass == nodes.gbPass) {
+			CompileDrawStream(deferredStream, "Deferred", 3);
+			Record(deferredStream);
+		}
+		else if (pass == nodes.forwardPass) {
+			CompileDrawStream(forwardStream, "Forward", 1);
+			Record(forwardStream);
+		}
+	}
+}
+
+void NullPipeline::EndFrame() {
+	totalStats += frameStats;
+	frameCount++;
+	frameIndex = (frameIndex + 1) % initDesc.numFrame;
+}
+
+void NullPipeline::CompileDrawStream(DrawStream& stream, std::string_view lightMode, size_t rtNum) {
+	UBPA_UTOPIA_PROFILE_SCOPE("NullPipeline::CompileDrawStream");
+
+	using namespace details;
+
+	stream.Clear();
+
+	const size_t objectStride = PipelineCore::CalcConstantBufferByteSize(sizeof(PipelineCore::ObjectConstants));
+	// fake addresses, the null device only compares them
+	const uint64_t commonBufferAddress = 1ull << 40;
+	const uint64_t objectBufferAddress = 2ull << 40;
+	const uint64_t materialBufferAddress = 3ull << 40;
+
+	std::vector<RootBinding> bindings;
+
+	auto Compile = [&](const RenderObjectList& objects, const InstanceBatch& batch, size_t instanceBase) {
+		const auto& obj = objects[batch.first];
+		const auto& shader = *obj.material->shader;
+		const auto& pass = shader.passes[obj.passIdx];
+
+		if (auto target = pass.tags.find("LightMode"); target == pass.tags.end() || target->second != lightMode)
+			return;
+
+		const auto& submesh = obj.mesh->GetLODSubMeshes(obj.lod).at(obj.submeshIdx);
+
+		DrawState state;
+		state.rootSignature = shader.GetInstanceID() + 1;
+		state.pso = ((shader.GetInstanceID() * 64 + obj.passIdx) * 8 + rtNum) + 1;
+		state.mesh = obj.mesh->GetInstanceID() + 1;
+		state.stencilEnable = pass.renderState.stencilState.enable;
+		state.stencilRef = pass.renderState.stencilState.ref;
+		state.indexCount = static_cast<uint32_t>(submesh.indexCount);
+		state.startIndex = static_cast<uint32_t>(submesh.indexStart);
+		state.baseVertex = static_cast<int32_t>(submesh.baseVertex);
+
+		bindings = {
+			{ RootBinding::Type::CBV, MaterialCB, materialBufferAddress + obj.material->GetInstanceID() * 256 },
+			{ RootBinding::Type::CBV, CameraCB, commonBufferAddress + core.cameraOffset },
+			{ RootBinding::Type::CBV, LightArrayCB, commonBufferAddress + core.lightOffset },
+			{ RootBinding::Type::CBV, ObjectCB, objectBufferAddress + obj.objectIdx * objectStride },
+			{ RootBinding::Type::SRV, Objects, objectBufferAddress },
+			{ RootBinding::Type::SRV, LightClusters, commonBufferAddress + core.clusterRangeOffset },
+		};
+		state.bindings = bindings.data();
+		state.bindingNum = bindings.size();
+
+		if (initDesc.instancing) {
+			bindings.push_back({ RootBinding::Type::SRV, Instances,
+				commonBufferAddress + core.instanceOffset + (instanceBase + batch.first) * sizeof(uint32_t) });
+			state.bindings = bindings.data();
+			state.bindingNum = bindings.size();
+			state.instanceCount = static_cast<uint32_t>(batch.count);
+			stream.Add(state);
+			return;
+		}
+
+		// one draw per object
+		for (size_t i = batch.first; i < batch.first + batch.count; i++) {
+			bindings[ObjectCB].value = objectBufferAddress + objects[i].objectIdx * objectStride;
+			stream.Add(state);
+		}
+	};
+
+	const auto& opaques = core.renderQueue.GetOpaques();
+	for (const auto& batch : core.opaqueBatcher.GetBatches())
+		Compile(opaques, batch, 0);
+
+	const auto& transparents = core.renderQueue.GetTransparents();
+	for (const auto& batch : core.transparentBatcher.GetBatches())
+		Compile(transparents, batch, opaques.size());
+}
+
+void NullPipeline::Record(const DrawStream& stream) {
+	// topology
+	frameStats.commands++;
+
+	for (const auto& record : stream.GetRecords()) {
+		if (record.flags & DrawRecord::SetRootSignature)
+			frameStats.commands++;
+		if (record.flags & DrawRecord::SetPSO)
+			frameStats.commands++;
+		if (record.flags & DrawRecord::SetMesh)
+			frameStats.commands += 2; // vertex and index buffers
+		if (record.flags & DrawRecord::SetStencilRef)
+			frameStats.commands++;
+		frameStats.commands += record.bindingNum + 1;
+		frameStats.instances += record.instanceCount;
+		frameStats.triangles += static_cast<size_t>(record.indexCount / 3) * record.instanceCount;
+	}
+
+	const auto& stats = stream.GetStats();
+	frameStats.draws += stats.draws;
+	frameStats.rootSignatureChanges += stats.rootSignatureChanges;
+	frameStats.psoChanges += stats.psoChanges;
+	frameStats.meshChanges += stats.meshChanges;
+	frameStats.stencilRefChanges += stats.stencilRefChanges;
+	frameStats.bindings += stats.bindings;
+	frameStats.skippedBindings += stats.skippedBindings;
+}
@@ -0,0 +1,104 @@
+#include <Utopia/Render/ObjectSlotAllocator.h>
+
+#include <algorithm>
+
+using namespace Ubpa::Utopia;
+
+ObjectSlotAllocator::ObjectSlotAllocator(size_t numFrame) noexcept
+	: numFrame{ static_cast<uint32_t>(std::max<size_t>(numFrame, 1)) } {}
+
+size_t ObjectSlotAllocator::Acquire(size_t world, UECS::Entity entity, bool& isNew) {
+	if (world >= entity2slot.size())
+		entity2slot.resize(world + 1);
+	auto& table = entity2slot[world];
+	if (entity.Idx() >= table.size())
+		table.resize(entity.Idx() + 1);
+
+	auto& entry = table[entity.Idx()];
+	if (entry.slot != static_cast<size_t>(-1) && entry.version == entity.Version()) {
+		slots[entry.slot].frame = frame;
+		isNew = false;
+		return entry.slot;
+	}
+
+	// the entity index is reused by a new entity, the old slot is released in ReleaseUnused
+
+	size_t slot;
+	if (!freeSlots.empty()) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		slot = slots.size();
+		slots.emplace_back();
+	}
+
+	slots[slot].world = world;
+	slots[slot].entityIdx = entity.Idx();
+	slots[slot].frame = frame;
+	entry.version = entity.Version();
+	entry.slot = slot;
+
+	isNew = true;
+	MarkDirty(slot);
+	return slot;
+}
+
+void ObjectSlotAllocator::MarkDirty(size_t slot) {
+	auto& s = slots[slot];
+	if (s.countdown == 0)
+		dirtySlots.push_back(slot);
+	s.countdown = numFrame;
+}
+
+void ObjectSlotAllocator::ReleaseUnused() {
+	for (size_t i = 0; i < slots.size(); i++) {
+		auto& s = slots[i];
+		if (s.world == static_cast<size_t>(-1) || s.frame == frame)
+			continue;
+
+		auto& entry = entity2slot[s.world][s.entityIdx];
+		if (entry.slot == i)
+			entry = {};
+
+		s.world = static_cast<size_t>(-1);
+		s.countdown = 0;
+		freeSlots.push_back(i);
+	}
+	// free slots are never dirty
+	dirtySlots.erase(
+		std::remove_if(dirtySlots.begin(), dirtySlots.end(), [&](size_t slot) { return slots[slot].countdown == 0; }),
+		dirtySlots.end()
+	);
+	frame++;
+}
+
+const std::vector<std::pair<size_t, size_t>>& ObjectSlotAllocator::CollectDirtyRanges() {
+	dirtyRanges.clear();
+	uploadNum = dirtySlots.size();
+
+	std::sort(dirtySlots.begin(), dirtySlots.end());
+	for (size_t slot : dirtySlots) {
+		if (!dirtyRanges.empty() && dirtyRanges.back().second == slot)
+			dirtyRanges.back().second++;
+		else
+			dirtyRanges.emplace_back(slot, slot + 1);
+	}
+
+	dirtySlots.erase(
+		std::remove_if(dirtySlots.begin(), dirtySlots.end(), [&](size_t slot) { return --slots[slot].countdown == 0; }),
+		dirtySlots.end()
+	);
+
+	return dirtyRanges;
+}
+
+void ObjectSlotAllocator::Clear() {
+	entity2slot.clear();
+	slots.clear();
+	freeSlots.clear();
+	dirtySlots.clear();
+	dirtyRanges.clear();
+	uploadNum = 0;
+	frame = 1;
+}
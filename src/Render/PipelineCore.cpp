@@ -0,0 +1,457 @@
+#include <Utopia/Render/PipelineCore.h>
+
+#include <Utopia/Render/Shader.h>
+#include <Utopia/Render/Mesh.h>
+#include <Utopia/Render/Material.h>
+#include <Utopia/Render/LODSelection.h>
+#include <Utopia/Render/Components/Camera.h>
+#include <Utopia/Render/Components/LODGroup.h>
+#include <Utopia/Render/Components/MeshFilter.h>
+#include <Utopia/Render/Components/MeshRenderer.h>
+#include <Utopia/Render/Components/SkinnedMesh.h>
+#include <Utopia/Render/Components/Light.h>
+#include <Utopia/Core/GameTimer.h>
+#include <Utopia/Core/Profiler.h>
+
+#include <Utopia/Core/Components/LocalToWorld.h>
+#include <Utopia/Core/Components/PrevLocalToWorld.h>
+#include <Utopia/Core/Components/FixedTime.h>
+#include <Utopia/Core/FixedTimestep.h>
+#include <Utopia/Core/Components/Translation.h>
+#include <Utopia/Core/Components/WorldToLocal.h>
+
+#include <UECS/World.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa::UECS;
+using namespace Ubpa;
+
+namespace {
+	// unique over all the pipelines, 0 is never used
+	std::atomic<uint64_t> nextExtractionID{ 1 };
+}
+
+PipelineCore::PipelineCore(size_t numFrame)
+	: objectSlots{ numFrame } {}
+
+size_t PipelineCore::LODState::Get(size_t world, Entity entity) const noexcept {
+	if (world >= entity2lod.size() || entity.Idx() >= entity2lod[world].size())
+		return 0;
+	const auto& entry = entity2lod[world][entity.Idx()];
+	return entry.version == entity.Version() ? entry.lod : 0;
+}
+
+void PipelineCore::LODState::Set(size_t world, Entity entity, size_t lod) {
+	if (world >= entity2lod.size())
+		entity2lod.resize(world + 1);
+	auto& table = entity2lod[world];
+	if (entity.Idx() >= table.size())
+		table.resize(entity.Idx() + 1);
+	table[entity.Idx()] = { entity.Version(), lod };
+}
+
+PipelineCore::ExtractionBuffer& PipelineCore::GetExtractionBuffer() {
+	// the buffer of the current thread is looked up once per extraction, not per chunk
+	thread_local uint64_t cachedExtractionID = 0;
+	thread_local ExtractionBuffer* cachedBuffer = nullptr;
+	if (cachedExtractionID == extractionID)
+		return *cachedBuffer;
+
+	std::lock_guard<std::mutex> lock(extractionMutex);
+	auto target = thread2extractionBuffer.find(std::this_thread::get_id());
+	if (target == thread2extractionBuffer.end()) {
+		extractionBuffers.push_back(std::make_unique<ExtractionBuffer>());
+		target = thread2extractionBuffer.emplace_hint(target, std::this_thread::get_id(), extractionBuffers.back().get());
+	}
+
+	cachedExtractionID = extractionID;
+	cachedBuffer = target->second;
+	return *cachedBuffer;
+}
+
+void PipelineCore::Extract(
+	const std::vector<const UECS::World*>& worlds,
+	const RenderCamera& camera,
+	size_t width,
+	size_t height
+) {
+	UBPA_UTOPIA_PROFILE_SCOPE("PipelineCore::Extract");
+
+	renderQueue.Clear();
+
+	extractNum++;
+	lodState = &camera2lodState[{ &camera.world, camera.entity.Idx(), camera.entity.Version() }];
+	lodState->lastExtraction = extractNum;
+
+	ExtractCamera(camera, width, height);
+	ExtractObjects(worlds);
+	ExtractLights(worlds, camera);
+
+	// drop the LOD states of the cameras not rendered for a while
+	for (auto iter = camera2lodState.begin(); iter != camera2lodState.end();) {
+		if (iter->second.lastExtraction + LODStateLifetime < extractNum)
+			iter = camera2lodState.erase(iter);
+		else
+			++iter;
+	}
+	lodState = nullptr;
+}
+
+void PipelineCore::ExtractCamera(const RenderCamera& camera, size_t width, size_t height) {
+	auto cmptCamera = camera.world.entityMngr.Get<Camera>(camera.entity);
+	auto cmptW2L = camera.world.entityMngr.Get<WorldToLocal>(camera.entity);
+	auto cmptTranslation = camera.world.entityMngr.Get<Translation>(camera.entity);
+	
+	cameraConstants.View = cmptW2L->value;
+	cameraConstants.InvView = cameraConstants.View.inverse();
+	cameraConstants.Proj = cmptCamera->prjectionMatrix;
+	cameraConstants.InvProj = cameraConstants.Proj.inverse();
+	cameraConstants.ViewProj = cameraConstants.Proj * cameraConstants.View;
+	cameraConstants.InvViewProj = cameraConstants.InvView * cameraConstants.InvProj;
+	cameraConstants.EyePosW = cmptTranslation->value.as<pointf3>();
+	cameraConstants.RenderTargetSize = { width, height };
+	cameraConstants.InvRenderTargetSize = { 1.0f / width, 1.0f / height };
+
+	cameraConstants.NearZ = cmptCamera->clippingPlaneMin;
+	cameraConstants.FarZ = cmptCamera->clippingPlaneMax;
+	cameraConstants.TotalTime = GameTimer::Instance().TotalTime();
+	cameraConstants.DeltaTime = GameTimer::Instance().DeltaTime();
+}
+
+void PipelineCore::ExtractObjects(const std::vector<const UECS::World*>& worlds) {
+	const Frustum frustum = Frustum::FromMatrix(cameraConstants.ViewProj);
+	const pointf3 eyePos = cameraConstants.EyePosW;
+	const float proj11 = cameraConstants.Proj[1][1];
+	std::atomic<size_t> culled{ 0 };
+
+	extractionID = nextExtractionID.fetch_add(1, std::memory_order_relaxed);
+	for (auto& buffer : extractionBuffers) {
+		buffer->renderQueue.Clear();
+		buffer->objects.clear();
+	}
+
+	ArchetypeFilter filter;
+	filter.all = {
+		CmptAccessType::Of<Latest<MeshFilter>>,
+		CmptAccessType::Of<Latest<MeshRenderer>>,
+		CmptAccessType::Of<Latest<LocalToWorld>>,
+	};
+	for (size_t worldIdx = 0; worldIdx < worlds.size(); worldIdx++) {
+		auto world = worlds[worldIdx];
+		// interpolate between the last two fixed steps
+		auto fixedTime = world->entityMngr.GetSingleton<FixedTime>();
+		world->RunChunkJob(
+			[&](ChunkView chunk) {
+				auto meshFilters = chunk.GetCmptArray<MeshFilter>();
+				auto meshRenderers = chunk.GetCmptArray<MeshRenderer>();
+				auto L2Ws = chunk.GetCmptArray<LocalToWorld>();
+				auto W2Ls = chunk.GetCmptArray<WorldToLocal>();
+				auto prevL2Ws = fixedTime ? chunk.GetCmptArray<PrevLocalToWorld>() : nullptr;
+				const LODGroup* lodGroups = chunk.GetCmptArray<LODGroup>();
+				const SkinnedMesh* skinnedMeshes = chunk.GetCmptArray<SkinnedMesh>();
+				auto entities = chunk.GetEntityArray();
+
+				// the deformed instance of a skinned mesh replaces the mesh of the MeshFilter
+				auto GetMesh = [&](size_t i) -> const Mesh* {
+					if (skinnedMeshes && skinnedMeshes[i].instance)
+						return skinnedMeshes[i].instance.get();
+					return meshFilters[i].mesh.get();
+				};
+
+				size_t N = chunk.EntityNum();
+
+				auto& buffer = GetExtractionBuffer();
+				buffer.bounds.Clear();
+				buffer.candidates.clear();
+				buffer.l2ws.resize(N);
+				buffer.objectIndices.resize(N);
+				buffer.lods.assign(N, 0);
+
+				// gather the submeshes to draw
+				for (size_t i = 0; i < N; i++) {
+					const Mesh* mesh = GetMesh(i);
+					const auto& meshRenderer = meshRenderers[i];
+
+					if (!mesh)
+						continue;
+
+					const auto& submeshes = mesh->GetSubMeshes();
+					size_t M = std::min(meshRenderer.materials.size(), submeshes.size());
+
+					if(M == 0)
+						continue;
+
+					buffer.l2ws[i] = prevL2Ws && prevL2Ws[i].seeded ?
+						FixedTimestep::Interpolate(prevL2Ws[i].value, L2Ws[i].value, fixedTime->alpha)
+						: L2Ws[i].value;
+
+					// the inverse is computed in the merge if the slot is dirty
+					ExtractionBuffer::ObjectRecord record;
+					record.world = worldIdx;
+					record.entity = entities[i];
+					record.l2w = buffer.l2ws[i];
+					record.hasW2L = W2Ls && !prevL2Ws;
+					if (record.hasW2L)
+						record.w2l = W2Ls[i].value;
+					record.lod = static_cast<size_t>(-1);
+					buffer.objectIndices[i] = buffer.objects.size();
+					buffer.objects.push_back(record);
+
+					for (size_t j = 0; j < M; j++) {
+						const auto& material = meshRenderer.materials[j];
+						if (!material || !material->shader)
+							continue;
+						if (material->shader->passes.empty())
+							continue;
+
+						buffer.bounds.Add(submeshes[j].bounds, buffer.l2ws[i]);
+						buffer.candidates.emplace_back(i, j);
+					}
+				}
+
+				// LOD of an entity by its largest submesh on the screen
+				if (lodGroups) {
+					buffer.screenSizes.assign(N, -1.f);
+					for (size_t k = 0; k < buffer.candidates.size(); k++) {
+						const size_t i = buffer.candidates[k].first;
+						const float radius = std::sqrt(
+							buffer.bounds.extentX[k] * buffer.bounds.extentX[k]
+							+ buffer.bounds.extentY[k] * buffer.bounds.extentY[k]
+							+ buffer.bounds.extentZ[k] * buffer.bounds.extentZ[k]
+						);
+						const pointf3 center{ buffer.bounds.centerX[k], buffer.bounds.centerY[k], buffer.bounds.centerZ[k] };
+						buffer.screenSizes[i] = std::max(buffer.screenSizes[i], ComputeLODScreenSize(center, radius, eyePos, proj11));
+					}
+					for (size_t i = 0; i < N; i++) {
+						if (buffer.screenSizes[i] < 0.f)
+							continue;
+						const auto& lodGroup = lodGroups[i];
+						const size_t lod = SelectLOD(
+							buffer.screenSizes[i],
+							lodState->Get(worldIdx, entities[i]),
+							lodGroup.screenSizes.data(),
+							lodGroup.screenSizes.size(),
+							lodGroup.hysteresis
+						);
+						buffer.objects[buffer.objectIndices[i]].lod = lod;
+						buffer.lods[i] = std::min(lod, GetMesh(i)->GetLODNum() - 1);
+					}
+				}
+
+				buffer.visible.resize(buffer.bounds.Size());
+				FrustumCull(frustum, buffer.bounds, buffer.visible.data());
+
+				// culled submeshes skip the queue, culled entities keep their slots
+				size_t chunkCulledNum = 0;
+				for (size_t k = 0; k < buffer.candidates.size(); k++) {
+					if (!buffer.visible[k]) {
+						chunkCulledNum++;
+						continue;
+					}
+
+					auto [i, j] = buffer.candidates[k];
+					const auto& l2w = buffer.l2ws[i];
+
+					const vecf3 toEye{
+						buffer.bounds.centerX[k] - eyePos[0],
+						buffer.bounds.centerY[k] - eyePos[1],
+						buffer.bounds.centerZ[k] - eyePos[2]
+					};
+
+					RenderObject obj;
+					obj.entity = entities[i];
+					obj.material = meshRenderers[i].materials[j].get();
+					obj.mesh = GetMesh(i);
+					obj.submeshIdx = j;
+					obj.lod = buffer.lods[i];
+					obj.objectIdx = buffer.objectIndices[i];
+					obj.translation = l2w.decompose_translation();
+					obj.depth = toEye.dot(toEye);
+
+					for (size_t p = 0; p < obj.material->shader->passes.size(); p++) {
+						obj.passIdx = p;
+						buffer.renderQueue.Add(obj);
+					}
+				}
+				culled += chunkCulledNum;
+			},
+			filter,
+			true
+		);
+	}
+
+	// merge, only the changed objects are marked dirty
+	for (const auto& buffer : extractionBuffers) {
+		buffer->slots.resize(buffer->objects.size());
+		for (size_t k = 0; k < buffer->objects.size(); k++) {
+			const auto& record = buffer->objects[k];
+			bool isNew;
+			size_t slot = objectSlots.Acquire(record.world, record.entity, isNew);
+			if (slot >= objects.size())
+				objects.resize(objectSlots.GetCapacity());
+
+			auto& data = objects[slot];
+			if (isNew || std::memcmp(&data.l2w, &record.l2w, sizeof(transformf)) != 0) {
+				data.l2w = record.l2w;
+				data.w2l = record.hasW2L ? record.w2l : record.l2w.inverse();
+				objectSlots.MarkDirty(slot);
+			}
+			buffer->slots[k] = slot;
+
+			if (record.lod != static_cast<size_t>(-1))
+				lodState->Set(record.world, record.entity, record.lod);
+		}
+		renderQueue.Append(buffer->renderQueue, buffer->slots.data());
+	}
+	objectSlots.ReleaseUnused();
+
+	culledNum = culled.load();
+	UBPA_UTOPIA_PROFILE_COUNTER("culled", culledNum);
+
+	{
+		UBPA_UTOPIA_PROFILE_SCOPE("PipelineCore::SortRenderQueue");
+		renderQueue.Sort();
+#ifdef UBPA_UTOPIA_USE_PROFILER
+		auto changes = renderQueue.CountStateChanges();
+		UBPA_UTOPIA_PROFILE_COUNTER("state changes", changes.shader + changes.material + changes.mesh);
+#endif // UBPA_UTOPIA_USE_PROFILER
+	}
+
+	{
+		UBPA_UTOPIA_PROFILE_SCOPE("PipelineCore::BuildInstanceBatches");
+		opaqueBatcher.Build(renderQueue.GetOpaques());
+		transparentBatcher.Build(renderQueue.GetTransparents());
+		UBPA_UTOPIA_PROFILE_COUNTER("draws (before batching)",
+			opaqueBatcher.GetStats().drawsBefore + transparentBatcher.GetStats().drawsBefore);
+		UBPA_UTOPIA_PROFILE_COUNTER("draws (after batching)",
+			opaqueBatcher.GetStats().drawsAfter + transparentBatcher.GetStats().drawsAfter);
+	}
+}
+
+void PipelineCore::ExtractLights(const std::vector<const UECS::World*>& worlds, const RenderCamera& camera) {
+	// the light array keeps the first LightArray::size lights in type order,
+	// point / spot / rect / disk lights are also clustered (no limit)
+	auto ToShaderLight = [](const Light& light, const transformf& l2w) {
+		ShaderLight shaderLight;
+		memset(&shaderLight, 0, sizeof(ShaderLight));
+		shaderLight.color = light.color * light.intensity;
+		shaderLight.range = light.range;
+		shaderLight.position = l2w * pointf3{ 0.f };
+		shaderLight.dir = (l2w * vecf3{ 0,0,1 }).normalize();
+		switch (light.type)
+		{
+		case LightType::Spot:
+			shaderLight.*ShaderLight::Spot::pCosHalfInnerSpotAngle = std::cos(to_radian(light.innerSpotAngle) / 2.f);
+			shaderLight.*ShaderLight::Spot::pCosHalfOuterSpotAngle = std::cos(to_radian(light.outerSpotAngle) / 2.f);
+			break;
+		case LightType::Rect:
+			shaderLight.horizontal = (l2w * vecf3{ 1,0,0 }).normalize();
+			shaderLight.*ShaderLight::Rect::pWidth = light.width;
+			shaderLight.*ShaderLight::Rect::pHeight = light.height;
+			break;
+		case LightType::Disk:
+			shaderLight.*ShaderLight::Disk::pRadius = light.radius;
+			break;
+		default:
+			break;
+		}
+		return shaderLight;
+	};
+
+	constexpr size_t LightTypeNum = 5;
+	std::array<std::vector<ShaderLight>, LightTypeNum> typeLights;
+	clusterLights.clear();
+	clusterShaderLights.clear();
+
+	for (auto world : worlds) {
+		world->RunEntityJob(
+			[&](const Light* light, const LocalToWorld* l2w) {
+				auto shaderLight = ToShaderLight(*light, l2w->value);
+				typeLights[static_cast<size_t>(light->type)].push_back(shaderLight);
+
+				if (light->type == LightType::Directional)
+					return;
+
+				ClusterLight clusterLight;
+				clusterLight.type = light->type;
+				clusterLight.position = shaderLight.position;
+				clusterLight.dir = shaderLight.dir;
+				clusterLight.range = light->range;
+				clusterLight.cosHalfOuterSpotAngle = std::cos(to_radian(light->outerSpotAngle) / 2.f);
+				clusterLights.push_back(clusterLight);
+
+				// f2: type
+				shaderLight.f2 = static_cast<float>(light->type);
+				clusterShaderLights.push_back(shaderLight);
+			},
+			false
+		);
+	}
+
+	size_t lightNum = 0;
+	std::array<uint32_t, LightTypeNum> typeLightNums;
+	for (size_t t = 0; t < LightTypeNum; t++) {
+		typeLightNums[t] = static_cast<uint32_t>(std::min(typeLights[t].size(), LightArray::size - lightNum));
+		for (size_t i = 0; i < typeLightNums[t]; i++)
+			lights.lights[lightNum + i] = typeLights[t][i];
+		lightNum += typeLightNums[t];
+	}
+	lights.diectionalLightNum = typeLightNums[static_cast<size_t>(LightType::Directional)];
+	lights.pointLightNum = typeLightNums[static_cast<size_t>(LightType::Point)];
+	lights.spotLightNum = typeLightNums[static_cast<size_t>(LightType::Spot)];
+	lights.rectLightNum = typeLightNums[static_cast<size_t>(LightType::Rect)];
+	lights.diskLightNum = typeLightNums[static_cast<size_t>(LightType::Disk)];
+
+	{ // clusters
+		UBPA_UTOPIA_PROFILE_SCOPE("PipelineCore::AssignLightClusters");
+
+		auto cmptCamera = camera.world.entityMngr.Get<Camera>(camera.entity);
+		LightClusterDesc desc;
+		desc.fovY = to_radian(cmptCamera->fov);
+		desc.aspect = cmptCamera->aspect;
+		desc.nearZ = cmptCamera->clippingPlaneMin;
+		desc.farZ = cmptCamera->clippingPlaneMax;
+		lightClusters.SetDesc(desc);
+		lightClusters.Assign(
+			cameraConstants.View,
+			clusterLights.data(),
+			clusterLights.size()
+		);
+
+		cameraConstants.ClusterDimX = static_cast<uint32_t>(desc.dimX);
+		cameraConstants.ClusterDimY = static_cast<uint32_t>(desc.dimY);
+		cameraConstants.ClusterDimZ = static_cast<uint32_t>(desc.dimZ);
+		cameraConstants.ClusterLogScale = lightClusters.GetLogScale();
+		cameraConstants.ClusterLogBias = lightClusters.GetLogBias();
+	}
+}
+
+size_t PipelineCore::LayoutCommonBuffer() {
+	const auto& opaques = renderQueue.GetOpaques();
+	const auto& transparents = renderQueue.GetTransparents();
+	const auto& clusterRanges = lightClusters.GetRanges();
+
+	instances.clear();
+	for (const auto& obj : opaques)
+		instances.push_back(static_cast<uint32_t>(obj.objectIdx));
+	for (const auto& obj : transparents)
+		instances.push_back(static_cast<uint32_t>(obj.objectIdx));
+
+	const auto& clusterIndices = lightClusters.GetLightIndices();
+
+	auto Align = [](size_t offset) { return (offset + 15) & ~static_cast<size_t>(15); };
+	clusterLightOffset = Align(instanceOffset
+		+ (opaques.size() + transparents.size()) * sizeof(uint32_t));
+	clusterRangeOffset = Align(clusterLightOffset
+		+ clusterShaderLights.size() * sizeof(ShaderLight));
+	clusterIndexOffset = Align(clusterRangeOffset
+		+ clusterRanges.size() * sizeof(LightClusterGrid::Range));
+
+	return clusterIndexOffset + std::max<size_t>(clusterIndices.size(), 1) * sizeof(uint32_t);
+}
@@ -4,62 +4,205 @@
 #include <Utopia/Render/Mesh.h>
 
 #include <algorithm>
+#include <array>
+#include <cstring>
 
 using namespace Ubpa::Utopia;
 
-void RenderQueue::Add(RenderObject object) {
-	if (object.material->shader->passes[object.passIdx].queue < (size_t)ShaderPass::Queue::Transparent)
+namespace {
+	constexpr uint64_t Bits(uint64_t value, size_t num) noexcept {
+		return value & ((uint64_t{ 1 } << num) - 1);
+	}
+
+	// depth >= 0, so the bits of the float are monotonic
+	uint32_t DepthBits(float depth) noexcept {
+		depth = std::max(depth, 0.f);
+		uint32_t bits;
+		std::memcpy(&bits, &depth, sizeof(float));
+		return bits;
+	}
+
+	// squared distance clamped to [2^-8, 2^24), 5 exponent bits and 5 mantissa bits (steps of about 3%)
+	uint64_t OpaqueDepthBits(float depth) noexcept {
+		constexpr float MinDepth = 1.f / 256.f;
+		constexpr float MaxDepth = 16777215.f;
+		return (DepthBits(std::clamp(depth, MinDepth, MaxDepth)) - DepthBits(MinDepth)) >> 18;
+	}
+
+	size_t QueueOf(const RenderObject& object) noexcept {
+		return object.material->shader->passes[object.passIdx].queue;
+	}
+
+	void AppendOrder(std::vector<uint32_t>& dst, const std::vector<uint32_t>& src, size_t offset) {
+		size_t begin = dst.size();
+		dst.insert(dst.end(), src.begin(), src.end());
+		for (size_t i = begin; i < dst.size(); i++)
+			dst[i] += static_cast<uint32_t>(offset);
+	}
+}
+
+uint64_t RenderQueue::OpaqueKey(const RenderObject& object) noexcept {
+	// opaque queues are below ShaderPass::Queue::Transparent (3000)
+	const uint64_t queue = std::min<uint64_t>(QueueOf(object), (1 << 12) - 1);
+	return (queue << 52)
+		| (Bits(object.material->shader->GetInstanceID(), 12) << 40)
+		| (Bits(object.material->GetInstanceID(), 12) << 28)
+		| (Bits(object.mesh->GetInstanceID(), 10) << 18)
+		| (Bits(object.passIdx, 2) << 16)
+		| (Bits(object.submeshIdx, 3) << 13)
+		| (Bits(object.lod, 3) << 10)
+		| OpaqueDepthBits(object.depth);
+}
+
+uint64_t RenderQueue::TransparentKey(const RenderObject& object) noexcept {
+	const uint64_t queue = std::min<uint64_t>(QueueOf(object), (1 << 13) - 1);
+	return (queue << 51)
+		| (Bits(~(DepthBits(object.depth) >> 8), 24) << 27)
+		| (Bits(object.material->shader->GetInstanceID(), 12) << 15)
+		| Bits(object.material->GetInstanceID(), 15);
+}
+
+void RenderQueue::Add(const RenderObject& object) {
+	if (QueueOf(object) < (size_t)ShaderPass::Queue::Transparent) {
+		opaqueOrder.push_back(static_cast<uint32_t>(opaques.size()));
 		opaques.push_back(object);
-	else
+		opaqueKeys.push_back(OpaqueKey(object));
+	}
+	else {
+		transparentOrder.push_back(static_cast<uint32_t>(transparents.size()));
 		transparents.push_back(object);
+		transparentKeys.push_back(TransparentKey(object));
+	}
+}
+
+void RenderQueue::Append(const RenderQueue& other, size_t objectIdxOffset) {
+	auto AppendObjects = [=](std::vector<RenderObject>& dst, const std::vector<RenderObject>& src) {
+		size_t begin = dst.size();
+		dst.insert(dst.end(), src.begin(), src.end());
+		for (size_t i = begin; i < dst.size(); i++)
+			dst[i].objectIdx += objectIdxOffset;
+	};
+	AppendOrder(opaqueOrder, other.opaqueOrder, opaques.size());
+	AppendOrder(transparentOrder, other.transparentOrder, transparents.size());
+	AppendObjects(opaques, other.opaques);
+	AppendObjects(transparents, other.transparents);
+	opaqueKeys.insert(opaqueKeys.end(), other.opaqueKeys.begin(), other.opaqueKeys.end());
+	transparentKeys.insert(transparentKeys.end(), other.transparentKeys.begin(), other.transparentKeys.end());
 }
 
-void RenderQueue::Sort(pointf3 cameraPos) {
-	auto opaqueLess = [=](const RenderObject& lhs, const RenderObject& rhs) {
-		auto lqueue = lhs.material->shader->passes[lhs.passIdx].queue;
-		auto rqueue = rhs.material->shader->passes[rhs.passIdx].queue;
-		if (lqueue < rqueue)
-			return true;
-		if (lqueue > rqueue)
-			return false;
-
-		auto lID = lhs.material->shader->GetInstanceID();
-		auto rID = lhs.material->shader->GetInstanceID();
-		if (lID < rID)
-			return true;
-		if (lID > rID)
-			return false;
-
-		if (lhs.material < rhs.material)
-			return true;
-		if (lhs.material > rhs.material)
-			return false;
-
-		auto lpos = lhs.mesh->GetSubMeshes().at(lhs.submeshIdx).bounds.center() + lhs.translation;
-		auto rpos = rhs.mesh->GetSubMeshes().at(rhs.submeshIdx).bounds.center() + rhs.translation;
-
-		return pointf3::distance(lpos, cameraPos) > pointf3::distance(rpos, cameraPos);
+void RenderQueue::Append(const RenderQueue& other, const size_t* objectIdxMap) {
+	auto AppendObjects = [=](std::vector<RenderObject>& dst, const std::vector<RenderObject>& src) {
+		size_t begin = dst.size();
+		dst.insert(dst.end(), src.begin(), src.end());
+		for (size_t i = begin; i < dst.size(); i++)
+			dst[i].objectIdx = objectIdxMap[dst[i].objectIdx];
 	};
+	AppendOrder(opaqueOrder, other.opaqueOrder, opaques.size());
+	AppendOrder(transparentOrder, other.transparentOrder, transparents.size());
+	AppendObjects(opaques, other.opaques);
+	AppendObjects(transparents, other.transparents);
+	opaqueKeys.insert(opaqueKeys.end(), other.opaqueKeys.begin(), other.opaqueKeys.end());
+	transparentKeys.insert(transparentKeys.end(), other.transparentKeys.begin(), other.transparentKeys.end());
+}
+
+void RenderQueue::Sort() {
+	Sort(opaqueKeys, opaqueOrder);
+	Sort(transparentKeys, transparentOrder);
+}
 
-	auto transparentLess = [=](const RenderObject& lhs, const RenderObject& rhs) {
-		auto lqueue = lhs.material->shader->passes[lhs.passIdx].queue;
-		auto rqueue = rhs.material->shader->passes[rhs.passIdx].queue;
-		if (lqueue < rqueue)
-			return true;
-		if (lqueue > rqueue)
-			return false;
+void RenderQueue::Sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& order) {
+	const size_t n = keys.size();
+	if (n < 2)
+		return;
 
-		auto lpos = lhs.mesh->GetSubMeshes().at(lhs.submeshIdx).bounds.center() + lhs.translation;
-		auto rpos = rhs.mesh->GetSubMeshes().at(rhs.submeshIdx).bounds.center() + rhs.translation;
+	keysBuffer.resize(n);
+	orderBuffer.resize(n);
 
-		return pointf3::distance(lpos, cameraPos) > pointf3::distance(rpos, cameraPos);
-	};
+	// 11-bit digits, 6 passes at most
+	constexpr size_t DigitBits = 11;
+	constexpr size_t DigitNum = (64 + DigitBits - 1) / DigitBits;
+	constexpr uint64_t DigitMask = (1 << DigitBits) - 1;
+
+	// digits without a varying bit are skipped
+	uint64_t varying = 0;
+	for (uint64_t key : keys)
+		varying |= key ^ keys[0];
+	std::array<size_t, DigitNum> shifts;
+	size_t passNum = 0;
+	for (size_t d = 0; d < DigitNum; d++) {
+		if ((varying >> (DigitBits * d)) & DigitMask)
+			shifts[passNum++] = DigitBits * d;
+	}
+
+	// histograms of all passes in one sweep
+	std::array<std::array<uint32_t, 1 << DigitBits>, DigitNum> histograms{};
+	for (uint64_t key : keys) {
+		for (size_t p = 0; p < passNum; p++)
+			histograms[p][(key >> shifts[p]) & DigitMask]++;
+	}
+
+	uint64_t* srcKeys = keys.data();
+	uint64_t* dstKeys = keysBuffer.data();
+	uint32_t* srcOrder = order.data();
+	uint32_t* dstOrder = orderBuffer.data();
+	for (size_t p = 0; p < passNum; p++) {
+		auto& histogram = histograms[p];
+		const size_t shift = shifts[p];
 
-	std::sort(opaques.begin(), opaques.end(), opaqueLess);
-	std::sort(transparents.begin(), transparents.end(), transparentLess);
+		uint32_t offset = 0;
+		for (auto& count : histogram) {
+			uint32_t c = count;
+			count = offset;
+			offset += c;
+		}
+
+		for (size_t i = 0; i < n; i++) {
+			uint32_t dst = histogram[(srcKeys[i] >> shift) & DigitMask]++;
+			dstKeys[dst] = srcKeys[i];
+			dstOrder[dst] = srcOrder[i];
+		}
+
+		std::swap(srcKeys, dstKeys);
+		std::swap(srcOrder, dstOrder);
+	}
+
+	if (srcKeys != keys.data()) {
+		keys.swap(keysBuffer);
+		order.swap(orderBuffer);
+	}
 }
 
 void RenderQueue::Clear() {
 	opaques.clear();
 	transparents.clear();
+	opaqueKeys.clear();
+	transparentKeys.clear();
+	opaqueOrder.clear();
+	transparentOrder.clear();
+}
+
+RenderQueue::StateChanges RenderQueue::CountStateChanges() const noexcept {
+	StateChanges changes;
+	const Shader* shader = nullptr;
+	const Material* material = nullptr;
+	const Mesh* mesh = nullptr;
+	auto Count = [&](const RenderObjectList& objects) {
+		for (const auto& object : objects) {
+			if (object.material->shader.get() != shader) {
+				shader = object.material->shader.get();
+				changes.shader++;
+			}
+			if (object.material != material) {
+				material = object.material;
+				changes.material++;
+			}
+			if (object.mesh != mesh) {
+				mesh = object.mesh;
+				changes.mesh++;
+			}
+		}
+	};
+	Count(GetOpaques());
+	Count(GetTransparents());
+	return changes;
 }
@@ -0,0 +1,109 @@
+#include <Utopia/Render/ShaderCBLayout.h>
+
+#include <Utopia/Render/Material.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+using namespace Ubpa::Utopia;
+
+namespace {
+	size_t CalcConstantBufferByteSize(size_t byteSize) noexcept {
+		return (byteSize + 255) & ~static_cast<size_t>(255);
+	}
+
+	std::atomic<size_t> nextLayoutID{ 0 };
+
+	// func(entry, data) for every property written into the layout, data has entry.size bytes
+	// bool is written as uint, textures are skipped, properties of mismatched size are skipped
+	template<typename Func>
+	void ForEachPacked(
+		const std::vector<ShaderCBLayout::Entry>& entries,
+		const std::map<std::string, ShaderProperty, std::less<>>& properties,
+		Func&& func)
+	{
+		auto propertyIter = properties.begin();
+		for (const auto& entry : entries) {
+			while (propertyIter != properties.end() && propertyIter->first < entry.name)
+				++propertyIter;
+			if (propertyIter == properties.end())
+				break;
+			if (propertyIter->first != entry.name)
+				continue;
+
+			std::visit([&](const auto& value) {
+				using Value = std::decay_t<decltype(value)>;
+				if constexpr (std::is_same_v<Value, bool>) {
+					auto v = static_cast<unsigned int>(value);
+					if (entry.size == sizeof(unsigned int))
+						func(entry, &v);
+				}
+				else if constexpr (std::is_same_v<Value, std::shared_ptr<const Texture2D>>
+					|| std::is_same_v<Value, std::shared_ptr<const TextureCube>>)
+					return;
+				else {
+					if (entry.size == sizeof(Value))
+						func(entry, &value);
+				}
+			}, propertyIter->second);
+		}
+	}
+}
+
+ShaderCBLayout::ShaderCBLayout(const ShaderCBReflection& refl, const std::set<std::string_view>& commonCBs)
+	: id{ nextLayoutID++ }
+{
+	for (const auto& cb : refl.constantBuffers) {
+		if (commonCBs.find(cb.name) != commonCBs.end())
+			continue;
+
+		auto target = offsetMap.find(cb.bindPoint);
+		if (target != offsetMap.end())
+			continue;
+
+		offsetMap.emplace_hint(target, cb.bindPoint, size);
+		for (const auto& var : cb.variables)
+			entries.push_back({ var.name, size + var.offset, var.size });
+		size += CalcConstantBufferByteSize(cb.size);
+	}
+
+	std::stable_sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+		return lhs.name < rhs.name;
+	});
+}
+
+void ShaderCBLayout::Pack(const std::map<std::string, ShaderProperty, std::less<>>& properties, uint8_t* dst) const {
+	std::memset(dst, 0, size);
+	ForEachPacked(entries, properties, [dst](const Entry& entry, const void* data) {
+		std::memcpy(dst + entry.offset, data, entry.size);
+	});
+}
+
+uint64_t ShaderCBLayout::Hash(const std::map<std::string, ShaderProperty, std::less<>>& properties) const noexcept {
+	uint64_t hash = 14695981039346656037ull;
+	auto Combine = [&](const void* data, size_t size) {
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	};
+	ForEachPacked(entries, properties, [&](const Entry& entry, const void* data) {
+		Combine(&entry.offset, sizeof(size_t));
+		Combine(data, entry.size);
+	});
+	return hash;
+}
+
+const std::vector<uint8_t>& ShaderCBLayout::GetPacked(const Material& material) const {
+	auto& packed = material.packedCB;
+	const uint64_t hash = Hash(material.properties);
+	if (packed.layoutID != id || packed.hash != hash) {
+		packed.data.resize(size);
+		Pack(material.properties, packed.data.data());
+		packed.layoutID = id;
+		packed.hash = hash;
+	}
+	return packed.data;
+}
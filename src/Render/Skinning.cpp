@@ -0,0 +1,190 @@
+#include <Utopia/Render/Skinning.h>
+
+#include <Utopia/Render/Mesh.h>
+#include <Utopia/Core/ParallelFor.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+// UBPA_UTOPIA_SKINNING_AVX2 : SkinningAVX2.cpp is compiled with AVX2 (Utopia_USE_AVX2)
+#ifdef UBPA_UTOPIA_SKINNING_AVX2
+#include "SkinningAVX2.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+namespace {
+	// vertices per item of the parallel loop
+	constexpr size_t BlockSize = 1024;
+	// less blocks run in the calling thread
+	constexpr size_t MinChunkBlocks = 4;
+
+	static_assert(sizeof(pointf3) == 3 * sizeof(float) && sizeof(normalf) == 3 * sizeof(float) && sizeof(vecf3) == 3 * sizeof(float));
+	static_assert(sizeof(valu4) == 4 * sizeof(uint32_t) && sizeof(valf4) == 4 * sizeof(float));
+	static_assert(sizeof(SkinMatrix) == 12 * sizeof(float));
+
+	// sum of the weighted matrices of the bones, in the order of the bones
+	void BlendMatrix(float* m, const valu4& indices, const valf4& weights, const SkinMatrix* skin) noexcept {
+		const float* m0 = &skin[indices[0]].m[0][0];
+		for (size_t c = 0; c < 12; c++)
+			m[c] = weights[0] * m0[c];
+		for (size_t k = 1; k < 4; k++) {
+			const float* mk = &skin[indices[k]].m[0][0];
+			for (size_t c = 0; c < 12; c++)
+				m[c] = m[c] + weights[k] * mk[c];
+		}
+	}
+
+	// m * (v, 0), normalized, zero stays zero
+	void TransformDirection(float* dst, const float* m, const float* v) noexcept {
+		float d[3];
+		for (size_t r = 0; r < 3; r++)
+			d[r] = m[4 * r + 0] * v[0] + m[4 * r + 1] * v[1] + m[4 * r + 2] * v[2];
+		const float norm2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+		if (!(norm2 > 0.f)) {
+			dst[0] = dst[1] = dst[2] = 0.f;
+			return;
+		}
+		const float norm = std::sqrt(std::max(norm2, 1e-30f));
+		for (size_t r = 0; r < 3; r++)
+			dst[r] = d[r] / norm;
+	}
+
+#ifdef UBPA_UTOPIA_SKINNING_AVX2
+	// AVX2, and the OS saves the YMM registers
+	bool SupportAVX2() noexcept {
+		static const bool support = [] {
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+				return false;
+			__cpuid(info, 1);
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx = (info[2] & (1 << 28)) != 0;
+			if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+				return false;
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") != 0;
+#endif
+		}();
+		return support;
+	}
+#endif // UBPA_UTOPIA_SKINNING_AVX2
+}
+
+void Ubpa::Utopia::ComputeSkinMatrices(
+	SkinMatrix* skin,
+	const transformf* boneLocalToWorld,
+	const transformf* inverseBindMatrices,
+	size_t boneNum,
+	const transformf& worldToLocal
+) {
+	for (size_t i = 0; i < boneNum; i++) {
+		const transformf m = worldToLocal * boneLocalToWorld[i] * inverseBindMatrices[i];
+		// column-major
+		for (size_t r = 0; r < 3; r++) {
+			for (size_t c = 0; c < 4; c++)
+				skin[i].m[r][c] = m[c][r];
+		}
+	}
+}
+
+void Ubpa::Utopia::SkinVertices(
+	pointf3* dstPositions,
+	normalf* dstNormals,
+	vecf3* dstTangents,
+	const pointf3* positions,
+	const normalf* normals,
+	const vecf3* tangents,
+	const valu4* boneIndices,
+	const valf4* boneWeights,
+	const SkinMatrix* skin,
+	size_t first,
+	size_t count
+) {
+	const bool hasNormals = dstNormals && normals;
+	const bool hasTangents = dstTangents && tangents;
+	const size_t end = first + count;
+	size_t v = first;
+#ifdef UBPA_UTOPIA_SKINNING_AVX2
+	if (SupportAVX2())
+		v += details::SkinVertices_AVX2(
+			dstPositions, hasNormals ? dstNormals : nullptr, hasTangents ? dstTangents : nullptr,
+			positions, normals, tangents,
+			boneIndices, boneWeights, skin,
+			first, count
+		);
+#endif // UBPA_UTOPIA_SKINNING_AVX2
+	for (; v < end; v++) {
+		float m[12];
+		BlendMatrix(m, boneIndices[v], boneWeights[v], skin);
+
+		const pointf3 p = positions[v];
+		for (size_t r = 0; r < 3; r++)
+			dstPositions[v][r] = m[4 * r + 0] * p[0] + m[4 * r + 1] * p[1] + m[4 * r + 2] * p[2] + m[4 * r + 3];
+		if (hasNormals) {
+			const normalf n = normals[v];
+			TransformDirection(&dstNormals[v][0], m, &n[0]);
+		}
+		if (hasTangents) {
+			const vecf3 t = tangents[v];
+			TransformDirection(&dstTangents[v][0], m, &t[0]);
+		}
+	}
+}
+
+bool Ubpa::Utopia::IsSkinningAVX2() noexcept {
+#ifdef UBPA_UTOPIA_SKINNING_AVX2
+	return SupportAVX2();
+#else
+	return false;
+#endif // UBPA_UTOPIA_SKINNING_AVX2
+}
+
+void Ubpa::Utopia::SkinMeshes(const SkinningTask* tasks, size_t num) {
+	// (task, first vertex) of every block
+	std::vector<std::pair<size_t, size_t>> blocks;
+	for (size_t i = 0; i < num; i++) {
+		const Mesh& mesh = *tasks[i].mesh;
+		assert(mesh.IsSkinned() && mesh.GetBoneWeights().size() == mesh.GetPositions().size());
+		assert(std::all_of(mesh.GetBoneIndices().begin(), mesh.GetBoneIndices().end(), [&](const valu4& indices) {
+			return indices[0] < tasks[i].boneNum && indices[1] < tasks[i].boneNum
+				&& indices[2] < tasks[i].boneNum && indices[3] < tasks[i].boneNum;
+		}));
+		for (size_t first = 0; first < mesh.GetPositions().size(); first += BlockSize)
+			blocks.emplace_back(i, first);
+	}
+
+	ParallelFor(blocks.size(), MinChunkBlocks, [&](size_t begin, size_t end) {
+		for (size_t b = begin; b < end; b++) {
+			const auto& task = tasks[blocks[b].first];
+			const Mesh& mesh = *task.mesh;
+			const size_t first = blocks[b].second;
+			const bool hasNormals = task.normals && !mesh.GetNormals().empty();
+			const bool hasTangents = task.tangents && !mesh.GetTangents().empty();
+			SkinVertices(
+				task.positions,
+				hasNormals ? task.normals : nullptr,
+				hasTangents ? task.tangents : nullptr,
+				mesh.GetPositions().data(),
+				hasNormals ? mesh.GetNormals().data() : nullptr,
+				hasTangents ? mesh.GetTangents().data() : nullptr,
+				mesh.GetBoneIndices().data(),
+				mesh.GetBoneWeights().data(),
+				task.skin,
+				first,
+				std::min(BlockSize, mesh.GetPositions().size() - first)
+			);
+		}
+	});
+}
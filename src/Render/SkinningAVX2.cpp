@@ -0,0 +1,120 @@
+// compiled with AVX2 if Utopia_USE_AVX2, see src/Render/CMakeLists.txt
+#ifdef __AVX2__
+
+#include "SkinningAVX2.h"
+
+#include <immintrin.h>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+namespace {
+	// 8 float3 at stride 3, structure of arrays
+	void Gather3(__m256* v, const float* src, __m256i offsets) noexcept {
+		for (size_t c = 0; c < 3; c++)
+			v[c] = _mm256_i32gather_ps(src + c, offsets, 4);
+	}
+
+	void Scatter3(float* dst, const __m256* v) noexcept {
+		alignas(32) float lanes[3][8];
+		for (size_t c = 0; c < 3; c++)
+			_mm256_store_ps(lanes[c], v[c]);
+		for (size_t i = 0; i < 8; i++) {
+			for (size_t c = 0; c < 3; c++)
+				dst[3 * i + c] = lanes[c][i];
+		}
+	}
+
+	void TransformDirection8(__m256* dst, const __m256* m, const __m256* v) noexcept {
+		__m256 d[3];
+		for (size_t r = 0; r < 3; r++) {
+			d[r] = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(m[4 * r + 0], v[0]), _mm256_mul_ps(m[4 * r + 1], v[1])),
+				_mm256_mul_ps(m[4 * r + 2], v[2])
+			);
+		}
+		const __m256 norm2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(d[0], d[0]), _mm256_mul_ps(d[1], d[1])), _mm256_mul_ps(d[2], d[2]));
+		const __m256 nonzero = _mm256_cmp_ps(norm2, _mm256_setzero_ps(), _CMP_GT_OQ);
+		// max keeps 0 / 0 out of the masked lanes
+		const __m256 norm = _mm256_sqrt_ps(_mm256_max_ps(norm2, _mm256_set1_ps(1e-30f)));
+		for (size_t r = 0; r < 3; r++)
+			dst[r] = _mm256_and_ps(_mm256_div_ps(d[r], norm), nonzero);
+	}
+}
+
+size_t Ubpa::Utopia::details::SkinVertices_AVX2(
+	pointf3* dstPositions,
+	normalf* dstNormals,
+	vecf3* dstTangents,
+	const pointf3* positions,
+	const normalf* normals,
+	const vecf3* tangents,
+	const valu4* boneIndices,
+	const valf4* boneWeights,
+	const SkinMatrix* skin,
+	size_t first,
+	size_t count
+) {
+	const bool hasNormals = dstNormals && normals;
+	const bool hasTangents = dstTangents && tangents;
+	const size_t end = first + count;
+	size_t v = first;
+	const __m256i stride3 = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	const __m256i stride16 = _mm256_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112);
+	for (; v + 8 <= end; v += 8) {
+		// blended matrices of the 8 vertices, a vertex at a time (the rows of a bone are contiguous)
+		// padded to 16 floats, aligned stores
+		alignas(32) float blended[8][16];
+		for (size_t i = 0; i < 8; i++) {
+			const valu4& indices = boneIndices[v + i];
+			const valf4& weights = boneWeights[v + i];
+			const float* m0 = &skin[indices[0]].m[0][0];
+			__m256 rows01 = _mm256_mul_ps(_mm256_set1_ps(weights[0]), _mm256_loadu_ps(m0));
+			__m128 row2 = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(m0 + 8));
+			for (size_t k = 1; k < 4; k++) {
+				const float* mk = &skin[indices[k]].m[0][0];
+				rows01 = _mm256_add_ps(rows01, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(mk)));
+				row2 = _mm_add_ps(row2, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(mk + 8)));
+			}
+			_mm256_store_ps(blended[i], rows01);
+			_mm_store_ps(blended[i] + 8, row2);
+		}
+		// structure of arrays, 12 elements of 8 vertices
+		__m256 m[12];
+		for (size_t c = 0; c < 12; c++)
+			m[c] = _mm256_i32gather_ps(&blended[0][c], stride16, 4);
+
+		// load everything before storing, dst can be src
+		__m256 p[3];
+		Gather3(p, &positions[v][0], stride3);
+		__m256 n[3];
+		__m256 t[3];
+		if (hasNormals)
+			Gather3(n, &normals[v][0], stride3);
+		if (hasTangents)
+			Gather3(t, &tangents[v][0], stride3);
+
+		__m256 dst[3];
+		for (size_t r = 0; r < 3; r++) {
+			dst[r] = _mm256_add_ps(
+				_mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(m[4 * r + 0], p[0]), _mm256_mul_ps(m[4 * r + 1], p[1])),
+					_mm256_mul_ps(m[4 * r + 2], p[2])
+				),
+				m[4 * r + 3]
+			);
+		}
+		Scatter3(&dstPositions[v][0], dst);
+		if (hasNormals) {
+			TransformDirection8(dst, m, n);
+			Scatter3(&dstNormals[v][0], dst);
+		}
+		if (hasTangents) {
+			TransformDirection8(dst, m, t);
+			Scatter3(&dstTangents[v][0], dst);
+		}
+	}
+	return v - first;
+}
+
+#endif // __AVX2__
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Utopia/Render/Skinning.h>
+
+namespace Ubpa::Utopia::details {
+	// the AVX2 kernel of SkinVertices, in a translation unit compiled with AVX2 (Utopia_USE_AVX2)
+	// only call it if the CPU supports AVX2
+	// skins 8 vertices at a time, the tail (< 8 vertices) is left to the scalar path
+	// return the number of skinned vertices
+	size_t SkinVertices_AVX2(
+		pointf3* dstPositions,
+		normalf* dstNormals,
+		vecf3* dstTangents,
+		const pointf3* positions,
+		const normalf* normals,
+		const vecf3* tangents,
+		const valu4* boneIndices,
+		const valf4* boneWeights,
+		const SkinMatrix* skin,
+		size_t first,
+		size_t count
+	);
+}
@@ -0,0 +1,73 @@
+#include <Utopia/Render/StdFrameGraph.h>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+StdFrameGraph StdFrameGraph::Register(UFG::FrameGraph& fg, FrameGraphTopology& topology, size_t width, size_t height) {
+	fg.Clear();
+	topology.Clear();
+	topology.AddParam(width);
+	topology.AddParam(height);
+
+	auto RegisterResourceNode = [&](std::string name) {
+		topology.AddResourceNode(name);
+		return fg.RegisterResourceNode(std::move(name));
+	};
+	auto RegisterMoveNode = [&](size_t dst, size_t src) {
+		topology.AddMoveNode(dst, src);
+		return fg.RegisterMoveNode(dst, src);
+	};
+	auto RegisterPassNode = [&](std::string name, std::vector<size_t> inputs, std::vector<size_t> outputs) {
+		topology.AddPassNode(name, inputs, outputs);
+		return fg.RegisterPassNode(std::move(name), std::move(inputs), std::move(outputs));
+	};
+
+	StdFrameGraph nodes;
+
+	nodes.gbuffer0 = RegisterResourceNode("GBuffer0");
+	nodes.gbuffer1 = RegisterResourceNode("GBuffer1");
+	nodes.gbuffer2 = RegisterResourceNode("GBuffer2");
+	nodes.deferLightedRT = RegisterResourceNode("Defer Lighted");
+	nodes.deferLightedSkyRT = RegisterResourceNode("Defer Lighted with Sky");
+	nodes.sceneRT = RegisterResourceNode("Scene");
+	nodes.presentedRT = RegisterResourceNode("Present");
+	RegisterMoveNode(nodes.deferLightedSkyRT, nodes.deferLightedRT);
+	RegisterMoveNode(nodes.sceneRT, nodes.deferLightedSkyRT);
+	nodes.deferDS = RegisterResourceNode("Defer Depth Stencil");
+	nodes.forwardDS = RegisterResourceNode("Forward Depth Stencil");
+	RegisterMoveNode(nodes.forwardDS, nodes.deferDS);
+	nodes.irradianceMap = RegisterResourceNode("Irradiance Map");
+	nodes.prefilterMap = RegisterResourceNode("PreFilter Map");
+	nodes.gbPass = RegisterPassNode(
+		"GBuffer Pass",
+		{},
+		{ nodes.gbuffer0, nodes.gbuffer1, nodes.gbuffer2, nodes.deferDS }
+	);
+	nodes.iblPass = RegisterPassNode(
+		"IBL",
+		{},
+		{ nodes.irradianceMap, nodes.prefilterMap }
+	);
+	nodes.deferLightingPass = RegisterPassNode(
+		"Defer Lighting",
+		{ nodes.gbuffer0, nodes.gbuffer1, nodes.gbuffer2, nodes.deferDS, nodes.irradianceMap, nodes.prefilterMap },
+		{ nodes.deferLightedRT }
+	);
+	nodes.skyboxPass = RegisterPassNode(
+		"Skybox",
+		{ nodes.deferDS },
+		{ nodes.deferLightedSkyRT }
+	);
+	nodes.forwardPass = RegisterPassNode(
+		"Forward",
+		{ nodes.irradianceMap, nodes.prefilterMap },
+		{ nodes.forwardDS, nodes.sceneRT }
+	);
+	nodes.postprocessPass = RegisterPassNode(
+		"Post Process",
+		{ nodes.sceneRT },
+		{ nodes.presentedRT }
+	);
+
+	return nodes;
+}
@@ -0,0 +1,112 @@
+#include <Utopia/Render/Systems/SkinningSystem.h>
+
+#include <Utopia/Render/Components/MeshFilter.h>
+#include <Utopia/Render/Components/Skeleton.h>
+#include <Utopia/Render/Components/SkinnedMesh.h>
+#include <Utopia/Render/Skinning.h>
+
+#include <Utopia/Core/Components/LocalToWorld.h>
+#include <Utopia/Core/ParallelFor.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa::UECS;
+using namespace Ubpa;
+
+namespace {
+	// editable copy of the bind pose, deformed in place every frame
+	std::shared_ptr<Mesh> CreateInstance(const Mesh& mesh) {
+		auto instance = std::make_shared<Mesh>();
+		instance->SetPositions(mesh.GetPositions());
+		instance->SetUV(mesh.GetUV());
+		instance->SetNormals(mesh.GetNormals());
+		instance->SetTangents(mesh.GetTangents());
+		instance->SetColors(mesh.GetColors());
+		instance->SetIndices(mesh.GetIndices());
+		instance->SetSubMeshCount(mesh.GetSubMeshes().size());
+		for (size_t i = 0; i < mesh.GetSubMeshes().size(); i++)
+			instance->SetSubMesh(i, mesh.GetSubMeshes()[i]);
+		std::vector<std::vector<SubMeshDescriptor>> lods;
+		for (size_t lod = 1; lod < mesh.GetLODNum(); lod++)
+			lods.push_back(mesh.GetLODSubMeshes(lod));
+		instance->SetLODs(std::move(lods));
+		// the meshlet bounds would go stale
+		instance->SetVertexLayout(mesh.GetVertexLayout());
+		instance->SetVertexCompression(mesh.GetVertexCompression());
+		return instance;
+	}
+}
+
+void SkinningSystem::OnUpdate(Schedule& schedule) {
+	// the bones are read by random access, after every job (the transform systems) of the frame
+	schedule.RegisterCommand([](World* w) {
+		std::vector<transformf> boneLocalToWorld;
+		std::vector<SkinMatrix> skins;
+		std::vector<size_t> skinOffsets;
+		std::vector<SkinningTask> tasks;
+		std::vector<Mesh*> instances;
+
+		// only the rendered entities
+		ArchetypeFilter filter;
+		filter.all = { CmptAccessType::Of<Latest<MeshFilter>> };
+		w->RunEntityJob(
+			[&](const LocalToWorld* l2w, const Skeleton* skeleton, SkinnedMesh* skinnedMesh) {
+				if (!skinnedMesh->mesh || !skinnedMesh->mesh->IsSkinned())
+					return;
+
+				const Mesh& mesh = *skinnedMesh->mesh;
+				const size_t boneNum = std::min(skeleton->bones.size(), skeleton->inverseBindMatrices.size());
+				boneLocalToWorld.resize(boneNum);
+				for (size_t i = 0; i < boneNum; i++) {
+					const Entity bone = skeleton->bones[i];
+					if (w->entityMngr.Exist(bone) && w->entityMngr.Have(bone, CmptType::Of<LocalToWorld>))
+						boneLocalToWorld[i] = w->entityMngr.Get<LocalToWorld>(bone)->value;
+					else // keeps the bind pose
+						boneLocalToWorld[i] = l2w->value * skeleton->inverseBindMatrices[i].inverse();
+				}
+				skinOffsets.push_back(skins.size());
+				skins.resize(skins.size() + boneNum);
+				ComputeSkinMatrices(
+					skins.data() + skinOffsets.back(),
+					boneLocalToWorld.data(),
+					skeleton->inverseBindMatrices.data(),
+					boneNum,
+					l2w->value.inverse()
+				);
+
+				if (!skinnedMesh->instance || skinnedMesh->instance->GetPositions().size() != mesh.GetPositions().size())
+					skinnedMesh->instance = CreateInstance(mesh);
+
+				Mesh& instance = *skinnedMesh->instance;
+				const size_t vertexNum = instance.GetPositions().size();
+				tasks.push_back({
+					&mesh,
+					nullptr, // skins may still grow
+					boneNum,
+					instance.EditPositions(0, vertexNum).data,
+					instance.GetNormals().empty() ? nullptr : instance.EditNormals(0, vertexNum).data,
+					instance.GetTangents().empty() ? nullptr : instance.EditTangents(0, vertexNum).data,
+				});
+				instances.push_back(&instance);
+			},
+			false,
+			filter
+		);
+
+		for (size_t i = 0; i < tasks.size(); i++)
+			tasks[i].skin = skins.data() + skinOffsets[i];
+		SkinMeshes(tasks.data(), tasks.size());
+
+		// bounds of the deformed submeshes, for the culling
+		ParallelFor(instances.size(), 4, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				Mesh& instance = *instances[i];
+				for (size_t j = 0; j < instance.GetSubMeshes().size(); j++)
+					instance.SetSubMesh(j, instance.GetSubMeshes()[j]);
+			}
+		});
+	});
+}
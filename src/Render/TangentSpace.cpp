@@ -0,0 +1,287 @@
+#include <Utopia/Render/TangentSpace.h>
+
+#include <Utopia/Core/ParallelFor.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define UBPA_UTOPIA_TANGENT_SPACE_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+namespace {
+	// less items run in the calling thread
+	constexpr size_t MinChunkSize = 8192;
+
+	// unnormalized face normals (p1 - p0) x (p2 - p0) of the triangles [begin, end)
+	// the SSE path evaluates the same expressions in the same order
+	void ComputeFaceNormals(
+		float* nx, float* ny, float* nz,
+		const uint32_t* indices, const pointf3* positions,
+		size_t begin, size_t end
+	) {
+		size_t t = begin;
+#ifdef UBPA_UTOPIA_TANGENT_SPACE_SSE
+		for (; t + 4 <= end; t += 4) {
+			const pointf3* p0[4];
+			const pointf3* p1[4];
+			const pointf3* p2[4];
+			for (size_t k = 0; k < 4; k++) {
+				p0[k] = &positions[indices[3 * (t + k) + 0]];
+				p1[k] = &positions[indices[3 * (t + k) + 1]];
+				p2[k] = &positions[indices[3 * (t + k) + 2]];
+			}
+			__m128 e1[3];
+			__m128 e2[3];
+			for (size_t c = 0; c < 3; c++) {
+				const __m128 c0 = _mm_setr_ps((*p0[0])[c], (*p0[1])[c], (*p0[2])[c], (*p0[3])[c]);
+				e1[c] = _mm_sub_ps(_mm_setr_ps((*p1[0])[c], (*p1[1])[c], (*p1[2])[c], (*p1[3])[c]), c0);
+				e2[c] = _mm_sub_ps(_mm_setr_ps((*p2[0])[c], (*p2[1])[c], (*p2[2])[c], (*p2[3])[c]), c0);
+			}
+			_mm_storeu_ps(nx + t, _mm_sub_ps(_mm_mul_ps(e1[1], e2[2]), _mm_mul_ps(e1[2], e2[1])));
+			_mm_storeu_ps(ny + t, _mm_sub_ps(_mm_mul_ps(e1[2], e2[0]), _mm_mul_ps(e1[0], e2[2])));
+			_mm_storeu_ps(nz + t, _mm_sub_ps(_mm_mul_ps(e1[0], e2[1]), _mm_mul_ps(e1[1], e2[0])));
+		}
+#endif // UBPA_UTOPIA_TANGENT_SPACE_SSE
+		for (; t < end; t++) {
+			const auto& p0 = positions[indices[3 * t + 0]];
+			const auto& p1 = positions[indices[3 * t + 1]];
+			const auto& p2 = positions[indices[3 * t + 2]];
+			const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			nx[t] = e1[1] * e2[2] - e1[2] * e2[1];
+			ny[t] = e1[2] * e2[0] - e1[0] * e2[2];
+			nz[t] = e1[0] * e2[1] - e1[1] * e2[0];
+		}
+	}
+
+	// normalize the vectors [0, num) in place, zero vectors stay zero
+	// the SSE path evaluates the same expressions in the same order
+	void NormalizeVectors(float* x, float* y, float* z, size_t num) {
+		size_t i = 0;
+#ifdef UBPA_UTOPIA_TANGENT_SPACE_SSE
+		const __m128 zero = _mm_setzero_ps();
+		for (; i + 4 <= num; i += 4) {
+			const __m128 vx = _mm_loadu_ps(x + i);
+			const __m128 vy = _mm_loadu_ps(y + i);
+			const __m128 vz = _mm_loadu_ps(z + i);
+			const __m128 norm2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+			const __m128 nonzero = _mm_cmpgt_ps(norm2, zero);
+			// max keeps 0 / 0 out of the masked lanes
+			const __m128 norm = _mm_sqrt_ps(_mm_max_ps(norm2, _mm_set1_ps(1e-30f)));
+			_mm_storeu_ps(x + i, _mm_and_ps(_mm_div_ps(vx, norm), nonzero));
+			_mm_storeu_ps(y + i, _mm_and_ps(_mm_div_ps(vy, norm), nonzero));
+			_mm_storeu_ps(z + i, _mm_and_ps(_mm_div_ps(vz, norm), nonzero));
+		}
+#endif // UBPA_UTOPIA_TANGENT_SPACE_SSE
+		for (; i < num; i++) {
+			const float norm2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+			if (!(norm2 > 0.f)) {
+				x[i] = y[i] = z[i] = 0.f;
+				continue;
+			}
+			const float norm = std::sqrt(std::max(norm2, 1e-30f));
+			x[i] /= norm;
+			y[i] /= norm;
+			z[i] /= norm;
+		}
+	}
+
+	float Dot(const float* a, const float* b) noexcept {
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	// v - n * dot(n, v), normalized, zero if it vanishes
+	void ProjectNormalized(float* dst, const float* v, const float* n) noexcept {
+		const float d = Dot(n, v);
+		for (size_t k = 0; k < 3; k++)
+			dst[k] = v[k] - n[k] * d;
+		const float norm2 = Dot(dst, dst);
+		const float scale = norm2 > 0.f ? 1.f / std::sqrt(norm2) : 0.f;
+		for (size_t k = 0; k < 3; k++)
+			dst[k] *= scale;
+	}
+}
+
+TriangleAdjacency Ubpa::Utopia::BuildTriangleAdjacency(std::vector<uint32_t> indices, size_t vertexCount) {
+	assert(indices.size() % 3 == 0);
+
+	TriangleAdjacency adjacency;
+	adjacency.indices = std::move(indices);
+	adjacency.offsets.assign(vertexCount + 1, 0);
+	for (auto index : adjacency.indices) {
+		assert(index < vertexCount);
+		adjacency.offsets[index + 1]++;
+	}
+	for (size_t v = 0; v < vertexCount; v++)
+		adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+	adjacency.triangles.resize(adjacency.indices.size());
+	std::vector<uint32_t> cursors(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+	for (size_t i = 0; i < adjacency.indices.size(); i++)
+		adjacency.triangles[cursors[adjacency.indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	return adjacency;
+}
+
+void Ubpa::Utopia::ComputeNormals(normalf* normals, const TriangleAdjacency& adjacency, const pointf3* positions) {
+	const size_t triangleNum = adjacency.GetTriangleNum();
+	const size_t vertexNum = adjacency.GetVertexNum();
+
+	std::vector<float> faceNormals(3 * triangleNum);
+	float* fx = faceNormals.data();
+	float* fy = fx + triangleNum;
+	float* fz = fy + triangleNum;
+	ParallelFor(triangleNum, MinChunkSize, [&](size_t begin, size_t end) {
+		ComputeFaceNormals(fx, fy, fz, adjacency.indices.data(), positions, begin, end);
+	});
+
+	ParallelFor(vertexNum, MinChunkSize, [&](size_t begin, size_t end) {
+		const size_t num = end - begin;
+		std::vector<float> sums(3 * num, 0.f);
+		float* x = sums.data();
+		float* y = x + num;
+		float* z = y + num;
+		for (size_t i = 0; i < num; i++) {
+			const size_t v = begin + i;
+			for (uint32_t j = adjacency.offsets[v]; j < adjacency.offsets[v + 1]; j++) {
+				const uint32_t t = adjacency.triangles[j];
+				x[i] += fx[t];
+				y[i] += fy[t];
+				z[i] += fz[t];
+			}
+		}
+		NormalizeVectors(x, y, z, num);
+		for (size_t i = 0; i < num; i++)
+			normals[begin + i] = { x[i], y[i], z[i] };
+	});
+}
+
+void Ubpa::Utopia::ComputeTangents(
+	vecf3* tangents,
+	const TriangleAdjacency& adjacency,
+	const pointf3* positions,
+	const normalf* normals,
+	const pointf2* uv,
+	TangentMode mode
+) {
+	const size_t triangleNum = adjacency.GetTriangleNum();
+	const size_t vertexNum = adjacency.GetVertexNum();
+	const uint32_t* indices = adjacency.indices.data();
+
+	// face tangents (s) and bitangents (t), 3 floats each
+	std::vector<float> faceS(3 * triangleNum);
+	std::vector<float> faceT(3 * triangleNum);
+	ParallelFor(triangleNum, MinChunkSize, [&](size_t begin, size_t end) {
+		for (size_t f = begin; f < end; f++) {
+			const auto& v1 = positions[indices[3 * f + 0]];
+			const auto& v2 = positions[indices[3 * f + 1]];
+			const auto& v3 = positions[indices[3 * f + 2]];
+			const auto& w1 = uv[indices[3 * f + 0]];
+			const auto& w2 = uv[indices[3 * f + 1]];
+			const auto& w3 = uv[indices[3 * f + 2]];
+
+			const float x1 = v2[0] - v1[0];
+			const float x2 = v3[0] - v1[0];
+			const float y1 = v2[1] - v1[1];
+			const float y2 = v3[1] - v1[1];
+			const float z1 = v2[2] - v1[2];
+			const float z2 = v3[2] - v1[2];
+
+			const float s1 = w2[0] - w1[0];
+			const float s2 = w3[0] - w1[0];
+			const float t1 = w2[1] - w1[1];
+			const float t2 = w3[1] - w1[1];
+
+			const float denominator = s1 * t2 - s2 * t1;
+			float* s = &faceS[3 * f];
+			float* t = &faceT[3 * f];
+			if (mode == TangentMode::MikkTSpace && denominator == 0.f) {
+				// degenerate, no contribution
+				s[0] = s[1] = s[2] = 0.f;
+				t[0] = t[1] = t[2] = 0.f;
+				continue;
+			}
+			const float r = denominator == 0.f ? 1.f : 1.f / denominator;
+			s[0] = (t2 * x1 - t1 * x2) * r;
+			s[1] = (t2 * y1 - t1 * y2) * r;
+			s[2] = (t2 * z1 - t1 * z2) * r;
+			t[0] = (s1 * x2 - s2 * x1) * r;
+			t[1] = (s1 * y2 - s2 * y1) * r;
+			t[2] = (s1 * z2 - s2 * z1) * r;
+			if (mode == TangentMode::MikkTSpace) {
+				const float lengthS = std::sqrt(Dot(s, s));
+				const float lengthT = std::sqrt(Dot(t, t));
+				for (size_t k = 0; k < 3; k++) {
+					s[k] = lengthS > 0.f ? s[k] / lengthS : 0.f;
+					t[k] = lengthT > 0.f ? t[k] / lengthT : 0.f;
+				}
+			}
+		}
+	});
+
+	ParallelFor(vertexNum, MinChunkSize, [&](size_t begin, size_t end) {
+		for (size_t v = begin; v < end; v++) {
+			const float n[3] = { normals[v][0], normals[v][1], normals[v][2] };
+			float sumS[3] = { 0.f, 0.f, 0.f };
+			float sumT[3] = { 0.f, 0.f, 0.f };
+			for (uint32_t j = adjacency.offsets[v]; j < adjacency.offsets[v + 1]; j++) {
+				const uint32_t f = adjacency.triangles[j];
+				const float* s = &faceS[3 * f];
+				const float* t = &faceT[3 * f];
+				if (mode == TangentMode::Accumulated) {
+					for (size_t k = 0; k < 3; k++) {
+						sumS[k] += s[k];
+						sumT[k] += t[k];
+					}
+					continue;
+				}
+
+				// the corner of v
+				size_t corner = 0;
+				while (indices[3 * f + corner] != v)
+					corner++;
+				const auto& p0 = positions[v];
+				const auto& p1 = positions[indices[3 * f + (corner + 1) % 3]];
+				const auto& p2 = positions[indices[3 * f + (corner + 2) % 3]];
+				const float d1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				const float d2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+				float e1[3], e2[3];
+				ProjectNormalized(e1, d1, n);
+				ProjectNormalized(e2, d2, n);
+				const float angle = std::acos(std::clamp(Dot(e1, e2), -1.f, 1.f));
+
+				float projS[3], projT[3];
+				ProjectNormalized(projS, s, n);
+				ProjectNormalized(projT, t, n);
+				for (size_t k = 0; k < 3; k++) {
+					sumS[k] += angle * projS[k];
+					sumT[k] += angle * projT[k];
+				}
+			}
+
+			// Gram-Schmidt orthogonalize
+			float tangent[3];
+			ProjectNormalized(tangent, sumS, n);
+			if (Dot(tangent, tangent) == 0.f) {
+				tangent[0] = 1.f;
+				tangent[1] = 0.f;
+				tangent[2] = 0.f;
+			}
+
+			// handedness
+			const float nxs[3] = {
+				n[1] * sumS[2] - n[2] * sumS[1],
+				n[2] * sumS[0] - n[0] * sumS[2],
+				n[0] * sumS[1] - n[1] * sumS[0],
+			};
+			const float sign = Dot(nxs, sumT) < 0.f ? -1.f : 1.f;
+			tangents[v] = { sign * tangent[0], sign * tangent[1], sign * tangent[2] };
+		}
+	});
+}
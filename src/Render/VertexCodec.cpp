@@ -0,0 +1,121 @@
+#include <Utopia/Render/VertexCodec.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+uint16_t Ubpa::Utopia::EncodeHalf(float value) noexcept {
+	uint32_t f;
+	std::memcpy(&f, &value, sizeof(float));
+
+	const uint32_t sign = (f >> 16) & 0x8000u;
+	const uint32_t absF = f & 0x7fffffffu;
+
+	// nan, inf
+	if (absF >= 0x7f800000u)
+		return static_cast<uint16_t>(sign | 0x7c00u | (absF > 0x7f800000u ? 0x200u : 0u));
+
+	// overflow -> inf
+	if (absF >= 0x477ff000u)
+		return static_cast<uint16_t>(sign | 0x7c00u);
+
+	// subnormal half
+	if (absF < 0x38800000u) {
+		if (absF < 0x33000000u)
+			return static_cast<uint16_t>(sign);
+		const uint32_t exp = absF >> 23;
+		const uint32_t mant = (absF & 0x7fffffu) | 0x800000u;
+		const uint32_t shift = 126 - exp; // in [14, 24]
+		uint32_t rst = mant >> shift;
+		const uint32_t rem = mant & ((1u << shift) - 1);
+		const uint32_t half = 1u << (shift - 1);
+		if (rem > half || (rem == half && (rst & 1u)))
+			rst++;
+		return static_cast<uint16_t>(sign | rst);
+	}
+
+	// normal half, the mantissa carry goes to the exponent
+	uint32_t rst = ((absF >> 13) - (112u << 10));
+	const uint32_t rem = absF & 0x1fffu;
+	if (rem > 0x1000u || (rem == 0x1000u && (rst & 1u)))
+		rst++;
+	return static_cast<uint16_t>(sign | rst);
+}
+
+float Ubpa::Utopia::DecodeHalf(uint16_t value) noexcept {
+	const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+	const uint32_t exp = (value >> 10) & 0x1fu;
+	const uint32_t mant = value & 0x3ffu;
+
+	uint32_t f;
+	if (exp == 0x1fu)
+		f = sign | 0x7f800000u | (mant << 13);
+	else if (exp != 0)
+		f = sign | ((exp + 112u) << 23) | (mant << 13);
+	else if (mant == 0)
+		f = sign;
+	else {
+		// subnormal half -> normal float
+		uint32_t e = 113;
+		uint32_t m = mant;
+		while (!(m & 0x400u)) {
+			m <<= 1;
+			e--;
+		}
+		f = sign | (e << 23) | ((m & 0x3ffu) << 13);
+	}
+
+	float rst;
+	std::memcpy(&rst, &f, sizeof(float));
+	return rst;
+}
+
+int16_t Ubpa::Utopia::EncodeSnorm16(float value) noexcept {
+	return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+float Ubpa::Utopia::DecodeSnorm16(int16_t value) noexcept {
+	// -32768 and -32767 are both -1
+	return std::max(static_cast<float>(value) / 32767.f, -1.f);
+}
+
+uint8_t Ubpa::Utopia::EncodeUnorm8(float value) noexcept {
+	return static_cast<uint8_t>(std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+}
+
+float Ubpa::Utopia::DecodeUnorm8(uint8_t value) noexcept {
+	return static_cast<float>(value) / 255.f;
+}
+
+std::array<int16_t, 2> Ubpa::Utopia::EncodeOctahedral(const vecf3& v) noexcept {
+	const float l1 = std::abs(v[0]) + std::abs(v[1]) + std::abs(v[2]);
+	if (l1 == 0.f)
+		return { 0, 0 };
+
+	float x = v[0] / l1;
+	float y = v[1] / l1;
+	// fold the lower hemisphere
+	if (v[2] < 0.f) {
+		const float fx = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+		const float fy = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+		x = fx;
+		y = fy;
+	}
+	return { EncodeSnorm16(x), EncodeSnorm16(y) };
+}
+
+vecf3 Ubpa::Utopia::DecodeOctahedral(const std::array<int16_t, 2>& e) noexcept {
+	float x = DecodeSnorm16(e[0]);
+	float y = DecodeSnorm16(e[1]);
+	const float z = 1.f - std::abs(x) - std::abs(y);
+	// unfold the lower hemisphere
+	const float t = std::max(-z, 0.f);
+	x += x >= 0.f ? -t : t;
+	y += y >= 0.f ? -t : t;
+
+	const float invLen = 1.f / std::sqrt(x * x + y * y + z * z);
+	return { x * invLen, y * invLen, z * invLen };
+}
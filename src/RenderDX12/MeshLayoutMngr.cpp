@@ -0,0 +1,113 @@
+#include <Utopia/Render/DX12/MeshLayoutMngr.h>
+
+#include <Utopia/Render/Mesh.h>
+
+using namespace Ubpa::Utopia;
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> MeshLayoutMngr::GenerateDesc(
+	bool uv,
+	bool normal,
+	bool tangent,
+	bool color,
+	VertexLayout layout,
+	VertexCompression compression
+) {
+	uint32_t mask = 0;
+	if (uv) mask |= GetVertexAttributeBit(VertexAttribute::UV);
+	if (normal) mask |= GetVertexAttributeBit(VertexAttribute::Normal);
+	if (tangent) mask |= GetVertexAttributeBit(VertexAttribute::Tangent);
+	if (color) mask |= GetVertexAttributeBit(VertexAttribute::Color);
+	const auto streams = VertexStreams::Create(layout, mask, compression);
+
+	constexpr LPCSTR semanticNames[VertexAttributeNum] = {
+		"POSITION",
+		"TEXCOORD",
+		"NORMAL",
+		"TENGENT",
+		"COLOR"
+	};
+	// VertexCompression -> formats, the input assembler decodes them
+	constexpr DXGI_FORMAT formats[3][VertexAttributeNum] = {
+		{
+			DXGI_FORMAT_R32G32B32_FLOAT,
+			DXGI_FORMAT_R32G32_FLOAT,
+			DXGI_FORMAT_R32G32B32_FLOAT,
+			DXGI_FORMAT_R32G32B32A32_FLOAT,
+			DXGI_FORMAT_R32G32B32A32_FLOAT
+		},
+		{
+			DXGI_FORMAT_R32G32B32_FLOAT,
+			DXGI_FORMAT_R16G16_FLOAT,
+			DXGI_FORMAT_R16G16B16A16_SNORM,
+			DXGI_FORMAT_R16G16B16A16_SNORM,
+			DXGI_FORMAT_R8G8B8A8_UNORM
+		},
+		{
+			DXGI_FORMAT_R32G32B32_FLOAT,
+			DXGI_FORMAT_R16G16_FLOAT,
+			DXGI_FORMAT_R16G16_SNORM,
+			DXGI_FORMAT_R16G16_SNORM,
+			DXGI_FORMAT_R8G8B8A8_UNORM
+		}
+	};
+	const auto& compressionFormats = formats[static_cast<size_t>(compression)];
+
+	std::vector<D3D12_INPUT_ELEMENT_DESC> rst;
+	rst.reserve(VertexAttributeNum);
+	for (size_t i = 0; i < VertexAttributeNum; i++) {
+		// if not exist attribute, set it to slot 0, offset 0
+		UINT slot = 0;
+		UINT offset = 0;
+		if (streams.attributeMask & (1u << i)) {
+			slot = static_cast<UINT>(streams.streams[i]);
+			offset = static_cast<UINT>(streams.offsets[i]);
+		}
+		rst.push_back(
+			{ semanticNames[i], 0, compressionFormats[i], slot, offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+		);
+	}
+
+	return rst;
+}
+
+MeshLayoutMngr::MeshLayoutMngr() {
+	constexpr VertexLayout layouts[] = {
+		VertexLayout::Interleaved,
+		VertexLayout::PositionSplit,
+		VertexLayout::Split
+	};
+	constexpr VertexCompression compressions[] = {
+		VertexCompression::None,
+		VertexCompression::Standard,
+		VertexCompression::Compact
+	};
+	layoutMap.reserve(std::size(compressions) * std::size(layouts) * 0b10000);
+	for (auto compression : compressions) {
+		for (auto layout : layouts) {
+			for (size_t attrs = 0; attrs <= 0b1111; attrs++) {
+				auto [uv, normal, tangent, color] = DecodeMeshLayoutID(attrs);
+				layoutMap.emplace(
+					GetMeshLayoutID(uv, normal, tangent, color, layout, compression),
+					GenerateDesc(uv, normal, tangent, color, layout, compression)
+				);
+			}
+		}
+	}
+}
+
+const std::vector<D3D12_INPUT_ELEMENT_DESC>& MeshLayoutMngr::GetMeshLayoutValue(size_t ID) {
+	auto target = layoutMap.find(ID);
+	assert(target != layoutMap.end());
+	return target->second;
+}
+
+size_t MeshLayoutMngr::GetMeshLayoutID(const Mesh& mesh) noexcept {
+	return GetMeshLayoutID(
+		!mesh.GetUV().empty(),
+		!mesh.GetNormals().empty(),
+		!mesh.GetTangents().empty(),
+		!mesh.GetColors().empty(),
+		mesh.GetVertexLayout(),
+		mesh.GetVertexCompression()
+	);
+}
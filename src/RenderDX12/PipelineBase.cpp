@@ -0,0 +1,274 @@
+#include <Utopia/Render/DX12/PipelineBase.h>
+
+#include <Utopia/Render/Material.h>
+#include <Utopia/Render/Shader.h>
+
+#include <Utopia/Render/DX12/RsrcMngrDX12.h>
+#include <Utopia/Render/DX12/ShaderCBMngrDX12.h>
+
+using namespace Ubpa::Utopia;
+
+PipelineBase::ShaderCBDesc PipelineBase::UpdateShaderCBs(
+	ShaderCBMngrDX12& shaderCBMngr,
+	const Shader& shader,
+	const std::unordered_set<const Material*>& materials,
+	const std::set<std::string_view>& commonCBs
+) {
+	PipelineBase::ShaderCBDesc rst;
+
+	const auto& layout = shaderCBMngr.GetLayout(shader, commonCBs);
+	rst.materialCBSize = layout.GetSize();
+	rst.offsetMap = layout.GetOffsetMap();
+
+	auto buffer = shaderCBMngr.GetBuffer(shader);
+	buffer->FastReserve(rst.materialCBSize * materials.size());
+	for (auto material : materials) {
+		size_t idx = rst.indexMap.size();
+		rst.indexMap[material->GetInstanceID()] = idx;
+	}
+
+	if (rst.materialCBSize == 0)
+		return rst;
+
+	// the blobs are repacked only when the materials change
+	for (auto material : materials) {
+		const auto& packed = layout.GetPacked(*material);
+		size_t index = rst.indexMap.at(material->GetInstanceID());
+		buffer->Set(rst.materialCBSize * index, packed.data(), packed.size());
+	}
+
+	return rst;
+}
+
+std::vector<PipelineBase::RootBindingSlot> PipelineBase::GetRootBindingSlots(const Shader& shader) {
+	std::vector<RootBindingSlot> slots;
+
+	auto FindRootParamIndex = [&](auto&& pred) {
+		for (size_t i = 0; i < shader.rootParameters.size(); i++) {
+			if (std::visit(pred, shader.rootParameters[i]))
+				return (UINT)i;
+		}
+		return static_cast<UINT>(-1);
+	};
+
+	auto GetSRVRootParamIndex = [&](UINT registerIndex) {
+		return FindRootParamIndex([=](const auto& param) {
+			using Type = std::decay_t<decltype(param)>;
+			if constexpr (std::is_same_v<Type, RootDescriptorTable>) {
+				const RootDescriptorTable& table = param;
+				if (table.size() != 1)
+					return false;
+
+				const auto& range = table.front();
+				assert(range.NumDescriptors > 0);
+
+				return range.BaseShaderRegister == registerIndex;
+			}
+			else
+				return false;
+		});
+	};
+
+	auto GetRootDescriptorIndex = [&](RootDescriptorType type, UINT registerIndex) {
+		return FindRootParamIndex([=](const auto& param) {
+			using Type = std::decay_t<decltype(param)>;
+			if constexpr (std::is_same_v<Type, RootDescriptor>) {
+				const RootDescriptor& descriptor = param;
+				return descriptor.DescriptorType == type && descriptor.ShaderRegister == registerIndex;
+			}
+			else
+				return false;
+		});
+	};
+
+	auto AddSlots = [&](ID3D12ShaderReflection* refl) {
+		D3D12_SHADER_DESC shaderDesc;
+		ThrowIfFailed(refl->GetDesc(&shaderDesc));
+
+		for (UINT i = 0; i < shaderDesc.BoundResources; i++) {
+			D3D12_SHADER_INPUT_BIND_DESC rsrcDesc;
+			ThrowIfFailed(refl->GetResourceBindingDesc(i, &rsrcDesc));
+
+			RootBindingSlot slot;
+			switch (rsrcDesc.Type)
+			{
+			case D3D_SIT_CBUFFER:
+				slot.source = RootBindingSlot::Source::CB;
+				slot.rootParamIndex = GetRootDescriptorIndex(RootDescriptorType::CBV, rsrcDesc.BindPoint);
+				assert(slot.rootParamIndex != static_cast<UINT>(-1));
+				break;
+			case D3D_SIT_TEXTURE:
+				slot.source = RootBindingSlot::Source::Texture;
+				slot.rootParamIndex = GetSRVRootParamIndex(rsrcDesc.BindPoint); // -1: inner SRV
+				break;
+			case D3D_SIT_STRUCTURED:
+				// bound as root SRV
+				slot.source = RootBindingSlot::Source::BufferSRV;
+				slot.rootParamIndex = GetRootDescriptorIndex(RootDescriptorType::SRV, rsrcDesc.BindPoint);
+				break;
+			default:
+				continue;
+			}
+
+			if (slot.rootParamIndex == static_cast<UINT>(-1))
+				continue;
+
+			// the passes and stages share resources
+			bool exist = false;
+			for (const auto& s : slots) {
+				if (s.rootParamIndex == slot.rootParamIndex) {
+					exist = true;
+					break;
+				}
+			}
+			if (exist)
+				continue;
+
+			slot.name = rsrcDesc.Name;
+			slot.bindPoint = rsrcDesc.BindPoint;
+			slot.dimension = rsrcDesc.Dimension;
+			slots.push_back(std::move(slot));
+		}
+	};
+
+	for (size_t i = 0; i < shader.passes.size(); i++) {
+		AddSlots(RsrcMngrDX12::Instance().GetShaderRefl_vs(shader, i));
+		AddSlots(RsrcMngrDX12::Instance().GetShaderRefl_ps(shader, i));
+	}
+
+	return slots;
+}
+
+void PipelineBase::ResolveRootBindings(
+	std::vector<RootBinding>& bindings,
+	const std::vector<RootBindingSlot>& slots,
+	ShaderCBMngrDX12& shaderCBMngr,
+	const ShaderCBDesc& shaderCBDescconst,
+	const Material& material,
+	const std::map<std::string_view, D3D12_GPU_VIRTUAL_ADDRESS>& commonCBs,
+	const std::map<std::string_view, D3D12_GPU_DESCRIPTOR_HANDLE>& commonSRVs,
+	const std::map<std::string_view, D3D12_GPU_VIRTUAL_ADDRESS>& commonBufferSRVs
+) {
+	auto buffer = shaderCBMngr.GetBuffer(*material.shader);
+	size_t cbPos = buffer->GetResource()->GetGPUVirtualAddress()
+		+ shaderCBDescconst.indexMap.at(material.GetInstanceID()) * shaderCBDescconst.materialCBSize;
+
+	for (const auto& slot : slots) {
+		switch (slot.source)
+		{
+		case RootBindingSlot::Source::CB:
+		{
+			D3D12_GPU_VIRTUAL_ADDRESS adress;
+
+			if (auto target = shaderCBDescconst.offsetMap.find(slot.bindPoint); target != shaderCBDescconst.offsetMap.end())
+				adress = cbPos + target->second;
+			else if (auto target = commonCBs.find(slot.name); target != commonCBs.end())
+				adress = target->second;
+			else {
+				assert(false);
+				break;
+			}
+			bindings.push_back({ RootBinding::Type::CBV, slot.rootParamIndex, adress });
+			break;
+		}
+		case RootBindingSlot::Source::Texture:
+		{
+			D3D12_GPU_DESCRIPTOR_HANDLE handle;
+			handle.ptr = 0;
+
+			if (auto target = material.properties.find(slot.name); target != material.properties.end()) {
+				switch (slot.dimension)
+				{
+				case D3D_SRV_DIMENSION_TEXTURE2D: {
+					assert(std::holds_alternative<std::shared_ptr<const Texture2D>>(target->second));
+					auto tex2d = std::get<std::shared_ptr<const Texture2D>>(target->second);
+					handle = RsrcMngrDX12::Instance().GetTexture2DSrvGpuHandle(*tex2d);
+					break;
+				}
+				case D3D_SRV_DIMENSION_TEXTURECUBE: {
+					assert(std::holds_alternative<std::shared_ptr<const TextureCube>>(target->second));
+					auto texcube = std::get<std::shared_ptr<const TextureCube>>(target->second);
+					handle = RsrcMngrDX12::Instance().GetTextureCubeSrvGpuHandle(*texcube);
+					break;
+				}
+				default:
+					assert("not support" && false);
+					break;
+				}
+			}
+			else if (auto target = commonSRVs.find(slot.name); target != commonSRVs.end())
+				handle = target->second;
+			else
+				break;
+
+			if (handle.ptr != 0)
+				bindings.push_back({ RootBinding::Type::DescriptorTable, slot.rootParamIndex, handle.ptr });
+
+			break;
+		}
+		case RootBindingSlot::Source::BufferSRV:
+		{
+			if (auto target = commonBufferSRVs.find(slot.name); target != commonBufferSRVs.end())
+				bindings.push_back({ RootBinding::Type::SRV, slot.rootParamIndex, target->second });
+
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+void PipelineBase::SetGraphicsRoot(ID3D12GraphicsCommandList* cmdList, const RootBinding* bindings, size_t num) {
+	for (size_t i = 0; i < num; i++) {
+		const auto& binding = bindings[i];
+		switch (binding.type)
+		{
+		case RootBinding::Type::CBV:
+			cmdList->SetGraphicsRootConstantBufferView(binding.slot, binding.value);
+			break;
+		case RootBinding::Type::SRV:
+			cmdList->SetGraphicsRootShaderResourceView(binding.slot, binding.value);
+			break;
+		case RootBinding::Type::DescriptorTable:
+			cmdList->SetGraphicsRootDescriptorTable(binding.slot, D3D12_GPU_DESCRIPTOR_HANDLE{ binding.value });
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	}
+}
+
+void PipelineBase::SetPSODescForRenderState(D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const RenderState& renderState) {
+	desc.RasterizerState.CullMode = static_cast<D3D12_CULL_MODE>(renderState.cullMode);
+	desc.DepthStencilState.DepthFunc = static_cast<D3D12_COMPARISON_FUNC>(renderState.zTest);
+	desc.DepthStencilState.DepthWriteMask = static_cast<D3D12_DEPTH_WRITE_MASK>(renderState.zWrite);
+
+	for (size_t i = 0; i < 8; i++) {
+		if (renderState.blendStates[i].enable) {
+			desc.BlendState.RenderTarget[i].BlendEnable = TRUE;
+			desc.BlendState.RenderTarget[i].SrcBlend = static_cast<D3D12_BLEND>(renderState.blendStates[i].src);
+			desc.BlendState.RenderTarget[i].DestBlend = static_cast<D3D12_BLEND>(renderState.blendStates[i].dest);
+			desc.BlendState.RenderTarget[i].BlendOp = static_cast<D3D12_BLEND_OP>(renderState.blendStates[i].op);
+			desc.BlendState.RenderTarget[i].SrcBlendAlpha = static_cast<D3D12_BLEND>(renderState.blendStates[i].srcAlpha);
+			desc.BlendState.RenderTarget[i].DestBlendAlpha = static_cast<D3D12_BLEND>(renderState.blendStates[i].destAlpha);
+			desc.BlendState.RenderTarget[i].BlendOpAlpha = static_cast<D3D12_BLEND_OP>(renderState.blendStates[i].opAlpha);
+		}
+	}
+	
+	if (renderState.stencilState.enable) {
+		desc.DepthStencilState.StencilEnable = TRUE;
+		desc.DepthStencilState.StencilReadMask = renderState.stencilState.readMask;
+		desc.DepthStencilState.StencilWriteMask = renderState.stencilState.writeMask;
+		D3D12_DEPTH_STENCILOP_DESC stencilDesc;
+		stencilDesc.StencilDepthFailOp = static_cast<D3D12_STENCIL_OP>(renderState.stencilState.depthFailOp);
+		stencilDesc.StencilFailOp = static_cast<D3D12_STENCIL_OP>(renderState.stencilState.failOp);
+		stencilDesc.StencilPassOp = static_cast<D3D12_STENCIL_OP>(renderState.stencilState.passOp);
+		stencilDesc.StencilFunc = static_cast<D3D12_COMPARISON_FUNC>(renderState.stencilState.func);
+		desc.DepthStencilState.FrontFace = stencilDesc;
+		desc.DepthStencilState.BackFace = stencilDesc;
+	}
+	for (size_t i = 0; i < 8; i++)
+		desc.BlendState.RenderTarget[i].RenderTargetWriteMask = renderState.colorMask[i];
+}
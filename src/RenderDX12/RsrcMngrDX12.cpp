@@ -7,8 +7,13 @@
 #include <Utopia/Render/Shader.h>
 #include <Utopia/Render/Mesh.h>
 
+#include <spdlog/spdlog.h>
+
 #include <unordered_map>
+#include <memory>
 #include <iostream>
+#include <cstring>
+#include <algorithm>
 
 using namespace Ubpa::Utopia;
 using namespace Ubpa;
@@ -34,11 +39,18 @@ struct RsrcMngrDX12::Impl {
 			Microsoft::WRL::ComPtr<ID3DBlob> psByteCode;
 			Microsoft::WRL::ComPtr<ID3D12ShaderReflection> vsRefl;
 			Microsoft::WRL::ComPtr<ID3D12ShaderReflection> psRefl;
+			// GetShaderByteCode_vs_Compact
+			Microsoft::WRL::ComPtr<ID3DBlob> vsCompactByteCode;
+			bool vsCompactCompiled{ false };
 		};
 		Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
 		std::vector<PassData> passes;
+		ShaderCBReflection cbRefl;
 	};
 
+	static void AppendCBRefl(ShaderCBReflection& cbRefl, ID3D12ShaderReflection* refl);
+	static DXGI_FORMAT GetIndexFormat(const Mesh& mesh) noexcept;
+
 	bool isInit{ false };
 	ID3D12Device* device{ nullptr };
 	DirectX::ResourceUploadBatch* upload{ nullptr };
@@ -50,6 +62,30 @@ struct RsrcMngrDX12::Impl {
 	unordered_map<size_t, ShaderCompileData> shaderMap;
 
 	unordered_map<size_t, UDX12::MeshGPUBuffer> meshMap;
+	unordered_map<size_t, RsrcMngrDX12::MeshBufferViews> meshViewsMap;
+	// vertex buffers of the editable meshes updated in place (Mesh::IsUpdatedInPlace()), in the upload heap
+	// the GPU reads them directly, an update only writes the updated byte ranges
+	// numFrame copies are written in turn (a mesh is updated at most once per frame),
+	// so the GPU has finished reading the written copy, and it replays the ranges it missed (countdown)
+	// created at the first in-place update, they replace the vertex buffer of the MeshGPUBuffer until
+	// an update isn't in place or the mesh is static
+	struct DynamicVertexBuffer {
+		struct Range {
+			size_t offset;
+			size_t size;
+			size_t countdown; // copies left
+		};
+		vector<unique_ptr<UDX12::DynamicUploadBuffer>> copies;
+		vector<size_t> sizes;
+		size_t cur{ 0 };
+		vector<Range> ranges;
+		bool active{ false }; // the views read copies[cur]
+	};
+	size_t numFrame{ 1 };
+	unordered_map<size_t, DynamicVertexBuffer> dynamicVertexBufferMap;
+	void UpdateMeshBufferViews(const Mesh& mesh, UDX12::MeshGPUBuffer& meshGPUBuffer);
+	// after mesh.UpdateVertexBuffer(), mesh.IsUpdatedInPlace()
+	void UpdateDynamicVertexBuffer(const Mesh& mesh);
 	vector<ID3D12PipelineState*> PSOs;
 
 	const CD3DX12_STATIC_SAMPLER_DESC pointWrap{
@@ -115,10 +151,11 @@ RsrcMngrDX12::~RsrcMngrDX12() {
 	delete(pImpl);
 }
 
-RsrcMngrDX12& RsrcMngrDX12::Init(ID3D12Device* device) {
+RsrcMngrDX12& RsrcMngrDX12::Init(ID3D12Device* device, size_t numFrame) {
 	assert(!pImpl->isInit);
 
 	pImpl->device = device;
+	pImpl->numFrame = std::max<size_t>(numFrame, 1);
 	pImpl->upload = new DirectX::ResourceUploadBatch{ device };
 
 	pImpl->isInit = true;
@@ -155,6 +192,8 @@ void RsrcMngrDX12::Clear() {
 	pImpl->textureCubeMap.clear();
 	pImpl->renderTargetMap.clear();
 	pImpl->meshMap.clear();
+	pImpl->meshViewsMap.clear();
+	pImpl->dynamicVertexBufferMap.clear();
 	pImpl->PSOs.clear();
 	pImpl->shaderMap.clear();
 
@@ -372,6 +411,10 @@ ID3D12Resource* RsrcMngrDX12::GetTextureCubeResource(const TextureCube& texCube)
 //	return pImpl->textureMap.find(tex2D.GetInstanceID())->second.allocationRTV;
 //}
 
+DXGI_FORMAT RsrcMngrDX12::Impl::GetIndexFormat(const Mesh& mesh) noexcept {
+	return mesh.GetIndexBufferIndexSize() == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+}
+
 UDX12::MeshGPUBuffer& RsrcMngrDX12::RegisterMesh(
 	DirectX::ResourceUploadBatch& upload,
 	UDX12::ResourceDeleteBatch& deleteBatch,
@@ -386,9 +429,9 @@ UDX12::MeshGPUBuffer& RsrcMngrDX12::RegisterMesh(
 		auto vb_data = mesh.GetVertexBufferData();
 		auto vb_count = (UINT)mesh.GetVertexBufferVertexCount();
 		auto vb_stride = (UINT)mesh.GetVertexBufferVertexStride();
-		auto ib_data = mesh.GetIndices().data();
-		auto ib_count = (UINT)mesh.GetIndices().size();
-		auto ib_format = DXGI_FORMAT_R32_UINT;
+		auto ib_data = mesh.GetIndexBufferData();
+		auto ib_count = (UINT)mesh.GetIndexBufferIndexCount();
+		auto ib_format = Impl::GetIndexFormat(mesh);
 
 		if (mesh.IsEditable()) {
 			auto [iter, success] = pImpl->meshMap.try_emplace(
@@ -397,11 +440,12 @@ UDX12::MeshGPUBuffer& RsrcMngrDX12::RegisterMesh(
 				mesh.GetVertexBufferData(),
 				(UINT)mesh.GetVertexBufferVertexCount(),
 				(UINT)mesh.GetVertexBufferVertexStride(),
-				mesh.GetIndices().data(),
-				(UINT)mesh.GetIndices().size(),
-				DXGI_FORMAT_R32_UINT
+				mesh.GetIndexBufferData(),
+				(UINT)mesh.GetIndexBufferIndexCount(),
+				Impl::GetIndexFormat(mesh)
 			);
 			assert(success);
+			pImpl->UpdateMeshBufferViews(mesh, iter->second);
 			return iter->second;
 		}
 		else {
@@ -411,11 +455,12 @@ UDX12::MeshGPUBuffer& RsrcMngrDX12::RegisterMesh(
 				mesh.GetVertexBufferData(),
 				(UINT)mesh.GetVertexBufferVertexCount(),
 				(UINT)mesh.GetVertexBufferVertexStride(),
-				mesh.GetIndices().data(),
-				(UINT)mesh.GetIndices().size(),
-				DXGI_FORMAT_R32_UINT
+				mesh.GetIndexBufferData(),
+				(UINT)mesh.GetIndexBufferIndexCount(),
+				Impl::GetIndexFormat(mesh)
 			);
 			assert(success);
+			pImpl->UpdateMeshBufferViews(mesh, iter->second);
 			return iter->second;
 		}
 	}
@@ -425,30 +470,43 @@ UDX12::MeshGPUBuffer& RsrcMngrDX12::RegisterMesh(
 			if (mesh.IsEditable()) {
 				if (mesh.IsDirty()) {
 					mesh.UpdateVertexBuffer();
-					meshGpuBuffer.Update(
-						pImpl->device, cmdList,
-						mesh.GetVertexBufferData(),
-						(UINT)mesh.GetVertexBufferVertexCount(),
-						(UINT)mesh.GetVertexBufferVertexStride(),
-						mesh.GetIndices().data(),
-						(UINT)mesh.GetIndices().size(),
-						DXGI_FORMAT_R32_UINT
-					);
+					// in place, only the updated ranges are copied to the dynamic vertex buffer
+					if (mesh.IsUpdatedInPlace())
+						pImpl->UpdateDynamicVertexBuffer(mesh);
+					else {
+						meshGpuBuffer.Update(
+							pImpl->device, cmdList,
+							mesh.GetVertexBufferData(),
+							(UINT)mesh.GetVertexBufferVertexCount(),
+							(UINT)mesh.GetVertexBufferVertexStride(),
+							mesh.GetIndexBufferData(),
+							(UINT)mesh.GetIndexBufferIndexCount(),
+							Impl::GetIndexFormat(mesh)
+						);
+						// the copies miss this update, they are rewritten at the next in-place update
+						if (auto dynamic = pImpl->dynamicVertexBufferMap.find(mesh.GetInstanceID()); dynamic != pImpl->dynamicVertexBufferMap.end())
+							dynamic->second.active = false;
+					}
 				}
 				//else
 				//	;// do nothing
 			}
 			else {
-				if (mesh.IsDirty()) {
+				// the vertex buffer of the MeshGPUBuffer misses the in-place updates
+				auto dynamic = pImpl->dynamicVertexBufferMap.find(mesh.GetInstanceID());
+				const bool patched = dynamic != pImpl->dynamicVertexBufferMap.end() && dynamic->second.active;
+				if (mesh.IsDirty() || patched) {
+					if (mesh.IsDirty())
+						mesh.UpdateVertexBuffer();
 					meshGpuBuffer.UpdateAndConvertToStatic(
 						deleteBatch,
 						pImpl->device, cmdList,
 						mesh.GetVertexBufferData(),
 						(UINT)mesh.GetVertexBufferVertexCount(),
 						(UINT)mesh.GetVertexBufferVertexStride(),
-						mesh.GetIndices().data(),
-						(UINT)mesh.GetIndices().size(),
-						DXGI_FORMAT_R32_UINT
+						mesh.GetIndexBufferData(),
+						(UINT)mesh.GetIndexBufferIndexCount(),
+						Impl::GetIndexFormat(mesh)
 					);
 				}
 				else
@@ -458,6 +516,7 @@ UDX12::MeshGPUBuffer& RsrcMngrDX12::RegisterMesh(
 		else
 			assert(!mesh.IsEditable() && !mesh.IsDirty());
 
+		pImpl->UpdateMeshBufferViews(mesh, meshGpuBuffer);
 		return meshGpuBuffer;
 	}
 	return pImpl->meshMap.find(mesh.GetInstanceID())->second;
@@ -467,6 +526,78 @@ UDX12::MeshGPUBuffer& RsrcMngrDX12::GetMeshGPUBuffer(const Mesh& mesh) const {
 	return pImpl->meshMap.find(mesh.GetInstanceID())->second;
 }
 
+const RsrcMngrDX12::MeshBufferViews& RsrcMngrDX12::GetMeshBufferViews(const Mesh& mesh) const {
+	return pImpl->meshViewsMap.find(mesh.GetInstanceID())->second;
+}
+
+void RsrcMngrDX12::Impl::UpdateMeshBufferViews(const Mesh& mesh, UDX12::MeshGPUBuffer& meshGPUBuffer) {
+	auto& views = meshViewsMap[mesh.GetInstanceID()];
+	const auto& streams = mesh.GetVertexStreams();
+	const auto vertexCount = mesh.GetVertexBufferVertexCount();
+	const auto buffer = meshGPUBuffer.VertexBufferView();
+
+	auto bufferLocation = buffer.BufferLocation;
+	if (!meshGPUBuffer.IsStatic()) {
+		auto target = dynamicVertexBufferMap.find(mesh.GetInstanceID());
+		if (target != dynamicVertexBufferMap.end() && target->second.active) {
+			const auto& dynamic = target->second;
+			bufferLocation = dynamic.copies[dynamic.cur]->GetResource()->GetGPUVirtualAddress();
+		}
+	}
+
+	views.vertexBufferNum = static_cast<UINT>(streams.streamNum);
+	for (size_t i = 0; i < streams.streamNum; i++) {
+		auto& view = views.vertexBuffers[i];
+		view.BufferLocation = bufferLocation + mesh.GetVertexStreamOffset(i);
+		view.StrideInBytes = static_cast<UINT>(streams.strides[i]);
+		view.SizeInBytes = static_cast<UINT>(streams.strides[i] * vertexCount);
+	}
+	views.indexBuffer = meshGPUBuffer.IndexBufferView();
+}
+
+void RsrcMngrDX12::Impl::UpdateDynamicVertexBuffer(const Mesh& mesh) {
+	assert(mesh.IsUpdatedInPlace());
+	const auto* data = static_cast<const uint8_t*>(mesh.GetVertexBufferData());
+	const size_t size = mesh.GetVertexBufferVertexCount() * mesh.GetVertexBufferVertexStride();
+
+	auto& buffer = dynamicVertexBufferMap[mesh.GetInstanceID()];
+	if (buffer.copies.empty()) {
+		// the first in-place update, the mesh is deforming
+		buffer.copies.resize(numFrame);
+		buffer.sizes.resize(numFrame, 0);
+		buffer.cur = numFrame - 1;
+	}
+
+	if (!buffer.active) {
+		// the copies are out of date, rewrite all of them
+		buffer.ranges.clear();
+		buffer.ranges.push_back({ 0, size, numFrame });
+		buffer.active = true;
+	}
+	else {
+		for (const auto& range : mesh.GetUpdatedVertexBufferRanges())
+			buffer.ranges.push_back({ range.offset, range.size, numFrame });
+	}
+
+	buffer.cur = (buffer.cur + 1) % numFrame;
+	auto& copy = buffer.copies[buffer.cur];
+	if (!copy)
+		copy = make_unique<UDX12::DynamicUploadBuffer>(device);
+	if (buffer.sizes[buffer.cur] < size) {
+		// the GPU doesn't read the copy any more, its resource can be replaced
+		copy->FastReserve(size);
+		buffer.sizes[buffer.cur] = size;
+	}
+
+	for (const auto& range : buffer.ranges)
+		copy->Set(range.offset, data + range.offset, range.size);
+
+	buffer.ranges.erase(
+		std::remove_if(buffer.ranges.begin(), buffer.ranges.end(), [](auto& range) { return --range.countdown == 0; }),
+		buffer.ranges.end()
+	);
+}
+
 bool RsrcMngrDX12::RegisterShader(const Shader& shader) {
 	auto target = pImpl->shaderMap.find(shader.GetInstanceID());
 	if (target != pImpl->shaderMap.end())
@@ -513,6 +644,8 @@ bool RsrcMngrDX12::RegisterShader(const Shader& shader) {
 			shaderCompileData.passes[i].psByteCode->GetBufferSize(),
 			IID_PPV_ARGS(&shaderCompileData.passes[i].psRefl)
 		));
+		Impl::AppendCBRefl(shaderCompileData.cbRefl, shaderCompileData.passes[i].vsRefl.Get());
+		Impl::AppendCBRefl(shaderCompileData.cbRefl, shaderCompileData.passes[i].psRefl.Get());
 	}
 
 	auto RangeTypeMap = [](RootDescriptorType type) {
@@ -621,6 +754,52 @@ const ID3DBlob* RsrcMngrDX12::GetShaderByteCode_ps(const Shader& shader, size_t
 	return pImpl->shaderMap.at(shader.GetInstanceID()).passes[passIdx].psByteCode.Get();
 }
 
+const ID3DBlob* RsrcMngrDX12::GetShaderByteCode_vs_Compact(const Shader& shader, size_t passIdx) {
+	auto& passData = pImpl->shaderMap.at(shader.GetInstanceID()).passes[passIdx];
+	if (passData.vsCompactCompiled)
+		return passData.vsCompactByteCode.Get();
+	passData.vsCompactCompiled = true;
+
+	D3D_SHADER_MACRO macros[] = {
+		{"VERTEX_COMPRESSION_COMPACT", "1"},
+		{nullptr, nullptr}
+	};
+	Ubpa::UDX12::D3DInclude d3dInclude{ shader.hlslFile->GetLocalDir(), "../" };
+	auto byteCode = UDX12::Util::CompileShader(
+		shader.hlslFile->GetText(),
+		macros,
+		shader.passes[passIdx].vertexName,
+		"vs_5_0",
+		&d3dInclude
+	);
+	if (!byteCode)
+		return nullptr;
+
+	Microsoft::WRL::ComPtr<ID3D12ShaderReflection> refl;
+	ThrowIfFailed(D3DReflect(
+		byteCode->GetBufferPointer(),
+		byteCode->GetBufferSize(),
+		IID_PPV_ARGS(&refl)
+	));
+	D3D12_SHADER_DESC shaderDesc;
+	ThrowIfFailed(refl->GetDesc(&shaderDesc));
+	for (UINT i = 0; i < shaderDesc.InputParameters; i++) {
+		D3D12_SIGNATURE_PARAMETER_DESC paramDesc;
+		ThrowIfFailed(refl->GetInputParameterDesc(i, &paramDesc));
+		if (std::strcmp(paramDesc.SemanticName, "NORMAL") != 0 && std::strcmp(paramDesc.SemanticName, "TENGENT") != 0)
+			continue;
+		// z or w, the input assembler fills them with 0 and 1
+		if (paramDesc.Mask & 0b1100) {
+			spdlog::warn("shader {} (pass {}) can't decode VertexCompression::Compact meshes, they are not drawn",
+				shader.name, passIdx);
+			return nullptr;
+		}
+	}
+
+	passData.vsCompactByteCode = std::move(byteCode);
+	return passData.vsCompactByteCode.Get();
+}
+
 ID3D12ShaderReflection* RsrcMngrDX12::GetShaderRefl_vs(const Shader& shader, size_t passIdx) const {
 	return pImpl->shaderMap.at(shader.GetInstanceID()).passes[passIdx].vsRefl.Get();
 }
@@ -633,6 +812,37 @@ ID3D12RootSignature* RsrcMngrDX12::GetShaderRootSignature(const Shader& shader)
 	return pImpl->shaderMap.at(shader.GetInstanceID()).rootSignature.Get();
 }
 
+const ShaderCBReflection& RsrcMngrDX12::GetShaderCBRefl(const Shader& shader) const {
+	return pImpl->shaderMap.at(shader.GetInstanceID()).cbRefl;
+}
+
+void RsrcMngrDX12::Impl::AppendCBRefl(ShaderCBReflection& cbRefl, ID3D12ShaderReflection* refl) {
+	D3D12_SHADER_DESC shaderDesc;
+	ThrowIfFailed(refl->GetDesc(&shaderDesc));
+
+	for (UINT i = 0; i < shaderDesc.ConstantBuffers; i++) {
+		auto cb = refl->GetConstantBufferByIndex(i);
+		D3D12_SHADER_BUFFER_DESC cbDesc;
+		ThrowIfFailed(cb->GetDesc(&cbDesc));
+
+		D3D12_SHADER_INPUT_BIND_DESC rsrcDesc;
+		if (FAILED(refl->GetResourceBindingDescByName(cbDesc.Name, &rsrcDesc)))
+			continue;
+
+		ShaderCBReflection::ConstantBuffer cbRst;
+		cbRst.name = cbDesc.Name;
+		cbRst.bindPoint = rsrcDesc.BindPoint;
+		cbRst.size = cbDesc.Size;
+		for (UINT j = 0; j < cbDesc.Variables; j++) {
+			auto var = cb->GetVariableByIndex(j);
+			D3D12_SHADER_VARIABLE_DESC varDesc;
+			ThrowIfFailed(var->GetDesc(&varDesc));
+			cbRst.variables.push_back({ varDesc.Name, varDesc.StartOffset, varDesc.Size });
+		}
+		cbRefl.constantBuffers.push_back(std::move(cbRst));
+	}
+}
+
 //RsrcMngrDX12& RsrcMngrDX12::RegisterRenderTexture2D(size_t id, UINT width, UINT height, DXGI_FORMAT format) {
 //	Impl::Texture tex;
 //	tex.resources.resize(1);
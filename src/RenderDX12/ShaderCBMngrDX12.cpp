@@ -0,0 +1,69 @@
+#include <Utopia/Render/DX12/ShaderCBMngrDX12.h>
+
+#include <Utopia/Render/DX12/RsrcMngrDX12.h>
+#include <Utopia/Render/Shader.h>
+
+#include <algorithm>
+
+using namespace Ubpa::Utopia;
+
+ShaderCBMngrDX12::~ShaderCBMngrDX12() {
+	for (auto [shaderID, buffer] : bufferMap) {
+		delete buffer;
+	}
+}
+
+Ubpa::UDX12::DynamicUploadBuffer* ShaderCBMngrDX12::GetBuffer(const Shader& shader) {
+	auto target = bufferMap.find(shader.GetInstanceID());
+	if (target != bufferMap.end())
+		return target->second;
+
+	auto rst = bufferMap.emplace_hint(
+		target,
+		shader.GetInstanceID(),
+		new UDX12::DynamicUploadBuffer{ device }
+	);
+	return rst->second;
+}
+
+
+Ubpa::UDX12::DynamicUploadBuffer* ShaderCBMngrDX12::GetCommonBuffer() {
+	size_t ID = static_cast<size_t>(-1);
+	auto target = bufferMap.find(ID);
+	if (target != bufferMap.end())
+		return target->second;
+
+	auto rst = bufferMap.emplace_hint(
+		target,
+		ID,
+		new UDX12::DynamicUploadBuffer{ device }
+	);
+	return rst->second;
+}
+
+Ubpa::UDX12::DynamicUploadBuffer* ShaderCBMngrDX12::GetObjectBuffer() {
+	size_t ID = static_cast<size_t>(-2);
+	auto target = bufferMap.find(ID);
+	if (target != bufferMap.end())
+		return target->second;
+
+	auto rst = bufferMap.emplace_hint(
+		target,
+		ID,
+		new UDX12::DynamicUploadBuffer{ device }
+	);
+	return rst->second;
+}
+
+const ShaderCBLayout& ShaderCBMngrDX12::GetLayout(const Shader& shader, const std::set<std::string_view>& commonCBs) {
+	auto& entries = layoutMap[shader.GetInstanceID()];
+	for (const auto& entry : entries) {
+		if (std::equal(entry.commonCBs.begin(), entry.commonCBs.end(), commonCBs.begin(), commonCBs.end()))
+			return entry.layout;
+	}
+
+	auto& entry = entries.emplace_back();
+	entry.commonCBs.insert(commonCBs.begin(), commonCBs.end());
+	entry.layout = ShaderCBLayout{ RsrcMngrDX12::Instance().GetShaderCBRefl(shader), commonCBs };
+	return entry.layout;
+}
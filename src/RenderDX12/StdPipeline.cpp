@@ -9,21 +9,16 @@
 #include <Utopia/Render/HLSLFile.h>
 #include <Utopia/Render/Shader.h>
 #include <Utopia/Render/Mesh.h>
-#include <Utopia/Render/RenderQueue.h>
+#include <Utopia/Render/PipelineCore.h>
+#include <Utopia/Render/DrawStream.h>
+#include <Utopia/Render/FrameGraphCache.h>
+#include <Utopia/Render/StdFrameGraph.h>
 
 #include <Utopia/Asset/AssetMngr.h>
 
 #include <Utopia/Core/Image.h>
-#include <Utopia/Render/Components/Camera.h>
-#include <Utopia/Render/Components/MeshFilter.h>
-#include <Utopia/Render/Components/MeshRenderer.h>
 #include <Utopia/Render/Components/Skybox.h>
-#include <Utopia/Render/Components/Light.h>
-#include <Utopia/Core/GameTimer.h>
-
-#include <Utopia/Core/Components/LocalToWorld.h>
-#include <Utopia/Core/Components/Translation.h>
-#include <Utopia/Core/Components/WorldToLocal.h>
+#include <Utopia/Core/Profiler.h>
 
 #include <UECS/World.h>
 
@@ -33,6 +28,9 @@
 
 #include <UDX12/FrameResourceMngr.h>
 
+#include <algorithm>
+#include <cstring>
+
 using namespace Ubpa::Utopia;
 using namespace Ubpa::UECS;
 using namespace Ubpa;
@@ -59,71 +57,7 @@ struct StdPipeline::Impl {
 	size_t ID_PSO_irradiance;
 	size_t ID_PSO_prefilter;
 
-	struct ObjectConstants {
-		transformf World;
-		transformf InvWorld;
-	};
-	struct CameraConstants {
-		transformf View;
-
-		transformf InvView;
-
-		transformf Proj;
-
-		transformf InvProj;
-
-		transformf ViewProj;
-
-		transformf InvViewProj;
-
-		pointf3 EyePosW;
-		float _pad0;
-
-		valf2 RenderTargetSize;
-		valf2 InvRenderTargetSize;
-
-		float NearZ;
-		float FarZ;
-		float TotalTime;
-		float DeltaTime;
-
-	};
-
-	struct ShaderLight {
-		rgbf color;
-		float range;
-		vecf3 dir;
-		float f0;
-		pointf3 position;
-		float f1;
-		vecf3 horizontal;
-		float f2;
-
-		struct Spot {
-			static constexpr auto pCosHalfInnerSpotAngle  = &ShaderLight::f0;
-			static constexpr auto pCosHalfOuterSpotAngle = &ShaderLight::f1;
-		};
-		struct Rect {
-			static constexpr auto pWidth  = &ShaderLight::f0;
-			static constexpr auto pHeight = &ShaderLight::f1;
-		};
-		struct Disk {
-			static constexpr auto pRadius = &ShaderLight::f0;
-		};
-	};
-	struct LightArray {
-		static constexpr size_t size = 16;
-
-		UINT diectionalLightNum{ 0 };
-		UINT pointLightNum{ 0 };
-		UINT spotLightNum{ 0 };
-		UINT rectLightNum{ 0 };
-		UINT diskLightNum{ 0 };
-		const UINT _g_cbLightArray_pad0{ static_cast<UINT>(-1) };
-		const UINT _g_cbLightArray_pad1{ static_cast<UINT>(-1) };
-		const UINT _g_cbLightArray_pad2{ static_cast<UINT>(-1) };
-		ShaderLight lights[size];
-	};
+	using ObjectConstants = PipelineCore::ObjectConstants;
 
 	struct QuadPositionLs {
 		valf4 positionL4x;
@@ -157,34 +91,42 @@ struct StdPipeline::Impl {
 	UDX12::DescriptorHeapAllocation defaultIBLSRVDH; // 3
 
 	struct RenderContext {
-		RenderQueue renderQueue;
-
-		CameraConstants cameraConstants;
-
 		std::unordered_map<size_t, PipelineBase::ShaderCBDesc> shaderCBDescMap; // shader ID -> desc
 
 		D3D12_GPU_DESCRIPTOR_HANDLE skybox;
-		LightArray lights;
-
-		// common
-		size_t cameraOffset = 0;
-		size_t lightOffset = UDX12::Util::CalcConstantBufferByteSize(sizeof(CameraConstants));
-		size_t objectOffset = UDX12::Util::CalcConstantBufferByteSize(sizeof(CameraConstants))
-			+ UDX12::Util::CalcConstantBufferByteSize(sizeof(LightArray));
-		struct EntityData {
-			valf<16> l2w;
-			valf<16> w2l;
+
+		// root bindings of the materials in the queue, resolved once per frame
+		struct MaterialBindings {
+			std::vector<RootBinding> bindings;
+			// patched per draw, -1 if the shader doesn't use it
+			size_t objectCB{ static_cast<size_t>(-1) };
+			size_t instances{ static_cast<size_t>(-1) };
+		};
+		std::unordered_map<size_t, MaterialBindings> materialBindings; // material ID -> bindings
+
+		// compiled on the first DrawObjects of the light mode in the frame
+		struct CompiledDrawStream {
+			bool valid{ false };
+			size_t rtNum{ 0 };
+			DXGI_FORMAT rtFormat{ DXGI_FORMAT_UNKNOWN };
+			DrawStream stream;
 		};
-		std::unordered_map<size_t, EntityData> entity2data;
-		std::unordered_map<size_t, size_t> entity2offset;
+		std::map<std::string, CompiledDrawStream, std::less<>> drawStreams; // light mode -> stream
 	};
 
 	const InitDesc initDesc;
 
+	PipelineCore core{ initDesc.numFrame };
+
 	static constexpr char StdPipeline_cbPerObject[] = "StdPipeline_cbPerObject";
 	static constexpr char StdPipeline_cbPerCamera[] = "StdPipeline_cbPerCamera";
 	static constexpr char StdPipeline_cbLightArray[] = "StdPipeline_cbLightArray";
 	static constexpr char StdPipeline_srvIBL[] = "StdPipeline_IrradianceMap";
+	static constexpr char StdPipeline_srvObjects[] = "StdPipeline_srvObjects";
+	static constexpr char StdPipeline_srvInstances[] = "StdPipeline_srvInstances";
+	static constexpr char StdPipeline_srvClusterLights[] = "StdPipeline_srvClusterLights";
+	static constexpr char StdPipeline_srvLightClusters[] = "StdPipeline_srvLightClusters";
+	static constexpr char StdPipeline_srvClusterLightIndices[] = "StdPipeline_srvClusterLightIndices";
 
 	const std::set<std::string_view> commonCBs{
 		StdPipeline_cbPerObject,
@@ -200,6 +142,9 @@ struct StdPipeline::Impl {
 	UDX12::FG::Executor fgExecutor;
 	UFG::Compiler fgCompiler;
 	UFG::FrameGraph fg;
+	// the graph is rebuilt every frame, the compiled result is reused while the topology is unchanged
+	FrameGraphTopology fgTopology;
+	FrameGraphCache<UFG::Compiler::Result> fgCache;
 
 	std::shared_ptr<Shader> deferLightingShader;
 	std::shared_ptr<Shader> skyboxShader;
@@ -237,9 +182,20 @@ struct StdPipeline::Impl {
 	};
 	std::unordered_map<PartialPSODesc, size_t, PartialPSODescHasher> PSOIDMap;
 
+	// per shader, resolved from the reflection once
+	struct ShaderDrawInfo {
+		ID3D12RootSignature* rootSignature;
+		std::vector<PipelineBase::RootBindingSlot> slots;
+		std::vector<std::string> lightModes; // pass index -> "LightMode" tag, empty if none
+	};
+	std::unordered_map<size_t, ShaderDrawInfo> shaderDrawInfos; // shader ID -> info
+	const ShaderDrawInfo& GetShaderDrawInfo(const Shader& shader);
+
 	void UpdateRenderContext(const std::vector<const UECS::World*>& worlds, const ResizeData& resizeData, const CameraData& cameraData);
 	void UpdateShaderCBs();
 	void Render(const ResizeData& resizeData, ID3D12Resource* rtb);
+	const DrawStream& GetDrawStream(std::string_view lightMode, size_t rtNum, DXGI_FORMAT rtFormat);
+	void CompileDrawStream(DrawStream& stream, std::string_view lightMode, size_t rtNum, DXGI_FORMAT rtFormat);
 	void DrawObjects(ID3D12GraphicsCommandList*, std::string_view lightMode, size_t rtNum, DXGI_FORMAT rtFormat);
 };
 
@@ -493,12 +449,18 @@ size_t StdPipeline::Impl::GetPSO_ID(const Shader& shader, size_t passIdx, const
 
 	auto target = PSOIDMap.find(partPsoDesc);
 	if (target == PSOIDMap.end()) {
+		const auto* vs = mesh.GetVertexCompression() == VertexCompression::Compact
+			? RsrcMngrDX12::Instance().GetShaderByteCode_vs_Compact(shader, passIdx)
+			: RsrcMngrDX12::Instance().GetShaderByteCode_vs(shader, passIdx);
+		if (!vs)
+			return static_cast<size_t>(-1);
+
 		const auto& layout = MeshLayoutMngr::Instance().GetMeshLayoutValue(layoutID);
 
 		auto desc = UDX12::Desc::PSO::MRT(
 			RsrcMngrDX12::Instance().GetShaderRootSignature(shader),
 			layout.data(), (UINT)layout.size(),
-			RsrcMngrDX12::Instance().GetShaderByteCode_vs(shader, passIdx),
+			vs,
 			RsrcMngrDX12::Instance().GetShaderByteCode_ps(shader, passIdx),
 			(UINT)rtNum,
 			rtFormat,
@@ -517,213 +479,11 @@ void StdPipeline::Impl::UpdateRenderContext(
 	const ResizeData& resizeData,
 	const CameraData& cameraData
 ) {
-	renderContext.renderQueue.Clear();
-	renderContext.entity2data.clear();
-	renderContext.entity2offset.clear();
-	renderContext.shaderCBDescMap.clear();
+	UBPA_UTOPIA_PROFILE_SCOPE("StdPipeline::UpdateRenderContext");
 
-	{ // camera
-		auto cmptCamera = cameraData.world.entityMngr.Get<Camera>(cameraData.entity);
-		auto cmptW2L = cameraData.world.entityMngr.Get<WorldToLocal>(cameraData.entity);
-		auto cmptTranslation = cameraData.world.entityMngr.Get<Translation>(cameraData.entity);
-		
-		renderContext.cameraConstants.View = cmptW2L->value;
-		renderContext.cameraConstants.InvView = renderContext.cameraConstants.View.inverse();
-		renderContext.cameraConstants.Proj = cmptCamera->prjectionMatrix;
-		renderContext.cameraConstants.InvProj = renderContext.cameraConstants.Proj.inverse();
-		renderContext.cameraConstants.ViewProj = renderContext.cameraConstants.Proj * renderContext.cameraConstants.View;
-		renderContext.cameraConstants.InvViewProj = renderContext.cameraConstants.InvView * renderContext.cameraConstants.InvProj;
-		renderContext.cameraConstants.EyePosW = cmptTranslation->value.as<pointf3>();
-		renderContext.cameraConstants.RenderTargetSize = { resizeData.width, resizeData.height };
-		renderContext.cameraConstants.InvRenderTargetSize = { 1.0f / resizeData.width, 1.0f / resizeData.height };
-
-		renderContext.cameraConstants.NearZ = cmptCamera->clippingPlaneMin;
-		renderContext.cameraConstants.FarZ = cmptCamera->clippingPlaneMax;
-		renderContext.cameraConstants.TotalTime = GameTimer::Instance().TotalTime();
-		renderContext.cameraConstants.DeltaTime = GameTimer::Instance().DeltaTime();
-	}
+	renderContext.shaderCBDescMap.clear();
 
-	{ // object
-		ArchetypeFilter filter;
-		filter.all = {
-			CmptAccessType::Of<Latest<MeshFilter>>,
-			CmptAccessType::Of<Latest<MeshRenderer>>,
-			CmptAccessType::Of<Latest<LocalToWorld>>,
-		};
-		for (auto world : worlds) {
-			world->RunChunkJob(
-				[&](ChunkView chunk) {
-					auto meshFilters = chunk.GetCmptArray<MeshFilter>();
-					auto meshRenderers = chunk.GetCmptArray<MeshRenderer>();
-					auto L2Ws = chunk.GetCmptArray<LocalToWorld>();
-					auto W2Ls = chunk.GetCmptArray<WorldToLocal>();
-					auto entities = chunk.GetEntityArray();
-
-					size_t N = chunk.EntityNum();
-
-					for (size_t i = 0; i < N; i++) {
-						auto meshFilter = meshFilters[i];
-						auto meshRenderer = meshRenderers[i];
-
-						if (!meshFilter.mesh)
-							return;
-
-						RenderObject obj;
-						obj.mesh = meshFilter.mesh;
-						obj.entity = entities[i];
-
-						size_t M = std::min(meshRenderer.materials.size(), obj.mesh->GetSubMeshes().size());
-
-						if(M == 0)
-							continue;
-
-						bool isDraw = false;
-
-						for (size_t j = 0; j < M; j++) {
-							auto material = meshRenderer.materials[j];
-							if (!material || !material->shader)
-								continue;
-							if (material->shader->passes.empty())
-								continue;
-
-							obj.material = material;
-							obj.translation = L2Ws[i].value.decompose_translation();
-							obj.submeshIdx = j;
-
-							for (size_t k = 0; k < obj.material->shader->passes.size(); k++) {
-								obj.passIdx = k;
-								renderContext.renderQueue.Add(obj);
-							}
-							isDraw = true;
-						}
-
-						if(!isDraw)
-							continue;
-
-						auto target = renderContext.entity2data.find(obj.entity.Idx());
-						if (target != renderContext.entity2data.end())
-							continue;
-						RenderContext::EntityData data;
-						data.l2w = L2Ws[i].value;
-						data.w2l = W2Ls ? W2Ls[i].value : L2Ws[i].value.inverse();
-						renderContext.entity2data.emplace_hint(target, std::pair{ obj.entity.Idx(), data });
-					}
-				},
-				filter,
-				false
-			);
-		}
-		renderContext.renderQueue.Sort(renderContext.cameraConstants.EyePosW);
-	}
-
-	{ // light
-		std::array<ShaderLight, LightArray::size> dirLights;
-		std::array<ShaderLight, LightArray::size> pointLights;
-		std::array<ShaderLight, LightArray::size> spotLights;
-		std::array<ShaderLight, LightArray::size> rectLights;
-		std::array<ShaderLight, LightArray::size> diskLights;
-		renderContext.lights.diectionalLightNum = 0;
-		renderContext.lights.pointLightNum = 0;
-		renderContext.lights.spotLightNum = 0;
-		renderContext.lights.rectLightNum = 0;
-		renderContext.lights.diskLightNum = 0;
-
-		for (auto world : worlds) {
-			world->RunEntityJob(
-				[&](const Light* light) {
-					switch (light->type)
-					{
-					case LightType::Directional:
-						renderContext.lights.diectionalLightNum++;
-						break;
-					case LightType::Point:
-						renderContext.lights.pointLightNum++;
-						break;
-					case LightType::Spot:
-						renderContext.lights.spotLightNum++;
-						break;
-					case LightType::Rect:
-						renderContext.lights.rectLightNum++;
-						break;
-					case LightType::Disk:
-						renderContext.lights.diskLightNum++;
-						break;
-					default:
-						assert("not support" && false);
-						break;
-					}
-				},
-				false
-			);
-		}
-		
-		size_t offset_diectionalLight = 0;
-		size_t offset_pointLight = offset_diectionalLight + renderContext.lights.diectionalLightNum;
-		size_t offset_spotLight = offset_pointLight + renderContext.lights.pointLightNum;
-		size_t offset_rectLight = offset_spotLight + renderContext.lights.spotLightNum;
-		size_t offset_diskLight = offset_rectLight + renderContext.lights.rectLightNum;
-		size_t cur_diectionalLight = 0;
-		size_t cur_pointLight = 0;
-		size_t cur_spotLight = 0;
-		size_t cur_rectLight = 0;
-		size_t cur_diskLight = 0;
-		for (auto world : worlds) {
-			world->RunEntityJob(
-				[&](const Light* light, const LocalToWorld* l2w) {
-					switch (light->type)
-					{
-					case LightType::Directional:
-						renderContext.lights.lights[cur_diectionalLight].color = light->color * light->intensity;
-						renderContext.lights.lights[cur_diectionalLight].dir = (l2w->value * vecf3{ 0,0,1 }).normalize();
-						cur_diectionalLight++;
-						break;
-					case LightType::Point:
-						renderContext.lights.lights[cur_pointLight].color = light->color * light->intensity;
-						renderContext.lights.lights[cur_pointLight].position = l2w->value * pointf3{ 0.f };
-						renderContext.lights.lights[cur_pointLight].range = light->range;
-						cur_pointLight++;
-						break;
-					case LightType::Spot:
-						renderContext.lights.lights[cur_spotLight].color = light->color * light->intensity;
-						renderContext.lights.lights[cur_spotLight].position = l2w->value * pointf3{ 0.f };
-						renderContext.lights.lights[cur_spotLight].dir = (l2w->value * vecf3{ 0,0,1 }).normalize();
-						renderContext.lights.lights[cur_spotLight].range = light->range;
-						renderContext.lights.lights[cur_spotLight].*
-							ShaderLight::Spot::pCosHalfInnerSpotAngle = std::cos(to_radian(light->innerSpotAngle) / 2.f);
-						renderContext.lights.lights[cur_spotLight].*
-							ShaderLight::Spot::pCosHalfOuterSpotAngle = std::cos(to_radian(light->outerSpotAngle) / 2.f);
-						cur_spotLight++;
-						break;
-					case LightType::Rect:
-						renderContext.lights.lights[cur_rectLight].color = light->color * light->intensity;
-						renderContext.lights.lights[cur_rectLight].position = l2w->value * pointf3{ 0.f };
-						renderContext.lights.lights[cur_rectLight].dir = (l2w->value * vecf3{ 0,0,1 }).normalize();
-						renderContext.lights.lights[cur_rectLight].horizontal = (l2w->value * vecf3{ 1,0,0 }).normalize();
-						renderContext.lights.lights[cur_rectLight].range = light->range;
-						renderContext.lights.lights[cur_rectLight].*
-							ShaderLight::Rect::pWidth = light->width;
-						renderContext.lights.lights[cur_rectLight].*
-							ShaderLight::Rect::pHeight = light->height;
-						cur_rectLight++;
-						break;
-					case LightType::Disk:
-						renderContext.lights.lights[cur_diskLight].color = light->color * light->intensity;
-						renderContext.lights.lights[cur_diskLight].position = l2w->value * pointf3{ 0.f };
-						renderContext.lights.lights[cur_diskLight].dir = (l2w->value * vecf3{ 0,0,1 }).normalize();
-						renderContext.lights.lights[cur_diskLight].range = light->range;
-						renderContext.lights.lights[cur_diskLight].*
-							ShaderLight::Disk::pRadius = light->radius;
-						cur_diskLight++;
-						break;
-					default:
-						break;
-					}
-				},
-				false
-			);
-		}
-		
-	}
+	core.Extract(worlds, cameraData, resizeData.width, resizeData.height);
 
 	// use first skybox in the world vector
 	renderContext.skybox = defaultSkybox;
@@ -742,38 +502,38 @@ void StdPipeline::Impl::UpdateRenderContext(
 }
 
 void StdPipeline::Impl::UpdateShaderCBs() {
+	UBPA_UTOPIA_PROFILE_SCOPE("StdPipeline::UpdateShaderCBs");
+
 	auto& shaderCBMngr = frameRsrcMngr.GetCurrentFrameResource()
 		->GetResource<ShaderCBMngrDX12>("ShaderCBMngrDX12");
 
-	{ // camera, lights, objects
+	{ // camera, lights, instances, light clusters
 		auto buffer = shaderCBMngr.GetCommonBuffer();
-		buffer->FastReserve(
-			UDX12::Util::CalcConstantBufferByteSize(sizeof(CameraConstants))
-			+ UDX12::Util::CalcConstantBufferByteSize(sizeof(LightArray))
-			+ renderContext.entity2data.size() * UDX12::Util::CalcConstantBufferByteSize(sizeof(ObjectConstants))
-		);
+		buffer->FastReserve(core.LayoutCommonBuffer());
+		core.UploadCommonBuffer([&](size_t offset, const void* data, size_t size) {
+			buffer->Set(offset, data, size);
+		});
+	}
 
-		buffer->Set(renderContext.cameraOffset, &renderContext.cameraConstants, sizeof(CameraConstants));
+	{ // objects, only the dirty slots
+		UBPA_UTOPIA_PROFILE_SCOPE("StdPipeline::UpdateObjects");
 
-		// light array
-		buffer->Set(renderContext.lightOffset, &renderContext.lights, sizeof(LightArray));
+		const size_t stride = UDX12::Util::CalcConstantBufferByteSize(sizeof(ObjectConstants));
 
-		// objects
-		size_t offset = renderContext.objectOffset;
-		for (auto& [idx, data] : renderContext.entity2data) {
-			ObjectConstants objectConstants;
-			objectConstants.World = data.l2w;
-			objectConstants.InvWorld = data.w2l;
-			renderContext.entity2offset[idx] = offset;
-			buffer->Set(offset, &objectConstants, sizeof(ObjectConstants));
-			offset += UDX12::Util::CalcConstantBufferByteSize(sizeof(ObjectConstants));
-		}
+		auto buffer = shaderCBMngr.GetObjectBuffer();
+		// keep the content
+		buffer->Reserve(std::max<size_t>(core.GetObjectCapacity(), 1) * stride);
+		core.UploadObjects(stride, [&](size_t offset, const void* data, size_t size) {
+			buffer->Set(offset, data, size);
+		});
+
+		UBPA_UTOPIA_PROFILE_COUNTER("uploaded objects", core.GetUploadedObjectNum());
 	}
 	
 	// TODO
 	std::unordered_set<const Material*> materials;
 	std::shared_ptr<const Shader> shader;
-	const auto& opaques = renderContext.renderQueue.GetOpaques();
+	const auto& opaques = core.renderQueue.GetOpaques();
 	auto AddOpaque = [&](size_t& index) {
 		if (opaques.size() == index)
 			return false;
@@ -785,15 +545,15 @@ void StdPipeline::Impl::UpdateShaderCBs() {
 		else if (shader != object.material->shader)
 			return false;
 
-		materials.insert(object.material.get());
+		materials.insert(object.material);
 		index++;
 
 		return true;
 	};
 
 	std::unordered_map<const Shader*, std::unordered_set<const Material*>> transparentMaterialMap;
-	for (const auto& transparent : renderContext.renderQueue.GetTransparents())
-		transparentMaterialMap[transparent.material->shader.get()].insert(transparent.material.get());
+	for (const auto& transparent : core.renderQueue.GetTransparents())
+		transparentMaterialMap[transparent.material->shader.get()].insert(transparent.material);
 
 	auto Commit = [&]() {
 		if (shader == nullptr)
@@ -822,9 +582,16 @@ void StdPipeline::Impl::UpdateShaderCBs() {
 		renderContext.shaderCBDescMap[shader->GetInstanceID()] =
 			PipelineBase::UpdateShaderCBs(shaderCBMngr, *shader, materials, commonCBs);
 	}
+
+	// the addresses changed, recompile the draw streams
+	renderContext.materialBindings.clear();
+	for (auto& [lightMode, compiled] : renderContext.drawStreams)
+		compiled.valid = false;
 }
 
 void StdPipeline::Impl::Render(const ResizeData& resizeData, ID3D12Resource* rtb) {
+	UBPA_UTOPIA_PROFILE_SCOPE("StdPipeline::Render");
+
 	size_t width = resizeData.width;
 	size_t height = resizeData.height;
 
@@ -832,56 +599,29 @@ void StdPipeline::Impl::Render(const ResizeData& resizeData, ID3D12Resource* rtb
 		->GetResource<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>("CommandAllocator");
 	cmdAlloc->Reset();
 
-	fg.Clear();
 	auto fgRsrcMngr = frameRsrcMngr.GetCurrentFrameResource()
 		->GetResource<std::shared_ptr<UDX12::FG::RsrcMngr>>("FrameGraphRsrcMngr");
 	fgRsrcMngr->NewFrame();
 	fgExecutor.NewFrame();;
 
-	auto gbuffer0 = fg.RegisterResourceNode("GBuffer0");
-	auto gbuffer1 = fg.RegisterResourceNode("GBuffer1");
-	auto gbuffer2 = fg.RegisterResourceNode("GBuffer2");
-	auto deferLightedRT = fg.RegisterResourceNode("Defer Lighted");
-	auto deferLightedSkyRT = fg.RegisterResourceNode("Defer Lighted with Sky");
-	auto sceneRT = fg.RegisterResourceNode("Scene");
-	auto presentedRT = fg.RegisterResourceNode("Present");
-	fg.RegisterMoveNode(deferLightedSkyRT, deferLightedRT);
-	fg.RegisterMoveNode(sceneRT, deferLightedSkyRT);
-	auto deferDS = fg.RegisterResourceNode("Defer Depth Stencil");
-	auto forwardDS = fg.RegisterResourceNode("Forward Depth Stencil");
-	fg.RegisterMoveNode(forwardDS, deferDS);
-	auto irradianceMap = fg.RegisterResourceNode("Irradiance Map");
-	auto prefilterMap = fg.RegisterResourceNode("PreFilter Map");
-	auto gbPass = fg.RegisterPassNode(
-		"GBuffer Pass",
-		{},
-		{ gbuffer0,gbuffer1,gbuffer2,deferDS }
-	);
-	auto iblPass = fg.RegisterPassNode(
-		"IBL",
-		{ },
-		{ irradianceMap, prefilterMap }
-	);
-	auto deferLightingPass = fg.RegisterPassNode(
-		"Defer Lighting",
-		{ gbuffer0,gbuffer1,gbuffer2,deferDS,irradianceMap,prefilterMap },
-		{ deferLightedRT }
-	);
-	auto skyboxPass = fg.RegisterPassNode(
-		"Skybox",
-		{ deferDS },
-		{ deferLightedSkyRT }
-	);
-	auto forwardPass = fg.RegisterPassNode(
-		"Forward",
-		{ irradianceMap,prefilterMap },
-		{ forwardDS, sceneRT }
-	);
-	auto postprocessPass = fg.RegisterPassNode(
-		"Post Process",
-		{ sceneRT },
-		{ presentedRT }
-	);
+	const auto nodes = StdFrameGraph::Register(fg, fgTopology, width, height);
+	const auto gbuffer0 = nodes.gbuffer0;
+	const auto gbuffer1 = nodes.gbuffer1;
+	const auto gbuffer2 = nodes.gbuffer2;
+	const auto deferLightedRT = nodes.deferLightedRT;
+	const auto deferLightedSkyRT = nodes.deferLightedSkyRT;
+	const auto sceneRT = nodes.sceneRT;
+	const auto presentedRT = nodes.presentedRT;
+	const auto deferDS = nodes.deferDS;
+	const auto forwardDS = nodes.forwardDS;
+	const auto irradianceMap = nodes.irradianceMap;
+	const auto prefilterMap = nodes.prefilterMap;
+	const auto gbPass = nodes.gbPass;
+	const auto iblPass = nodes.iblPass;
+	const auto deferLightingPass = nodes.deferLightingPass;
+	const auto skyboxPass = nodes.skyboxPass;
+	const auto forwardPass = nodes.forwardPass;
+	const auto postprocessPass = nodes.postprocessPass;
 
 	D3D12_RESOURCE_DESC dsDesc = UDX12::Desc::RSRC::Basic(
 		D3D12_RESOURCE_DIMENSION_TEXTURE2D,
@@ -1129,7 +869,7 @@ void StdPipeline::Impl::Render(const ResizeData& resizeData, ID3D12Resource* rtb
 
 			auto cbLights = frameRsrcMngr.GetCurrentFrameResource()
 				->GetResource<ShaderCBMngrDX12>("ShaderCBMngrDX12")
-				.GetCommonBuffer()->GetResource()->GetGPUVirtualAddress() + renderContext.lightOffset;
+				.GetCommonBuffer()->GetResource()->GetGPUVirtualAddress() + core.lightOffset;
 			cmdList->SetGraphicsRootConstantBufferView(3, cbLights);
 
 			auto cbPerCamera = frameRsrcMngr.GetCurrentFrameResource()
@@ -1137,6 +877,11 @@ void StdPipeline::Impl::Render(const ResizeData& resizeData, ID3D12Resource* rtb
 				.GetCommonBuffer()->GetResource();
 			cmdList->SetGraphicsRootConstantBufferView(4, cbPerCamera->GetGPUVirtualAddress());
 
+			// light clusters (point and spot lights)
+			cmdList->SetGraphicsRootShaderResourceView(5, cbPerCamera->GetGPUVirtualAddress() + core.clusterLightOffset);
+			cmdList->SetGraphicsRootShaderResourceView(6, cbPerCamera->GetGPUVirtualAddress() + core.clusterRangeOffset);
+			cmdList->SetGraphicsRootShaderResourceView(7, cbPerCamera->GetGPUVirtualAddress() + core.clusterIndexOffset);
+
 			cmdList->IASetVertexBuffers(0, 0, nullptr);
 			cmdList->IASetIndexBuffer(nullptr);
 			cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -1233,17 +978,65 @@ void StdPipeline::Impl::Render(const ResizeData& resizeData, ID3D12Resource* rtb
 		flag = true;
 	}
 
-	auto [success, crst] = fgCompiler.Compile(fg);
+	const auto* crst = [&]() {
+		UBPA_UTOPIA_PROFILE_SCOPE("StdPipeline::Render::Compile");
+		return fgCache.GetOrCompile(fgTopology.GetHash(), [&]() {
+			return fgCompiler.Compile(fg);
+		});
+	}();
+	UBPA_UTOPIA_PROFILE_COUNTER("frame graph cache hits", fgCache.GetHitNum());
+	UBPA_UTOPIA_PROFILE_COUNTER("frame graph cache misses", fgCache.GetMissNum());
+	assert(crst);
+
+	UBPA_UTOPIA_PROFILE_SCOPE("StdPipeline::Render::Execute");
 	fgExecutor.Execute(
 		initDesc.device,
 		initDesc.cmdQueue,
 		cmdAlloc.Get(),
-		crst,
+		*crst,
 		*fgRsrcMngr
 	);
 }
 
-void StdPipeline::Impl::DrawObjects(ID3D12GraphicsCommandList* cmdList, std::string_view lightMode, size_t rtNum, DXGI_FORMAT rtFormat) {
+const StdPipeline::Impl::ShaderDrawInfo& StdPipeline::Impl::GetShaderDrawInfo(const Shader& shader) {
+	auto [target, isNew] = shaderDrawInfos.try_emplace(shader.GetInstanceID());
+	auto& info = target->second;
+	if (!isNew)
+		return info;
+
+	info.rootSignature = RsrcMngrDX12::Instance().GetShaderRootSignature(shader);
+	info.slots = PipelineBase::GetRootBindingSlots(shader);
+	info.lightModes.reserve(shader.passes.size());
+	for (const auto& pass : shader.passes) {
+		if (auto tag = pass.tags.find("LightMode"); tag != pass.tags.end())
+			info.lightModes.push_back(tag->second);
+		else
+			info.lightModes.emplace_back();
+	}
+	return info;
+}
+
+const DrawStream& StdPipeline::Impl::GetDrawStream(std::string_view lightMode, size_t rtNum, DXGI_FORMAT rtFormat) {
+	auto target = renderContext.drawStreams.find(lightMode);
+	if (target == renderContext.drawStreams.end())
+		target = renderContext.drawStreams.emplace(std::string{ lightMode }, RenderContext::CompiledDrawStream{}).first;
+
+	auto& compiled = target->second;
+	if (!compiled.valid || compiled.rtNum != rtNum || compiled.rtFormat != rtFormat) {
+		CompileDrawStream(compiled.stream, lightMode, rtNum, rtFormat);
+		compiled.valid = true;
+		compiled.rtNum = rtNum;
+		compiled.rtFormat = rtFormat;
+	}
+	return compiled.stream;
+}
+
+void StdPipeline::Impl::CompileDrawStream(DrawStream& stream, std::string_view lightMode, size_t rtNum, DXGI_FORMAT rtFormat) {
+	UBPA_UTOPIA_PROFILE_SCOPE("StdPipeline::CompileDrawStream");
+	assert(!lightMode.empty());
+
+	stream.Clear();
+
 	auto& shaderCBMngr = frameRsrcMngr.GetCurrentFrameResource()
 		->GetResource<ShaderCBMngrDX12>("ShaderCBMngrDX12");
 
@@ -1256,63 +1049,155 @@ void StdPipeline::Impl::DrawObjects(ID3D12GraphicsCommandList* cmdList, std::str
 		ibl = iblData->SRVDH.GetGpuHandle();
 	}
 
-	auto commonBuffer = shaderCBMngr.GetCommonBuffer();
-	auto cameraCBAdress = commonBuffer->GetResource()->GetGPUVirtualAddress()
-		+ renderContext.cameraOffset;
-	
-	const Shader* shader{ nullptr };
-	auto Draw = [&](const RenderObject& obj) {
-		const auto& pass = obj.material->shader->passes[obj.passIdx];
+	const auto commonBufferAddress = shaderCBMngr.GetCommonBuffer()->GetResource()->GetGPUVirtualAddress();
 
-		if (auto target = pass.tags.find("LightMode"); target == pass.tags.end() || target->second != lightMode)
-			return;
+	// object CBs are indexed by slot
+	const auto objectBufferAddress = shaderCBMngr.GetObjectBuffer()->GetResource()->GetGPUVirtualAddress();
+	const size_t objectStride = UDX12::Util::CalcConstantBufferByteSize(sizeof(ObjectConstants));
 
-		if (shader != obj.material->shader.get()) {
-			shader = obj.material->shader.get();
-			cmdList->SetGraphicsRootSignature(RsrcMngrDX12::Instance().GetShaderRootSignature(*shader));
+	// per object / per batch addresses are patched in the draws
+	const std::map<std::string_view, D3D12_GPU_VIRTUAL_ADDRESS> commonCBAddresses{
+		{StdPipeline_cbPerObject, 0},
+		{StdPipeline_cbPerCamera, commonBufferAddress + core.cameraOffset},
+		{StdPipeline_cbLightArray, commonBufferAddress + core.lightOffset}
+	};
+	const std::map<std::string_view, D3D12_GPU_DESCRIPTOR_HANDLE> commonSRVs{
+		{StdPipeline_srvIBL, ibl}
+	};
+	// structured buffers, bound if the shader declares them
+	const std::map<std::string_view, D3D12_GPU_VIRTUAL_ADDRESS> commonBufferSRVs{
+		{StdPipeline_srvObjects, objectBufferAddress},
+		{StdPipeline_srvInstances, 0},
+		{StdPipeline_srvClusterLights, commonBufferAddress + core.clusterLightOffset},
+		{StdPipeline_srvLightClusters, commonBufferAddress + core.clusterRangeOffset},
+		{StdPipeline_srvClusterLightIndices, commonBufferAddress + core.clusterIndexOffset}
+	};
+
+	auto GetMaterialBindings = [&](const Material& material, const ShaderDrawInfo& info)
+		-> const RenderContext::MaterialBindings&
+	{
+		auto [target, isNew] = renderContext.materialBindings.try_emplace(material.GetInstanceID());
+		auto& rst = target->second;
+		if (!isNew)
+			return rst;
+
+		PipelineBase::ResolveRootBindings(rst.bindings, info.slots, shaderCBMngr,
+			renderContext.shaderCBDescMap.at(material.shader->GetInstanceID()), material,
+			commonCBAddresses, commonSRVs, commonBufferSRVs);
+
+		for (size_t i = 0; i < info.slots.size(); i++) {
+			const auto& slot = info.slots[i];
+			size_t* index = nullptr;
+			if (slot.name == StdPipeline_cbPerObject)
+				index = &rst.objectCB;
+			else if (slot.name == StdPipeline_srvInstances)
+				index = &rst.instances;
+			else
+				continue;
+
+			for (size_t j = 0; j < rst.bindings.size(); j++) {
+				if (rst.bindings[j].slot == slot.rootParamIndex) {
+					*index = j;
+					break;
+				}
+			}
 		}
+		return rst;
+	};
 
-		auto matBuffer = shaderCBMngr.GetBuffer(*shader);
+	std::vector<RootBinding> bindings;
 
-		const auto& shaderCBDesc = renderContext.shaderCBDescMap.at(shader->GetInstanceID());
+	// objects[batch.first, batch.first + batch.count) share mesh, submesh, material and pass
+	// instanceBase: index of objects[0] in the instance array
+	auto Compile = [&](const RenderObjectList& objects, const InstanceBatch& batch, size_t instanceBase) {
+		const auto& obj = objects[batch.first];
+		const auto& shader = *obj.material->shader;
+		const auto& info = GetShaderDrawInfo(shader);
 
-		auto lightCBAdress = commonBuffer->GetResource()->GetGPUVirtualAddress()
-			+ renderContext.lightOffset;
+		if (info.lightModes[obj.passIdx] != lightMode)
+			return;
 
-		auto& meshGPUBuffer = RsrcMngrDX12::Instance().GetMeshGPUBuffer(*obj.mesh);
-		const auto& submesh = obj.mesh->GetSubMeshes().at(obj.submeshIdx);
-		cmdList->IASetVertexBuffers(0, 1, &meshGPUBuffer.VertexBufferView());
-		cmdList->IASetIndexBuffer(&meshGPUBuffer.IndexBufferView());
-		// submesh.topology
-		cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		const auto& materialBindings = GetMaterialBindings(*obj.material, info);
+		bindings = materialBindings.bindings;
 
-		D3D12_GPU_VIRTUAL_ADDRESS objCBAddress =
-			commonBuffer->GetResource()->GetGPUVirtualAddress()
-			+ renderContext.entity2offset.at(obj.entity.Idx());
+		const auto& pass = shader.passes[obj.passIdx];
+		const auto& submesh = obj.mesh->GetLODSubMeshes(obj.lod).at(obj.submeshIdx);
 
-		StdPipeline::SetGraphicsRoot_CBV_SRV(cmdList, shaderCBMngr, shaderCBDesc, *obj.material,
-			{
-				{StdPipeline_cbPerObject, objCBAddress},
-				{StdPipeline_cbPerCamera, cameraCBAdress},
-				{StdPipeline_cbLightArray, lightCBAdress}
-			},
-			{
-				{StdPipeline_srvIBL, ibl}
-			}
-		);
-		if (shader->passes[obj.passIdx].renderState.stencilState.enable)
-			cmdList->OMSetStencilRef(shader->passes[obj.passIdx].renderState.stencilState.ref);
-		cmdList->SetPipelineState(RsrcMngrDX12::Instance().GetPSO(GetPSO_ID(
-			*shader, obj.passIdx, *obj.mesh, rtNum, rtFormat
-		)));
-		cmdList->DrawIndexedInstanced((UINT)submesh.indexCount, 1, (UINT)submesh.indexStart, (INT)submesh.baseVertex, 0);
+		// the shader can't decode the vertex compression of the mesh
+		const size_t psoID = GetPSO_ID(shader, obj.passIdx, *obj.mesh, rtNum, rtFormat);
+		if (psoID == static_cast<size_t>(-1))
+			return;
+
+		DrawState state;
+		state.rootSignature = reinterpret_cast<uintptr_t>(info.rootSignature);
+		state.pso = reinterpret_cast<uintptr_t>(RsrcMngrDX12::Instance().GetPSO(psoID));
+		state.mesh = reinterpret_cast<uintptr_t>(&RsrcMngrDX12::Instance().GetMeshBufferViews(*obj.mesh));
+		state.stencilEnable = pass.renderState.stencilState.enable;
+		state.stencilRef = pass.renderState.stencilState.ref;
+		state.bindings = bindings.data();
+		state.bindingNum = bindings.size();
+		state.indexCount = (uint32_t)submesh.indexCount;
+		state.startIndex = (uint32_t)submesh.indexStart;
+		state.baseVertex = (int32_t)submesh.baseVertex;
+
+		// the vertex shader declares StdPipeline_srvInstances (see STD_PIPELINE_SRV_INSTANCES)
+		if (materialBindings.instances != static_cast<size_t>(-1)) {
+			bindings[materialBindings.instances].value = commonBufferAddress
+				+ core.instanceOffset
+				+ (instanceBase + batch.first) * sizeof(uint32_t);
+			if (materialBindings.objectCB != static_cast<size_t>(-1))
+				bindings[materialBindings.objectCB].value = objectBufferAddress + obj.objectIdx * objectStride;
+			state.instanceCount = (uint32_t)batch.count;
+			stream.Add(state);
+			return;
+		}
+
+		// fallback: one draw per object
+		for (size_t i = batch.first; i < batch.first + batch.count; i++) {
+			if (materialBindings.objectCB != static_cast<size_t>(-1))
+				bindings[materialBindings.objectCB].value = objectBufferAddress + objects[i].objectIdx * objectStride;
+			stream.Add(state);
+		}
 	};
 
-	for (const auto& obj : renderContext.renderQueue.GetOpaques())
-		Draw(obj);
+	const auto& opaques = core.renderQueue.GetOpaques();
+	for (const auto& batch : core.opaqueBatcher.GetBatches())
+		Compile(opaques, batch, 0);
+
+	const auto& transparents = core.renderQueue.GetTransparents();
+	for (const auto& batch : core.transparentBatcher.GetBatches())
+		Compile(transparents, batch, opaques.size());
 
-	for (const auto& obj : renderContext.renderQueue.GetTransparents())
-		Draw(obj);
+	const auto& stats = stream.GetStats();
+	UBPA_UTOPIA_PROFILE_COUNTER("draw records", stats.draws);
+	UBPA_UTOPIA_PROFILE_COUNTER("skipped root bindings", stats.skippedBindings);
+}
+
+void StdPipeline::Impl::DrawObjects(ID3D12GraphicsCommandList* cmdList, std::string_view lightMode, size_t rtNum, DXGI_FORMAT rtFormat) {
+	UBPA_UTOPIA_PROFILE_SCOPE("StdPipeline::DrawObjects");
+
+	const auto& stream = GetDrawStream(lightMode, rtNum, rtFormat);
+	const auto* bindings = stream.GetBindings().data();
+
+	// submesh.topology
+	cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	for (const auto& record : stream.GetRecords()) {
+		if (record.flags & DrawRecord::SetRootSignature)
+			cmdList->SetGraphicsRootSignature(reinterpret_cast<ID3D12RootSignature*>(static_cast<uintptr_t>(record.rootSignature)));
+		if (record.flags & DrawRecord::SetPSO)
+			cmdList->SetPipelineState(reinterpret_cast<ID3D12PipelineState*>(static_cast<uintptr_t>(record.pso)));
+		if (record.flags & DrawRecord::SetMesh) {
+			const auto& views = *reinterpret_cast<const RsrcMngrDX12::MeshBufferViews*>(static_cast<uintptr_t>(record.mesh));
+			cmdList->IASetVertexBuffers(0, views.vertexBufferNum, views.vertexBuffers.data());
+			cmdList->IASetIndexBuffer(&views.indexBuffer);
+		}
+		if (record.flags & DrawRecord::SetStencilRef)
+			cmdList->OMSetStencilRef(record.stencilRef);
+
+		PipelineBase::SetGraphicsRoot(cmdList, bindings + record.bindingOffset, record.bindingNum);
+		cmdList->DrawIndexedInstanced(record.indexCount, record.instanceCount, record.startIndex, record.baseVertex, 0);
+	}
 }
 
 StdPipeline::StdPipeline(InitDesc initDesc)
@@ -1343,10 +1228,12 @@ void StdPipeline::Render(ID3D12Resource* rt) {
 }
 
 void StdPipeline::EndFrame() {
+	UBPA_UTOPIA_PROFILE_SCOPE("StdPipeline::EndFrame");
 	pImpl->frameRsrcMngr.EndFrame(initDesc.cmdQueue);
 }
 
 void StdPipeline::Impl_Resize() {
+	pImpl->fgCache.Invalidate();
 	for (auto& frsrc : pImpl->frameRsrcMngr.GetFrameResources()) {
 		frsrc->DelayUpdateResource(
 			"FrameGraphRsrcMngr",
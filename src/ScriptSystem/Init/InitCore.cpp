@@ -3,12 +3,16 @@
 #include <Utopia/Core/Components/Components.h>
 
 void Ubpa::Utopia::detail::InitCore(lua_State* L) {
+	ULuaPP::Register<AnimationTarget>(L);
+	ULuaPP::Register<Animator>(L);
 	ULuaPP::Register<Children>(L);
+	ULuaPP::Register<FixedTime>(L);
 	ULuaPP::Register<Input>(L);
 	ULuaPP::Register<LocalToParent>(L);
 	ULuaPP::Register<LocalToWorld>(L);
 	ULuaPP::Register<Name>(L);
 	ULuaPP::Register<Parent>(L);
+	ULuaPP::Register<PrevLocalToWorld>(L);
 	ULuaPP::Register<Roamer>(L);
 	ULuaPP::Register<Rotation>(L);
 	ULuaPP::Register<RotationEuler>(L);
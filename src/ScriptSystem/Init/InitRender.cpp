@@ -4,8 +4,11 @@
 
 void Ubpa::Utopia::detail::InitRender(lua_State* L) {
 	ULuaPP::Register<Camera>(L);
+	ULuaPP::Register<LODGroup>(L);
 	ULuaPP::Register<Light>(L);
 	ULuaPP::Register<MeshFilter>(L);
 	ULuaPP::Register<MeshRenderer>(L);
+	ULuaPP::Register<Skeleton>(L);
+	ULuaPP::Register<SkinnedMesh>(L);
 	ULuaPP::Register<Skybox>(L);
 }
@@ -3,6 +3,8 @@
 #include <Utopia/ScriptSystem/LuaCtxMngr.h>
 #include <Utopia/ScriptSystem/LuaContext.h>
 
+#include <Utopia/Core/Profiler.h>
+
 using namespace Ubpa::Utopia;
 
 const Ubpa::UECS::SystemFunc* LuaECSAgency::RegisterEntityJob(
@@ -16,12 +18,16 @@ const Ubpa::UECS::SystemFunc* LuaECSAgency::RegisterEntityJob(
 ) {
 	assert(!cmptLocator.CmptAccessTypes().empty());
 	auto bytes = systemFunc.dump();
+	auto zoneName = UBPA_UTOPIA_PROFILE_INTERN(name);
 	auto sysfunc = s->RegisterChunkJob(
-	[bytes = std::move(bytes), cmptLocator = std::move(cmptLocator)]
+	[bytes = std::move(bytes), cmptLocator = std::move(cmptLocator), zoneName]
 	(UECS::World* w, UECS::SingletonsView singletonsView, UECS::ChunkView chunk) {
 		if (chunk.EntityNum() == 0)
 			return;
 
+		UBPA_UTOPIA_PROFILE_SCOPE(zoneName);
+		UBPA_UTOPIA_PROFILE_COUNTER("entities", chunk.EntityNum());
+
 		auto luaCtx = LuaCtxMngr::Instance().GetContext(w);
 		auto L = luaCtx->Request();
 		{
@@ -68,8 +74,10 @@ const Ubpa::UECS::SystemFunc* LuaECSAgency::RegisterChunkJob(
 	bool isParallel
 ) {
 	auto bytes = systemFunc.dump();
+	auto zoneName = UBPA_UTOPIA_PROFILE_INTERN(name);
 	auto sysfunc = s->RegisterChunkJob(
-		[bytes](UECS::World* w, UECS::SingletonsView singletonsView, size_t entityBeginIndexInQuery, UECS::ChunkView chunk) {
+		[bytes, zoneName](UECS::World* w, UECS::SingletonsView singletonsView, size_t entityBeginIndexInQuery, UECS::ChunkView chunk) {
+			UBPA_UTOPIA_PROFILE_SCOPE(zoneName);
 			auto luaCtx = LuaCtxMngr::Instance().GetContext(w);
 			auto L = luaCtx->Request();
 			{
@@ -91,7 +99,9 @@ const Ubpa::UECS::SystemFunc* LuaECSAgency::RegisterJob(
 	UECS::SingletonLocator singletonLocator
 ) {
 	auto bytes = systemFunc.dump();
-	auto sysfunc = s->RegisterJob([bytes](UECS::World* w, UECS::SingletonsView singletonsView) {
+	auto zoneName = UBPA_UTOPIA_PROFILE_INTERN(name);
+	auto sysfunc = s->RegisterJob([bytes, zoneName](UECS::World* w, UECS::SingletonsView singletonsView) {
+		UBPA_UTOPIA_PROFILE_SCOPE(zoneName);
 		auto luaCtx = LuaCtxMngr::Instance().GetContext(w);
 		auto L = luaCtx->Request();
 		{
@@ -33,10 +33,12 @@ struct AnimateMeshSystem {
 			) {
 				if (time->elapsedTime < 10.f) {
 					if (meshFilter->mesh->IsEditable()) {
-						auto positions = meshFilter->mesh->GetPositions();
-						for (auto& pos : positions)
+						// a brush over a quarter of the vertices, only its range is re-encoded and uploaded
+						const size_t vertexNum = meshFilter->mesh->GetPositions().size();
+						const size_t count = std::max<size_t>(vertexNum / 4, 1);
+						const size_t first = static_cast<size_t>(Ubpa::rand01<float>() * (vertexNum - count));
+						for (auto& pos : meshFilter->mesh->EditPositions(first, count))
 							pos[1] = 0.2f * (Ubpa::rand01<float>() - 0.5f);
-						meshFilter->mesh->SetPositions(positions);
 					}
 				}
 				else
@@ -145,7 +147,7 @@ bool DynamicMeshApp::Initialize()
 	if (!InitDirect3D())
 		return false;
 
-	Ubpa::Utopia::RsrcMngrDX12::Instance().Init(uDevice.raw.Get());
+	Ubpa::Utopia::RsrcMngrDX12::Instance().Init(uDevice.raw.Get(), gNumFrameResources);
 
 	Ubpa::UDX12::DescriptorHeapMngr::Instance().Init(uDevice.raw.Get(), 1024, 1024, 1024, 1024, 1024);
 
@@ -328,7 +328,7 @@ bool ImGUIApp::Initialize()
 	if (!InitDirect3D())
 		return false;
 
-	Ubpa::Utopia::RsrcMngrDX12::Instance().Init(uDevice.raw.Get());
+	Ubpa::Utopia::RsrcMngrDX12::Instance().Init(uDevice.raw.Get(), gNumFrameResources);
 
 	Ubpa::UDX12::DescriptorHeapMngr::Instance().Init(uDevice.raw.Get(), 1024, 1024, 1024, 1024, 1024);
 
@@ -0,0 +1,253 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Asset/AssetMngr.h>
+#include <Utopia/Render/Mesh.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+// binary data of a glTF, the JSON refers to its bytes as buffer 0
+struct GLTFBuilder {
+	vector<uint8_t> bin;
+	string bufferViews;
+	string accessors;
+	size_t viewNum{ 0 };
+	size_t accessorNum{ 0 };
+
+	template<typename T>
+	size_t AddView(const vector<T>& data, size_t stride = 0) {
+		while (bin.size() % 4 != 0)
+			bin.push_back(0);
+		const size_t offset = bin.size();
+		bin.resize(offset + data.size() * sizeof(T));
+		memcpy(bin.data() + offset, data.data(), data.size() * sizeof(T));
+		bufferViews += string(viewNum ? "," : "") + "{\"buffer\":0,\"byteOffset\":" + to_string(offset)
+			+ ",\"byteLength\":" + to_string(data.size() * sizeof(T))
+			+ (stride ? ",\"byteStride\":" + to_string(stride) : string{}) + "}";
+		return viewNum++;
+	}
+
+	size_t AddAccessor(size_t view, size_t offset, int componentType, size_t count, const char* type) {
+		accessors += string(accessorNum ? "," : "") + "{\"bufferView\":" + to_string(view) + ",\"byteOffset\":" + to_string(offset)
+			+ ",\"componentType\":" + to_string(componentType) + ",\"count\":" + to_string(count) + ",\"type\":\"" + type + "\"}";
+		return accessorNum++;
+	}
+
+	string JSON(const string& primitives, const string& uri) const {
+		return "{\"asset\":{\"version\":\"2.0\"},\"meshes\":[{\"primitives\":[" + primitives + "]}],"
+			"\"buffers\":[{" + uri + "\"byteLength\":" + to_string(bin.size()) + "}],"
+			"\"bufferViews\":[" + bufferViews + "],\"accessors\":[" + accessors + "]}";
+	}
+
+	void WriteGLB(const filesystem::path& path, const string& primitives) const {
+		string json = JSON(primitives, "");
+		while (json.size() % 4 != 0)
+			json.push_back(' ');
+		const uint32_t header[3] = { 0x46546C67, 2, static_cast<uint32_t>(12 + 8 + json.size() + 8 + bin.size()) };
+		const uint32_t jsonChunk[2] = { static_cast<uint32_t>(json.size()), 0x4E4F534A };
+		const uint32_t binChunk[2] = { static_cast<uint32_t>(bin.size()), 0x004E4942 };
+		ofstream file(path, ios::binary);
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(jsonChunk), sizeof(jsonChunk));
+		file.write(json.data(), json.size());
+		file.write(reinterpret_cast<const char*>(binChunk), sizeof(binChunk));
+		file.write(reinterpret_cast<const char*>(bin.data()), bin.size());
+	}
+
+	void WriteGLTF(const filesystem::path& path, const string& primitives) const {
+		static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		string base64;
+		for (size_t i = 0; i < bin.size(); i += 3) {
+			uint32_t bits = bin[i] << 16;
+			if (i + 1 < bin.size()) bits |= bin[i + 1] << 8;
+			if (i + 2 < bin.size()) bits |= bin[i + 2];
+			base64 += table[(bits >> 18) & 63];
+			base64 += table[(bits >> 12) & 63];
+			base64 += i + 1 < bin.size() ? table[(bits >> 6) & 63] : '=';
+			base64 += i + 2 < bin.size() ? table[bits & 63] : '=';
+		}
+		ofstream file(path);
+		file << JSON(primitives, "\"uri\":\"data:application/octet-stream;base64," + base64 + "\",");
+	}
+};
+
+// interleaved positions and normals (strided views), 16-bit and 32-bit indices, packed tangents and uv
+static GLTFBuilder BuildScene(string& primitives) {
+	GLTFBuilder builder;
+	// quad in z = 0, triangle in z = 1
+	const vector<float> quad = {
+		0,0,0, 0,0,1,
+		1,0,0, 0,0,1,
+		1,1,0, 0,0,1,
+		0,1,0, 0,0,1,
+	};
+	const vector<uint16_t> quadIndices = { 0, 1, 2, 0, 2, 3 };
+	const vector<float> triangle = { 0,0,1, 1,0,1, 0,1,1 };
+	const vector<float> triangleNormals = { 0,0,1, 0,0,1, 0,0,1 };
+	const vector<uint32_t> triangleIndices = { 0, 1, 2 };
+	vector<float> tangents;
+	vector<float> uv;
+	for (size_t i = 0; i < 7; i++) {
+		tangents.insert(tangents.end(), { 1.f, 0.f, 0.f, -1.f });
+		uv.insert(uv.end(), { 0.5f, 0.25f });
+	}
+
+	const size_t quadView = builder.AddView(quad, 6 * sizeof(float));
+	const size_t quadPositions = builder.AddAccessor(quadView, 0, 5126, 4, "VEC3");
+	const size_t quadNormals = builder.AddAccessor(quadView, 3 * sizeof(float), 5126, 4, "VEC3");
+	const size_t quadIndexView = builder.AddView(quadIndices);
+	const size_t quadIndexAccessor = builder.AddAccessor(quadIndexView, 0, 5123, 6, "SCALAR");
+	const size_t triangleView = builder.AddView(triangle);
+	const size_t trianglePositions = builder.AddAccessor(triangleView, 0, 5126, 3, "VEC3");
+	const size_t triangleNormalView = builder.AddView(triangleNormals);
+	const size_t triangleNormalAccessor = builder.AddAccessor(triangleNormalView, 0, 5126, 3, "VEC3");
+	const size_t triangleIndexView = builder.AddView(triangleIndices);
+	const size_t triangleIndexAccessor = builder.AddAccessor(triangleIndexView, 0, 5125, 3, "SCALAR");
+	const size_t tangentView = builder.AddView(tangents);
+	const size_t quadTangents = builder.AddAccessor(tangentView, 0, 5126, 4, "VEC4");
+	const size_t triangleTangents = builder.AddAccessor(tangentView, 4 * 4 * sizeof(float), 5126, 3, "VEC4");
+	const size_t uvView = builder.AddView(uv);
+	const size_t quadUV = builder.AddAccessor(uvView, 0, 5126, 4, "VEC2");
+	const size_t triangleUV = builder.AddAccessor(uvView, 4 * 2 * sizeof(float), 5126, 3, "VEC2");
+
+	auto Primitive = [](size_t positionAccessor, size_t normalAccessor, size_t tangentAccessor, size_t uvAccessor, size_t indexAccessor) {
+		return "{\"attributes\":{\"POSITION\":" + to_string(positionAccessor) + ",\"NORMAL\":" + to_string(normalAccessor)
+			+ ",\"TANGENT\":" + to_string(tangentAccessor) + ",\"TEXCOORD_0\":" + to_string(uvAccessor) + "},\"indices\":" + to_string(indexAccessor) + "}";
+	};
+	primitives = Primitive(quadPositions, quadNormals, quadTangents, quadUV, quadIndexAccessor)
+		+ "," + Primitive(trianglePositions, triangleNormalAccessor, triangleTangents, triangleUV, triangleIndexAccessor);
+	return builder;
+}
+
+static void CheckScene(const Mesh* mesh, const char* name) {
+	cout << name << endl;
+	Check(mesh != nullptr, "loaded");
+	if (!mesh)
+		return;
+	Check(mesh->GetPositions().size() == 7, "vertex num");
+	Check(mesh->GetSubMeshes().size() == 2, "a submesh per primitive");
+	if (mesh->GetSubMeshes().size() != 2)
+		return;
+	Check(mesh->GetSubMeshes()[0].indexCount == 6 && mesh->GetSubMeshes()[1].indexCount == 3, "index counts");
+
+	// the submeshes keep their triangles
+	auto SumZ = [&](const SubMeshDescriptor& desc) {
+		float z = 0.f;
+		for (size_t i = 0; i < desc.indexCount; i++)
+			z += mesh->GetPositions()[mesh->GetIndices()[desc.indexStart + i] + desc.baseVertex][2];
+		return z;
+	};
+	Check(SumZ(mesh->GetSubMeshes()[0]) == 0.f && SumZ(mesh->GetSubMeshes()[1]) == 3.f, "triangles of the submeshes");
+
+	bool normals = mesh->GetNormals().size() == 7;
+	bool tangents = mesh->GetTangents().size() == 7;
+	bool uv = mesh->GetUV().size() == 7;
+	for (size_t i = 0; i < 7; i++) {
+		normals = normals && mesh->GetNormals()[i][2] == 1.f;
+		// the handedness w is the sign of the tangent
+		tangents = tangents && mesh->GetTangents()[i][0] == -1.f && mesh->GetTangents()[i][1] == 0.f;
+		uv = uv && mesh->GetUV()[i][0] == 0.5f && mesh->GetUV()[i][1] == 0.25f;
+	}
+	Check(normals, "provided normals");
+	Check(tangents, "provided tangents");
+	Check(uv, "provided uv");
+}
+
+int main() {
+	const filesystem::path dir = "../assets/models";
+	if (!filesystem::is_directory(dir))
+		filesystem::create_directories(dir);
+
+	{ // binary and embedded buffers
+		string primitives;
+		GLTFBuilder builder = BuildScene(primitives);
+		builder.WriteGLB(dir / "test_gltf.glb", primitives);
+		builder.WriteGLTF(dir / "test_gltf.gltf", primitives);
+
+		CheckScene(AssetMngr::Instance().LoadAsset<Mesh>(dir / "test_gltf.glb").get(), "glb");
+		CheckScene(AssetMngr::Instance().LoadAsset<Mesh>(dir / "test_gltf.gltf").get(), "gltf");
+		AssetMngr::Instance().Clear();
+	}
+
+	{ // benchmark : the same grid in .glb and .obj
+		constexpr size_t n = 512;
+		vector<float> positions;
+		vector<float> normals;
+		vector<float> uv;
+		vector<uint32_t> indices;
+		for (size_t j = 0; j <= n; j++) {
+			for (size_t i = 0; i <= n; i++) {
+				const float x = i / float(n);
+				const float z = j / float(n);
+				positions.insert(positions.end(), { x, 0.1f * sin(10.f * x) * cos(10.f * z), z });
+				normals.insert(normals.end(), { 0.f, 1.f, 0.f });
+				uv.insert(uv.end(), { x, z });
+			}
+		}
+		for (size_t j = 0; j < n; j++) {
+			for (size_t i = 0; i < n; i++) {
+				const uint32_t v = static_cast<uint32_t>(j * (n + 1) + i);
+				indices.insert(indices.end(), { v, v + static_cast<uint32_t>(n + 1), v + 1, v + 1, v + static_cast<uint32_t>(n + 1), v + static_cast<uint32_t>(n + 2) });
+			}
+		}
+		const size_t vertexNum = (n + 1) * (n + 1);
+
+		GLTFBuilder builder;
+		const size_t p = builder.AddAccessor(builder.AddView(positions), 0, 5126, vertexNum, "VEC3");
+		const size_t nrm = builder.AddAccessor(builder.AddView(normals), 0, 5126, vertexNum, "VEC3");
+		const size_t t = builder.AddAccessor(builder.AddView(uv), 0, 5126, vertexNum, "VEC2");
+		const size_t idx = builder.AddAccessor(builder.AddView(indices), 0, 5125, indices.size(), "SCALAR");
+		builder.WriteGLB(dir / "test_gltf_grid.glb", "{\"attributes\":{\"POSITION\":" + to_string(p) + ",\"NORMAL\":" + to_string(nrm)
+			+ ",\"TEXCOORD_0\":" + to_string(t) + "},\"indices\":" + to_string(idx) + "}");
+
+		{
+			ostringstream obj;
+			for (size_t i = 0; i < vertexNum; i++)
+				obj << "v " << positions[3 * i] << " " << positions[3 * i + 1] << " " << positions[3 * i + 2] << "\n";
+			for (size_t i = 0; i < vertexNum; i++)
+				obj << "vn " << normals[3 * i] << " " << normals[3 * i + 1] << " " << normals[3 * i + 2] << "\n";
+			for (size_t i = 0; i < vertexNum; i++)
+				obj << "vt " << uv[2 * i] << " " << uv[2 * i + 1] << "\n";
+			for (size_t i = 0; i < indices.size(); i += 3) {
+				obj << "f";
+				for (size_t k = 0; k < 3; k++)
+					obj << " " << indices[i + k] + 1 << "/" << indices[i + k] + 1 << "/" << indices[i + k] + 1;
+				obj << "\n";
+			}
+			ofstream(dir / "test_gltf_grid.obj") << obj.str();
+		}
+
+		// the best of 3 loads, the loaded assets are cleared before each
+		auto Load = [&](const char* name) {
+			double best = numeric_limits<double>::max();
+			for (size_t i = 0; i < 3; i++) {
+				AssetMngr::Instance().Clear();
+				const auto begin = chrono::steady_clock::now();
+				auto mesh = AssetMngr::Instance().LoadAsset<Mesh>(dir / name);
+				const auto end = chrono::steady_clock::now();
+				Check(mesh && mesh->GetPositions().size() == vertexNum, "grid vertex num");
+				best = min(best, chrono::duration<double, milli>(end - begin).count());
+			}
+			return best;
+		};
+		const double glb = Load("test_gltf_grid.glb");
+		const double obj = Load("test_gltf_grid.obj");
+		// benchmark, not checked : the buffers are copied instead of parsing text, the mesh building is shared
+		cout << "grid (" << vertexNum << " vertices) : glb " << glb << " ms, obj " << obj << " ms, x" << obj / glb << endl;
+		AssetMngr::Instance().Clear();
+	}
+
+	return CheckResult();
+}
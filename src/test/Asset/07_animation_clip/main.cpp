@@ -0,0 +1,55 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Asset/AssetMngr.h>
+#include <Utopia/Core/AnimationClip.h>
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+int main() {
+	const filesystem::path dir = "../assets/animations";
+	if (!filesystem::is_directory(dir))
+		filesystem::create_directories(dir);
+
+	// track 0 : every channel, track 1 : translations only, track 2 : scales only
+	ofstream(dir / "test_missing_channels.anim") << R"({
+	"sampleRate": 30,
+	"frameNum": 2,
+	"tracks": [
+		{ "translations": [ 1, 2, 3, 1, 2, 4 ], "rotations": [ 0, 0.7071068, 0, 0.7071068 ], "scales": [ 2 ] },
+		{ "translations": [ 5, 6, 7 ] },
+		{ "scales": [ 3, 4 ] }
+	]
+})";
+
+	auto clip = AssetMngr::Instance().LoadAsset<AnimationClip>(dir / "test_missing_channels.anim");
+	Check(clip != nullptr, "loaded");
+	if (!clip)
+		return CheckResult();
+
+	constexpr uint8_t T = GetAnimationChannelBit(AnimationChannel::Translation);
+	constexpr uint8_t R = GetAnimationChannelBit(AnimationChannel::Rotation);
+	constexpr uint8_t S = GetAnimationChannelBit(AnimationChannel::Scale);
+	Check(clip->GetTrackNum() == 3, "track num");
+	Check(clip->GetFrameNum() == 2, "frame num");
+	Check(clip->GetChannelMask(0) == (T | R | S), "channels of track 0");
+	// the channels of the previous track are not reused
+	Check(clip->GetChannelMask(1) == T, "channels of track 1");
+	Check(clip->GetChannelMask(2) == S, "channels of track 2");
+
+	AnimationPose pose;
+	clip->Sample(pose, 0.f, false);
+	Check(pose.translations[1][0] == 5.f && pose.translations[1][1] == 6.f && pose.translations[1][2] == 7.f, "translation of track 1");
+	Check(pose.scales[1] == 1.f, "default scale of track 1");
+	Check(pose.rotations[2][3] == 1.f, "default rotation of track 2");
+	Check(std::abs(pose.scales[2] - 3.f) < 1e-3f, "scale of track 2");
+
+	AssetMngr::Instance().Clear();
+
+	return CheckResult();
+}
@@ -0,0 +1,417 @@
+// headless benchmark of the core systems
+// usage:
+//   01_system_benchmark [--entities N] [--roots N] [--depth N] [--fanout N]
+//                       [--mix T|TR|TRS|TRSE|TRSW...] [--warmup N] [--iterations N]
+//                       [--no-lua] [--out path]
+// - flat entities : <mix> + LocalToWorld
+// - hierarchy     : <roots> trees of <depth> levels, every inner node has <fanout> children
+// - mix           : T(ranslation), R(otation), S(cale), E (RotationEuler), W (WorldToLocal)
+// result is written as JSON (stdout by default)
+
+#include <Utopia/Core/Components/Components.h>
+#include <Utopia/Core/Systems/Systems.h>
+
+#include <Utopia/ScriptSystem/LuaCtxMngr.h>
+#include <Utopia/ScriptSystem/LuaContext.h>
+
+#include <ULuaPP/ULuaPP.h>
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Ubpa::UECS;
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+
+// ============================
+//      allocation counting
+// ============================
+
+namespace {
+	std::atomic<size_t> gAllocCount{ 0 };
+	std::atomic<size_t> gAllocBytes{ 0 };
+}
+
+void* operator new(std::size_t size) {
+	gAllocCount.fetch_add(1, std::memory_order_relaxed);
+	gAllocBytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size == 0 ? 1 : size))
+		return ptr;
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) {
+	return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+// ============================
+//            config
+// ============================
+
+struct Config {
+	size_t entities{ 10000 };
+	size_t roots{ 100 };
+	size_t depth{ 3 };
+	size_t fanout{ 4 };
+	std::string mix{ "TRS" };
+	size_t warmup{ 3 };
+	size_t iterations{ 20 };
+	bool lua{ true };
+	std::string out;
+
+	bool Parse(int argc, char** argv) {
+		for (int i = 1; i < argc; i++) {
+			std::string_view arg = argv[i];
+			auto next = [&]() -> const char* {
+				return i + 1 < argc ? argv[++i] : nullptr;
+			};
+			auto nextSize = [&](size_t& value) {
+				auto str = next();
+				if (!str)
+					return false;
+				value = static_cast<size_t>(std::strtoull(str, nullptr, 10));
+				return true;
+			};
+
+			if (arg == "--entities") { if (!nextSize(entities)) return false; }
+			else if (arg == "--roots") { if (!nextSize(roots)) return false; }
+			else if (arg == "--depth") { if (!nextSize(depth)) return false; }
+			else if (arg == "--fanout") { if (!nextSize(fanout)) return false; }
+			else if (arg == "--warmup") { if (!nextSize(warmup)) return false; }
+			else if (arg == "--iterations") { if (!nextSize(iterations)) return false; }
+			else if (arg == "--mix") { auto str = next(); if (!str) return false; mix = str; }
+			else if (arg == "--out") { auto str = next(); if (!str) return false; out = str; }
+			else if (arg == "--no-lua") lua = false;
+			else
+				return false;
+		}
+		return iterations > 0;
+	}
+
+	bool Has(char c) const noexcept { return mix.find(c) != std::string::npos; }
+};
+
+// ============================
+//         world builder
+// ============================
+
+struct BenchWorld {
+	World w;
+	size_t entityNum{ 0 };
+
+	BenchWorld() {
+		w.entityMngr.cmptTraits.Register<
+			Children,
+			LocalToParent,
+			LocalToWorld,
+			Parent,
+			Rotation,
+			RotationEuler,
+			Scale,
+			Translation,
+			WorldTime,
+			WorldToLocal
+		>();
+	}
+
+	~BenchWorld() {
+		if (LuaCtxMngr::Instance().GetContext(&w))
+			LuaCtxMngr::Instance().Unregister(&w);
+	}
+
+	template<typename... Systems>
+	void Activate() {
+		auto indices = w.systemMngr.Register<Systems...>();
+		for (auto idx : indices)
+			w.systemMngr.Activate(idx);
+	}
+
+	void ActivateLua() {
+		auto ctx = LuaCtxMngr::Instance().Register(&w);
+		sol::state_view lua{ ctx->Main() };
+		lua["world"] = &w;
+		lua.script(R"(
+BenchLuaSystem = function(schedule)
+  local type0 = CmptAccessType.new("Ubpa::Utopia::Translation", AccessMode.WRITE)
+  local f = function(w, singletons, e, idx, cmpts)
+    local translation = Translation.voidp(cmpts:GetCmpt(type0):Ptr())
+    translation.value[1] = translation.value[1] + 1
+  end
+  local cLocator = CmptLocator.new(type0, 1)
+  LuaECSAgency.RegisterEntityJob(
+    schedule,
+    f,
+    "BenchLuaSystem",
+    ArchetypeFilter.new(),
+    cLocator,
+    SingletonLocator.new(),
+    true
+  )
+end
+BenchLuaSystemIdx = world.systemMngr:Register("BenchLuaSystem", BenchLuaSystem)
+world.systemMngr:Activate(BenchLuaSystemIdx)
+)");
+	}
+
+	static std::vector<CmptType> MixTypes(const Config& config) {
+		std::vector<CmptType> types{ CmptType::Of<LocalToWorld> };
+		if (config.Has('T')) types.push_back(CmptType::Of<Translation>);
+		if (config.Has('R') || config.Has('E')) types.push_back(CmptType::Of<Rotation>);
+		if (config.Has('S')) types.push_back(CmptType::Of<Scale>);
+		if (config.Has('E')) types.push_back(CmptType::Of<RotationEuler>);
+		if (config.Has('W')) types.push_back(CmptType::Of<WorldToLocal>);
+		return types;
+	}
+
+	void InitTRS(Entity e, std::mt19937& rng) {
+		std::uniform_real_distribution<float> dist{ -10.f, 10.f };
+		if (auto t = w.entityMngr.Get<Translation>(e))
+			t->value = { dist(rng), dist(rng), dist(rng) };
+		if (auto r = w.entityMngr.Get<RotationEuler>(e))
+			r->value = { dist(rng), dist(rng), dist(rng) };
+		else if (auto r = w.entityMngr.Get<Rotation>(e))
+			r->value = quatf{ vecf3{ 0,1,0 }, to_radian(dist(rng)) };
+		if (auto s = w.entityMngr.Get<Scale>(e))
+			s->value = 1.f + 0.01f * dist(rng);
+	}
+
+	void CreateFlat(const Config& config, std::mt19937& rng) {
+		auto types = MixTypes(config);
+		for (size_t i = 0; i < config.entities; i++) {
+			auto e = w.entityMngr.Create(types.data(), types.size());
+			InitTRS(e, rng);
+		}
+		entityNum += config.entities;
+	}
+
+	Entity CreateNode(const Config& config, std::mt19937& rng, Entity parent, size_t level) {
+		auto types = MixTypes(config);
+		if (parent.Valid()) {
+			types.push_back(CmptType::Of<Parent>);
+			types.push_back(CmptType::Of<LocalToParent>);
+		}
+		bool isLeaf = level + 1 >= config.depth || config.fanout == 0;
+		if (!isLeaf)
+			types.push_back(CmptType::Of<Children>);
+
+		auto e = w.entityMngr.Create(types.data(), types.size());
+		InitTRS(e, rng);
+		entityNum++;
+
+		if (parent.Valid()) {
+			w.entityMngr.Get<Parent>(e)->value = parent;
+			w.entityMngr.Get<Children>(parent)->value.insert(e);
+		}
+
+		if (!isLeaf) {
+			for (size_t i = 0; i < config.fanout; i++)
+				CreateNode(config, rng, e, level + 1);
+		}
+
+		return e;
+	}
+
+	void CreateHierarchy(const Config& config, std::mt19937& rng) {
+		if (config.depth == 0)
+			return;
+		for (size_t i = 0; i < config.roots; i++)
+			CreateNode(config, rng, Entity::Invalid(), 0);
+	}
+};
+
+// ============================
+//            runner
+// ============================
+
+struct Result {
+	std::string name;
+	size_t entityNum{ 0 };
+	std::vector<double> times; // in ms
+	size_t allocCount{ 0 };
+	size_t allocBytes{ 0 };
+};
+
+Result Run(std::string name, BenchWorld& bench, const Config& config) {
+	Result rst;
+	rst.name = std::move(name);
+	rst.entityNum = bench.entityNum;
+
+	for (size_t i = 0; i < config.warmup; i++)
+		bench.w.Update();
+
+	rst.times.reserve(config.iterations);
+	size_t allocCount0 = gAllocCount.load();
+	size_t allocBytes0 = gAllocBytes.load();
+	for (size_t i = 0; i < config.iterations; i++) {
+		auto t0 = std::chrono::steady_clock::now();
+		bench.w.Update();
+		auto t1 = std::chrono::steady_clock::now();
+		rst.times.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+	}
+	rst.allocCount = gAllocCount.load() - allocCount0;
+	rst.allocBytes = gAllocBytes.load() - allocBytes0;
+
+	return rst;
+}
+
+void Dump(std::ostream& os, const Config& config, const std::vector<Result>& results) {
+	os << "{\n";
+	os << "  \"config\": {";
+	os << "\"entities\": " << config.entities << ", ";
+	os << "\"roots\": " << config.roots << ", ";
+	os << "\"depth\": " << config.depth << ", ";
+	os << "\"fanout\": " << config.fanout << ", ";
+	os << "\"mix\": \"" << config.mix << "\", ";
+	os << "\"warmup\": " << config.warmup << ", ";
+	os << "\"iterations\": " << config.iterations << ", ";
+	os << "\"lua\": " << (config.lua ? "true" : "false");
+	os << "},\n";
+	os << "  \"systems\": [\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const auto& r = results[i];
+		auto sorted = r.times;
+		std::sort(sorted.begin(), sorted.end());
+		double sum = 0.;
+		for (auto t : sorted)
+			sum += t;
+		double mean = sum / sorted.size();
+		double median = sorted[sorted.size() / 2];
+		double entitiesPerSecond = mean > 0. ? r.entityNum / (mean / 1000.) : 0.;
+
+		os << "    {";
+		os << "\"name\": \"" << r.name << "\", ";
+		os << "\"entities\": " << r.entityNum << ", ";
+		os << "\"mean_ms\": " << mean << ", ";
+		os << "\"median_ms\": " << median << ", ";
+		os << "\"min_ms\": " << sorted.front() << ", ";
+		os << "\"max_ms\": " << sorted.back() << ", ";
+		os << "\"entities_per_second\": " << entitiesPerSecond << ", ";
+		os << "\"allocs_per_update\": " << double(r.allocCount) / config.iterations << ", ";
+		os << "\"alloc_bytes_per_update\": " << double(r.allocBytes) / config.iterations;
+		os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	os << "  ]\n";
+	os << "}\n";
+}
+
+int main(int argc, char** argv) {
+	Config config;
+	if (!config.Parse(argc, argv)) {
+		std::cerr << "usage: " << argv[0]
+			<< " [--entities N] [--roots N] [--depth N] [--fanout N] [--mix TRSEW]"
+			<< " [--warmup N] [--iterations N] [--no-lua] [--out path]" << std::endl;
+		return 1;
+	}
+
+	std::vector<Result> results;
+
+	// every case builds its own world, so a system only sees the archetypes it runs on
+
+	{
+		BenchWorld bench;
+		std::mt19937 rng{ 0 };
+		bench.CreateFlat(config, rng);
+		bench.Activate<TRSToLocalToWorldSystem>();
+		results.push_back(Run(TRSToLocalToWorldSystem::SystemFuncName, bench, config));
+	}
+
+	{
+		BenchWorld bench;
+		std::mt19937 rng{ 0 };
+		bench.CreateHierarchy(config, rng);
+		bench.Activate<TRSToLocalToParentSystem>();
+		results.push_back(Run(TRSToLocalToParentSystem::SystemFuncName, bench, config));
+	}
+
+	{
+		BenchWorld bench;
+		std::mt19937 rng{ 0 };
+		bench.CreateHierarchy(config, rng);
+		bench.Activate<LocalToParentSystem>();
+		results.push_back(Run(LocalToParentSystem::SystemFuncName, bench, config));
+	}
+
+	{
+		Config w2lConfig = config;
+		w2lConfig.mix += 'W';
+		BenchWorld bench;
+		std::mt19937 rng{ 0 };
+		bench.CreateFlat(w2lConfig, rng);
+		bench.Activate<WorldToLocalSystem>();
+		results.push_back(Run(WorldToLocalSystem::SystemFuncName, bench, config));
+	}
+
+	{
+		Config eulerConfig = config;
+		eulerConfig.mix += 'E';
+		BenchWorld bench;
+		std::mt19937 rng{ 0 };
+		bench.CreateFlat(eulerConfig, rng);
+		bench.Activate<RotationEulerSystem>();
+		results.push_back(Run(RotationEulerSystem::SystemFuncName, bench, config));
+	}
+
+	if (config.lua) {
+		Config luaConfig = config;
+		luaConfig.mix += 'T';
+		BenchWorld bench;
+		std::mt19937 rng{ 0 };
+		bench.CreateFlat(luaConfig, rng);
+		bench.ActivateLua();
+		results.push_back(Run("BenchLuaSystem", bench, config));
+	}
+
+	{ // full world.Update()
+		BenchWorld bench;
+		std::mt19937 rng{ 0 };
+		bench.CreateFlat(config, rng);
+		bench.CreateHierarchy(config, rng);
+		bench.Activate<
+			LocalToParentSystem,
+			RotationEulerSystem,
+			TRSToLocalToParentSystem,
+			TRSToLocalToWorldSystem,
+			WorldToLocalSystem
+		>();
+		if (config.lua)
+			bench.ActivateLua();
+		results.push_back(Run("World::Update", bench, config));
+	}
+
+	if (config.out.empty())
+		Dump(std::cout, config, results);
+	else {
+		std::ofstream ofs{ config.out };
+		Dump(ofs, config, results);
+	}
+
+	LuaCtxMngr::Instance().Clear();
+
+	return 0;
+}
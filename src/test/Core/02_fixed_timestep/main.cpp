@@ -0,0 +1,100 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Core/FixedTimestep.h>
+
+#include <Utopia/Core/Components/Components.h>
+#include <Utopia/Core/Systems/Systems.h>
+
+#include <cmath>
+#include <iostream>
+
+using namespace Ubpa::UECS;
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+struct MoveSystem {
+	static constexpr char SystemFuncName[] = "MoveSystem";
+
+	// 1 unit per second along x
+	static void OnUpdate(Schedule& schedule) {
+		schedule.RegisterEntityJob(
+			[](Translation* t, Latest<Singleton<WorldTime>> time) {
+				t->value[0] += time->deltaTime;
+			},
+			SystemFuncName
+		);
+	}
+};
+
+static bool Near(double a, double b) {
+	return std::abs(a - b) < 1e-4;
+}
+
+int main() {
+	{ // accumulator
+		FixedTimestep timestep{ 50., 4 }; // step: 0.02 s
+
+		Check(timestep.Advance(0.01) == 0, "no step under a step time");
+		Check(Near(timestep.GetAlpha(), 0.5), "alpha of half a step");
+		Check(timestep.Advance(0.03) == 2, "two steps");
+		Check(Near(timestep.GetAlpha(), 0.), "alpha after whole steps");
+
+		// spiral of death: a 1 s hitch runs at most 4 steps
+		Check(timestep.Advance(1.005) == 4, "clamped steps");
+		Check(Near(timestep.GetAlpha(), 0.25), "alpha keeps the fraction");
+		Check(Near(timestep.GetDroppedTime(), 0.92), "dropped time");
+	}
+
+	{ // world
+		World w;
+		w.entityMngr.cmptTraits.Register<
+			FixedTime,
+			LocalToWorld,
+			PrevLocalToWorld,
+			Translation,
+			WorldTime
+		>();
+		auto indices = w.systemMngr.Register<
+			MoveSystem,
+			TRSToLocalToWorldSystem,
+			WorldTimeSystem
+		>();
+		for (auto idx : indices)
+			w.systemMngr.Activate(idx);
+
+		w.entityMngr.Create<WorldTime>();
+		auto [e, t, l2w, prevL2W] = w.entityMngr.Create<Translation, LocalToWorld, PrevLocalToWorld>();
+
+		FixedTimestep timestep{ 10. };
+		size_t num = 0;
+		for (size_t i = 0; i < 25; i++) // 25 frames of 0.01 s
+			num += timestep.Update(w, 0.01);
+
+		Check(num == 2, "steps of world");
+		Check(Near(timestep.GetElapsedTime(), 0.2), "elapsed time");
+
+		auto fixedTime = w.entityMngr.GetSingleton<FixedTime>();
+		Check(fixedTime && Near(fixedTime->alpha, 0.5), "alpha in FixedTime");
+
+		auto curr = w.entityMngr.Get<LocalToWorld>(e)->value;
+		auto prev = w.entityMngr.Get<PrevLocalToWorld>(e)->value;
+		Check(Near(curr.decompose_translation()[0], 0.2), "current position");
+		Check(Near(prev.decompose_translation()[0], 0.1), "previous position");
+
+		auto blend = FixedTimestep::Interpolate(prev, curr, fixedTime ? fixedTime->alpha : 0.f);
+		Check(Near(blend.decompose_translation()[0], 0.15), "interpolated position");
+
+		// a spawned entity starts from its own LocalToWorld, not from the origin
+		auto [spawned, spawnedT, spawnedL2W, spawnedPrevL2W] = w.entityMngr.Create<Translation, LocalToWorld, PrevLocalToWorld>();
+		spawnedT->value = { 5.f, 0.f, 0.f };
+		Check(!spawnedPrevL2W->seeded, "unseeded before a step");
+		Check(timestep.Update(w, 0.06) == 1, "step of the spawned entity");
+		auto spawnedCurr = w.entityMngr.Get<LocalToWorld>(spawned)->value;
+		auto spawnedPrev = w.entityMngr.Get<PrevLocalToWorld>(spawned);
+		Check(spawnedPrev->seeded, "seeded after a step");
+		Check(Near(spawnedPrev->value.decompose_translation()[0], spawnedCurr.decompose_translation()[0]), "seeded position");
+	}
+
+	return CheckResult();
+}
@@ -0,0 +1,270 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Core/AnimationClip.h>
+
+#include <Utopia/Core/Components/Components.h>
+#include <Utopia/Core/Systems/Systems.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace Ubpa::UECS;
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+static bool Near(float a, float b, float error) {
+	return std::abs(a - b) <= error;
+}
+
+static float Distance(const vecf3& a, const vecf3& b) {
+	return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+static float Angle(const quatf& a, const quatf& b) {
+	const float dot = std::abs(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]);
+	return 2.f * std::acos(std::min(dot, 1.f));
+}
+
+static quatf AxisAngle(const vecf3& axis, float angle) {
+	quatf q;
+	q[0] = axis[0] * std::sin(angle / 2.f);
+	q[1] = axis[1] * std::sin(angle / 2.f);
+	q[2] = axis[2] * std::sin(angle / 2.f);
+	q[3] = std::cos(angle / 2.f);
+	return q;
+}
+
+// smooth curves, t in seconds
+static vecf3 TranslationAt(size_t bone, float t) {
+	return { std::sin(t + bone), 0.5f * std::cos(2.f * t), 0.1f * bone };
+}
+
+static quatf RotationAt(size_t bone, float t) {
+	return AxisAngle({ 0.f, 1.f, 0.f }, 1.5f * std::sin(t + 0.3f * bone));
+}
+
+static float ScaleAt(float t) {
+	return 1.f + 0.25f * std::sin(3.f * t);
+}
+
+// bone 0 : every channel animated, bone 1 : constant translation and scale, bone 2 : rotation only
+static vector<AnimationClip::Track> BuildTracks(float sampleRate, size_t frameNum) {
+	vector<AnimationClip::Track> tracks(3);
+	for (size_t f = 0; f < frameNum; f++) {
+		const float t = f / sampleRate;
+		tracks[0].translations.push_back(TranslationAt(0, t));
+		tracks[0].rotations.push_back(RotationAt(0, t));
+		tracks[0].scales.push_back(ScaleAt(t));
+		tracks[1].translations.push_back({ 1.f, 2.f, 3.f });
+		tracks[1].rotations.push_back(RotationAt(1, t));
+		tracks[2].rotations.push_back(RotationAt(2, t));
+	}
+	tracks[1].scales.push_back(2.f);
+	return tracks;
+}
+
+int main() {
+	constexpr float sampleRate = 30.f;
+	constexpr size_t frameNum = 91; // 3 s
+	// 1 mm, 0.1 degree
+	AnimationCompressionSettings settings;
+	settings.translationError = 1e-3f;
+	settings.rotationError = 2e-3f;
+	settings.scaleError = 1e-3f;
+	const auto tracks = BuildTracks(sampleRate, frameNum);
+	const AnimationClip clip{ tracks, sampleRate, frameNum, settings };
+
+	{ // layout
+		constexpr uint8_t T = GetAnimationChannelBit(AnimationChannel::Translation);
+		constexpr uint8_t R = GetAnimationChannelBit(AnimationChannel::Rotation);
+		constexpr uint8_t S = GetAnimationChannelBit(AnimationChannel::Scale);
+		Check(clip.GetTrackNum() == 3, "track num");
+		Check(clip.GetChannelMask(0) == (T | R | S), "channels of track 0");
+		Check(clip.GetChannelMask(2) == R, "channels of track 2");
+		Check(Near(clip.GetDuration(), 3.f, 1e-6f), "duration");
+
+		// 4 animated channels
+		Check(clip.GetKeyNum() < 4 * (frameNum + (frameNum - 1) / settings.segmentFrames), "keys reduced");
+		const size_t rawSize = frameNum * 3 * (3 + 4 + 1) * sizeof(float);
+		Check(clip.GetCompressedSize() * 4 < rawSize, "compressed size");
+	}
+
+	{ // error bound, at the frames and between them
+		AnimationPose pose;
+		float maxT = 0.f;
+		float maxR = 0.f;
+		float maxS = 0.f;
+		for (size_t i = 0; i < 2 * frameNum - 1; i++) {
+			const float t = i / (2.f * sampleRate);
+			clip.Sample(pose, t, false);
+			maxT = std::max(maxT, Distance(pose.translations[0], TranslationAt(0, t)));
+			maxS = std::max(maxS, std::abs(pose.scales[0] - ScaleAt(t)));
+			for (size_t b = 0; b < 3; b++)
+				maxR = std::max(maxR, Angle(pose.rotations[b], RotationAt(b, t)));
+		}
+		// between the frames, the curvature of the source adds to the bound
+		Check(maxT < 2.f * settings.translationError, "translation error");
+		Check(maxR < 2.f * settings.rotationError, "rotation error");
+		Check(maxS < 2.f * settings.scaleError, "scale error");
+
+		maxT = maxR = 0.f;
+		for (size_t f = 0; f < frameNum; f++) {
+			clip.Sample(pose, f / sampleRate, false);
+			maxT = std::max(maxT, Distance(pose.translations[0], tracks[0].translations[f]));
+			maxR = std::max(maxR, Angle(pose.rotations[0], tracks[0].rotations[f]));
+		}
+		// the angle is measured by acos here, quantization adds to the bound
+		Check(maxT <= 1.1f * settings.translationError, "translation error at the frames");
+		Check(maxR <= 1.1f * settings.rotationError, "rotation error at the frames");
+
+		clip.Sample(pose, 1.f, false);
+		Check(Distance(pose.translations[1], { 1.f, 2.f, 3.f }) == 0.f, "constant translation");
+		Check(pose.scales[1] == 2.f, "constant scale");
+	}
+
+	{ // loop and clamp
+		AnimationPose a;
+		AnimationPose b;
+		clip.Sample(a, 0.5f, true);
+		clip.Sample(b, 3.5f, true);
+		Check(Distance(a.translations[0], b.translations[0]) < 1e-4f, "loop");
+		clip.Sample(b, -2.5f, true);
+		Check(Distance(a.translations[0], b.translations[0]) < 1e-4f, "loop of a negative time");
+		clip.Sample(a, 3.f, false);
+		clip.Sample(b, 10.f, false);
+		Check(Distance(a.translations[0], b.translations[0]) == 0.f, "clamp");
+	}
+
+	{ // segments of the maximum length, noise cannot be reduced : a key per frame
+		AnimationCompressionSettings noiseSettings;
+		noiseSettings.segmentFrames = 1000; // clamped
+		constexpr size_t maxSegmentFrames = 254;
+		constexpr size_t noiseFrameNum = 2 * maxSegmentFrames + 1;
+		vector<AnimationClip::Track> noiseTracks(1);
+		uint32_t seed = 1;
+		auto Noise = [&]() {
+			seed = seed * 1664525u + 1013904223u;
+			return (seed >> 8) / float(1u << 24);
+		};
+		for (size_t f = 0; f < noiseFrameNum; f++)
+			noiseTracks[0].translations.push_back({ Noise(), Noise(), Noise() });
+		const AnimationClip noise{ noiseTracks, sampleRate, noiseFrameNum, noiseSettings };
+		Check(noise.GetKeyNum() == 2 * (maxSegmentFrames + 1), "a key per frame");
+
+		AnimationPose pose;
+		float maxT = 0.f;
+		for (size_t f = 0; f < noiseFrameNum; f++) {
+			noise.Sample(pose, f / sampleRate, false);
+			maxT = std::max(maxT, Distance(pose.translations[0], noiseTracks[0].translations[f]));
+		}
+		Check(maxT <= noiseSettings.translationError, "noise at the frames");
+	}
+
+	{ // blend
+		vector<AnimationClip::Track> otherTracks(3);
+		otherTracks[0].translations.push_back({ 2.f, 0.f, 0.f });
+		otherTracks[0].rotations.push_back(AxisAngle({ 0.f, 1.f, 0.f }, 1.f));
+		otherTracks[1].rotations.push_back(quatf::identity());
+		otherTracks[2].scales.push_back(3.f); // not in clip
+		const AnimationClip other{ otherTracks, sampleRate, 1 };
+
+		AnimationPose base;
+		AnimationPose pose;
+		AnimationPose blend;
+		clip.Sample(base, 0.f, false);
+		other.Sample(blend, 0.f, false);
+
+		pose = base;
+		BlendAnimationPoses(pose, blend, 0.f);
+		Check(Distance(pose.translations[0], base.translations[0]) == 0.f, "weight 0");
+		pose = base;
+		BlendAnimationPoses(pose, blend, 1.f);
+		Check(Distance(pose.translations[0], { 2.f, 0.f, 0.f }) < 1e-6f, "weight 1");
+		Check(Angle(pose.rotations[0], blend.rotations[0]) < 1e-3f, "rotation of weight 1");
+
+		pose = base;
+		BlendAnimationPoses(pose, blend, 0.5f);
+		const float x = 0.5f * (base.translations[0][0] + 2.f);
+		Check(Near(pose.translations[0][0], x, 1e-6f), "weight 0.5");
+		Check(Angle(pose.rotations[1], base.rotations[1]) + Angle(pose.rotations[1], quatf::identity()) - Angle(base.rotations[1], quatf::identity()) < 1e-3f, "rotation halfway");
+		Check(pose.scales[0] == base.scales[0], "channel of dst only");
+		Check(pose.scales[2] == 3.f, "channel of src only");
+		Check(pose.channelMasks[2] == (GetAnimationChannelBit(AnimationChannel::Rotation) | GetAnimationChannelBit(AnimationChannel::Scale)), "blended channels");
+	}
+
+	{ // world
+		World w;
+		w.entityMngr.cmptTraits.Register<
+			AnimationTarget,
+			Animator,
+			LocalToWorld,
+			Rotation,
+			Scale,
+			Translation,
+			WorldTime
+		>();
+		auto indices = w.systemMngr.Register<
+			AnimatorSystem,
+			TRSToLocalToWorldSystem
+		>();
+		for (auto idx : indices)
+			w.systemMngr.Activate(idx);
+
+		auto [timeEntity, time] = w.entityMngr.Create<WorldTime>();
+		time->deltaTime = 0.5f;
+
+		auto [animatorEntity, animator] = w.entityMngr.Create<Animator>();
+		animator->clip = std::make_shared<AnimationClip>(tracks, sampleRate, frameNum, settings);
+		auto [e0, target0, l2w0, t0, r0, s0] = w.entityMngr.Create<AnimationTarget, LocalToWorld, Translation, Rotation, Scale>();
+		*target0 = { animatorEntity, 0 };
+		auto [e1, target1, t1] = w.entityMngr.Create<AnimationTarget, Translation>();
+		*target1 = { animatorEntity, 1 };
+		auto [e2, target2, t2] = w.entityMngr.Create<AnimationTarget, Translation>();
+		*target2 = { animatorEntity, 3 }; // no such track
+
+		w.Update();
+
+		AnimationPose pose;
+		clip.Sample(pose, 0.5f);
+		auto animated = w.entityMngr.Get<Animator>(animatorEntity);
+		Check(Near(animated->time, 0.5f, 1e-6f), "animator time");
+		Check(Distance(w.entityMngr.Get<Translation>(e0)->value, pose.translations[0]) == 0.f, "target translation");
+		Check(w.entityMngr.Get<Scale>(e0)->value == pose.scales[0], "target scale");
+		Check(Distance(w.entityMngr.Get<Translation>(e1)->value, { 1.f, 2.f, 3.f }) == 0.f, "second target");
+		const auto l2w = w.entityMngr.Get<LocalToWorld>(e0)->value;
+		Check(Distance(l2w.decompose_translation(), pose.translations[0]) < 1e-5f, "sampled before the TRS systems");
+		Check(Distance(w.entityMngr.Get<Translation>(e2)->value, { 0.f }) == 0.f, "target of a missing track");
+	}
+
+	{ // benchmark
+		constexpr size_t boneNum = 64;
+		constexpr size_t longFrameNum = 301; // 10 s
+		vector<AnimationClip::Track> boneTracks(boneNum);
+		for (size_t b = 0; b < boneNum; b++) {
+			for (size_t f = 0; f < longFrameNum; f++) {
+				const float t = f / sampleRate;
+				boneTracks[b].translations.push_back(TranslationAt(b, t));
+				boneTracks[b].rotations.push_back(RotationAt(b, t));
+			}
+		}
+		const AnimationClip longClip{ boneTracks, sampleRate, longFrameNum };
+
+		AnimationPose pose;
+		constexpr size_t sampleNum = 10000;
+		float sum = 0.f;
+		const auto begin = chrono::steady_clock::now();
+		for (size_t i = 0; i < sampleNum; i++) {
+			longClip.Sample(pose, i * 0.0011f);
+			sum += pose.translations[i % boneNum][0];
+		}
+		const auto end = chrono::steady_clock::now();
+		const double ns = chrono::duration<double, nano>(end - begin).count() / (sampleNum * boneNum);
+		cout << "sample: " << ns << " ns per bone, "
+			<< longClip.GetCompressedSize() << " / " << longFrameNum * boneNum * 7 * sizeof(float) << " bytes"
+			<< (sum == 0.f ? " " : "") << endl;
+	}
+
+	return CheckResult();
+}
@@ -0,0 +1,145 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Core/Profiler.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace std;
+
+static void Spin(uint64_t ns) {
+	const uint64_t end = Profiler::Now() + ns;
+	while (Profiler::Now() < end)
+		;
+}
+
+int main() {
+	auto& profiler = Profiler::Instance();
+
+	{ // Collect : nesting, depth, counters
+		profiler.Clear();
+		{
+			ProfileScope outer{ "outer" };
+			{
+				ProfileScope inner{ "inner" };
+				ProfileScope::SetCurrentCounter("items", 42);
+				Spin(100000);
+			}
+			Spin(100000);
+		}
+
+		auto zones = profiler.Collect();
+		Check(zones.size() == 2, "collected zones");
+		if (zones.size() == 2) {
+			Check(string{ zones[0].name } == "outer" && zones[0].depth == 0, "outer zone first");
+			Check(string{ zones[1].name } == "inner" && zones[1].depth == 1, "inner zone nested");
+			Check(zones[0].begin <= zones[1].begin && zones[1].end <= zones[0].end, "inner inside outer");
+			Check(zones[1].counterName && string{ zones[1].counterName } == "items"
+				&& zones[1].counter == 42, "counter of the inner zone");
+			Check(!zones[0].counterName, "no counter on the outer zone");
+		}
+	}
+
+	{ // GetStats
+		profiler.Clear();
+		for (size_t i = 0; i < 3; i++) {
+			ProfileScope scope{ "step" };
+			Spin(200000);
+		}
+		{
+			ProfileScope scope{ "once" };
+		}
+
+		auto stats = profiler.GetStats();
+		Check(stats.size() == 2, "stats per name");
+		if (stats.size() == 2) {
+			Check(stats[0].name == "step" && stats[0].count == 3, "sorted by total time");
+			Check(stats[0].minMs >= 0.2 && stats[0].minMs <= stats[0].meanMs && stats[0].meanMs <= stats[0].maxMs,
+				"min <= mean <= max");
+			Check(stats[1].name == "once" && stats[1].count == 1, "single zone");
+		}
+	}
+
+	{ // DumpChromeTrace
+		profiler.Clear();
+		{
+			ProfileScope scope{ "quote\"d" };
+			scope.SetCounter("n", 7);
+		}
+
+		auto trace = profiler.DumpChromeTrace();
+		Check(trace.find("\"traceEvents\":[") != string::npos, "trace events");
+		Check(trace.find("\"name\":\"quote\\\"d\"") != string::npos, "escaped zone name");
+		Check(trace.find("\"ph\":\"X\"") != string::npos, "complete events");
+		Check(trace.find("\"args\":{\"n\":7}") != string::npos, "counter as args");
+	}
+
+	{ // ring wraparound : only the newest zones of a thread are kept
+		// the slot of the next write is skipped, so a full ring yields <capacity> - 1 zones
+		profiler.Clear();
+		profiler.SetThreadBufferCapacity(6); // rounded up to 8
+		const char* name = profiler.Intern("wrap");
+		thread worker{ [name]() {
+			for (int64_t i = 0; i < 20; i++) {
+				ProfileScope scope{ name };
+				scope.SetCounter("i", i);
+			}
+		} };
+		worker.join();
+		profiler.SetThreadBufferCapacity(1 << 14);
+
+		auto zones = profiler.Collect();
+		vector<int64_t> counters;
+		for (const auto& zone : zones) {
+			if (zone.name == name)
+				counters.push_back(zone.counter);
+		}
+		Check(counters.size() == 7, "capacity of the ring");
+		bool newest = true;
+		for (size_t i = 0; i < counters.size(); i++)
+			newest &= counters[i] == static_cast<int64_t>(13 + i);
+		Check(newest, "the oldest zones are overwritten");
+		Check(profiler.Intern("wrap") == name, "interned once");
+	}
+
+	{ // per-scope overhead
+		constexpr size_t N = 1000000;
+		profiler.Clear();
+		auto t0 = chrono::steady_clock::now();
+		for (size_t i = 0; i < N; i++) {
+			ProfileScope scope{ "overhead" };
+		}
+		auto t1 = chrono::steady_clock::now();
+
+		profiler.SetEnabled(false);
+		for (size_t i = 0; i < N; i++) {
+			ProfileScope scope{ "disabled" };
+		}
+		auto t2 = chrono::steady_clock::now();
+		profiler.SetEnabled(true);
+
+		double enabledNs = chrono::duration<double, nano>(t1 - t0).count() / N;
+		double disabledNs = chrono::duration<double, nano>(t2 - t1).count() / N;
+		cout << "per-scope overhead: " << enabledNs << " ns, disabled: " << disabledNs << " ns" << endl;
+
+		// two timestamps and a ring write
+#ifdef NDEBUG
+		Check(enabledNs < 50., "enabled overhead");
+#else
+		Check(enabledNs < 1000., "enabled overhead");
+#endif
+		Check(disabledNs < 100., "disabled overhead");
+
+		auto zones = profiler.Collect();
+		Check(none_of(zones.begin(), zones.end(), [](const Profiler::Zone& zone) {
+			return string{ zone.name } == "disabled";
+		}), "nothing recorded when disabled");
+	}
+
+	return CheckResult();
+}
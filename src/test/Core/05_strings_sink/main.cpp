@@ -0,0 +1,140 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Core/StringsSink.h>
+
+#include <spdlog/logger.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace std;
+
+static shared_ptr<spdlog::logger> CreateLogger(shared_ptr<StringsSink> sink) {
+	auto logger = make_shared<spdlog::logger>("test", sink);
+	logger->set_level(spdlog::level::trace);
+	logger->set_pattern("%v");
+	return logger;
+}
+
+static void LogNumbers(spdlog::logger& logger, size_t begin, size_t end) {
+	for (size_t i = begin; i < end; i++)
+		logger.info("{}", i);
+}
+
+int main() {
+	{ // concurrent producers
+		constexpr size_t ThreadNum = 4;
+		constexpr size_t LogNum = 2000;
+		auto sink = make_shared<StringsSink>(ThreadNum * LogNum, ThreadNum * LogNum);
+		auto logger = CreateLogger(sink);
+
+		vector<thread> producers;
+		for (size_t t = 0; t < ThreadNum; t++) {
+			producers.emplace_back([&logger, t]() {
+				LogNumbers(*logger, t * LogNum, (t + 1) * LogNum);
+			});
+		}
+		for (auto& producer : producers)
+			producer.join();
+
+		vector<uint64_t> ids;
+		vector<size_t> lastOfThread(ThreadNum, 0);
+		vector<bool> seen(ThreadNum * LogNum, false);
+		bool inOrder = true;
+		sink->ForEach([&](const StringsSink::Log& log) {
+			ids.push_back(log.id);
+			size_t value = stoul(string{ log.text });
+			size_t t = value / LogNum;
+			inOrder &= value >= lastOfThread[t];
+			lastOfThread[t] = value;
+			seen[value] = true;
+		});
+
+		Check(sink->GetDroppedNum() == 0, "no drop under the capacity");
+		Check(ids.size() == ThreadNum * LogNum, "every record kept");
+		bool consecutive = true;
+		for (size_t i = 0; i < ids.size(); i++)
+			consecutive &= ids[i] == i;
+		Check(consecutive, "monotonic ids");
+		Check(inOrder, "records of a thread keep their order");
+		bool all = true;
+		for (bool s : seen)
+			all &= s;
+		Check(all, "every value seen once");
+	}
+
+	{ // overflow : the ring drops the records it can't hold until a reader drains it
+		auto sink = make_shared<StringsSink>(8, 100);
+		auto logger = CreateLogger(sink);
+
+		LogNumbers(*logger, 0, 20);
+		Check(sink->GetDroppedNum() == 12, "dropped records");
+
+		auto logs = sink->CopyLogs();
+		Check(logs.size() == 8, "ring capacity");
+		Check(!logs.empty() && logs.front() == "0\n" && logs.back() == "7\n", "the oldest records are kept");
+
+		LogNumbers(*logger, 20, 24);
+		Check(sink->CopyLogs().size() == 12, "the drained ring accepts records again");
+		Check(sink->GetDroppedNum() == 12, "no more drop");
+	}
+
+	{ // eviction and ForEachSince
+		auto sink = make_shared<StringsSink>(64, 10);
+		auto logger = CreateLogger(sink);
+
+		for (size_t i = 0; i < 3; i++) {
+			LogNumbers(*logger, i * 10, (i + 1) * 10);
+			sink->ForEach([](const StringsSink::Log&) {});
+		}
+
+		Check(sink->GetEvictedNum() == 20, "evicted records");
+		Check(sink->GetFirstID() == 20, "first id after eviction");
+		Check(sink->GetNextID() == 30, "next id");
+
+		vector<uint64_t> ids;
+		sink->ForEachSince(25, [&](const StringsSink::Log& log) {
+			ids.push_back(log.id);
+			Check(log.text == to_string(log.id) + "\n", "text of the id");
+		});
+		Check(ids == vector<uint64_t>{ 25, 26, 27, 28, 29 }, "logs since an id");
+
+		size_t num = 0;
+		sink->ForEachSince(3, [&](const StringsSink::Log&) { num++; });
+		Check(num == 10, "an evicted begin id starts at the first log");
+
+		num = 0;
+		sink->ForEachSince(sink->GetNextID(), [&](const StringsSink::Log&) { num++; });
+		Check(num == 0, "nothing since the next id");
+
+		// ForEachOf skips the evicted ids and stops at the ids not in the history
+		const uint64_t ofIDs[] = { 5, 19, 20, 24, 29, 30, 31 };
+		ids.clear();
+		sink->ForEachOf(ofIDs, sizeof(ofIDs) / sizeof(uint64_t), [&](const StringsSink::Log& log) {
+			ids.push_back(log.id);
+		});
+		Check(ids == vector<uint64_t>{ 20, 24, 29 }, "logs of ids");
+
+		// an index clamped to GetFirstID() maps one to one to ForEachOf
+		vector<uint64_t> index{ 2, 11, 21, 22, 27 };
+		LogNumbers(*logger, 30, 35);
+		const uint64_t firstID = sink->GetFirstID();
+		Check(firstID == 25, "first id after more logs");
+		index.erase(index.begin(), lower_bound(index.begin(), index.end(), firstID));
+		num = 0;
+		sink->ForEachOf(index.data(), index.size(), [&](const StringsSink::Log&) { num++; });
+		Check(index.size() == 1 && num == index.size(), "clamped index");
+
+		sink->Clear();
+		Check(sink->CopyLogs().empty(), "cleared");
+		Check(sink->GetFirstID() == sink->GetNextID(), "first id of an empty history");
+		LogNumbers(*logger, 35, 36);
+		Check(sink->GetFirstID() == 35, "ids are not reset by Clear");
+	}
+
+	return CheckResult();
+}
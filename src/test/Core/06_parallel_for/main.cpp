@@ -0,0 +1,95 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Core/ParallelFor.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace std;
+
+// every index is visited once
+static bool VisitOnce(size_t num, size_t minChunkSize) {
+	vector<atomic<uint32_t>> visits(num);
+	ParallelFor(num, minChunkSize, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			visits[i]++;
+	});
+	for (const auto& v : visits) {
+		if (v != 1)
+			return false;
+	}
+	return true;
+}
+
+int main() {
+	{ // chunks
+		Check(VisitOnce(0, 16), "empty loop");
+		Check(VisitOnce(1, 16), "one item");
+		Check(VisitOnce(15, 16), "smaller than a chunk");
+		Check(VisitOnce(100003, 16), "many chunks");
+		Check(VisitOnce(100003, 0), "minChunkSize 0");
+	}
+
+	{ // repeated loops reuse the pool
+		bool ok = true;
+		for (size_t i = 0; i < 1000; i++)
+			ok &= VisitOnce(1000 + i, 16);
+		Check(ok, "repeated loops");
+	}
+
+	{ // a nested loop runs in the calling thread
+		constexpr size_t N = 64;
+		vector<atomic<uint32_t>> visits(N * N);
+		ParallelFor(N, 1, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				ParallelFor(N, 1, [&](size_t innerBegin, size_t innerEnd) {
+					for (size_t j = innerBegin; j < innerEnd; j++)
+						visits[i * N + j]++;
+				});
+			}
+		});
+		bool ok = true;
+		for (const auto& v : visits)
+			ok &= v == 1;
+		Check(ok, "nested loops");
+	}
+
+	{ // concurrent loops from several threads
+		constexpr size_t ThreadNum = 4;
+		vector<thread> threads;
+		atomic<bool> ok{ true };
+		for (size_t t = 0; t < ThreadNum; t++) {
+			threads.emplace_back([&]() {
+				for (size_t i = 0; i < 100; i++) {
+					if (!VisitOnce(10000, 16))
+						ok = false;
+				}
+			});
+		}
+		for (auto& t : threads)
+			t.join();
+		Check(ok, "concurrent loops");
+	}
+
+	{ // no thread is created per call
+		constexpr size_t LoopNum = 10000;
+		vector<float> data(4096, 1.f);
+		const auto t0 = chrono::steady_clock::now();
+		for (size_t i = 0; i < LoopNum; i++) {
+			ParallelFor(data.size(), 16, [&](size_t begin, size_t end) {
+				for (size_t k = begin; k < end; k++)
+					data[k] *= 1.0001f;
+			});
+		}
+		const auto t1 = chrono::steady_clock::now();
+		const double us = chrono::duration<double, micro>(t1 - t0).count() / LoopNum;
+		cout << "ParallelFor of 4096 items: " << us << " us" << endl;
+	}
+
+	return CheckResult();
+}
@@ -0,0 +1,125 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/FrustumCulling.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+// brute force: culled if all 8 corners are outside the same clip plane
+// return -1 if the box is too close to a plane to decide
+static int BruteForceVisible(const transformf& viewProj, const bboxf3& box) {
+	float outsideMax[6];
+	for (auto& v : outsideMax)
+		v = -std::numeric_limits<float>::max();
+	float scale = 0.f;
+	for (size_t c = 0; c < 8; c++) {
+		pointf3 corner{
+			(c & 1) ? box.maxP()[0] : box.minP()[0],
+			(c & 2) ? box.maxP()[1] : box.minP()[1],
+			(c & 4) ? box.maxP()[2] : box.minP()[2],
+		};
+		float clip[4];
+		for (size_t r = 0; r < 4; r++)
+			clip[r] = viewProj[0][r] * corner[0] + viewProj[1][r] * corner[1] + viewProj[2][r] * corner[2] + viewProj[3][r];
+		const float inside[6] = {
+			clip[3] + clip[0], clip[3] - clip[0],
+			clip[3] + clip[1], clip[3] - clip[1],
+			clip[2], clip[3] - clip[2],
+		};
+		for (size_t k = 0; k < 6; k++) {
+			outsideMax[k] = std::max(outsideMax[k], inside[k]);
+			scale = std::max(scale, std::abs(inside[k]));
+		}
+	}
+	bool visible = true;
+	for (size_t k = 0; k < 6; k++) {
+		if (std::abs(outsideMax[k]) < 1e-4f * scale)
+			return -1;
+		if (outsideMax[k] < 0.f)
+			visible = false;
+	}
+	return visible ? 1 : 0;
+}
+
+int main() {
+	// camera at the origin, looking at -z
+	const transformf proj = transformf::perspective(to_radian(60.f), 1.f, 0.1f, 100.f, 0.f);
+	const transformf view = transformf::eye();
+	const transformf viewProj = proj * view;
+	const Frustum frustum = Frustum::FromMatrix(viewProj);
+
+	{ // cases
+		CullingBounds bounds;
+		bounds.Add(bboxf3{ pointf3{ -1.f, -1.f, -11.f }, pointf3{ 1.f, 1.f, -9.f } }); // in front
+		bounds.Add(bboxf3{ pointf3{ -1.f, -1.f, 9.f }, pointf3{ 1.f, 1.f, 11.f } }); // behind
+		bounds.Add(bboxf3{ pointf3{ -101.f, -1.f, -11.f }, pointf3{ -99.f, 1.f, -9.f } }); // left
+		bounds.Add(bboxf3{ pointf3{ -1.f, -1.f, -201.f }, pointf3{ 1.f, 1.f, -199.f } }); // beyond far
+		bounds.Add(bboxf3{ pointf3{ -1.f, -1.f, -1.f }, pointf3{ 1.f, 1.f, 1.f } }); // around the camera
+		// local box at the origin, moved behind the camera
+		bounds.Add(bboxf3{ pointf3{ -1.f, -1.f, -1.f }, pointf3{ 1.f, 1.f, 1.f } }, transformf{ vecf3{ 0.f, 0.f, 10.f } });
+
+		uint8_t visible[6];
+		FrustumCull(frustum, bounds, visible);
+		Check(visible[0] == 1, "in front");
+		Check(visible[1] == 0, "behind");
+		Check(visible[2] == 0, "left");
+		Check(visible[3] == 0, "beyond far");
+		Check(visible[4] == 1, "around the camera");
+		Check(visible[5] == 0, "transformed");
+	}
+
+	{ // random: SSE = scalar = brute force
+		constexpr size_t N = 100000;
+		mt19937 rng{ 0 };
+		uniform_real_distribution<float> posDist{ -150.f, 150.f };
+		uniform_real_distribution<float> sizeDist{ 0.1f, 10.f };
+
+		CullingBounds bounds;
+		vector<bboxf3> boxes;
+		bounds.Reserve(N);
+		boxes.reserve(N);
+		for (size_t i = 0; i < N; i++) {
+			pointf3 c{ posDist(rng), posDist(rng), posDist(rng) };
+			vecf3 e{ sizeDist(rng), sizeDist(rng), sizeDist(rng) };
+			boxes.emplace_back(c - e, c + e);
+			bounds.Add(boxes.back());
+		}
+
+		vector<uint8_t> visible(N), visibleScalar(N);
+
+		auto t0 = chrono::steady_clock::now();
+		FrustumCull(frustum, bounds, visible.data());
+		auto t1 = chrono::steady_clock::now();
+		FrustumCull_Scalar(frustum, bounds, visibleScalar.data());
+		auto t2 = chrono::steady_clock::now();
+
+		size_t visibleNum = 0;
+		size_t mismatchScalar = 0;
+		size_t mismatchBruteForce = 0;
+		for (size_t i = 0; i < N; i++) {
+			visibleNum += visible[i];
+			if (visible[i] != visibleScalar[i])
+				mismatchScalar++;
+			int ref = BruteForceVisible(viewProj, boxes[i]);
+			if (ref != -1 && ref != visible[i])
+				mismatchBruteForce++;
+		}
+
+		Check(mismatchScalar == 0, "SSE and scalar mismatch");
+		Check(mismatchBruteForce == 0, "brute force mismatch");
+
+		cout << "visible: " << visibleNum << " / " << N << endl
+			<< "FrustumCull        : " << chrono::duration<double, milli>(t1 - t0).count() << " ms" << endl
+			<< "FrustumCull_Scalar : " << chrono::duration<double, milli>(t2 - t1).count() << " ms" << endl;
+	}
+
+	return CheckResult();
+}
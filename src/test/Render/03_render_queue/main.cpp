@@ -0,0 +1,134 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/RenderQueue.h>
+#include <Utopia/Render/Material.h>
+#include <Utopia/Render/Shader.h>
+#include <Utopia/Render/Mesh.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+static void Print(const char* name, const RenderQueue::StateChanges& changes) {
+	cout << name << " state changes: shader " << changes.shader
+		<< ", material " << changes.material
+		<< ", mesh " << changes.mesh << endl;
+}
+
+int main() {
+	constexpr size_t N = 100000;
+	constexpr size_t ShaderNum = 8;
+	constexpr size_t MaterialNum = 64;
+	constexpr size_t MeshNum = 32;
+
+	// shader 0, 1: transparent
+	vector<shared_ptr<Shader>> shaders;
+	for (size_t i = 0; i < ShaderNum; i++) {
+		auto shader = make_shared<Shader>();
+		ShaderPass pass;
+		pass.queue = i < 2 ? (size_t)ShaderPass::Queue::Transparent : (size_t)ShaderPass::Queue::Geometry;
+		shader->passes.push_back(pass);
+		shaders.push_back(shader);
+	}
+	vector<shared_ptr<Material>> materials;
+	for (size_t i = 0; i < MaterialNum; i++) {
+		auto material = make_shared<Material>();
+		material->shader = shaders[i % ShaderNum];
+		materials.push_back(material);
+	}
+	vector<shared_ptr<Mesh>> meshes;
+	for (size_t i = 0; i < MeshNum; i++)
+		meshes.push_back(make_shared<Mesh>());
+
+	mt19937 rng{ 0 };
+	uniform_int_distribution<size_t> materialDist{ 0, MaterialNum - 1 };
+	uniform_int_distribution<size_t> meshDist{ 0, MeshNum - 1 };
+	uniform_real_distribution<float> depthDist{ 0.f, 10000.f };
+
+	vector<RenderObject> objects(N);
+	for (size_t i = 0; i < N; i++) {
+		auto& obj = objects[i];
+		obj.material = materials[materialDist(rng)].get();
+		obj.passIdx = 0;
+		obj.mesh = meshes[meshDist(rng)].get();
+		obj.submeshIdx = 0;
+		obj.objectIdx = i;
+		obj.depth = depthDist(rng);
+	}
+
+	RenderQueue queue;
+	// best of a few rounds of the first n objects, the scratch buffers are reused
+	auto TimeSort = [&](size_t n) {
+		double best = 1e9;
+		for (size_t round = 0; round < 5; round++) {
+			queue.Clear();
+			for (size_t i = 0; i < n; i++)
+				queue.Add(objects[i]);
+
+			auto t0 = chrono::steady_clock::now();
+			queue.Sort();
+			auto t1 = chrono::steady_clock::now();
+			best = std::min(best, chrono::duration<double, milli>(t1 - t0).count());
+		}
+		return best;
+	};
+
+	// reference: std::sort of the same (key, index) pairs
+	auto TimeStdSort = [&](size_t n) {
+		double best = 1e9;
+		vector<pair<uint64_t, uint32_t>> keys(n);
+		for (size_t round = 0; round < 5; round++) {
+			for (size_t i = 0; i < n; i++)
+				keys[i] = { RenderQueue::OpaqueKey(objects[i]), static_cast<uint32_t>(i) };
+			auto t0 = chrono::steady_clock::now();
+			sort(keys.begin(), keys.end());
+			auto t1 = chrono::steady_clock::now();
+			best = std::min(best, chrono::duration<double, milli>(t1 - t0).count());
+		}
+		return best;
+	};
+
+	const double smallMs = TimeSort(N / 10);
+	const double stdMs = TimeStdSort(N);
+	const double ms = TimeSort(N);
+
+	queue.Clear();
+	for (const auto& obj : objects)
+		queue.Add(obj);
+	Print("unsorted", queue.CountStateChanges());
+	queue.Sort();
+	Print("sorted  ", queue.CountStateChanges());
+
+	cout << "sort " << N / 10 << " items: " << smallMs << " ms" << endl
+		<< "sort " << N << " items: " << ms << " ms (std::sort by key: " << stdMs << " ms)" << endl;
+
+	// radix sort vs std::sort is only reported, the ratio depends on the machine
+#ifdef NDEBUG
+	Check(ms < 1., "sort 100k items under a millisecond");
+#endif // NDEBUG
+
+	const auto& opaques = queue.GetOpaques();
+	const auto& transparents = queue.GetTransparents();
+	Check(opaques.size() + transparents.size() == N, "size");
+
+	// opaque: grouped by shader and material, front-to-back in a group
+	for (size_t i = 1; i < opaques.size(); i++) {
+		Check(RenderQueue::OpaqueKey(opaques[i - 1]) <= RenderQueue::OpaqueKey(opaques[i]), "opaque key order");
+		if (opaques[i - 1].material == opaques[i].material && opaques[i - 1].mesh == opaques[i].mesh)
+			Check(opaques[i - 1].depth <= opaques[i].depth * 1.04f, "opaque front-to-back"); // 10-bit depth
+	}
+	// transparent: back-to-front
+	for (size_t i = 1; i < transparents.size(); i++)
+		Check(transparents[i - 1].depth * 1.001f >= transparents[i].depth, "transparent back-to-front"); // 24-bit depth
+
+	RenderQueue::StateChanges changes = queue.CountStateChanges();
+	Check(changes.material <= MaterialNum + transparents.size(), "material changes");
+
+	return CheckResult();
+}
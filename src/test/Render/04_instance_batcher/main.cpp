@@ -0,0 +1,136 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/InstanceBatcher.h>
+#include <Utopia/Render/Material.h>
+#include <Utopia/Render/Shader.h>
+#include <Utopia/Render/Mesh.h>
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <tuple>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+int main() {
+	constexpr size_t N = 100000;
+	constexpr size_t MaterialNum = 16;
+	constexpr size_t MeshNum = 8;
+	constexpr size_t MaxBatchSize = 64;
+
+	auto shader = make_shared<Shader>();
+	shader->passes.emplace_back();
+	vector<shared_ptr<Material>> materials;
+	for (size_t i = 0; i < MaterialNum; i++) {
+		auto material = make_shared<Material>();
+		material->shader = shader;
+		materials.push_back(material);
+	}
+	vector<shared_ptr<Mesh>> meshes;
+	for (size_t i = 0; i < MeshNum; i++)
+		meshes.push_back(make_shared<Mesh>());
+
+	mt19937 rng{ 0 };
+	uniform_int_distribution<size_t> materialDist{ 0, MaterialNum - 1 };
+	uniform_int_distribution<size_t> meshDist{ 0, MeshNum - 1 };
+	uniform_real_distribution<float> depthDist{ 0.f, 10000.f };
+
+	RenderQueue queue;
+	for (size_t i = 0; i < N; i++) {
+		RenderObject obj;
+		obj.material = materials[materialDist(rng)].get();
+		obj.passIdx = 0;
+		obj.mesh = meshes[meshDist(rng)].get();
+		obj.submeshIdx = 0;
+		obj.objectIdx = i;
+		obj.depth = depthDist(rng);
+		queue.Add(obj);
+	}
+	queue.Sort();
+	const auto& opaques = queue.GetOpaques();
+
+	InstanceBatcher batcher{ MaxBatchSize };
+	batcher.Build(opaques);
+	const auto& batches = batcher.GetBatches();
+	const auto& stats = batcher.GetStats();
+
+	cout << "draws: " << stats.drawsBefore << " -> " << stats.drawsAfter
+		<< ", max instances: " << stats.maxInstances << endl;
+
+	Check(stats.drawsBefore == N, "draws before");
+	Check(stats.drawsAfter == batches.size(), "draws after");
+	Check(stats.maxInstances <= MaxBatchSize, "max batch size");
+	// at least one batch per (material, mesh) pair, each full but the last
+	Check(stats.drawsAfter >= MaterialNum * MeshNum, "batch lower bound");
+	Check(stats.drawsAfter <= MaterialNum * MeshNum + N / MaxBatchSize, "batch upper bound");
+
+	// batches cover the objects in order, all instances are compatible
+	size_t next = 0;
+	for (const auto& batch : batches) {
+		Check(batch.first == next, "contiguous batches");
+		Check(batch.count > 0, "empty batch");
+		for (size_t i = batch.first + 1; i < batch.first + batch.count; i++)
+			Check(InstanceBatcher::IsCompatible(opaques[batch.first], opaques[i]), "compatible instances");
+		next = batch.first + batch.count;
+	}
+	Check(next == opaques.size(), "cover all objects");
+
+	// adjacent batches are split only by the max size or a state change
+	for (size_t i = 1; i < batches.size(); i++) {
+		if (InstanceBatcher::IsCompatible(opaques[batches[i - 1].first], opaques[batches[i].first]))
+			Check(batches[i - 1].count == MaxBatchSize, "split only when full");
+	}
+
+	// instance data is packed in the sorted order
+	vector<size_t> objectData(N);
+	for (size_t i = 0; i < N; i++)
+		objectData[i] = i * 3;
+	vector<size_t> instances(opaques.size());
+	InstanceBatcher::PackInstances(opaques, objectData.data(), instances.data());
+	for (const auto& batch : batches) {
+		for (size_t k = 0; k < batch.count; k++)
+			Check(instances[batch.first + k] == opaques[batch.first + k].objectIdx * 3, "packed instance");
+	}
+
+	{ // multi-submesh meshes at mixed depths: one batch per (material, mesh, submesh, lod)
+		constexpr size_t SubmeshNum = 4;
+		constexpr size_t LODNum = 2;
+		uniform_int_distribution<size_t> submeshDist{ 0, SubmeshNum - 1 };
+		uniform_int_distribution<size_t> lodDist{ 0, LODNum - 1 };
+
+		RenderQueue submeshQueue;
+		set<tuple<const Material*, const Mesh*, size_t, size_t>> groups;
+		for (size_t i = 0; i < N; i++) {
+			RenderObject obj;
+			obj.material = materials[materialDist(rng)].get();
+			obj.passIdx = 0;
+			obj.mesh = meshes[meshDist(rng)].get();
+			obj.submeshIdx = submeshDist(rng);
+			obj.lod = lodDist(rng);
+			obj.objectIdx = i;
+			obj.depth = depthDist(rng);
+			submeshQueue.Add(obj);
+			groups.emplace(obj.material, obj.mesh, obj.submeshIdx, obj.lod);
+		}
+		submeshQueue.Sort();
+
+		InstanceBatcher submeshBatcher{ N };
+		submeshBatcher.Build(submeshQueue.GetOpaques());
+		cout << "multi-submesh draws: " << submeshBatcher.GetStats().drawsBefore
+			<< " -> " << submeshBatcher.GetStats().drawsAfter << endl;
+		Check(submeshBatcher.GetStats().drawsAfter == groups.size(), "no fragmented batches");
+	}
+
+	// max batch size 1: no batching
+	batcher.SetMaxBatchSize(1);
+	batcher.Build(opaques);
+	Check(batcher.GetStats().drawsAfter == N, "no batching");
+
+	batcher.Clear();
+	Check(batcher.GetBatches().empty(), "clear");
+
+	return CheckResult();
+}
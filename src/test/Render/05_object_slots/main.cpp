@@ -0,0 +1,82 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/ObjectSlotAllocator.h>
+
+#include <iostream>
+#include <set>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa::UECS;
+using namespace std;
+
+static size_t CountSlots(const vector<pair<size_t, size_t>>& ranges) {
+	size_t num = 0;
+	for (const auto& [begin, end] : ranges)
+		num += end - begin;
+	return num;
+}
+
+int main() {
+	constexpr size_t NumFrame = 3;
+	constexpr size_t N = 1000;
+
+	ObjectSlotAllocator allocator{ NumFrame };
+	vector<size_t> slots(N);
+
+	// frame 0: every entity gets a new, unique slot
+	set<size_t> uniqueSlots;
+	for (size_t i = 0; i < N; i++) {
+		bool isNew;
+		slots[i] = allocator.Acquire(0, Entity{ i, 0 }, isNew);
+		Check(isNew, "new slot");
+		uniqueSlots.insert(slots[i]);
+	}
+	allocator.ReleaseUnused();
+	Check(uniqueSlots.size() == N, "unique slots");
+	Check(allocator.GetLiveNum() == N, "live num");
+
+	// new slots are uploaded into every frame resource, then nothing for a static scene
+	for (size_t f = 0; f < NumFrame; f++) {
+		const auto& ranges = allocator.CollectDirtyRanges();
+		Check(CountSlots(ranges) == N, "upload new slots");
+		Check(ranges.size() == 1, "merged range");
+		for (size_t i = 0; i < N; i++) {
+			bool isNew;
+			Check(allocator.Acquire(0, Entity{ i, 0 }, isNew) == slots[i] && !isNew, "stable slot");
+		}
+		allocator.ReleaseUnused();
+	}
+	Check(CountSlots(allocator.CollectDirtyRanges()) == 0, "static scene");
+
+	// a moved entity is uploaded NumFrame times
+	allocator.MarkDirty(slots[10]);
+	allocator.MarkDirty(slots[11]);
+	allocator.MarkDirty(slots[500]);
+	for (size_t f = 0; f < NumFrame; f++) {
+		const auto& ranges = allocator.CollectDirtyRanges();
+		Check(CountSlots(ranges) == 3, "dirty slots");
+		Check(ranges.size() == 2, "dirty ranges");
+	}
+	Check(CountSlots(allocator.CollectDirtyRanges()) == 0, "clean");
+
+	// entities not acquired in a frame are released and their slots are reused
+	for (size_t i = 0; i < N; i += 2) {
+		bool isNew;
+		allocator.Acquire(0, Entity{ i, 0 }, isNew);
+	}
+	allocator.ReleaseUnused();
+	Check(allocator.GetLiveNum() == N / 2, "released");
+	Check(allocator.GetCapacity() == N, "capacity");
+
+	// a destroyed entity whose index is reused gets a new slot, other worlds have their own slots
+	{
+		bool isNew;
+		size_t slot = allocator.Acquire(0, Entity{ 0, 1 }, isNew);
+		Check(isNew && slot != slots[0], "new version");
+		size_t other = allocator.Acquire(1, Entity{ 2, 0 }, isNew);
+		Check(isNew && other != slots[2], "other world");
+		Check(allocator.GetCapacity() == N, "reuse free slots");
+	}
+
+	return CheckResult();
+}
@@ -0,0 +1,146 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/LightCluster.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+static bool Contains(const LightClusterGrid& grid, size_t cluster, uint32_t light) {
+	const auto& range = grid.GetRanges()[cluster];
+	for (uint32_t i = 0; i < range.count; i++) {
+		if (grid.GetLightIndices()[range.offset + i] == light)
+			return true;
+	}
+	return false;
+}
+
+static size_t CountClusters(const LightClusterGrid& grid, uint32_t light) {
+	size_t num = 0;
+	for (size_t c = 0; c < grid.GetClusterNum(); c++)
+		num += Contains(grid, c, light) ? 1 : 0;
+	return num;
+}
+
+int main() {
+	LightClusterDesc desc;
+	desc.dimX = 16;
+	desc.dimY = 9;
+	desc.dimZ = 24;
+	desc.fovY = to_radian(60.f);
+	desc.aspect = 16.f / 9.f;
+	desc.nearZ = 0.3f;
+	desc.farZ = 200.f;
+
+	LightClusterGrid grid;
+	grid.SetDesc(desc);
+
+	{ // cases, camera at the origin looking at -z
+		const transformf view = transformf::eye();
+		ClusterLight lights[4];
+		lights[0].type = LightType::Point; // in front
+		lights[0].position = { 0.f, 0.f, -10.f };
+		lights[0].range = 1.f;
+		lights[1].type = LightType::Point; // behind
+		lights[1].position = { 0.f, 0.f, 10.f };
+		lights[1].range = 1.f;
+		lights[2].type = LightType::Spot; // in front, pointing away from the camera
+		lights[2].position = { 0.f, 0.f, -10.f };
+		lights[2].dir = { 0.f, 0.f, -1.f };
+		lights[2].range = 5.f;
+		lights[2].cosHalfOuterSpotAngle = std::cos(to_radian(15.f));
+		lights[3].type = LightType::Disk; // in front, facing away from the camera
+		lights[3].position = { 0.f, 0.f, -10.f };
+		lights[3].dir = { 0.f, 0.f, -1.f };
+		lights[3].range = 5.f;
+		grid.Assign(view, lights, 4);
+
+		// cluster of the position of light 0
+		float d = 10.f;
+		size_t z = static_cast<size_t>(std::floor(std::log(d) * grid.GetLogScale() + grid.GetLogBias()));
+		size_t cluster = grid.GetClusterIndex(desc.dimX / 2, desc.dimY / 2, z);
+		Check(Contains(grid, cluster, 0), "point light in its cluster");
+		Check(CountClusters(grid, 1) == 0, "point light behind");
+
+		// the spot and the disk light nothing in front of them
+		size_t nearCluster = grid.GetClusterIndex(desc.dimX / 2, desc.dimY / 2, z - 3);
+		Check(Contains(grid, nearCluster, 0) == false, "point light range");
+		Check(!Contains(grid, nearCluster, 2), "spot light cone");
+		Check(!Contains(grid, nearCluster, 3), "disk light side");
+		Check(CountClusters(grid, 2) < CountClusters(grid, 3), "spot light narrower than disk light");
+		Check(CountClusters(grid, 2) > 0, "spot light");
+	}
+
+	{ // random lights, SIMD vs reference
+		constexpr size_t N = 4096;
+		mt19937 rng{ 0 };
+		uniform_real_distribution<float> xyDist{ -60.f, 60.f };
+		uniform_real_distribution<float> zDist{ -150.f, 10.f };
+		uniform_real_distribution<float> rangeDist{ 0.5f, 8.f };
+		uniform_real_distribution<float> dirDist{ -1.f, 1.f };
+		uniform_real_distribution<float> angleDist{ 5.f, 80.f };
+		uniform_int_distribution<int> typeDist{ 1, 4 };
+
+		vector<ClusterLight> lights(N);
+		for (auto& light : lights) {
+			light.type = static_cast<LightType>(typeDist(rng));
+			light.position = { xyDist(rng), xyDist(rng), zDist(rng) };
+			vecf3 dir{ dirDist(rng), dirDist(rng), dirDist(rng) };
+			float len = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]) + 1e-6f;
+			light.dir = { dir[0] / len, dir[1] / len, dir[2] / len };
+			light.range = rangeDist(rng);
+			light.cosHalfOuterSpotAngle = std::cos(to_radian(angleDist(rng)));
+		}
+
+		const transformf view{ vecf3{ 1.f, -2.f, 3.f } };
+
+		// best of a few rounds, the first one warms up the buffers
+		auto Time = [&](LightClusterGrid& g, size_t num, bool bruteForce) {
+			double best = 1e9;
+			for (size_t round = 0; round < 5; round++) {
+				auto t0 = chrono::steady_clock::now();
+				if (bruteForce)
+					g.Assign_BruteForce(view, lights.data(), num);
+				else
+					g.Assign(view, lights.data(), num);
+				auto t1 = chrono::steady_clock::now();
+				best = std::min(best, chrono::duration<double, milli>(t1 - t0).count());
+			}
+			return best;
+		};
+
+		LightClusterGrid reference;
+		reference.SetDesc(desc);
+		const double bruteForceMs = Time(reference, N, true);
+		const double halfMs = Time(grid, N / 2, false);
+		const double ms = Time(grid, N, false);
+
+		cout << N << " lights, " << grid.GetClusterNum() << " clusters, "
+			<< grid.GetLightIndices().size() << " indices: "
+			<< ms << " ms (brute force: " << bruteForceMs << " ms), "
+			<< N / 2 << " lights: " << halfMs << " ms" << endl;
+
+		Check(ms < bruteForceMs, "faster than the brute force");
+#ifdef NDEBUG
+		// measured about 0.45 ms on a single-core VM
+		Check(halfMs < 1., "2048 lights under a millisecond");
+#endif // NDEBUG
+
+		Check(grid.GetLightIndices().size() == reference.GetLightIndices().size(), "index num");
+		Check(grid.GetLightIndices() == reference.GetLightIndices(), "indices");
+		bool sameRanges = true;
+		for (size_t c = 0; c < grid.GetClusterNum(); c++) {
+			sameRanges &= grid.GetRanges()[c].offset == reference.GetRanges()[c].offset;
+			sameRanges &= grid.GetRanges()[c].count == reference.GetRanges()[c].count;
+		}
+		Check(sameRanges, "ranges");
+	}
+
+	return CheckResult();
+}
@@ -0,0 +1,87 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/ShaderCBLayout.h>
+#include <Utopia/Render/Material.h>
+
+#include <cstring>
+#include <iostream>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+template<typename T>
+static T Read(const vector<uint8_t>& data, size_t offset) {
+	T value;
+	memcpy(&value, data.data() + offset, sizeof(T));
+	return value;
+}
+
+int main() {
+	// vs and ps of a pass, the material buffer (b1) appears in both stages
+	ShaderCBReflection refl;
+	refl.constantBuffers.push_back({ "StdPipeline_cbPerObject", 0, 128, {
+		{ "gWorld", 0, 64 },
+		{ "gInvWorld", 64, 64 },
+	} });
+	refl.constantBuffers.push_back({ "cbMaterial", 1, 48, {
+		{ "gAlbedo", 0, 12 },
+		{ "gRoughness", 12, 4 },
+		{ "gUseMap", 16, 4 },
+		{ "gTiling", 32, 8 },
+	} });
+	refl.constantBuffers.push_back({ "cbMaterial", 1, 48, {
+		{ "gAlbedo", 0, 12 },
+		{ "gRoughness", 12, 4 },
+		{ "gUseMap", 16, 4 },
+		{ "gTiling", 32, 8 },
+	} });
+	refl.constantBuffers.push_back({ "cbExtra", 3, 4, {
+		{ "gMetalness", 0, 4 },
+	} });
+
+	ShaderCBLayout layout{ refl, { "StdPipeline_cbPerObject" } };
+
+	Check(layout.GetSize() == 512, "size");
+	Check(layout.GetOffsetMap().size() == 2, "bind points");
+	Check(layout.GetOffsetMap().at(1) == 0, "offset b1");
+	Check(layout.GetOffsetMap().at(3) == 256, "offset b3");
+	Check(layout.GetEntries().size() == 5, "entries");
+	for (size_t i = 1; i < layout.GetEntries().size(); i++)
+		Check(layout.GetEntries()[i - 1].name <= layout.GetEntries()[i].name, "sorted entries");
+
+	Material material;
+	material.properties["gAlbedo"] = rgbf{ 0.5f, 0.25f, 1.f };
+	material.properties["gRoughness"] = 0.75f;
+	material.properties["gUseMap"] = true;
+	material.properties["gTiling"] = val<float, 2>{ 2.f, 3.f };
+	material.properties["gMetalness"] = 1.f;
+	material.properties["gNotInShader"] = 4.f;
+	material.properties["gMismatched"] = 1.0; // double
+
+	const auto& packed = layout.GetPacked(material);
+	Check(packed.size() == 512, "packed size");
+	Check(Read<float>(packed, 0) == 0.5f && Read<float>(packed, 8) == 1.f, "rgb");
+	Check(Read<float>(packed, 12) == 0.75f, "float");
+	Check(Read<unsigned>(packed, 16) == 1u, "bool as uint");
+	Check(Read<float>(packed, 32) == 2.f && Read<float>(packed, 36) == 3.f, "float2");
+	Check(Read<float>(packed, 256) == 1.f, "second buffer");
+	Check(Read<unsigned>(packed, 20) == 0u, "padding is zero");
+
+	// repacked only when a packed value changes
+	const uint64_t hash = material.packedCB.hash;
+	material.properties["gNotInShader"] = 8.f;
+	layout.GetPacked(material);
+	Check(material.packedCB.hash == hash, "unpacked properties don't change the hash");
+	material.properties["gRoughness"] = 0.125f;
+	Check(Read<float>(layout.GetPacked(material), 12) == 0.125f && material.packedCB.hash != hash, "repacked");
+	material.properties["gRoughness"] = 0.75f;
+	Check(Read<float>(layout.GetPacked(material), 12) == 0.75f && material.packedCB.hash == hash, "same values, same hash");
+
+	// another layout (e.g. the shader is reloaded) repacks
+	ShaderCBLayout layout2{ refl, { "StdPipeline_cbPerObject", "cbExtra" } };
+	Check(layout2.GetSize() == 256, "common buffers are skipped");
+	Check(layout2.GetPacked(material).size() == 256, "repacked for another layout");
+
+	return CheckResult();
+}
@@ -0,0 +1,148 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/DrawStream.h>
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace std;
+
+// state of the command list after the replay
+struct Device {
+	uint64_t rootSignature{ 0 };
+	uint64_t pso{ 0 };
+	uint64_t mesh{ 0 };
+	uint32_t stencilRef{ 0 };
+	map<uint32_t, uint64_t> slots;
+};
+
+int main() {
+	constexpr size_t N = 10000;
+	constexpr size_t SlotNum = 6;
+
+	mt19937 rng(7);
+	auto Rand = [&](size_t n) { return static_cast<uint64_t>(uniform_int_distribution<size_t>(0, n - 1)(rng)); };
+
+	// sorted-like sequence: runs of the same root signature / pso / mesh / material
+	vector<DrawState> states(N);
+	vector<vector<RootBinding>> bindings(N);
+	for (size_t i = 0; i < N; i++) {
+		auto& state = states[i];
+		if (i > 0 && Rand(4) != 0) {
+			state = states[i - 1];
+			bindings[i] = bindings[i - 1];
+		}
+		else {
+			state.rootSignature = 1 + Rand(3);
+			state.pso = 100 + Rand(8);
+			state.stencilEnable = Rand(2) == 0;
+			state.stencilRef = static_cast<uint32_t>(Rand(3));
+			bindings[i].clear();
+			for (uint32_t slot = 0; slot < SlotNum; slot++) {
+				if (Rand(3) != 0)
+					bindings[i].push_back({ static_cast<RootBinding::Type>(slot % 3), slot, 1000 + Rand(4) });
+			}
+		}
+		if (Rand(3) == 0)
+			state.mesh = 10 + Rand(4);
+		// per object
+		if (!bindings[i].empty())
+			bindings[i].front().value = 5000 + i;
+		state.indexCount = static_cast<uint32_t>(3 * (1 + Rand(100)));
+		state.instanceCount = static_cast<uint32_t>(1 + Rand(4));
+		state.startIndex = static_cast<uint32_t>(Rand(1000));
+		state.baseVertex = static_cast<int32_t>(Rand(1000));
+	}
+
+	DrawStream stream;
+	for (size_t i = 0; i < N; i++) {
+		states[i].bindings = bindings[i].data();
+		states[i].bindingNum = bindings[i].size();
+		stream.Add(states[i]);
+	}
+
+	const auto& records = stream.GetRecords();
+	Check(records.size() == N, "one record per draw");
+
+	// replay and compare the state of every draw
+	Device device;
+	size_t mismatches = 0;
+	for (size_t i = 0; i < records.size() && i < N; i++) {
+		const auto& record = records[i];
+		if (record.flags & DrawRecord::SetRootSignature) {
+			device.rootSignature = record.rootSignature;
+			device.slots.clear();
+		}
+		if (record.flags & DrawRecord::SetPSO)
+			device.pso = record.pso;
+		if (record.flags & DrawRecord::SetMesh)
+			device.mesh = record.mesh;
+		if (record.flags & DrawRecord::SetStencilRef)
+			device.stencilRef = record.stencilRef;
+		for (uint32_t j = 0; j < record.bindingNum; j++) {
+			const auto& binding = stream.GetBindings()[record.bindingOffset + j];
+			device.slots[binding.slot] = binding.value;
+		}
+
+		const auto& state = states[i];
+		bool match = device.rootSignature == state.rootSignature
+			&& device.pso == state.pso
+			&& device.mesh == state.mesh
+			&& (!state.stencilEnable || device.stencilRef == state.stencilRef)
+			&& record.indexCount == state.indexCount
+			&& record.instanceCount == state.instanceCount
+			&& record.startIndex == state.startIndex
+			&& record.baseVertex == state.baseVertex;
+		for (const auto& binding : bindings[i]) {
+			auto target = device.slots.find(binding.slot);
+			match &= target != device.slots.end() && target->second == binding.value;
+		}
+		if (!match)
+			mismatches++;
+	}
+	Check(mismatches == 0, "replayed state matches the full state");
+
+	size_t fullBindings = 0;
+	for (const auto& b : bindings)
+		fullBindings += b.size();
+	const auto& stats = stream.GetStats();
+	Check(stats.draws == N, "stats.draws");
+	Check(stats.bindings == stream.GetBindings().size(), "stats.bindings");
+	Check(stats.bindings + stats.skippedBindings == fullBindings, "bindings + skipped == full");
+	Check(stats.skippedBindings > 0, "redundant bindings are skipped");
+	Check(stats.psoChanges < N / 2, "redundant pso changes are skipped");
+
+	{ // a root signature change rebinds every slot
+		DrawStream s;
+		RootBinding b{ RootBinding::Type::CBV, 0, 42 };
+		DrawState state;
+		state.bindings = &b;
+		state.bindingNum = 1;
+		state.rootSignature = 1;
+		s.Add(state);
+		s.Add(state);
+		state.rootSignature = 2;
+		s.Add(state);
+		Check(s.GetRecords()[0].bindingNum == 1, "first draw binds");
+		Check(s.GetRecords()[1].bindingNum == 0 && s.GetRecords()[1].flags == 0, "same state, nothing set");
+		Check(s.GetRecords()[2].bindingNum == 1
+			&& (s.GetRecords()[2].flags & DrawRecord::SetRootSignature), "root signature change rebinds");
+
+		s.Clear();
+		Check(s.GetRecords().empty() && s.GetBindings().empty() && s.GetStats().draws == 0, "clear");
+		s.Add(state);
+		Check(s.GetRecords()[0].flags == (DrawRecord::SetRootSignature | DrawRecord::SetPSO | DrawRecord::SetMesh),
+			"first draw after clear sets the whole state");
+	}
+
+	cout << "records: " << records.size()
+		<< ", bindings: " << stats.bindings << " / " << fullBindings
+		<< ", root signature changes: " << stats.rootSignatureChanges
+		<< ", pso changes: " << stats.psoChanges
+		<< ", mesh changes: " << stats.meshChanges << endl;
+
+	return CheckResult();
+}
@@ -0,0 +1,102 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/StdFrameGraph.h>
+
+#include <algorithm>
+#include <iostream>
+#include <tuple>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+int main() {
+	UFG::FrameGraph fg;
+	UFG::Compiler compiler;
+	FrameGraphTopology topology;
+	FrameGraphCache<UFG::Compiler::Result> cache;
+
+	size_t compileNum = 0;
+	auto Compile = [&]() {
+		compileNum++;
+		return compiler.Compile(fg);
+	};
+
+	// the graph of StdPipeline is registered again every frame
+	const UFG::Compiler::Result* first = nullptr;
+	StdFrameGraph nodes;
+	for (size_t frame = 0; frame < 100; frame++) {
+		nodes = StdFrameGraph::Register(fg, topology, 1280, 720);
+		const auto* rst = cache.GetOrCompile(topology.GetHash(), Compile);
+		Check(rst != nullptr, "compile succeeds");
+		if (!rst)
+			break;
+		if (frame == 0)
+			first = rst;
+		auto [success, fresh] = compiler.Compile(fg);
+		Check(success && rst->sorted_passes == fresh.sorted_passes, "reused result == fresh result");
+	}
+	Check(cache.GetMissNum() == 1, "compiled once");
+	Check(cache.GetHitNum() == 99, "hits");
+	Check(compileNum == 1, "compile calls");
+	Check(first && first->sorted_passes.size() == 6, "all passes sorted");
+	Check(first && !first->sorted_passes.empty() && first->sorted_passes.back() == nodes.postprocessPass,
+		"post process is the last pass");
+
+	const uint64_t stdHash = topology.GetHash();
+
+	{ // resize
+		StdFrameGraph::Register(fg, topology, 1920, 1080);
+		Check(topology.GetHash() != stdHash, "resize changes the hash");
+		Check(cache.GetOrCompile(topology.GetHash(), Compile) != nullptr, "recompiled on resize");
+		Check(cache.GetMissNum() == 2, "miss on resize");
+	}
+
+	{ // topology change: an extra pass after post process
+		nodes = StdFrameGraph::Register(fg, topology, 1280, 720);
+		Check(topology.GetHash() == stdHash, "same graph, same hash");
+
+		const size_t overlayRT = fg.RegisterResourceNode("Overlay");
+		topology.AddResourceNode("Overlay");
+		const size_t overlayPass = fg.RegisterPassNode("Overlay Pass", { nodes.presentedRT }, { overlayRT });
+		topology.AddPassNode("Overlay Pass", { nodes.presentedRT }, { overlayRT });
+		Check(topology.GetHash() != stdHash, "new pass changes the hash");
+
+		const size_t misses = cache.GetMissNum();
+		const auto* rst = cache.GetOrCompile(topology.GetHash(), Compile);
+		Check(cache.GetMissNum() == misses + 1, "miss on topology change");
+		auto [success, fresh] = compiler.Compile(fg);
+		Check(rst && success && rst->sorted_passes == fresh.sorted_passes, "recompiled on topology change");
+		Check(rst && rst->sorted_passes.size() == 7 && rst->sorted_passes.back() == overlayPass,
+			"the new pass is sorted");
+
+		// "ab" + "c" vs "a" + "bc"
+		FrameGraphTopology t0, t1;
+		t0.AddResourceNode("ab");
+		t0.AddResourceNode("c");
+		t1.AddResourceNode("a");
+		t1.AddResourceNode("bc");
+		Check(t0.GetHash() != t1.GetHash(), "node boundaries are hashed");
+	}
+
+	{ // failed compilation is not cached
+		auto Fail = []() { return tuple<bool, UFG::Compiler::Result>{ false, {} }; };
+		const size_t misses = cache.GetMissNum();
+		Check(cache.GetOrCompile(1, Fail) == nullptr, "compilation fails");
+		Check(cache.GetOrCompile(1, Fail) == nullptr, "failure not cached");
+		Check(cache.GetMissNum() == misses + 2, "failures are misses");
+	}
+
+	{ // invalidate
+		StdFrameGraph::Register(fg, topology, 1280, 720);
+		cache.GetOrCompile(topology.GetHash(), Compile);
+		const size_t misses = cache.GetMissNum();
+		cache.GetOrCompile(topology.GetHash(), Compile);
+		Check(cache.GetMissNum() == misses, "hit");
+		cache.Invalidate();
+		cache.GetOrCompile(topology.GetHash(), Compile);
+		Check(cache.GetMissNum() == misses + 1, "miss after invalidate");
+	}
+
+	return CheckResult();
+}
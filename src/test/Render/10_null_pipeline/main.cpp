@@ -0,0 +1,175 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/NullPipeline.h>
+#include <Utopia/Render/Material.h>
+#include <Utopia/Render/Shader.h>
+#include <Utopia/Render/Mesh.h>
+#include <Utopia/Render/Components/Camera.h>
+#include <Utopia/Render/Components/MeshFilter.h>
+#include <Utopia/Render/Components/MeshRenderer.h>
+#include <Utopia/Core/Components/LocalToWorld.h>
+#include <Utopia/Core/Components/Translation.h>
+#include <Utopia/Core/Components/WorldToLocal.h>
+
+#include <UECS/World.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa::UECS;
+using namespace Ubpa;
+using namespace std;
+
+// unit cube
+static shared_ptr<Mesh> CreateCube() {
+	auto mesh = make_shared<Mesh>();
+	mesh->SetPositions({
+		{ -0.5f, -0.5f, -0.5f }, { 0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f },
+		{ -0.5f, -0.5f,  0.5f }, { 0.5f, -0.5f,  0.5f }, { 0.5f, 0.5f,  0.5f }, { -0.5f, 0.5f,  0.5f },
+	});
+	mesh->SetIndices({
+		0, 2, 1, 0, 3, 2,
+		4, 5, 6, 4, 6, 7,
+		0, 1, 5, 0, 5, 4,
+		3, 6, 2, 3, 7, 6,
+		0, 4, 7, 0, 7, 3,
+		1, 2, 6, 1, 6, 5,
+	});
+	mesh->SetSubMeshCount(1);
+	mesh->SetSubMesh(0, { 0, 36 });
+	return mesh;
+}
+
+struct Scene {
+	World world;
+	Entity camera;
+	vector<Entity> objects;
+};
+
+static void BuildScene(Scene& scene, size_t N, size_t materialNum, size_t meshNum) {
+	auto deferred = make_shared<Shader>();
+	deferred->passes.emplace_back();
+	deferred->passes.back().tags["LightMode"] = "Deferred";
+	auto forward = make_shared<Shader>();
+	forward->passes.emplace_back();
+	forward->passes.back().tags["LightMode"] = "Forward";
+	forward->passes.back().queue = 3000; // transparent
+
+	vector<shared_ptr<Material>> materials;
+	for (size_t i = 0; i < materialNum; i++) {
+		auto material = make_shared<Material>();
+		material->shader = i % 4 == 3 ? forward : deferred;
+		materials.push_back(material);
+	}
+	vector<shared_ptr<Mesh>> meshes;
+	for (size_t i = 0; i < meshNum; i++)
+		meshes.push_back(CreateCube());
+
+	{ // camera at the origin, looking along -z
+		auto [e, camera, w2l, translation] = scene.world.entityMngr.Create<Camera, WorldToLocal, Translation>();
+		camera->prjectionMatrix = transformf::perspective(to_radian(camera->fov), camera->aspect,
+			camera->clippingPlaneMin, camera->clippingPlaneMax, 0.f);
+		w2l->value = transformf::eye();
+		scene.camera = e;
+	}
+
+	mt19937 rng{ 0 };
+	uniform_real_distribution<float> xyDist{ -200.f, 200.f };
+	uniform_real_distribution<float> zDist{ -500.f, 500.f };
+	for (size_t i = 0; i < N; i++) {
+		auto [e, l2w, meshFilter, meshRenderer] = scene.world.entityMngr.Create<LocalToWorld, MeshFilter, MeshRenderer>();
+		l2w->value = transformf{ vecf3{ xyDist(rng), xyDist(rng), zDist(rng) } };
+		meshFilter->mesh = meshes[i % meshNum];
+		meshRenderer->materials.push_back(materials[(i / meshNum) % materialNum]);
+		scene.objects.push_back(e);
+	}
+}
+
+int main() {
+	constexpr size_t N = 20000;
+	constexpr size_t MaterialNum = 16;
+	constexpr size_t MeshNum = 8;
+	constexpr size_t NumFrame = 3;
+	constexpr size_t FrameNum = 60;
+
+	Scene scene;
+	BuildScene(scene, N, MaterialNum, MeshNum);
+	const vector<const World*> worlds{ &scene.world };
+	const RenderCamera camera{ scene.camera, scene.world };
+
+	NullPipeline pipeline{ { NumFrame, true } };
+	pipeline.Resize(1280, 720);
+
+	vector<NullPipeline::Stats> frames;
+	auto t0 = chrono::steady_clock::now();
+	for (size_t i = 0; i < FrameNum; i++) {
+		pipeline.BeginFrame(worlds, camera);
+		pipeline.Render();
+		pipeline.EndFrame();
+		frames.push_back(pipeline.GetFrameStats());
+	}
+	auto t1 = chrono::steady_clock::now();
+	double ms = chrono::duration<double, milli>(t1 - t0).count() / FrameNum;
+
+	const auto& first = frames.front();
+	const auto& last = frames.back();
+	cout << "objects: " << N << ", visible: " << first.objects << ", culled: " << first.culled << endl
+		<< "draws: " << last.draws << ", instances: " << last.instances << ", commands: " << last.commands << endl
+		<< "pso changes: " << last.psoChanges << ", mesh changes: " << last.meshChanges
+		<< ", bindings: " << last.bindings << " (skipped " << last.skippedBindings << ")" << endl
+		<< "uploaded: " << first.uploadedBytes << " B (first frame), " << last.uploadedBytes << " B (static)" << endl
+		<< "CPU: " << ms << " ms / frame" << endl;
+
+	Check(first.objects + first.culled == N, "every submesh is queued or culled");
+	Check(first.objects > 0 && first.culled > 0, "some objects are culled");
+	Check(last.instances == last.objects, "every queued object is drawn once");
+	Check(last.draws < last.instances, "instancing reduces the draws");
+	Check(first.uploadedObjects == N, "all objects uploaded in the first frame");
+	Check(frames[NumFrame].uploadedObjects == 0, "static objects are not uploaded after numFrame frames");
+	Check(last.uploadedBytes < first.uploadedBytes, "static frames upload less");
+	Check(pipeline.GetTotalStats().frameGraphCompiles == 1, "frame graph compiled once");
+	Check(pipeline.GetTotalStats().frameGraphCacheHits == FrameNum - 1, "frame graph reused");
+
+	// deterministic
+	bool same = true;
+	for (size_t i = NumFrame; i < FrameNum; i++) {
+		same &= frames[i].draws == last.draws
+			&& frames[i].commands == last.commands
+			&& frames[i].uploadedBytes == last.uploadedBytes;
+	}
+	Check(same, "static frames record the same commands");
+
+	{ // a moved object is uploaded numFrame times
+		scene.world.entityMngr.Get<LocalToWorld>(scene.objects.front())->value = transformf{ vecf3{ 0.f, 0.f, -10.f } };
+		for (size_t i = 0; i < NumFrame + 1; i++) {
+			pipeline.BeginFrame(worlds, camera);
+			pipeline.Render();
+			pipeline.EndFrame();
+			Check(pipeline.GetFrameStats().uploadedObjects == (i < NumFrame ? 1 : 0), "moved object upload");
+		}
+	}
+
+	{ // resize recompiles the frame graph
+		pipeline.Resize(1920, 1080);
+		pipeline.BeginFrame(worlds, camera);
+		pipeline.Render();
+		pipeline.EndFrame();
+		Check(pipeline.GetFrameStats().frameGraphCompiles == 1, "recompiled on resize");
+	}
+
+	{ // without instancing, one draw per object
+		NullPipeline noInstancing{ { NumFrame, false } };
+		noInstancing.Resize(1280, 720);
+		noInstancing.BeginFrame(worlds, camera);
+		noInstancing.Render();
+		noInstancing.EndFrame();
+		const auto& stats = noInstancing.GetFrameStats();
+		Check(stats.draws == stats.objects, "draw per object");
+		Check(stats.skippedBindings > 0, "redundant bindings are skipped");
+	}
+
+	return CheckResult();
+}
@@ -0,0 +1,137 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/Mesh.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+static bool Equal(const Mesh& mesh, VertexAttribute attr, size_t vertex, const void* expected) {
+	const auto& streams = mesh.GetVertexStreams();
+	const size_t i = static_cast<size_t>(attr);
+	const size_t stream = streams.streams[i];
+	const uint8_t* data = static_cast<const uint8_t*>(mesh.GetVertexBufferData())
+		+ mesh.GetVertexStreamOffset(stream)
+		+ vertex * streams.strides[stream]
+		+ streams.offsets[i];
+	return memcmp(data, expected, VertexAttributeSizes[i]) == 0;
+}
+
+static bool MatchAttributes(const Mesh& mesh) {
+	for (size_t v = 0; v < mesh.GetVertexBufferVertexCount(); v++) {
+		if (!Equal(mesh, VertexAttribute::Position, v, mesh.GetPositions()[v].data())
+			|| !Equal(mesh, VertexAttribute::UV, v, mesh.GetUV()[v].data())
+			|| !Equal(mesh, VertexAttribute::Normal, v, mesh.GetNormals()[v].data())
+			|| !Equal(mesh, VertexAttribute::Color, v, mesh.GetColors()[v].data()))
+			return false;
+	}
+	return true;
+}
+
+static void TestStreams() {
+	constexpr uint32_t all = 0b11111;
+	constexpr auto interleaved = VertexStreams::Create(VertexLayout::Interleaved, all);
+	static_assert(interleaved.streamNum == 1 && interleaved.strides[0] == 56);
+	static_assert(interleaved.offsets[static_cast<size_t>(VertexAttribute::Color)] == 44);
+
+	constexpr auto positionSplit = VertexStreams::Create(VertexLayout::PositionSplit, all);
+	static_assert(positionSplit.streamNum == 2);
+	static_assert(positionSplit.strides[0] == 12 && positionSplit.strides[1] == 44);
+	static_assert(positionSplit.GetVertexSize() == interleaved.GetVertexSize());
+
+	constexpr uint32_t noTangent = all & ~GetVertexAttributeBit(VertexAttribute::Tangent);
+	constexpr auto split = VertexStreams::Create(VertexLayout::Split, noTangent);
+	static_assert(split.streamNum == 4);
+	static_assert(split.streams[static_cast<size_t>(VertexAttribute::Color)] == 3);
+	Check(split.GetStreamMask(GetVertexAttributeBit(VertexAttribute::Normal)) == 0b0100, "split stream mask");
+	Check(split.GetStreamMask(GetVertexAttributeBit(VertexAttribute::Tangent)) == 0, "absent attribute has no stream");
+
+	// the position is always present
+	constexpr auto positionOnly = VertexStreams::Create(VertexLayout::PositionSplit, 0);
+	static_assert(positionOnly.streamNum == 1 && positionOnly.strides[0] == 12);
+}
+
+static void TestMesh() {
+	constexpr size_t n = 37;
+	vector<pointf3> positions(n);
+	vector<pointf2> uv(n);
+	vector<normalf> normals(n);
+	vector<rgbf> colors(n);
+	for (size_t i = 0; i < n; i++) {
+		float f = static_cast<float>(i);
+		positions[i] = { f, f + 0.1f, f + 0.2f };
+		uv[i] = { f * 0.5f, f * 0.25f };
+		normals[i] = { 0.f, 1.f, f };
+		colors[i] = { f, 2.f * f, 3.f * f };
+	}
+
+	Mesh mesh;
+	mesh.SetPositions(positions);
+	mesh.SetUV(uv);
+	mesh.SetNormals(normals);
+	mesh.SetColors(colors);
+
+	mesh.UpdateVertexBuffer();
+	Check(mesh.GetVertexStreams().streamNum == 1, "interleaved by default");
+	Check(mesh.GetVertexBufferVertexStride() == 44, "interleaved stride");
+	Check(MatchAttributes(mesh), "interleaved content");
+	// same bytes as the per-vertex build
+	{
+		const uint8_t* data = static_cast<const uint8_t*>(mesh.GetVertexBufferData());
+		bool match = true;
+		for (size_t i = 0; i < n; i++) {
+			const uint8_t* v = data + i * 44;
+			match &= memcmp(v, positions[i].data(), 12) == 0;
+			match &= memcmp(v + 12, uv[i].data(), 8) == 0;
+			match &= memcmp(v + 20, normals[i].data(), 12) == 0;
+			match &= memcmp(v + 32, colors[i].data(), 12) == 0;
+		}
+		Check(match, "interleaved matches the per-vertex order");
+	}
+
+	for (auto layout : { VertexLayout::PositionSplit, VertexLayout::Split }) {
+		mesh.SetVertexLayout(layout);
+		Check(mesh.IsDirty(), "layout change marks dirty");
+		mesh.UpdateVertexBuffer();
+		const auto& streams = mesh.GetVertexStreams();
+		Check(streams.layout == layout, "layout applied");
+		Check(mesh.GetVertexStreamOffset(0) == 0 && streams.strides[0] == 12, "position stream first");
+		Check(mesh.GetVertexBufferVertexStride() == 44, "total stride is independent of the layout");
+		Check(mesh.GetUpdatedVertexStreams() == (1u << streams.streamNum) - 1, "layout change rebuilds every stream");
+		Check(MatchAttributes(mesh), "split content");
+
+		// only the stream of the positions is rebuilt
+		for (auto& p : positions)
+			p[1] += 1.f;
+		mesh.SetPositions(positions);
+		mesh.UpdateVertexBuffer();
+		Check(mesh.GetUpdatedVertexStreams() == 0b1, "positions only update their stream");
+		Check(MatchAttributes(mesh), "content after a partial update");
+
+		for (auto& c : colors)
+			c[0] += 1.f;
+		mesh.SetColors(colors);
+		mesh.UpdateVertexBuffer();
+		const uint32_t colorStream = 1u << streams.streams[static_cast<size_t>(VertexAttribute::Color)];
+		Check(mesh.GetUpdatedVertexStreams() == colorStream, "colors only update their stream");
+		Check(MatchAttributes(mesh), "content after a color update");
+	}
+
+	// a new attribute changes the arrangement
+	mesh.SetTangents(vector<vecf3>(n, vecf3{ 1.f, 0.f, 0.f }));
+	mesh.UpdateVertexBuffer();
+	Check(mesh.GetVertexStreams().streamNum == 5, "tangent stream added");
+	Check(mesh.GetUpdatedVertexStreams() == 0b11111, "new attribute rebuilds every stream");
+	Check(MatchAttributes(mesh), "content after adding an attribute");
+}
+
+int main() {
+	TestStreams();
+	TestMesh();
+
+	return CheckResult();
+}
@@ -0,0 +1,206 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/Mesh.h>
+#include <Utopia/Render/VertexCodec.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+static vecf3 RandomUnit(mt19937& rng) {
+	normal_distribution<float> dist;
+	while (true) {
+		float x = dist(rng), y = dist(rng), z = dist(rng);
+		float len = sqrt(x * x + y * y + z * z);
+		if (len > 1e-4f)
+			return { x / len, y / len, z / len };
+	}
+}
+
+static float Angle(const vecf3& a, const vecf3& b) {
+	// atan2 keeps the precision of small angles
+	double cx = double(a[1]) * b[2] - double(a[2]) * b[1];
+	double cy = double(a[2]) * b[0] - double(a[0]) * b[2];
+	double cz = double(a[0]) * b[1] - double(a[1]) * b[0];
+	double d = double(a[0]) * b[0] + double(a[1]) * b[1] + double(a[2]) * b[2];
+	return static_cast<float>(atan2(sqrt(cx * cx + cy * cy + cz * cz), d));
+}
+
+static void TestHalf() {
+	// every finite half survives the round trip
+	bool roundTrip = true;
+	for (uint32_t h = 0; h < 0x10000; h++) {
+		if ((h & 0x7c00u) == 0x7c00u)
+			continue;
+		roundTrip &= EncodeHalf(DecodeHalf(static_cast<uint16_t>(h))) == h;
+	}
+	Check(roundTrip, "half round trip");
+
+	mt19937 rng{ 42 };
+	uniform_real_distribution<float> dist{ -4.f, 4.f };
+	float maxRelError = 0.f;
+	for (size_t i = 0; i < 100000; i++) {
+		float x = dist(rng);
+		if (abs(x) < 1.f / 16384.f)
+			continue;
+		maxRelError = max(maxRelError, abs(DecodeHalf(EncodeHalf(x)) - x) / abs(x));
+	}
+	Check(maxRelError <= 1.f / 2048.f, "half relative error <= 2^-11");
+
+	Check(DecodeHalf(EncodeHalf(65504.f)) == 65504.f, "half max");
+	Check(std::isinf(DecodeHalf(EncodeHalf(1e6f))), "half overflow");
+	Check(DecodeHalf(EncodeHalf(0.5f)) == 0.5f, "half exact");
+}
+
+static void TestNorm() {
+	float maxSnorm = 0.f;
+	float maxUnorm = 0.f;
+	for (size_t i = 0; i <= 10000; i++) {
+		float x = static_cast<float>(i) / 10000.f;
+		maxSnorm = max(maxSnorm, abs(DecodeSnorm16(EncodeSnorm16(2.f * x - 1.f)) - (2.f * x - 1.f)));
+		maxUnorm = max(maxUnorm, abs(DecodeUnorm8(EncodeUnorm8(x)) - x));
+	}
+	Check(maxSnorm <= 0.5f / 32767.f + 1e-7f, "snorm16 error <= half step");
+	Check(maxUnorm <= 0.5f / 255.f + 1e-7f, "unorm8 error <= half step");
+	Check(DecodeUnorm8(EncodeUnorm8(2.f)) == 1.f && DecodeUnorm8(EncodeUnorm8(-1.f)) == 0.f, "unorm8 clamp");
+}
+
+static void TestOctahedral() {
+	mt19937 rng{ 7 };
+	float maxError = 0.f;
+	for (size_t i = 0; i < 100000; i++) {
+		vecf3 v = RandomUnit(rng);
+		maxError = max(maxError, Angle(v, DecodeOctahedral(EncodeOctahedral(v))));
+	}
+	// 0.01 degree
+	cout << "octahedral max error: " << maxError << " rad" << endl;
+	Check(maxError < 1.75e-4f, "octahedral angular error < 0.01 degree");
+
+	// axes and the folded edges are exact
+	const vecf3 axes[] = { {1.f, 0.f, 0.f}, {-1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, -1.f, 0.f}, {0.f, 0.f, 1.f}, {0.f, 0.f, -1.f} };
+	for (const auto& axis : axes)
+		Check(Angle(axis, DecodeOctahedral(EncodeOctahedral(axis))) < 1e-6f, "octahedral axis");
+}
+
+static void TestMesh() {
+	constexpr size_t n = 1000;
+	mt19937 rng{ 1 };
+	uniform_real_distribution<float> dist01{ 0.f, 1.f };
+
+	vector<pointf3> positions(n);
+	vector<pointf2> uv(n);
+	vector<normalf> normals(n);
+	vector<vecf3> tangents(n);
+	vector<rgbf> colors(n);
+	vector<uint32_t> indices;
+	for (size_t i = 0; i < n; i++) {
+		positions[i] = { dist01(rng), dist01(rng), dist01(rng) };
+		uv[i] = { dist01(rng), dist01(rng) };
+		auto normal = RandomUnit(rng);
+		normals[i] = { normal[0], normal[1], normal[2] };
+		tangents[i] = RandomUnit(rng);
+		colors[i] = { dist01(rng), dist01(rng), dist01(rng) };
+	}
+	for (size_t i = 0; i + 2 < n; i++) {
+		indices.push_back(static_cast<uint32_t>(i));
+		indices.push_back(static_cast<uint32_t>(i + 1));
+		indices.push_back(static_cast<uint32_t>(i + 2));
+	}
+
+	Mesh mesh;
+	mesh.SetPositions(positions);
+	mesh.SetUV(uv);
+	mesh.SetNormals(normals);
+	mesh.SetTangents(tangents);
+	mesh.SetColors(colors);
+	mesh.SetIndices(indices);
+	mesh.UpdateVertexBuffer();
+	Check(mesh.GetVertexBufferVertexStride() == 56, "uncompressed stride");
+	Check(mesh.GetIndexBufferIndexSize() == 2, "16-bit indices");
+	{
+		const uint16_t* ib = static_cast<const uint16_t*>(mesh.GetIndexBufferData());
+		bool match = mesh.GetIndexBufferIndexCount() == indices.size();
+		for (size_t i = 0; match && i < indices.size(); i++)
+			match = ib[i] == indices[i];
+		Check(match, "16-bit index content");
+	}
+
+	for (auto compression : { VertexCompression::Standard, VertexCompression::Compact }) {
+		mesh.SetVertexCompression(compression);
+		mesh.UpdateVertexBuffer();
+
+		const auto& streams = mesh.GetVertexStreams();
+		const size_t stride = mesh.GetVertexBufferVertexStride();
+		Check(stride == (compression == VertexCompression::Standard ? 36 : 28), "compressed stride");
+
+		const uint8_t* data = static_cast<const uint8_t*>(mesh.GetVertexBufferData());
+		auto element = [&](size_t v, VertexAttribute attr) {
+			const size_t a = static_cast<size_t>(attr);
+			return data + v * stride + streams.offsets[a];
+		};
+
+		float maxPos = 0.f, maxUV = 0.f, maxNormal = 0.f, maxTangent = 0.f, maxColor = 0.f;
+		for (size_t v = 0; v < n; v++) {
+			float p[3];
+			memcpy(p, element(v, VertexAttribute::Position), sizeof(p));
+			for (size_t k = 0; k < 3; k++)
+				maxPos = max(maxPos, abs(p[k] - positions[v][k]));
+
+			uint16_t h[2];
+			memcpy(h, element(v, VertexAttribute::UV), sizeof(h));
+			for (size_t k = 0; k < 2; k++)
+				maxUV = max(maxUV, abs(DecodeHalf(h[k]) - uv[v][k]));
+
+			auto decodeDir = [&](VertexAttribute attr) {
+				if (compression == VertexCompression::Compact) {
+					array<int16_t, 2> e;
+					memcpy(e.data(), element(v, attr), sizeof(e));
+					return DecodeOctahedral(e);
+				}
+				int16_t e[4];
+				memcpy(e, element(v, attr), sizeof(e));
+				return vecf3{ DecodeSnorm16(e[0]), DecodeSnorm16(e[1]), DecodeSnorm16(e[2]) };
+			};
+			const vecf3 normal{ normals[v][0], normals[v][1], normals[v][2] };
+			maxNormal = max(maxNormal, Angle(normal, decodeDir(VertexAttribute::Normal)));
+			maxTangent = max(maxTangent, Angle(tangents[v], decodeDir(VertexAttribute::Tangent)));
+
+			uint8_t c[4];
+			memcpy(c, element(v, VertexAttribute::Color), sizeof(c));
+			for (size_t k = 0; k < 3; k++)
+				maxColor = max(maxColor, abs(DecodeUnorm8(c[k]) - colors[v][k]));
+			Check(c[3] == 255, "color alpha");
+		}
+		Check(maxPos == 0.f, "positions are exact");
+		Check(maxUV <= 1.f / 4096.f, "uv error (half in [0, 1])");
+		Check(maxNormal < 1.75e-4f, "normal angular error < 0.01 degree");
+		Check(maxTangent < 1.75e-4f, "tangent angular error < 0.01 degree");
+		Check(maxColor <= 0.5f / 255.f + 1e-6f, "color error");
+	}
+	Check(mesh.GetVertexBufferVertexStride() * 2 == 56, "compact halves the vertex");
+
+	// too many vertices for 16-bit indices
+	vector<pointf3> many(70000, pointf3{ 0.f, 0.f, 0.f });
+	Mesh big;
+	big.SetPositions(many);
+	big.SetIndices({ 0, 1, 69999 });
+	big.UpdateVertexBuffer();
+	Check(big.GetIndexBufferIndexSize() == 4, "32-bit indices");
+	Check(static_cast<const uint32_t*>(big.GetIndexBufferData())[2] == 69999, "32-bit index content");
+}
+
+int main() {
+	TestHalf();
+	TestNorm();
+	TestOctahedral();
+	TestMesh();
+
+	return CheckResult();
+}
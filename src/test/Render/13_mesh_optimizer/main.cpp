@@ -0,0 +1,214 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/MeshOptimizer.h>
+#include <Utopia/Render/Mesh.h>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+// n x n vertices, shuffled triangles
+static void MakeGrid(size_t n, vector<pointf3>& positions, vector<uint32_t>& indices, mt19937& rng) {
+	positions.clear();
+	for (size_t y = 0; y < n; y++) {
+		for (size_t x = 0; x < n; x++)
+			positions.push_back({ static_cast<float>(x), static_cast<float>(y), 0.f });
+	}
+
+	vector<array<uint32_t, 3>> triangles;
+	for (size_t y = 0; y + 1 < n; y++) {
+		for (size_t x = 0; x + 1 < n; x++) {
+			uint32_t v0 = static_cast<uint32_t>(y * n + x);
+			uint32_t v1 = v0 + 1;
+			uint32_t v2 = v0 + static_cast<uint32_t>(n);
+			uint32_t v3 = v2 + 1;
+			triangles.push_back({ v0, v1, v2 });
+			triangles.push_back({ v1, v3, v2 });
+		}
+	}
+	shuffle(triangles.begin(), triangles.end(), rng);
+
+	indices.clear();
+	for (const auto& tri : triangles) {
+		// rotate, the winding is kept
+		size_t r = rng() % 3;
+		for (size_t k = 0; k < 3; k++)
+			indices.push_back(tri[(k + r) % 3]);
+	}
+}
+
+// triangles with the smallest index first, sorted
+static vector<array<uint32_t, 3>> Canonical(const vector<uint32_t>& indices) {
+	vector<array<uint32_t, 3>> rst;
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		array<uint32_t, 3> tri{ indices[i], indices[i + 1], indices[i + 2] };
+		while (tri[0] > tri[1] || tri[0] > tri[2])
+			tri = { tri[1], tri[2], tri[0] };
+		rst.push_back(tri);
+	}
+	sort(rst.begin(), rst.end());
+	return rst;
+}
+
+static void TestGrid() {
+	mt19937 rng{ 3 };
+	vector<pointf3> positions;
+	vector<uint32_t> indices;
+	MakeGrid(100, positions, indices, rng);
+	const size_t vertexCount = positions.size();
+
+	const auto before = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+
+	vector<uint32_t> cacheOptimized(indices.size());
+	OptimizeVertexCache(cacheOptimized.data(), indices.data(), indices.size(), vertexCount);
+	const auto afterCache = AnalyzeVertexCache(cacheOptimized.data(), cacheOptimized.size(), vertexCount);
+	Check(Canonical(cacheOptimized) == Canonical(indices), "vertex cache keeps the triangles");
+	Check(afterCache.acmr < 0.8f, "vertex cache ACMR < 0.8");
+	Check(afterCache.atvr < 1.6f, "vertex cache ATVR < 1.6");
+
+	vector<uint32_t> overdrawOptimized(indices.size());
+	OptimizeOverdraw(overdrawOptimized.data(), cacheOptimized.data(), cacheOptimized.size(), positions.data(), vertexCount, 1.05f);
+	const auto afterOverdraw = AnalyzeVertexCache(overdrawOptimized.data(), overdrawOptimized.size(), vertexCount);
+	Check(Canonical(overdrawOptimized) == Canonical(indices), "overdraw keeps the triangles");
+	Check(afterOverdraw.acmr <= 1.15f * afterCache.acmr, "overdraw keeps the ACMR near the threshold");
+
+	vector<uint32_t> remap(vertexCount);
+	size_t used = OptimizeVertexFetchRemap(remap.data(), overdrawOptimized.data(), overdrawOptimized.size(), vertexCount);
+	Check(used == vertexCount, "every vertex is used");
+	uint32_t next = 0;
+	bool firstUse = true;
+	for (auto index : overdrawOptimized) {
+		uint32_t v = remap[index];
+		if (v == next)
+			next++;
+		else
+			firstUse &= v < next;
+	}
+	Check(firstUse, "vertices in the order of their first use");
+
+	cout << "ACMR " << before.acmr << " -> " << afterCache.acmr << " (cache) -> " << afterOverdraw.acmr << " (overdraw)" << endl;
+	cout << "ATVR " << before.atvr << " -> " << afterCache.atvr << " (cache) -> " << afterOverdraw.atvr << " (overdraw)" << endl;
+}
+
+// two spheres, one inside the other, the outer faces should be drawn first
+static void TestOverdrawOrder() {
+	vector<pointf3> positions;
+	vector<uint32_t> indices;
+	const size_t rings = 16, segments = 32;
+	for (float radius : { 0.5f, 1.f }) {
+		const uint32_t base = static_cast<uint32_t>(positions.size());
+		for (size_t r = 0; r <= rings; r++) {
+			float theta = 3.14159265f * static_cast<float>(r) / rings;
+			for (size_t s = 0; s <= segments; s++) {
+				float phi = 2.f * 3.14159265f * static_cast<float>(s) / segments;
+				positions.push_back({ radius * sin(theta) * cos(phi), radius * cos(theta), radius * sin(theta) * sin(phi) });
+			}
+		}
+		for (size_t r = 0; r < rings; r++) {
+			for (size_t s = 0; s < segments; s++) {
+				uint32_t v0 = base + static_cast<uint32_t>(r * (segments + 1) + s);
+				uint32_t v1 = v0 + 1;
+				uint32_t v2 = v0 + static_cast<uint32_t>(segments + 1);
+				uint32_t v3 = v2 + 1;
+				indices.insert(indices.end(), { v0, v1, v2, v1, v3, v2 });
+			}
+		}
+	}
+	// the inner sphere first
+	const size_t half = indices.size() / 2;
+	rotate(indices.begin(), indices.begin() + half, indices.end());
+
+	vector<uint32_t> cacheOptimized(indices.size());
+	OptimizeVertexCache(cacheOptimized.data(), indices.data(), indices.size(), positions.size());
+	vector<uint32_t> overdrawOptimized(indices.size());
+	OptimizeOverdraw(overdrawOptimized.data(), cacheOptimized.data(), cacheOptimized.size(), positions.data(), positions.size(), 1.05f);
+
+	const uint32_t innerEnd = static_cast<uint32_t>((rings + 1) * (segments + 1));
+	size_t outerInFirstHalf = 0;
+	for (size_t i = 0; i < half; i += 3) {
+		if (overdrawOptimized[i] >= innerEnd)
+			outerInFirstHalf++;
+	}
+	Check(outerInFirstHalf * 3 > half * 3 / 4, "outer sphere mostly drawn first");
+}
+
+static void TestMesh() {
+	mt19937 rng{ 5 };
+	vector<pointf3> gridPositions;
+	vector<uint32_t> gridIndices;
+	MakeGrid(20, gridPositions, gridIndices, rng);
+
+	// submesh 0: grid, submesh 1: the same grid with a base vertex, one unused vertex at the end
+	vector<pointf3> positions = gridPositions;
+	for (const auto& p : gridPositions)
+		positions.push_back({ p[0], p[1], 1.f });
+	positions.push_back({ -1.f, -1.f, -1.f });
+	vector<uint32_t> indices = gridIndices;
+	indices.insert(indices.end(), gridIndices.begin(), gridIndices.end());
+
+	auto trianglePositions = [](const Mesh& mesh, size_t submeshIdx) {
+		const auto& submesh = mesh.GetSubMeshes()[submeshIdx];
+		vector<array<float, 9>> rst;
+		for (size_t i = 0; i < submesh.indexCount; i += 3) {
+			array<array<float, 3>, 3> tri;
+			for (size_t k = 0; k < 3; k++) {
+				const auto& p = mesh.GetPositions()[mesh.GetIndices()[submesh.indexStart + i + k] + submesh.baseVertex];
+				tri[k] = { p[0], p[1], p[2] };
+			}
+			while (tri[0] > tri[1] || tri[0] > tri[2])
+				tri = { tri[1], tri[2], tri[0] };
+			rst.push_back({ tri[0][0], tri[0][1], tri[0][2], tri[1][0], tri[1][1], tri[1][2], tri[2][0], tri[2][1], tri[2][2] });
+		}
+		sort(rst.begin(), rst.end());
+		return rst;
+	};
+
+	Mesh mesh;
+	mesh.SetPositions(positions);
+	mesh.SetIndices(indices);
+	mesh.SetSubMeshCount(2);
+	mesh.SetSubMesh(0, { 0, gridIndices.size() });
+	SubMeshDescriptor desc1{ gridIndices.size(), gridIndices.size() };
+	desc1.baseVertex = gridPositions.size();
+	mesh.SetSubMesh(1, desc1);
+
+	// the first bone index is the old vertex
+	vector<valu4> boneIndices(positions.size());
+	vector<valf4> boneWeights(positions.size());
+	for (size_t v = 0; v < positions.size(); v++) {
+		boneIndices[v] = { v, 0, 0, 0 };
+		boneWeights[v] = { 1.f, 0.f, 0.f, 0.f };
+	}
+	mesh.SetBoneWeights(boneIndices, boneWeights);
+
+	const auto triangles0 = trianglePositions(mesh, 0);
+	const auto triangles1 = trianglePositions(mesh, 1);
+
+	auto report = OptimizeMesh(mesh);
+	Check(report.after.acmr < report.before.acmr, "mesh ACMR decreases");
+	Check(mesh.GetPositions().size() == positions.size() - 1, "unused vertex removed");
+	Check(mesh.GetSubMeshes()[1].baseVertex == 0, "base vertex folded");
+	Check(trianglePositions(mesh, 0) == triangles0, "submesh 0 keeps its triangles");
+	Check(trianglePositions(mesh, 1) == triangles1, "submesh 1 keeps its triangles");
+	Check(mesh.IsDirty(), "mesh is dirty");
+
+	bool bonesRemapped = mesh.GetBoneIndices().size() == mesh.GetPositions().size()
+		&& mesh.GetBoneWeights().size() == mesh.GetPositions().size();
+	for (size_t v = 0; bonesRemapped && v < mesh.GetPositions().size(); v++)
+		bonesRemapped = mesh.GetPositions()[v] == positions[mesh.GetBoneIndices()[v][0]];
+	Check(bonesRemapped, "bone weights follow the vertices");
+}
+
+int main() {
+	TestGrid();
+	TestOverdrawOrder();
+	TestMesh();
+
+	return CheckResult();
+}
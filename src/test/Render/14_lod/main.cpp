@@ -0,0 +1,290 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/MeshSimplifier.h>
+#include <Utopia/Render/MeshOptimizer.h>
+#include <Utopia/Render/LODSelection.h>
+#include <Utopia/Render/Mesh.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+static array<double, 3> Normal(const vector<pointf3>& positions, const uint32_t* tri) {
+	const auto& p0 = positions[tri[0]];
+	const auto& p1 = positions[tri[1]];
+	const auto& p2 = positions[tri[2]];
+	const double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	return {
+		e1[1] * e2[2] - e1[2] * e2[1],
+		e1[2] * e2[0] - e1[0] * e2[2],
+		e1[0] * e2[1] - e1[1] * e2[0],
+	};
+}
+
+// unit UV sphere, outward winding
+// the column u = 1 duplicates the positions of u = 0 (UV seam), one vertex per pole (u = -1)
+static void MakeSphere(size_t segments, size_t rings, vector<pointf3>& positions, vector<uint32_t>& indices, vector<float>& us) {
+	const float pi = 3.14159265f;
+	positions.clear();
+	indices.clear();
+	us.clear();
+
+	positions.push_back({ 0.f, 1.f, 0.f });
+	us.push_back(-1.f);
+	for (size_t r = 1; r < rings; r++) {
+		const float theta = pi * r / rings;
+		for (size_t s = 0; s <= segments; s++) {
+			const float phi = 2.f * pi * (s % segments) / segments;
+			positions.push_back({ sin(theta) * cos(phi), cos(theta), -sin(theta) * sin(phi) });
+			us.push_back(static_cast<float>(s) / segments);
+		}
+	}
+	positions.push_back({ 0.f, -1.f, 0.f });
+	us.push_back(-1.f);
+
+	const uint32_t row = static_cast<uint32_t>(segments + 1);
+	auto vertex = [&](size_t r, size_t s) { return static_cast<uint32_t>(1 + (r - 1) * row + s); };
+	const uint32_t south = static_cast<uint32_t>(positions.size() - 1);
+	for (size_t s = 0; s < segments; s++) {
+		indices.insert(indices.end(), { 0, vertex(1, s), vertex(1, s + 1) });
+		indices.insert(indices.end(), { south, vertex(rings - 1, s + 1), vertex(rings - 1, s) });
+	}
+	for (size_t r = 1; r + 1 < rings; r++) {
+		for (size_t s = 0; s < segments; s++) {
+			indices.insert(indices.end(), { vertex(r, s), vertex(r + 1, s), vertex(r + 1, s + 1) });
+			indices.insert(indices.end(), { vertex(r, s), vertex(r + 1, s + 1), vertex(r, s + 1) });
+		}
+	}
+}
+
+static bool AllFacingOutwards(const vector<pointf3>& positions, const vector<uint32_t>& indices) {
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		auto n = Normal(positions, indices.data() + i);
+		double c[3] = { 0., 0., 0. };
+		for (size_t k = 0; k < 3; k++) {
+			for (size_t d = 0; d < 3; d++)
+				c[d] += positions[indices[i + k]][d];
+		}
+		if (n[0] * c[0] + n[1] * c[1] + n[2] * c[2] <= 0.)
+			return false;
+	}
+	return true;
+}
+
+// every edge (by position) has 2 triangles
+static bool IsClosed(const vector<pointf3>& positions, const vector<uint32_t>& indices) {
+	map<pair<array<float, 3>, array<float, 3>>, size_t> edges;
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		for (size_t k = 0; k < 3; k++) {
+			const auto& a = positions[indices[i + k]];
+			const auto& b = positions[indices[i + (k + 1) % 3]];
+			array<float, 3> pa{ a[0], a[1], a[2] };
+			array<float, 3> pb{ b[0], b[1], b[2] };
+			edges[minmax(pa, pb)]++;
+		}
+	}
+	for (const auto& [edge, count] : edges) {
+		if (count != 2)
+			return false;
+	}
+	return true;
+}
+
+static void TestSphere() {
+	vector<pointf3> positions;
+	vector<uint32_t> indices;
+	vector<float> us;
+	MakeSphere(48, 24, positions, indices, us);
+
+	vector<uint32_t> lod;
+	const size_t target = indices.size() / 4 / 3 * 3;
+	float error = SimplifyIndices(lod, indices.data(), indices.size(), positions.data(), positions.size(), target, 0.1f);
+	Check(lod.size() <= target, "sphere reaches the target");
+	Check(lod.size() > 0, "sphere keeps triangles");
+	Check(error > 0.f && error <= 0.1f, "sphere error in (0, target error]");
+	Check(AllFacingOutwards(positions, lod), "sphere has no flipped triangles");
+	Check(IsClosed(positions, lod), "sphere stays closed");
+
+	// a triangle across the seam would stretch over the whole texture
+	bool seamKept = true;
+	for (size_t i = 0; i < lod.size(); i += 3) {
+		float minU = 1.f, maxU = 0.f;
+		for (size_t k = 0; k < 3; k++) {
+			const float u = us[lod[i + k]];
+			if (u < 0.f)
+				continue;
+			minU = min(minU, u);
+			maxU = max(maxU, u);
+		}
+		seamKept &= maxU - minU < 0.5f;
+	}
+	Check(seamKept, "no triangle crosses the seam");
+
+	// the error bound stops the simplification
+	vector<uint32_t> strict;
+	float strictError = SimplifyIndices(strict, indices.data(), indices.size(), positions.data(), positions.size(), target, 1e-6f);
+	Check(strict.size() == indices.size() && strictError == 0.f, "tiny error bound keeps the sphere");
+}
+
+static void TestGridBorder() {
+	// flat n x n grid, a border only collapses along itself, so the area is kept
+	const size_t n = 17;
+	vector<pointf3> positions;
+	vector<uint32_t> indices;
+	for (size_t y = 0; y < n; y++) {
+		for (size_t x = 0; x < n; x++)
+			positions.push_back({ static_cast<float>(x), static_cast<float>(y), 0.f });
+	}
+	for (size_t y = 0; y + 1 < n; y++) {
+		for (size_t x = 0; x + 1 < n; x++) {
+			uint32_t v0 = static_cast<uint32_t>(y * n + x);
+			uint32_t v1 = v0 + 1;
+			uint32_t v2 = v0 + static_cast<uint32_t>(n);
+			uint32_t v3 = v2 + 1;
+			indices.insert(indices.end(), { v0, v1, v2, v1, v3, v2 });
+		}
+	}
+
+	vector<uint32_t> lod;
+	float error = SimplifyIndices(lod, indices.data(), indices.size(), positions.data(), positions.size(), 6, 1e-3f);
+	Check(lod.size() < indices.size() / 10, "flat grid collapses");
+	Check(error < 1e-3f, "flat grid error");
+
+	double area = 0.;
+	bool upward = true;
+	for (size_t i = 0; i < lod.size(); i += 3) {
+		auto normal = Normal(positions, lod.data() + i);
+		upward &= normal[2] > 0.;
+		area += 0.5 * normal[2];
+	}
+	const double expected = static_cast<double>((n - 1) * (n - 1));
+	Check(upward, "flat grid has no flipped triangles");
+	Check(abs(area - expected) < 1e-3, "flat grid keeps its border");
+
+	// a vertex only collapses in its region
+	vector<uint32_t> ownRegions(positions.size());
+	for (size_t v = 0; v < positions.size(); v++)
+		ownRegions[v] = static_cast<uint32_t>(v);
+	vector<uint32_t> isolated;
+	SimplifyIndices(isolated, indices.data(), indices.size(), positions.data(), positions.size(), 6, 1e-3f, ownRegions.data());
+	Check(isolated == indices, "a region per vertex keeps the grid");
+
+	// the middle column is kept, a vertex per region
+	vector<uint32_t> regions(positions.size(), 0);
+	for (size_t y = 0; y < n; y++)
+		regions[y * n + n / 2] = static_cast<uint32_t>(1 + y);
+	vector<uint32_t> split;
+	SimplifyIndices(split, indices.data(), indices.size(), positions.data(), positions.size(), 6, 1e-3f, regions.data());
+	bool columnKept = true;
+	for (size_t y = 0; y < n; y++)
+		columnKept &= find(split.begin(), split.end(), static_cast<uint32_t>(y * n + n / 2)) != split.end();
+	Check(split.size() < indices.size() / 4, "the regions collapse");
+	Check(columnKept, "no collapse across the regions");
+}
+
+static void TestGenerateLODs() {
+	vector<pointf3> positions;
+	vector<uint32_t> indices;
+	vector<float> us;
+	MakeSphere(32, 16, positions, indices, us);
+	const size_t indexCount = indices.size();
+
+	Mesh mesh;
+	mesh.SetPositions(positions);
+	mesh.SetIndices(indices);
+	mesh.SetSubMeshCount(1);
+	mesh.SetSubMesh(0, { 0, indexCount });
+
+	LODGenerationDesc desc;
+	desc.levelNum = 4;
+	desc.ratio = 0.5f;
+	desc.maxError = 0.2f;
+	size_t levelNum = GenerateLODs(mesh, desc);
+	Check(levelNum == 4 && mesh.GetLODNum() == 4, "4 levels");
+
+	bool decreasing = true;
+	bool inRange = true;
+	for (size_t lod = 1; lod < mesh.GetLODNum(); lod++) {
+		const auto& prev = mesh.GetLODSubMeshes(lod - 1)[0];
+		const auto& desc = mesh.GetLODSubMeshes(lod)[0];
+		decreasing &= desc.indexCount < prev.indexCount;
+		inRange &= desc.indexStart + desc.indexCount <= mesh.GetIndices().size();
+		inRange &= desc.indexCount % 3 == 0;
+	}
+	Check(decreasing, "levels get coarser");
+	Check(inRange, "levels index the index buffer");
+	Check(mesh.GetSubMeshes()[0].indexCount == indexCount, "level 0 is the mesh");
+	Check(mesh.GetLODSubMeshes(3)[0].indexCount <= indexCount / 8 + 3, "level 3 ~ 1/8 of the triangles");
+
+	// the levels survive the optimization
+	vector<size_t> counts;
+	for (size_t lod = 0; lod < mesh.GetLODNum(); lod++)
+		counts.push_back(mesh.GetLODSubMeshes(lod)[0].indexCount);
+	OptimizeMesh(mesh);
+	bool kept = mesh.GetLODNum() == counts.size();
+	for (size_t lod = 0; kept && lod < mesh.GetLODNum(); lod++) {
+		const auto& desc = mesh.GetLODSubMeshes(lod)[0];
+		kept &= desc.indexCount == counts[lod] && desc.baseVertex == 0;
+		vector<uint32_t> range(
+			mesh.GetIndices().begin() + desc.indexStart,
+			mesh.GetIndices().begin() + desc.indexStart + desc.indexCount
+		);
+		kept &= AllFacingOutwards(mesh.GetPositions(), range);
+	}
+	Check(kept, "levels kept by OptimizeMesh");
+
+	// changing the submeshes drops the levels
+	mesh.SetSubMeshCount(1);
+	Check(mesh.GetLODNum() == 1, "SetSubMeshCount drops the levels");
+}
+
+static void TestSelection() {
+	const float thresholds[] = { 0.5f, 0.25f, 0.125f };
+
+	Check(SelectLOD(1.f, 0, thresholds, 3, 0.f) == 0, "large -> 0");
+	Check(SelectLOD(0.3f, 0, thresholds, 3, 0.f) == 1, "0.3 -> 1");
+	Check(SelectLOD(0.2f, 0, thresholds, 3, 0.f) == 2, "0.2 -> 2");
+	Check(SelectLOD(0.01f, 0, thresholds, 3, 0.f) == 3, "small -> 3");
+	Check(SelectLOD(0.01f, 7, thresholds, 3, 0.f) == 3, "current level clamped");
+
+	// hysteresis 0.1: coarser below 0.45, finer above 0.55
+	Check(SelectLOD(0.48f, 0, thresholds, 3, 0.1f) == 0, "stays at 0 in the band");
+	Check(SelectLOD(0.44f, 0, thresholds, 3, 0.1f) == 1, "0 -> 1 below the band");
+	Check(SelectLOD(0.52f, 1, thresholds, 3, 0.1f) == 1, "stays at 1 in the band");
+	Check(SelectLOD(0.56f, 1, thresholds, 3, 0.1f) == 0, "1 -> 0 above the band");
+	Check(SelectLOD(0.1f, 0, thresholds, 3, 0.1f) == 3, "0 -> 3 at once");
+	Check(SelectLOD(0.24f, 0, thresholds, 3, 0.1f) == 1, "0 -> 1, 2 is in its band");
+	Check(SelectLOD(0.3f, 3, thresholds, 3, 0.1f) == 1, "3 -> 1, 0 is in its band");
+
+	// no popping while the size oscillates around a threshold
+	size_t lod = 0;
+	size_t switches = 0;
+	for (size_t i = 0; i < 100; i++) {
+		float size = 0.25f + (i % 2 == 0 ? 0.01f : -0.01f);
+		size_t next = SelectLOD(size, lod, thresholds, 3, 0.1f);
+		switches += next != lod;
+		lod = next;
+	}
+	Check(switches <= 1, "oscillation doesn't pop");
+
+	Check(abs(ComputeLODScreenSize({ 0.f, 0.f, 10.f }, 1.f, { 0.f, 0.f, 0.f }, 1.f) - 0.1f) < 1e-6f, "screen size");
+	Check(ComputeLODScreenSize({ 0.f, 0.f, 0.5f }, 1.f, { 0.f, 0.f, 0.f }, 1.f) == numeric_limits<float>::infinity(), "eye inside");
+}
+
+int main() {
+	TestSphere();
+	TestGridBorder();
+	TestGenerateLODs();
+	TestSelection();
+
+	return CheckResult();
+}
@@ -0,0 +1,229 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/Meshlet.h>
+#include <Utopia/Render/FrustumCulling.h>
+#include <Utopia/Render/Mesh.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+static void MakeGrid(size_t n, vector<pointf3>& positions, vector<uint32_t>& indices) {
+	positions.clear();
+	indices.clear();
+	for (size_t y = 0; y < n; y++) {
+		for (size_t x = 0; x < n; x++)
+			positions.push_back({ static_cast<float>(x), static_cast<float>(y), 0.f });
+	}
+	for (size_t y = 0; y + 1 < n; y++) {
+		for (size_t x = 0; x + 1 < n; x++) {
+			uint32_t v0 = static_cast<uint32_t>(y * n + x);
+			uint32_t v1 = v0 + 1;
+			uint32_t v2 = v0 + static_cast<uint32_t>(n);
+			uint32_t v3 = v2 + 1;
+			indices.insert(indices.end(), { v0, v1, v2, v1, v3, v2 });
+		}
+	}
+}
+
+// unit UV sphere, outward winding
+static void MakeSphere(size_t segments, size_t rings, vector<pointf3>& positions, vector<uint32_t>& indices) {
+	const float pi = 3.14159265f;
+	positions.clear();
+	indices.clear();
+	for (size_t r = 0; r <= rings; r++) {
+		const float theta = pi * r / rings;
+		for (size_t s = 0; s <= segments; s++) {
+			const float phi = 2.f * pi * s / segments;
+			positions.push_back({ sin(theta) * cos(phi), cos(theta), -sin(theta) * sin(phi) });
+		}
+	}
+	const uint32_t row = static_cast<uint32_t>(segments + 1);
+	for (uint32_t r = 0; r < rings; r++) {
+		for (uint32_t s = 0; s < segments; s++) {
+			uint32_t v0 = r * row + s;
+			uint32_t v1 = v0 + row;
+			if (r != 0)
+				indices.insert(indices.end(), { v0, v1, v1 + 1 });
+			if (r + 1 != rings)
+				indices.insert(indices.end(), { v0, v1 + 1, v0 + 1 });
+		}
+	}
+}
+
+static array<float, 3> Normal(const pointf3& p0, const pointf3& p1, const pointf3& p2) {
+	const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	return {
+		e1[1] * e2[2] - e1[2] * e2[1],
+		e1[2] * e2[0] - e1[0] * e2[2],
+		e1[0] * e2[1] - e1[1] * e2[0],
+	};
+}
+
+// every plane keeps everything
+static Frustum OpenFrustum() {
+	Frustum frustum;
+	for (auto& plane : frustum.planes)
+		plane = { 0.f, 0.f, 0.f, 1.f };
+	return frustum;
+}
+
+static void TestBuild() {
+	vector<pointf3> positions;
+	vector<uint32_t> indices;
+	MakeGrid(33, positions, indices);
+
+	MeshletData data;
+	vector<uint32_t> ordered(indices.size());
+	BuildMeshlets(data, ordered.data(), indices.data(), indices.size(), positions.data(), positions.size());
+
+	bool limits = true;
+	bool same = true;
+	bool contained = true;
+	bool flat = true;
+	size_t triangleNum = 0;
+	size_t indexStart = 0;
+	for (size_t i = 0; i < data.meshlets.size(); i++) {
+		const auto& meshlet = data.meshlets[i];
+		const auto& bounds = data.bounds[i];
+		limits &= meshlet.vertexCount <= MeshletMaxVertices && meshlet.triangleCount <= MeshletMaxTriangles;
+		limits &= meshlet.triangleCount > 0;
+		same &= meshlet.indexStart == indexStart;
+		for (uint32_t t = 0; t < 3 * meshlet.triangleCount; t++) {
+			uint8_t local = data.triangles[meshlet.triangleOffset + t];
+			same &= local < meshlet.vertexCount;
+			uint32_t v = data.vertices[meshlet.vertexOffset + local];
+			same &= v == ordered[meshlet.indexStart + t];
+			const auto& p = positions[v];
+			const float d[3] = { p[0] - bounds.center[0], p[1] - bounds.center[1], p[2] - bounds.center[2] };
+			contained &= sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) <= bounds.radius + 1e-4f;
+		}
+		flat &= bounds.coneCutoff < 1e-3f && bounds.coneAxis[2] > 0.999f;
+		triangleNum += meshlet.triangleCount;
+		indexStart += 3 * meshlet.triangleCount;
+	}
+	Check(limits, "meshlet limits");
+	Check(same, "meshlets follow the reordered triangles");
+	Check(triangleNum == indices.size() / 3, "every triangle in a meshlet");
+
+	// same triangles with the same winding
+	auto SortedTriangles = [](const vector<uint32_t>& indices) {
+		vector<array<uint32_t, 3>> triangles;
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			array<uint32_t, 3> triangle{ indices[i], indices[i + 1], indices[i + 2] };
+			rotate(triangle.begin(), min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+	Check(SortedTriangles(ordered) == SortedTriangles(indices), "triangles are reordered only");
+	Check(contained, "bounding spheres contain the vertices");
+	Check(flat, "flat grid has a zero-spread cone");
+	// 2048 triangles, a 64-vertex meshlet holds at most ~98 triangles of a grid
+	Check(data.meshlets.size() <= 2048 / 60, "meshlets are well filled");
+}
+
+static void TestMeshAndCulling() {
+	vector<pointf3> positions;
+	vector<uint32_t> indices;
+	MakeSphere(64, 32, positions, indices);
+
+	// submesh 1 is the sphere with a base vertex
+	vector<pointf3> meshPositions = { { 9.f, 9.f, 9.f } };
+	meshPositions.insert(meshPositions.end(), positions.begin(), positions.end());
+	vector<uint32_t> meshIndices = { 0, 0, 0 };
+	meshIndices.insert(meshIndices.end(), indices.begin(), indices.end());
+
+	Mesh mesh;
+	mesh.SetPositions(meshPositions);
+	mesh.SetIndices(meshIndices);
+	mesh.SetSubMeshCount(2);
+	mesh.SetSubMesh(0, { 0, 3 });
+	SubMeshDescriptor desc{ 3, indices.size() };
+	desc.baseVertex = 1;
+	mesh.SetSubMesh(1, desc);
+
+	BuildMeshlets(mesh);
+	const auto& data = mesh.GetMeshlets();
+	Check(data.GetSubMeshMeshletNum(0) == 1 && data.GetSubMeshMeshletNum(1) > 1, "meshlets per submesh");
+
+	// the index buffer follows the meshlets
+	bool consistent = true;
+	for (size_t i = data.submeshOffsets[1]; i < data.submeshOffsets[2]; i++) {
+		const auto& meshlet = data.meshlets[i];
+		for (uint32_t t = 0; t < 3 * meshlet.triangleCount; t++) {
+			uint32_t v = data.vertices[meshlet.vertexOffset + data.triangles[meshlet.triangleOffset + t]];
+			consistent &= mesh.GetIndices()[meshlet.indexStart + t] + 1 == v;
+		}
+	}
+	Check(consistent, "index buffer in meshlet order");
+	Check(mesh.GetSubMeshes()[1].indexCount == indices.size(), "submesh keeps its triangles");
+
+	// backface culling, eye on +z
+	const pointf3 eye{ 0.f, 0.f, 5.f };
+	vector<MeshletIndexRange> ranges;
+	auto stats = CullMeshlets(ranges, data, 1, OpenFrustum(), eye);
+	Check(stats.backfaceCulled > 0, "back meshlets culled");
+	Check(stats.frustumCulled == 0, "open frustum culls nothing");
+	Check(stats.visible + stats.backfaceCulled == data.GetSubMeshMeshletNum(1), "every meshlet counted");
+
+	// conservative: the front-facing triangles with a vertex at x >= minX are in the ranges
+	const auto& sphereIndices = mesh.GetIndices();
+	auto KeepsFront = [&](const vector<MeshletIndexRange>& ranges, const pointf3& eye, float minX) {
+		vector<uint8_t> drawn(sphereIndices.size() / 3, 0);
+		for (const auto& range : ranges) {
+			for (size_t j = 0; j < range.indexCount; j += 3)
+				drawn[(range.indexStart + j) / 3] = 1;
+		}
+		for (size_t i = 3; i < sphereIndices.size(); i += 3) {
+			const auto& p0 = meshPositions[sphereIndices[i + 0] + 1];
+			const auto& p1 = meshPositions[sphereIndices[i + 1] + 1];
+			const auto& p2 = meshPositions[sphereIndices[i + 2] + 1];
+			auto n = Normal(p0, p1, p2);
+			const float toEye[3] = { eye[0] - p0[0], eye[1] - p0[1], eye[2] - p0[2] };
+			const bool front = n[0] * toEye[0] + n[1] * toEye[1] + n[2] * toEye[2] > 0.f;
+			const bool inside = max({ p0[0], p1[0], p2[0] }) >= minX;
+			if (front && inside && !drawn[i / 3])
+				return false;
+		}
+		return true;
+	};
+
+	size_t rangeTriangles = 0;
+	bool ordered = true;
+	for (size_t i = 0; i < ranges.size(); i++) {
+		if (i > 0)
+			ordered &= ranges[i - 1].indexStart + ranges[i - 1].indexCount < ranges[i].indexStart;
+		rangeTriangles += ranges[i].indexCount / 3;
+	}
+	Check(ordered, "ranges sorted and merged");
+	Check(KeepsFront(ranges, eye, -2.f), "front-facing triangles are kept");
+	Check(rangeTriangles < indices.size() / 3 * 3 / 4, "back of the sphere culled");
+
+	// frustum culling, keep x >= 0.5
+	Frustum frustum = OpenFrustum();
+	frustum.planes[0] = { 1.f, 0.f, 0.f, -0.5f };
+	const pointf3 sideEye{ 100.f, 0.f, 0.f };
+	ranges.clear();
+	stats = CullMeshlets(ranges, data, 1, frustum, sideEye);
+	Check(stats.frustumCulled > 0, "meshlets outside culled");
+	Check(KeepsFront(ranges, sideEye, 0.5f), "meshlets inside kept");
+
+	mesh.SetIndices(mesh.GetIndices());
+	Check(mesh.GetMeshlets().Empty(), "SetIndices clears the meshlets");
+}
+
+int main() {
+	TestBuild();
+	TestMeshAndCulling();
+
+	return CheckResult();
+}
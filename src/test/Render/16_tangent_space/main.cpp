@@ -0,0 +1,245 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/Mesh.h>
+#include <Utopia/Render/TangentSpace.h>
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+static void MakeGrid(size_t n, vector<pointf3>& positions, vector<pointf2>& uv, vector<uint32_t>& indices) {
+	positions.clear();
+	uv.clear();
+	indices.clear();
+	for (size_t y = 0; y < n; y++) {
+		for (size_t x = 0; x < n; x++) {
+			positions.push_back({ static_cast<float>(x), static_cast<float>(y), 0.f });
+			uv.push_back({ static_cast<float>(x) / (n - 1), static_cast<float>(y) / (n - 1) });
+		}
+	}
+	for (size_t y = 0; y + 1 < n; y++) {
+		for (size_t x = 0; x + 1 < n; x++) {
+			uint32_t v0 = static_cast<uint32_t>(y * n + x);
+			uint32_t v1 = v0 + 1;
+			uint32_t v2 = v0 + static_cast<uint32_t>(n);
+			uint32_t v3 = v2 + 1;
+			indices.insert(indices.end(), { v0, v1, v2, v1, v3, v2 });
+		}
+	}
+}
+
+// unit UV sphere, outward winding
+static void MakeSphere(size_t segments, size_t rings, vector<pointf3>& positions, vector<pointf2>& uv, vector<uint32_t>& indices) {
+	const float pi = 3.14159265f;
+	positions.clear();
+	uv.clear();
+	indices.clear();
+	for (size_t r = 0; r <= rings; r++) {
+		const float theta = pi * r / rings;
+		for (size_t s = 0; s <= segments; s++) {
+			const float phi = 2.f * pi * s / segments;
+			positions.push_back({ sin(theta) * cos(phi), cos(theta), -sin(theta) * sin(phi) });
+			uv.push_back({ static_cast<float>(s) / segments, static_cast<float>(r) / rings });
+		}
+	}
+	const uint32_t row = static_cast<uint32_t>(segments + 1);
+	for (uint32_t r = 0; r < rings; r++) {
+		for (uint32_t s = 0; s < segments; s++) {
+			uint32_t v0 = r * row + s;
+			uint32_t v1 = v0 + row;
+			if (r != 0)
+				indices.insert(indices.end(), { v0, v1, v1 + 1 });
+			if (r + 1 != rings)
+				indices.insert(indices.end(), { v0, v1 + 1, v0 + 1 });
+		}
+	}
+}
+
+static float Length(const normalf& n) {
+	return sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+}
+
+static void TestNormals() {
+	vector<pointf3> positions;
+	vector<pointf2> uv;
+	vector<uint32_t> indices;
+	MakeSphere(32, 16, positions, uv, indices);
+
+	// vertex 0 has no triangle, the ones after it are still normalized
+	vector<pointf3> meshPositions = { { 0.f, 0.f, 0.f } };
+	meshPositions.insert(meshPositions.end(), positions.begin(), positions.end());
+
+	Mesh mesh;
+	mesh.SetPositions(meshPositions);
+	mesh.SetIndices(indices);
+	mesh.SetSubMeshCount(1);
+	SubMeshDescriptor desc{ 0, indices.size() };
+	desc.baseVertex = 1;
+	mesh.SetSubMesh(0, desc);
+	mesh.GenNormals();
+
+	const auto& normals = mesh.GetNormals();
+	Check(normals.size() == meshPositions.size(), "a normal per vertex");
+	Check(Length(normals[0]) == 0.f, "vertex without triangles has a zero normal");
+	bool unit = true;
+	bool outward = true;
+	for (size_t i = 1; i < normals.size(); i++) {
+		const auto& n = normals[i];
+		const auto& p = meshPositions[i];
+		// the pole copies only have (nearly) zero-area triangles
+		if (abs(p[1]) > 0.999f) {
+			unit &= Length(n) == 0.f || abs(Length(n) - 1.f) < 1e-5f;
+			continue;
+		}
+		unit &= abs(Length(n) - 1.f) < 1e-5f;
+		// the seam only sees half of its ring
+		outward &= n[0] * p[0] + n[1] * p[1] + n[2] * p[2] > 0.9f;
+	}
+	Check(unit, "normals after a zero normal are normalized");
+	Check(outward, "sphere normals point outward");
+
+	// dynamic mesh, new positions with the same topology
+	for (auto& p : meshPositions) {
+		p[0] *= 2.f;
+		p[1] = -p[1];
+	}
+	mesh.SetPositions(meshPositions);
+	mesh.GenNormals();
+	// mirroring y flips the winding, the normals point inward
+	bool inward = true;
+	for (size_t i = 1; i < meshPositions.size(); i++) {
+		const auto& n = mesh.GetNormals()[i];
+		const auto& p = meshPositions[i];
+		if (abs(p[1]) > 0.999f)
+			continue;
+		inward &= n[0] * p[0] + n[1] * p[1] + n[2] * p[2] < 0.f;
+	}
+	Check(inward, "regenerated for new positions");
+}
+
+static void TestParallel() {
+	// large enough to be split over the threads
+	vector<pointf3> positions;
+	vector<pointf2> uv;
+	vector<uint32_t> indices;
+	MakeGrid(301, positions, uv, indices);
+	for (auto& p : positions)
+		p[2] = sin(p[0] * 0.1f) * cos(p[1] * 0.07f) * 5.f;
+
+	// scalar scatter reference
+	vector<float> reference(3 * positions.size(), 0.f);
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		const auto& p0 = positions[indices[i + 0]];
+		const auto& p1 = positions[indices[i + 1]];
+		const auto& p2 = positions[indices[i + 2]];
+		const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		const float n[3] = {
+			e1[1] * e2[2] - e1[2] * e2[1],
+			e1[2] * e2[0] - e1[0] * e2[2],
+			e1[0] * e2[1] - e1[1] * e2[0],
+		};
+		for (size_t k = 0; k < 3; k++) {
+			for (size_t c = 0; c < 3; c++)
+				reference[3 * indices[i + k] + c] += n[c];
+		}
+	}
+
+	auto adjacency = BuildTriangleAdjacency(indices, positions.size());
+	vector<normalf> normals(positions.size());
+	ComputeNormals(normals.data(), adjacency, positions.data());
+	bool same = true;
+	for (size_t v = 0; v < positions.size(); v++) {
+		const float* r = &reference[3 * v];
+		const float length = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+		for (size_t c = 0; c < 3; c++)
+			same &= abs(normals[v][c] - r[c] / length) < 1e-5f;
+	}
+	Check(same, "parallel normals match the scalar reference");
+
+	vector<normalf> again(positions.size());
+	ComputeNormals(again.data(), adjacency, positions.data());
+	bool deterministic = true;
+	for (size_t v = 0; v < positions.size(); v++) {
+		for (size_t c = 0; c < 3; c++)
+			deterministic &= again[v][c] == normals[v][c];
+	}
+	Check(deterministic, "normals are deterministic");
+
+	for (auto mode : { TangentMode::Accumulated, TangentMode::MikkTSpace }) {
+		vector<vecf3> tangents(positions.size());
+		ComputeTangents(tangents.data(), adjacency, positions.data(), normals.data(), uv.data(), mode);
+		bool frame = true;
+		for (size_t v = 0; v < positions.size(); v++) {
+			const auto& t = tangents[v];
+			const auto& n = normals[v];
+			frame &= abs(t[0] * t[0] + t[1] * t[1] + t[2] * t[2] - 1.f) < 1e-4f;
+			frame &= abs(t[0] * n[0] + t[1] * n[1] + t[2] * n[2]) < 1e-4f;
+			// u follows x
+			frame &= t[0] > 0.f;
+		}
+		Check(frame, mode == TangentMode::Accumulated ? "accumulated tangent frames" : "MikkTSpace tangent frames");
+	}
+}
+
+static void TestTangents() {
+	vector<pointf3> positions;
+	vector<pointf2> uv;
+	vector<uint32_t> indices;
+	MakeGrid(5, positions, uv, indices);
+
+	for (auto mode : { TangentMode::Accumulated, TangentMode::MikkTSpace }) {
+		for (bool mirrored : { false, true }) {
+			vector<pointf2> meshUV = uv;
+			if (mirrored) {
+				for (auto& coord : meshUV)
+					coord[0] = 1.f - coord[0];
+			}
+
+			Mesh mesh;
+			mesh.SetPositions(positions);
+			mesh.SetUV(meshUV);
+			mesh.SetIndices(indices);
+			mesh.SetSubMeshCount(1);
+			mesh.SetSubMesh(0, { 0, indices.size() });
+			mesh.GenTangents(mode);
+
+			// n = +z, the bitangent (v) is +y, cross(n, t) is the bitangent
+			bool right = true;
+			for (const auto& t : mesh.GetTangents())
+				right &= abs(t[0] - 1.f) < 1e-5f && abs(t[1]) < 1e-5f && abs(t[2]) < 1e-5f;
+			Check(right, mirrored ? "mirrored UV, cross(n, t) stays the bitangent" : "grid tangents follow u");
+		}
+	}
+
+	// MikkTSpace ignores the UV scale of the triangles, the accumulated mode weights by it
+	// vertex 0 : a triangle with large UVs and the tangent +x, one with tiny UVs and the tangent -y
+	vector<pointf3> fanPositions = { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, -1.f, 0.f } };
+	vector<pointf2> fanUV = { { 0.f, 0.f }, { 10.f, 0.f }, { 0.f, 10.f }, { 0.f, 0.f }, { 0.f, 0.f } };
+	fanUV[3] = { 0.f, -0.01f };
+	fanUV[4] = { 0.01f, 0.f };
+	vector<uint32_t> fanIndices = { 0, 1, 2, 0, 3, 4 };
+	auto adjacency = BuildTriangleAdjacency(fanIndices, fanPositions.size());
+	vector<normalf> normals(fanPositions.size());
+	ComputeNormals(normals.data(), adjacency, fanPositions.data());
+
+	vector<vecf3> accumulated(fanPositions.size());
+	vector<vecf3> mikk(fanPositions.size());
+	ComputeTangents(accumulated.data(), adjacency, fanPositions.data(), normals.data(), fanUV.data(), TangentMode::Accumulated);
+	ComputeTangents(mikk.data(), adjacency, fanPositions.data(), normals.data(), fanUV.data(), TangentMode::MikkTSpace);
+	// accumulated : dominated by the tiny UVs (-y), MikkTSpace : equal right angles, the diagonal
+	Check(accumulated[0][1] < -0.99f, "accumulated tangents weight by the UV scale");
+	Check(abs(mikk[0][0] + mikk[0][1]) < 1e-4f && mikk[0][0] > 0.7f, "MikkTSpace weights by the corner angle");
+}
+
+int main() {
+	TestNormals();
+	TestParallel();
+	TestTangents();
+
+	return CheckResult();
+}
@@ -0,0 +1,149 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/Mesh.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+static void Fill(Mesh& mesh, size_t n) {
+	vector<pointf3> positions(n);
+	vector<pointf2> uv(n);
+	vector<normalf> normals(n);
+	vector<rgbf> colors(n);
+	for (size_t i = 0; i < n; i++) {
+		float f = static_cast<float>(i);
+		positions[i] = { f, f + 0.1f, f + 0.2f };
+		uv[i] = { f / n, 1.f - f / n };
+		normals[i] = { 0.f, 1.f, 0.f };
+		colors[i] = { f / n, 0.5f, 0.25f };
+	}
+	mesh.SetPositions(move(positions));
+	mesh.SetUV(move(uv));
+	mesh.SetNormals(move(normals));
+	mesh.SetColors(move(colors));
+}
+
+// the vertex buffer equals the one built from scratch
+static bool MatchFullBuild(const Mesh& mesh) {
+	Mesh full;
+	full.SetPositions(mesh.GetPositions());
+	full.SetUV(mesh.GetUV());
+	full.SetNormals(mesh.GetNormals());
+	full.SetColors(mesh.GetColors());
+	full.SetVertexLayout(mesh.GetVertexLayout());
+	full.SetVertexCompression(mesh.GetVertexCompression());
+	full.UpdateVertexBuffer();
+	const size_t size = mesh.GetVertexBufferVertexCount() * mesh.GetVertexBufferVertexStride();
+	return memcmp(full.GetVertexBufferData(), mesh.GetVertexBufferData(), size) == 0;
+}
+
+// the ranges are sorted, disjoint and not adjacent
+static bool Coalesced(const vector<BufferRange>& ranges) {
+	for (size_t i = 1; i < ranges.size(); i++) {
+		if (ranges[i - 1].offset + ranges[i - 1].size >= ranges[i].offset)
+			return false;
+	}
+	return true;
+}
+
+static void TestInterleaved() {
+	constexpr size_t n = 100;
+	Mesh mesh;
+	Fill(mesh, n);
+	mesh.SetIndices({ 0, 1, 2 });
+	mesh.UpdateVertexBuffer();
+	const size_t stride = mesh.GetVertexBufferVertexStride();
+	Check(!mesh.IsUpdatedInPlace(), "the first update builds the buffer");
+	Check(mesh.GetUpdatedVertexBufferRanges().size() == 1
+		&& mesh.GetUpdatedVertexBufferRanges()[0].offset == 0
+		&& mesh.GetUpdatedVertexBufferRanges()[0].size == n * stride, "the whole buffer is updated");
+
+	// overlapping edits are merged
+	for (auto& p : mesh.EditPositions(10, 5))
+		p[1] += 1.f;
+	auto span = mesh.EditPositions(13, 4);
+	Check(span.size == 4 && span.data == mesh.GetPositions().data() + 13, "span over the vertices");
+	span[3][2] = -1.f;
+	Check(mesh.IsDirty(), "edits mark dirty");
+	mesh.UpdateVertexBuffer();
+	Check(mesh.IsUpdatedInPlace(), "edits update in place");
+	const auto& ranges = mesh.GetUpdatedVertexBufferRanges();
+	Check(ranges.size() == 1 && ranges[0].offset == 10 * stride && ranges[0].size == 7 * stride, "merged vertex range");
+	Check(MatchFullBuild(mesh), "edited content");
+
+	// ranges of several attributes in one stream
+	mesh.EditColors(0, 2)[1] = { 1.f, 0.f, 0.f };
+	mesh.EditUV(2, 1)[0] = { 0.5f, 0.5f };
+	mesh.EditNormals(50, 3)[0] = { 1.f, 0.f, 0.f };
+	mesh.UpdateVertexBuffer();
+	Check(mesh.GetUpdatedVertexBufferRanges().size() == 2, "adjacent ranges of different attributes are merged");
+	Check(mesh.GetUpdatedVertexBufferRanges()[0].size == 3 * stride, "colors and uv merged");
+	Check(MatchFullBuild(mesh), "content of several attributes");
+
+	// a whole set wins over the edits
+	mesh.EditPositions(0, 1)[0] = { 5.f, 5.f, 5.f };
+	mesh.SetColors(mesh.GetColors());
+	mesh.EditColors(3, 1)[0] = { 0.f, 0.f, 1.f };
+	mesh.UpdateVertexBuffer();
+	Check(mesh.IsUpdatedInPlace(), "set of the same size updates in place");
+	Check(mesh.GetUpdatedVertexBufferRanges().size() == 1
+		&& mesh.GetUpdatedVertexBufferRanges()[0].size == n * stride, "set updates the whole attribute");
+	Check(MatchFullBuild(mesh), "content after a set");
+
+	// new indices or a new size need a full upload
+	mesh.SetIndices({ 0, 2, 1 });
+	mesh.EditPositions(0, 1)[0] = { 6.f, 6.f, 6.f };
+	mesh.UpdateVertexBuffer();
+	Check(!mesh.IsUpdatedInPlace(), "new indices are not in place");
+	Fill(mesh, n + 1);
+	mesh.UpdateVertexBuffer();
+	Check(!mesh.IsUpdatedInPlace(), "a new vertex count is not in place");
+	Check(MatchFullBuild(mesh), "content after a resize");
+
+	// empty edits change nothing
+	mesh.EditPositions(4, 0);
+	Check(!mesh.IsDirty(), "empty edit");
+}
+
+static void TestSplitCompressed() {
+	constexpr size_t n = 64;
+	for (auto compression : { VertexCompression::None, VertexCompression::Standard, VertexCompression::Compact }) {
+		Mesh mesh;
+		Fill(mesh, n);
+		mesh.SetVertexLayout(VertexLayout::Split);
+		mesh.SetVertexCompression(compression);
+		mesh.UpdateVertexBuffer();
+
+		mesh.EditPositions(n - 1, 1)[0] = { 1.f, 2.f, 3.f };
+		mesh.EditNormals(7, 9)[8] = { 0.f, 0.f, 1.f };
+		mesh.EditColors(0, 1)[0] = { 0.f, 1.f, 0.f };
+		mesh.EditUV(20, 2)[1] = { 0.125f, 0.75f };
+		mesh.UpdateVertexBuffer();
+
+		const auto& streams = mesh.GetVertexStreams();
+		const auto& ranges = mesh.GetUpdatedVertexBufferRanges();
+		Check(mesh.IsUpdatedInPlace(), "split edits update in place");
+		Check(ranges.size() == 4 && Coalesced(ranges), "a range per stream");
+		const size_t normalStream = streams.streams[static_cast<size_t>(VertexAttribute::Normal)];
+		bool normalRange = false;
+		for (const auto& range : ranges) {
+			normalRange |= range.offset == mesh.GetVertexStreamOffset(normalStream) + 7 * streams.strides[normalStream]
+				&& range.size == 9 * streams.strides[normalStream];
+		}
+		Check(normalRange, "normal range in its stream");
+		Check(mesh.GetUpdatedVertexStreams() == (1u << streams.streamNum) - 1, "every stream updated");
+		Check(MatchFullBuild(mesh), "split / compressed content");
+	}
+}
+
+int main() {
+	TestInterleaved();
+	TestSplitCompressed();
+
+	return CheckResult();
+}
@@ -0,0 +1,324 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/Skinning.h>
+#include <Utopia/Render/Mesh.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa;
+using namespace std;
+
+// rows of the affine part
+static transformf Affine(const float (&rows)[3][4]) {
+	transformf m = transformf::eye();
+	for (size_t r = 0; r < 3; r++) {
+		for (size_t c = 0; c < 4; c++)
+			m[c][r] = rows[r][c];
+	}
+	return m;
+}
+
+// rotation about z by angle, then a translation
+static transformf RotateZ(float angle, float tx, float ty, float tz) {
+	const float c = cos(angle);
+	const float s = sin(angle);
+	return Affine({
+		{ c, -s, 0.f, tx },
+		{ s, c, 0.f, ty },
+		{ 0.f, 0.f, 1.f, tz },
+	});
+}
+
+template<typename T>
+static bool Same(const vector<T>& a, const vector<T>& b) {
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < a.size(); i++) {
+		for (size_t c = 0; c < 3; c++) {
+			if (a[i][c] != b[i][c])
+				return false;
+		}
+	}
+	return true;
+}
+
+struct SkinnedVertices {
+	vector<pointf3> positions;
+	vector<normalf> normals;
+	vector<vecf3> tangents;
+	vector<valu4> boneIndices;
+	vector<valf4> boneWeights;
+};
+
+static SkinnedVertices RandomVertices(size_t num, size_t boneNum, mt19937& rng) {
+	uniform_real_distribution<float> coord(-1.f, 1.f);
+	uniform_real_distribution<float> weight(0.f, 1.f);
+	uniform_int_distribution<uint32_t> bone(0, static_cast<uint32_t>(boneNum - 1));
+	SkinnedVertices vertices;
+	for (size_t i = 0; i < num; i++) {
+		vertices.positions.push_back({ coord(rng), coord(rng), coord(rng) });
+		vertices.normals.push_back({ coord(rng), coord(rng), coord(rng) });
+		vertices.tangents.push_back({ coord(rng), coord(rng), coord(rng) });
+		vertices.boneIndices.push_back({ bone(rng), bone(rng), bone(rng), bone(rng) });
+		float w[4] = { weight(rng), weight(rng), weight(rng), weight(rng) };
+		const float sum = w[0] + w[1] + w[2] + w[3];
+		vertices.boneWeights.push_back({ w[0] / sum, w[1] / sum, w[2] / sum, w[3] / sum });
+	}
+	// a zero normal stays zero
+	vertices.normals[7] = { 0.f, 0.f, 0.f };
+	return vertices;
+}
+
+static vector<SkinMatrix> RandomSkin(size_t boneNum, mt19937& rng) {
+	uniform_real_distribution<float> angle(-3.f, 3.f);
+	uniform_real_distribution<float> offset(-5.f, 5.f);
+	vector<transformf> bones;
+	vector<transformf> inverseBind;
+	for (size_t i = 0; i < boneNum; i++) {
+		bones.push_back(RotateZ(angle(rng), offset(rng), offset(rng), offset(rng)));
+		inverseBind.push_back(RotateZ(angle(rng), offset(rng), offset(rng), offset(rng)));
+	}
+	vector<SkinMatrix> skin(boneNum);
+	ComputeSkinMatrices(skin.data(), bones.data(), inverseBind.data(), boneNum, transformf::eye());
+	return skin;
+}
+
+static void TestSkinMatrices() {
+	// bone : rotate 90 degrees about z then translate (1, 2, 3), bind : translate (-1, 0, 0), world to local : translate (0, 0, -3)
+	const transformf bone = RotateZ(1.57079633f, 1.f, 2.f, 3.f);
+	const transformf inverseBind = RotateZ(0.f, -1.f, 0.f, 0.f);
+	const transformf worldToLocal = RotateZ(0.f, 0.f, 0.f, -3.f);
+	SkinMatrix skin;
+	ComputeSkinMatrices(&skin, &bone, &inverseBind, 1, worldToLocal);
+	// p -> (p - (1, 0, 0)) rotated -> + (1, 2, 0) : (x, y, z) -> (1 - y, 2 + x - 1, z)
+	const float expected[3][4] = {
+		{ 0.f, -1.f, 0.f, 1.f },
+		{ 1.f, 0.f, 0.f, 1.f },
+		{ 0.f, 0.f, 1.f, 0.f },
+	};
+	bool same = true;
+	for (size_t r = 0; r < 3; r++) {
+		for (size_t c = 0; c < 4; c++)
+			same &= abs(skin.m[r][c] - expected[r][c]) < 1e-5f;
+	}
+	Check(same, "skin matrix is worldToLocal * bone * inverseBind");
+}
+
+static void TestVertices() {
+	mt19937 rng(7);
+	const size_t boneNum = 16;
+	// not a multiple of 8, the scalar tail runs
+	const size_t num = 1003;
+	auto vertices = RandomVertices(num, boneNum, rng);
+	auto skin = RandomSkin(boneNum, rng);
+
+	vector<pointf3> positions(num);
+	vector<normalf> normals(num);
+	vector<vecf3> tangents(num);
+	const size_t first = 5;
+	SkinVertices(
+		positions.data(), normals.data(), tangents.data(),
+		vertices.positions.data(), vertices.normals.data(), vertices.tangents.data(),
+		vertices.boneIndices.data(), vertices.boneWeights.data(),
+		skin.data(), first, num - first
+	);
+
+	// double reference
+	bool samePositions = true;
+	bool sameDirections = true;
+	for (size_t v = first; v < num; v++) {
+		double m[3][4] = {};
+		for (size_t k = 0; k < 4; k++) {
+			for (size_t r = 0; r < 3; r++) {
+				for (size_t c = 0; c < 4; c++)
+					m[r][c] += double(vertices.boneWeights[v][k]) * skin[vertices.boneIndices[v][k]].m[r][c];
+			}
+		}
+		const auto& p = vertices.positions[v];
+		for (size_t r = 0; r < 3; r++)
+			samePositions &= abs(m[r][0] * p[0] + m[r][1] * p[1] + m[r][2] * p[2] + m[r][3] - positions[v][r]) < 1e-4;
+
+		auto CheckDirection = [&](const float* src, const float* dst) {
+			double d[3];
+			for (size_t r = 0; r < 3; r++)
+				d[r] = m[r][0] * src[0] + m[r][1] * src[1] + m[r][2] * src[2];
+			const double norm = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+			for (size_t r = 0; r < 3; r++)
+				sameDirections &= abs((norm > 0. ? d[r] / norm : 0.) - dst[r]) < 1e-4;
+		};
+		CheckDirection(&vertices.normals[v][0], &normals[v][0]);
+		CheckDirection(&vertices.tangents[v][0], &tangents[v][0]);
+	}
+	Check(samePositions, "blended positions");
+	Check(sameDirections, "blended and renormalized normals and tangents");
+	Check(normals[7][0] == 0.f && normals[7][1] == 0.f && normals[7][2] == 0.f, "zero normal stays zero");
+	Check(positions[first - 1][0] == 0.f && positions[first - 1][1] == 0.f, "vertices before first untouched");
+
+	// in place, without tangents
+	auto inPlace = vertices;
+	SkinVertices(
+		inPlace.positions.data(), inPlace.normals.data(), nullptr,
+		inPlace.positions.data(), inPlace.normals.data(), nullptr,
+		inPlace.boneIndices.data(), inPlace.boneWeights.data(),
+		skin.data(), first, num - first
+	);
+	bool same = true;
+	for (size_t v = first; v < num; v++) {
+		for (size_t c = 0; c < 3; c++)
+			same &= inPlace.positions[v][c] == positions[v][c] && inPlace.normals[v][c] == normals[v][c];
+	}
+	Check(same, "skinning in place");
+	Check(Same(inPlace.tangents, vertices.tangents), "tangents skipped");
+}
+
+static void TestRigid() {
+	// every vertex on bone 1 with weight 1 : a rotation, the lengths are kept
+	mt19937 rng(3);
+	const size_t num = 64;
+	auto vertices = RandomVertices(num, 2, rng);
+	for (size_t v = 0; v < num; v++) {
+		vertices.boneIndices[v] = { 1u, 0u, 0u, 0u };
+		vertices.boneWeights[v] = { 1.f, 0.f, 0.f, 0.f };
+		auto& n = vertices.normals[v];
+		const float norm = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (norm > 0.f)
+			n = { n[0] / norm, n[1] / norm, n[2] / norm };
+	}
+	const transformf bones[2] = { transformf::eye(), RotateZ(0.5f, 0.f, 0.f, 1.f) };
+	const transformf inverseBind[2] = { transformf::eye(), transformf::eye() };
+	SkinMatrix skin[2];
+	ComputeSkinMatrices(skin, bones, inverseBind, 2, transformf::eye());
+
+	vector<pointf3> positions(num);
+	vector<normalf> normals(num);
+	SkinVertices(
+		positions.data(), normals.data(), nullptr,
+		vertices.positions.data(), vertices.normals.data(), nullptr,
+		vertices.boneIndices.data(), vertices.boneWeights.data(),
+		skin, 0, num
+	);
+	bool rigid = true;
+	const float c = cos(0.5f);
+	const float s = sin(0.5f);
+	for (size_t v = 0; v < num; v++) {
+		const auto& p = vertices.positions[v];
+		const auto& n = vertices.normals[v];
+		rigid &= abs(positions[v][0] - (c * p[0] - s * p[1])) < 1e-5f;
+		rigid &= abs(positions[v][1] - (s * p[0] + c * p[1])) < 1e-5f;
+		rigid &= abs(positions[v][2] - (p[2] + 1.f)) < 1e-5f;
+		rigid &= abs(normals[v][0] - (c * n[0] - s * n[1])) < 1e-5f;
+		rigid &= abs(normals[v][2] - n[2]) < 1e-5f;
+	}
+	Check(rigid, "single bone is a rigid transform");
+}
+
+static void TestMeshes() {
+	// crowd : meshes of several blocks, skinned together
+	mt19937 rng(11);
+	const size_t boneNum = 24;
+	vector<Mesh> meshes(3);
+	vector<vector<SkinMatrix>> skins;
+	vector<SkinnedVertices> outputs(meshes.size());
+	vector<SkinningTask> tasks;
+	for (size_t i = 0; i < meshes.size(); i++) {
+		auto vertices = RandomVertices(4000 + 1001 * i, boneNum, rng);
+		meshes[i].SetPositions(vertices.positions);
+		meshes[i].SetNormals(vertices.normals);
+		// mesh 1 has no tangents
+		if (i != 1)
+			meshes[i].SetTangents(vertices.tangents);
+		meshes[i].SetBoneWeights(vertices.boneIndices, vertices.boneWeights);
+		skins.push_back(RandomSkin(boneNum, rng));
+
+		const size_t num = vertices.positions.size();
+		outputs[i].positions.resize(num);
+		outputs[i].normals.resize(num);
+		outputs[i].tangents.resize(num);
+	}
+	for (size_t i = 0; i < meshes.size(); i++)
+		tasks.push_back({ &meshes[i], skins[i].data(), boneNum, outputs[i].positions.data(), outputs[i].normals.data(), outputs[i].tangents.data() });
+	Check(meshes[0].IsSkinned() && meshes[0].IsVertexValid(), "bone weights are per vertex");
+	const auto untouched = outputs[1].tangents;
+
+	SkinMeshes(tasks.data(), tasks.size());
+
+	bool same = true;
+	for (size_t i = 0; i < meshes.size(); i++) {
+		const auto& mesh = meshes[i];
+		const size_t num = mesh.GetPositions().size();
+		vector<pointf3> positions(num);
+		vector<normalf> normals(num);
+		vector<vecf3> tangents(num);
+		SkinVertices(
+			positions.data(), normals.data(), mesh.GetTangents().empty() ? nullptr : tangents.data(),
+			mesh.GetPositions().data(), mesh.GetNormals().data(), mesh.GetTangents().empty() ? nullptr : mesh.GetTangents().data(),
+			mesh.GetBoneIndices().data(), mesh.GetBoneWeights().data(),
+			skins[i].data(), 0, num
+		);
+		same &= Same(positions, outputs[i].positions) && Same(normals, outputs[i].normals);
+		same &= Same(mesh.GetTangents().empty() ? untouched : tangents, outputs[i].tangents);
+	}
+	Check(same, "parallel blocks match a single pass");
+}
+
+static void BenchmarkCrowd() {
+	// 300 characters of 3000 vertices, 4 distinct meshes, a pose per character
+	constexpr size_t CharacterNum = 300;
+	constexpr size_t VertexNum = 3000;
+	constexpr size_t MeshNum = 4;
+	mt19937 rng(13);
+	const size_t boneNum = 64;
+	vector<Mesh> meshes(MeshNum);
+	for (auto& mesh : meshes) {
+		auto vertices = RandomVertices(VertexNum, boneNum, rng);
+		mesh.SetPositions(vertices.positions);
+		mesh.SetNormals(vertices.normals);
+		mesh.SetTangents(vertices.tangents);
+		mesh.SetBoneWeights(vertices.boneIndices, vertices.boneWeights);
+	}
+	vector<vector<SkinMatrix>> skins;
+	vector<SkinnedVertices> outputs(CharacterNum);
+	vector<SkinningTask> tasks;
+	for (size_t i = 0; i < CharacterNum; i++) {
+		skins.push_back(RandomSkin(boneNum, rng));
+		outputs[i].positions.resize(VertexNum);
+		outputs[i].normals.resize(VertexNum);
+		outputs[i].tangents.resize(VertexNum);
+	}
+	for (size_t i = 0; i < CharacterNum; i++) {
+		tasks.push_back({ &meshes[i % MeshNum], skins[i].data(), boneNum,
+			outputs[i].positions.data(), outputs[i].normals.data(), outputs[i].tangents.data() });
+	}
+
+	double best = 1e9;
+	for (size_t round = 0; round < 5; round++) {
+		auto t0 = chrono::steady_clock::now();
+		SkinMeshes(tasks.data(), tasks.size());
+		auto t1 = chrono::steady_clock::now();
+		best = std::min(best, chrono::duration<double, milli>(t1 - t0).count());
+	}
+
+	const bool avx2 = IsSkinningAVX2();
+	cout << "skin " << CharacterNum << " x " << VertexNum << " vertices ("
+		<< (avx2 ? "AVX2" : "scalar") << " kernel): " << best << " ms" << endl;
+#ifdef NDEBUG
+	// a few milliseconds for the crowd, the scalar kernel of old CPUs is about 3x slower
+	Check(best < (avx2 ? 5. : 15.), "crowd skinning budget");
+#endif // NDEBUG
+}
+
+int main() {
+	TestSkinMatrices();
+	TestVertices();
+	TestRigid();
+	TestMeshes();
+	BenchmarkCrowd();
+
+	return CheckResult();
+}
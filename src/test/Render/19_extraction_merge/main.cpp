@@ -0,0 +1,219 @@
+#include "../../common/Check.h"
+
+#include <Utopia/Render/PipelineCore.h>
+#include <Utopia/Render/Material.h>
+#include <Utopia/Render/Shader.h>
+#include <Utopia/Render/Mesh.h>
+#include <Utopia/Render/LODSelection.h>
+#include <Utopia/Render/Components/Camera.h>
+#include <Utopia/Render/Components/LODGroup.h>
+#include <Utopia/Render/Components/MeshFilter.h>
+#include <Utopia/Render/Components/MeshRenderer.h>
+#include <Utopia/Core/Components/LocalToWorld.h>
+#include <Utopia/Core/Components/Translation.h>
+#include <Utopia/Core/Components/WorldToLocal.h>
+
+#include <UECS/World.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <vector>
+
+using namespace Ubpa::Utopia;
+using namespace Ubpa::UECS;
+using namespace Ubpa;
+using namespace std;
+
+static shared_ptr<Mesh> CreateTriangle() {
+	auto mesh = make_shared<Mesh>();
+	mesh->SetPositions({ { -0.5f, -0.5f, 0.f }, { 0.5f, -0.5f, 0.f }, { 0.f, 0.5f, 0.f } });
+	mesh->SetIndices({ 0, 1, 2 });
+	mesh->SetSubMeshCount(1);
+	mesh->SetSubMesh(0, { 0, 3 });
+	return mesh;
+}
+
+// objects in front of the camera (-z), so that nothing is culled
+// every third entity has a WorldToLocal (another archetype)
+static void BuildWorld(World& world, size_t N, float x, shared_ptr<Mesh> mesh, shared_ptr<Material> material) {
+	for (size_t i = 0; i < N; i++) {
+		const transformf l2w{ vecf3{ x, 0.01f * static_cast<float>(i % 100), -10.f - 0.01f * static_cast<float>(i) } };
+		if (i % 3 == 0) {
+			auto [e, cmptL2W, w2l, meshFilter, meshRenderer] =
+				world.entityMngr.Create<LocalToWorld, WorldToLocal, MeshFilter, MeshRenderer>();
+			cmptL2W->value = l2w;
+			w2l->value = l2w.inverse();
+			meshFilter->mesh = mesh;
+			meshRenderer->materials.push_back(material);
+		}
+		else {
+			auto [e, cmptL2W, meshFilter, meshRenderer] = world.entityMngr.Create<LocalToWorld, MeshFilter, MeshRenderer>();
+			cmptL2W->value = l2w;
+			meshFilter->mesh = mesh;
+			meshRenderer->materials.push_back(material);
+		}
+	}
+}
+
+static transformf ToTransform(const valf<16>& value) {
+	transformf rst;
+	memcpy(&rst, &value, sizeof(transformf));
+	return rst;
+}
+
+int main() {
+	{ // RenderObject is a trivially copyable packet
+		static_assert(std::is_trivially_copyable_v<RenderObject>);
+
+		RenderObject obj;
+		obj.passIdx = 1;
+		obj.submeshIdx = 2;
+		obj.lod = 3;
+		obj.objectIdx = 4;
+		obj.translation = { 1.f, 2.f, 3.f };
+		obj.depth = 5.f;
+
+		RenderObject copy;
+		memcpy(&copy, &obj, sizeof(RenderObject));
+		Check(copy.passIdx == 1 && copy.submeshIdx == 2 && copy.lod == 3 && copy.objectIdx == 4
+			&& copy.translation[2] == 3.f && copy.depth == 5.f, "memcpy of a RenderObject");
+	}
+
+	auto shader = make_shared<Shader>();
+	shader->passes.emplace_back();
+	shader->passes.back().tags["LightMode"] = "Deferred";
+	auto material = make_shared<Material>();
+	material->shader = shader;
+	auto mesh = CreateTriangle();
+
+	{ // Append remaps the local indices of a packet to the slots
+		RenderQueue local;
+		for (size_t i = 0; i < 3; i++) {
+			RenderObject obj;
+			obj.material = material.get();
+			obj.passIdx = 0;
+			obj.mesh = mesh.get();
+			obj.submeshIdx = 0;
+			obj.objectIdx = i;
+			local.Add(obj);
+		}
+		const size_t slots[] = { 7, 3, 5 };
+		RenderQueue merged;
+		merged.Append(local, slots);
+		merged.Append(local, slots);
+		multiset<size_t> indices;
+		for (const auto& obj : merged.GetOpaques())
+			indices.insert(obj.objectIdx);
+		Check(indices == multiset<size_t>{ 3, 3, 5, 5, 7, 7 }, "remapped indices");
+	}
+
+	{ // parallel extraction of two worlds, merged into one queue and persistent slots
+		constexpr size_t N = 5000;
+		World world0;
+		World world1;
+		BuildWorld(world0, N, -1.f, mesh, material);
+		BuildWorld(world1, N, 1.f, mesh, material);
+
+		auto [cameraEntity, cmptCamera, w2l, translation] = world0.entityMngr.Create<Camera, WorldToLocal, Translation>();
+		const Entity camera = cameraEntity;
+		cmptCamera->prjectionMatrix = transformf::perspective(to_radian(cmptCamera->fov), cmptCamera->aspect,
+			cmptCamera->clippingPlaneMin, cmptCamera->clippingPlaneMax, 0.f);
+		w2l->value = transformf::eye();
+
+		const vector<const World*> worlds{ &world0, &world1 };
+		PipelineCore core{ 3 };
+
+		// (x, y, z, slot) of the queued objects
+		auto Extract = [&]() {
+			core.Extract(worlds, { camera, world0 }, 1280, 720);
+			vector<tuple<float, float, float, size_t>> rst;
+			for (const auto& obj : core.renderQueue.GetOpaques())
+				rst.emplace_back(obj.translation[0], obj.translation[1], obj.translation[2], obj.objectIdx);
+			sort(rst.begin(), rst.end());
+			return rst;
+		};
+
+		auto frame0 = Extract();
+		Check(frame0.size() == 2 * N, "every object queued once");
+		Check(core.GetCulledNum() == 0, "nothing culled");
+
+		set<size_t> slots;
+		bool match = true;
+		bool inverse = true;
+		for (const auto& [x, y, z, slot] : frame0) {
+			slots.insert(slot);
+			if (slot >= core.GetObjectCapacity() || slot >= core.objects.size()) {
+				match = false;
+				continue;
+			}
+			const transformf l2w = ToTransform(core.objects[slot].l2w);
+			const transformf w2l = ToTransform(core.objects[slot].w2l);
+			const auto t = l2w.decompose_translation();
+			match &= t[0] == x && t[1] == y && t[2] == z;
+			const auto origin = w2l * (l2w * pointf3{ 0.f });
+			inverse &= std::abs(origin[0]) < 1e-3f && std::abs(origin[1]) < 1e-3f && std::abs(origin[2]) < 1e-3f;
+		}
+		Check(slots.size() == 2 * N, "a slot per entity of each world");
+		Check(match, "object data of the slot");
+		Check(inverse, "inverse of the object data");
+
+		Check(Extract() == frame0, "persistent slots");
+	}
+
+	{ // the LOD hysteresis state is per camera
+		auto lodMesh = CreateTriangle();
+		lodMesh->SetLODs({ { { 0, 3 } }, { { 0, 3 } }, { { 0, 3 } } });
+
+		World world;
+		auto [nearEntity, nearCamera, nearW2L, nearTranslation] = world.entityMngr.Create<Camera, WorldToLocal, Translation>();
+		nearCamera->prjectionMatrix = transformf::perspective(to_radian(nearCamera->fov), nearCamera->aspect,
+			nearCamera->clippingPlaneMin, nearCamera->clippingPlaneMax, 0.f);
+		nearW2L->value = transformf::eye();
+		auto [farEntity, farCamera, farW2L, farTranslation] = world.entityMngr.Create<Camera, WorldToLocal, Translation>();
+		farCamera->clippingPlaneMax = 10000.f;
+		farCamera->prjectionMatrix = transformf::perspective(to_radian(farCamera->fov), farCamera->aspect,
+			farCamera->clippingPlaneMin, farCamera->clippingPlaneMax, 0.f);
+		farTranslation->value = { 0.f, 0.f, 1000.f };
+		farW2L->value = transformf{ vecf3{ 0.f, 0.f, -1000.f } };
+		const Entity cameraNear = nearEntity;
+		const Entity cameraFar = farEntity;
+
+		// the object covers the first threshold of the LODGroup (0.5) for the near camera,
+		// inside the hysteresis band: level 0 stays 0, a coarser level only goes back to 1
+		const float radius = std::sqrt(0.5f); // of the bounds of the triangle
+		const float proj11 = nearCamera->prjectionMatrix[1][1];
+		float minDist = 1.f;
+		float maxDist = 1000.f;
+		for (size_t i = 0; i < 64; i++) {
+			const float dist = 0.5f * (minDist + maxDist);
+			if (ComputeLODScreenSize(pointf3{ 0.f, 0.f, -dist }, radius, pointf3{ 0.f, 0.f, 0.f }, proj11) > 0.5f)
+				minDist = dist;
+			else
+				maxDist = dist;
+		}
+
+		auto [entity, l2w, meshFilter, meshRenderer, lodGroup] =
+			world.entityMngr.Create<LocalToWorld, MeshFilter, MeshRenderer, LODGroup>();
+		l2w->value = transformf{ vecf3{ 0.f, 0.f, -minDist } };
+		meshFilter->mesh = lodMesh;
+		meshRenderer->materials.push_back(material);
+
+		const vector<const World*> worlds{ &world };
+		PipelineCore core{ 3 };
+		auto SelectedLOD = [&](Entity camera) {
+			core.Extract(worlds, { camera, world }, 1280, 720);
+			const auto& opaques = core.renderQueue.GetOpaques();
+			return opaques.empty() ? static_cast<size_t>(-1) : opaques.front().lod;
+		};
+
+		Check(SelectedLOD(cameraNear) == 0, "near camera keeps level 0 in the hysteresis band");
+		Check(SelectedLOD(cameraFar) == 3, "far camera selects the coarsest level");
+		Check(SelectedLOD(cameraNear) == 0, "the far camera doesn't change the level of the near camera");
+	}
+
+	return CheckResult();
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+
+// shared by the self-checking tests:
+// Check() reports a failed condition, and main returns CheckResult()
+
+inline size_t failures = 0;
+
+inline void Check(bool cond, const char* msg) {
+	if (!cond) {
+		std::cerr << "[FAIL] " << msg << std::endl;
+		failures++;
+	}
+}
+
+inline int CheckResult() {
+	if (failures == 0)
+		std::cout << "all passed" << std::endl;
+
+	return failures == 0 ? 0 : 1;
+}